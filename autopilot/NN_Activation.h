@@ -0,0 +1,173 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+namespace NN {
+
+/**
+ * @brief An activation function that is applied to the output of another operation.
+ * */
+enum class Activation : uint8_t
+{
+  kNone,
+  kReLU,
+  kSigmoid,
+  kTanh
+};
+
+/**
+ * @brief How accurately sigmoid and tanh are computed.
+ *
+ * @details Both modes are built from polynomial approximations of exp. The scalar functions below and the SIMD
+ *          kernels in @ref NN_Kernels.h perform the same operations in the same order, so a value gets the same result
+ *          no matter which kernel computes it. The errors are the largest found by testing every float against a
+ *          double precision reference, for results in the normal range.
+ * */
+enum class ActivationMode : uint8_t
+{
+  /**
+   * @brief Exp is within 1 ULP, sigmoid within 2.5 ULP and tanh within 1.5 ULP.
+   *
+   * @details Infinities and NaNs are handled, and results that would be denormal are flushed to zero.
+   * */
+  kPrecise,
+
+  /**
+   * @brief Exp and sigmoid are within 122 ULP (a relative error below 1.5e-5), and tanh within 26 ULP.
+   *
+   * @details This uses a shorter polynomial and clamps the input instead of checking for special values, so NaNs are
+   *          not propagated.
+   * */
+  kFast
+};
+
+inline auto
+floatToBits(const float x) -> uint32_t
+{
+  uint32_t bits{};
+  memcpy(&bits, &x, sizeof(bits));
+  return bits;
+}
+
+inline auto
+bitsToFloat(const uint32_t bits) -> float
+{
+  float x{};
+  memcpy(&x, &bits, sizeof(x));
+  return x;
+}
+
+/**
+ * @brief Rounds a value to the nearest integer, with ties to even. The value has to be smaller than 2^22.
+ * */
+inline auto
+roundToIntegral(const float x) -> float
+{
+  return (x + 12582912.0F) - 12582912.0F;
+}
+
+/**
+ * @brief Computes `2^n` for an integer in the normal exponent range.
+ * */
+inline auto
+pow2(const int32_t n) -> float
+{
+  return bitsToFloat(static_cast<uint32_t>(n + 127) << 23);
+}
+
+/**
+ * @brief Computes exp with the Cephes range reduction and polynomial. See @ref ActivationMode::kPrecise.
+ * */
+inline auto
+preciseExp(const float x) -> float
+{
+  auto c = (x < 88.7228394F) ? x : 88.7228394F;
+  c = (c > -87.3365479F) ? c : -87.3365479F;
+  const auto n = roundToIntegral(c * 1.44269504F);
+  // ln(2) is split in two, so that the first product is exact.
+  const auto r = (c - n * 0.693359375F) - n * -2.12194440e-4F;
+  auto p = 1.9875691500e-4F;
+  p = p * r + 1.3981999507e-3F;
+  p = p * r + 8.3334519073e-3F;
+  p = p * r + 4.1665795894e-2F;
+  p = p * r + 1.6666665459e-1F;
+  p = p * r + 5.0000001201e-1F;
+  auto y = p * (r * r) + r + 1.0F;
+  // The scale is applied in two steps, because 2^128 is not a float.
+  const auto ni = static_cast<int32_t>(n);
+  const auto n1 = ni >> 1;
+  y = y * pow2(n1) * pow2(ni - n1);
+  y = (x > -87.3365479F) ? y : 0.0F;
+  y = (x < 88.7228394F) ? y : bitsToFloat(0x7f800000U);
+  return (x == x) ? y : x;
+}
+
+/**
+ * @brief Computes exp with a minimax polynomial of degree four. See @ref ActivationMode::kFast.
+ * */
+inline auto
+fastExp(const float x) -> float
+{
+  auto c = (x < 88.0F) ? x : 88.0F;
+  c = (c > -86.0F) ? c : -86.0F;
+  const auto n = roundToIntegral(c * 1.44269504F);
+  const auto r = c - n * 0.693147182F;
+  auto p = 4.12777211e-2F;
+  p = p * r + 1.67535328e-1F;
+  p = p * r + 5.00051179e-1F;
+  const auto y = p * (r * r) + r + 1.0F;
+  return y * pow2(static_cast<int32_t>(n));
+}
+
+inline auto
+applyReLU(const float x) -> float
+{
+  return (x >= 0.0F) ? x : 0.0F;
+}
+
+inline auto
+applySigmoid(const float x, const ActivationMode mode = ActivationMode::kPrecise) -> float
+{
+  const auto ex = (mode == ActivationMode::kPrecise) ? preciseExp(-x) : fastExp(-x);
+  return 1.0F / (1.0F + ex);
+}
+
+/**
+ * @brief Computes tanh with the Cephes odd polynomial for small values, and from exp for large ones.
+ * */
+inline auto
+applyTanh(const float x, const ActivationMode mode = ActivationMode::kPrecise) -> float
+{
+  const auto a = bitsToFloat(floatToBits(x) & 0x7fffffffU);
+  const auto z = a * a;
+  auto p = -5.70498872745e-3F;
+  p = p * z + 2.06390887954e-2F;
+  p = p * z - 5.37397155531e-2F;
+  p = p * z + 1.33314422036e-1F;
+  p = p * z - 3.33332819422e-1F;
+  const auto small = p * z * a + a;
+  const auto ex = (mode == ActivationMode::kPrecise) ? preciseExp(a + a) : fastExp(a + a);
+  const auto large = 1.0F - 2.0F / (ex + 1.0F);
+  const auto t = (a < 0.625F) ? small : large;
+  return bitsToFloat(floatToBits(t) | (floatToBits(x) & 0x80000000U));
+}
+
+inline auto
+applyActivation(const float x, const Activation activation, const ActivationMode mode = ActivationMode::kPrecise)
+  -> float
+{
+  switch (activation) {
+    case Activation::kNone:
+      break;
+    case Activation::kReLU:
+      return applyReLU(x);
+    case Activation::kSigmoid:
+      return applySigmoid(x, mode);
+    case Activation::kTanh:
+      return applyTanh(x, mode);
+  }
+  return x;
+}
+
+} // namespace NN
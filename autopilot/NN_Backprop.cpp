@@ -0,0 +1,706 @@
+#include "NN_Backprop.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace NN {
+
+namespace {
+
+/**
+ * @brief Computes the derivative of an activation from its output, which is all that the tape keeps.
+ * */
+inline auto
+activationDerivative(const float y, const Activation activation) -> float
+{
+  switch (activation) {
+    case Activation::kNone:
+      break;
+    case Activation::kReLU:
+      return (y > 0.0F) ? 1.0F : 0.0F;
+    case Activation::kSigmoid:
+      return y * (1.0F - y);
+    case Activation::kTanh:
+      return 1.0F - y * y;
+  }
+  return 1.0F;
+}
+
+} // namespace
+
+GradientTape::GradientTape(const Net* net)
+  : runner_(net)
+  , net_(net)
+{
+}
+
+auto
+GradientTape::allocMemory() -> bool
+{
+  maxEntries_ = numEntries_;
+  valuesPerSample_ = numValues_;
+  if (maxEntries_ == 0) {
+    return true;
+  }
+
+  entries_ = static_cast<TapeEntry*>(malloc(sizeof(TapeEntry) * maxEntries_));
+  if (!entries_) {
+    return false;
+  }
+
+  if (valuesPerSample_ > 0) {
+    values_ = static_cast<float*>(malloc(sizeof(float) * valuesPerSample_ * net_->batchSize));
+    if (!values_) {
+      free(entries_);
+      entries_ = nullptr;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void
+GradientTape::releaseMemory()
+{
+  free(entries_);
+  free(values_);
+  entries_ = nullptr;
+  values_ = nullptr;
+}
+
+auto
+GradientTape::getRegister(const uint8_t reg, const uint16_t sample) -> float*
+{
+  return runner_.getRegister(reg, sample);
+}
+
+void
+GradientTape::setBatchSize(const uint16_t batchSize)
+{
+  runner_.setBatchSize(batchSize);
+  batchSize_ = (batchSize < net_->batchSize) ? batchSize : net_->batchSize;
+}
+
+auto
+GradientTape::getBatchSize() const -> uint16_t
+{
+  return batchSize_;
+}
+
+void
+GradientTape::reset()
+{
+  runner_.reset();
+  numEntries_ = 0;
+  numValues_ = 0;
+  parameterOffset_ = 0;
+  for (uint8_t i = 0; i < NN_MAX_REGS; i++) {
+    sizes_[i] = net_->regSizes[i];
+  }
+}
+
+auto
+GradientTape::getNumEntries() const -> InstrIndex
+{
+  return numEntries_;
+}
+
+auto
+GradientTape::getEntry(const InstrIndex index) const -> const TapeEntry&
+{
+  return entries_[index];
+}
+
+auto
+GradientTape::getValues(const uint32_t offset) const -> const float*
+{
+  return values_ + offset;
+}
+
+auto
+GradientTape::isMeasuring() const -> bool
+{
+  return entries_ == nullptr;
+}
+
+auto
+GradientTape::beginEntry() -> TapeEntry*
+{
+  if (isMeasuring() || (numEntries_ >= maxEntries_)) {
+    numEntries_++;
+    return nullptr;
+  }
+  auto* entry = &entries_[numEntries_++];
+  *entry = TapeEntry();
+  return entry;
+}
+
+auto
+GradientTape::save(const uint8_t reg, const FeatureSize size) -> uint32_t
+{
+  const auto offset = numValues_;
+
+  if (isMeasuring()) {
+    numValues_ += size;
+    return offset;
+  }
+
+  const auto total = static_cast<uint32_t>(size) * batchSize_;
+  if ((offset + total) > (valuesPerSample_ * net_->batchSize)) {
+    return TapeEntry::kNotSaved;
+  }
+
+  for (uint16_t b = 0; b < batchSize_; b++) {
+    memcpy(values_ + offset + static_cast<uint32_t>(b) * size, runner_.getRegister(reg, b), size * sizeof(float));
+  }
+
+  numValues_ += total;
+
+  return offset;
+}
+
+void
+GradientTape::beginAssignment(const uint8_t dstReg)
+{
+  currentReg_ = dstReg;
+  runner_.beginAssignment(dstReg);
+}
+
+void
+GradientTape::interpret(const LinearExpr& expr)
+{
+  auto* entry = beginEntry();
+
+  const auto left = save(expr.inRegister, expr.inFeatures);
+
+  if (!isMeasuring()) {
+    runner_.interpret(expr);
+  }
+
+  sizes_[currentReg_] = expr.outFeatures;
+
+  const auto output =
+    (expr.activation != Activation::kNone) ? save(currentReg_, expr.outFeatures) : TapeEntry::kNotSaved;
+
+  if (entry) {
+    entry->left = left;
+    entry->output = output;
+    entry->parameters = parameterOffset_;
+    entry->leftSize = expr.inFeatures;
+    entry->outputSize = expr.outFeatures;
+  }
+
+  parameterOffset_ += linearParameterCount(expr.inFeatures, expr.outFeatures, net_->weightLayout);
+}
+
+void
+GradientTape::interpret(const MatMulExpr& expr)
+{
+  auto* entry = beginEntry();
+
+  const auto lSize = sizes_[expr.leftOpReg];
+  const auto rSize = sizes_[expr.rightOpReg];
+  const uint32_t m = expr.leftRows;
+  const uint32_t k = (m > 0) ? (lSize / m) : 0;
+  const uint32_t n = (k > 0) ? (rSize / k) : 0;
+  const auto outSize = static_cast<FeatureSize>(m * n);
+
+  const auto left = save(expr.leftOpReg, lSize);
+  const auto right = save(expr.rightOpReg, rSize);
+
+  if (!isMeasuring()) {
+    runner_.interpret(expr);
+  }
+
+  sizes_[currentReg_] = outSize;
+
+  const auto output = (expr.activation != Activation::kNone) ? save(currentReg_, outSize) : TapeEntry::kNotSaved;
+
+  if (entry) {
+    entry->left = left;
+    entry->right = right;
+    entry->output = output;
+    entry->leftSize = lSize;
+    entry->rightSize = rSize;
+    entry->outputSize = outSize;
+  }
+}
+
+void
+GradientTape::interpret(const ConcatExpr& expr)
+{
+  auto* entry = beginEntry();
+
+  const auto lSize = sizes_[expr.leftOpReg];
+  const auto rSize = sizes_[expr.rightOpReg];
+  const auto outSize = static_cast<FeatureSize>(lSize + rSize);
+
+  if (!isMeasuring()) {
+    runner_.interpret(expr);
+  }
+
+  sizes_[currentReg_] = outSize;
+
+  const auto output = (expr.activation != Activation::kNone) ? save(currentReg_, outSize) : TapeEntry::kNotSaved;
+
+  if (entry) {
+    entry->output = output;
+    entry->leftSize = lSize;
+    entry->rightSize = rSize;
+    entry->outputSize = outSize;
+  }
+}
+
+void
+GradientTape::interpret(const CompAddExpr& expr)
+{
+  auto* entry = beginEntry();
+
+  const auto lSize = sizes_[expr.leftOpReg];
+  const auto rSize = sizes_[expr.rightOpReg];
+  const auto minSize = (lSize < rSize) ? lSize : rSize;
+
+  if (!isMeasuring()) {
+    runner_.interpret(expr);
+  }
+
+  sizes_[currentReg_] = minSize;
+
+  const auto output = (expr.activation != Activation::kNone) ? save(currentReg_, minSize) : TapeEntry::kNotSaved;
+
+  if (entry) {
+    entry->output = output;
+    entry->leftSize = minSize;
+    entry->rightSize = minSize;
+    entry->outputSize = minSize;
+  }
+}
+
+void
+GradientTape::interpret(const CompMulExpr& expr)
+{
+  auto* entry = beginEntry();
+
+  const auto lSize = sizes_[expr.leftOpReg];
+  const auto rSize = sizes_[expr.rightOpReg];
+  const auto minSize = (lSize < rSize) ? lSize : rSize;
+
+  const auto left = save(expr.leftOpReg, minSize);
+  const auto right = save(expr.rightOpReg, minSize);
+
+  if (!isMeasuring()) {
+    runner_.interpret(expr);
+  }
+
+  sizes_[currentReg_] = minSize;
+
+  const auto output = (expr.activation != Activation::kNone) ? save(currentReg_, minSize) : TapeEntry::kNotSaved;
+
+  if (entry) {
+    entry->left = left;
+    entry->right = right;
+    entry->output = output;
+    entry->leftSize = minSize;
+    entry->rightSize = minSize;
+    entry->outputSize = minSize;
+  }
+}
+
+void
+GradientTape::interpret(const ReLUExpr& expr)
+{
+  auto* entry = beginEntry();
+  const auto size = sizes_[expr.inRegister];
+  if (!isMeasuring()) {
+    runner_.interpret(expr);
+  }
+  sizes_[currentReg_] = size;
+  const auto output = save(currentReg_, size);
+  if (entry) {
+    entry->output = output;
+    entry->leftSize = size;
+    entry->outputSize = size;
+  }
+}
+
+void
+GradientTape::interpret(const SigmoidExpr& expr)
+{
+  auto* entry = beginEntry();
+  const auto size = sizes_[expr.inRegister];
+  if (!isMeasuring()) {
+    runner_.interpret(expr);
+  }
+  sizes_[currentReg_] = size;
+  const auto output = save(currentReg_, size);
+  if (entry) {
+    entry->output = output;
+    entry->leftSize = size;
+    entry->outputSize = size;
+  }
+}
+
+void
+GradientTape::interpret(const TanhExpr& expr)
+{
+  auto* entry = beginEntry();
+  const auto size = sizes_[expr.inRegister];
+  if (!isMeasuring()) {
+    runner_.interpret(expr);
+  }
+  sizes_[currentReg_] = size;
+  const auto output = save(currentReg_, size);
+  if (entry) {
+    entry->output = output;
+    entry->leftSize = size;
+    entry->outputSize = size;
+  }
+}
+
+template<typename ExprT>
+void
+GradientTape::runConstant(const ExprT& expr, const FeatureSize outputSize, const uint32_t numParameters)
+{
+  auto* entry = beginEntry();
+  if (!isMeasuring()) {
+    runner_.interpret(expr);
+  }
+  sizes_[currentReg_] = outputSize;
+  if (entry) {
+    entry->parameters = parameterOffset_;
+    entry->outputSize = outputSize;
+  }
+  parameterOffset_ += numParameters;
+}
+
+void
+GradientTape::interpret(const GRUExpr& expr)
+{
+  runConstant(expr, expr.hiddenSize, gruParameterCount(expr.inFeatures, expr.hiddenSize, net_->weightLayout));
+}
+
+void
+GradientTape::interpret(const Conv1DExpr& expr)
+{
+  const auto layout = net_->weightLayout;
+  runConstant(expr, expr.outChannels, conv1DParameterCount(expr.inChannels, expr.outChannels, expr.kernelSize, layout));
+}
+
+Backprop::Backprop(const Net* net, const GradientTape* tape)
+  : net_(net)
+  , tape_(tape)
+{
+}
+
+auto
+Backprop::allocMemory() -> bool
+{
+  uint32_t regFloats{};
+  uint32_t maxRegSize{};
+  for (uint8_t i = 0; i < NN_MAX_REGS; i++) {
+    regFloats += net_->regSizes[i];
+    maxRegSize = (net_->regSizes[i] > maxRegSize) ? net_->regSizes[i] : maxRegSize;
+  }
+
+  const auto batchSize = static_cast<uint32_t>(net_->batchSize);
+  const auto numFloats = (regFloats + maxRegSize) * batchSize + net_->numParameters;
+
+  memory_ = malloc(sizeof(float) * ((numFloats > 0) ? numFloats : 1));
+  if (!memory_) {
+    return false;
+  }
+
+  auto* floats = static_cast<float*>(memory_);
+  for (uint8_t i = 0; i < NN_MAX_REGS; i++) {
+    gradients_[i] = floats;
+    floats += static_cast<uint32_t>(net_->regSizes[i]) * batchSize;
+  }
+  scratch_ = floats;
+  floats += maxRegSize * batchSize;
+  parameterGradients_ = floats;
+
+  memset(memory_, 0, sizeof(float) * numFloats);
+
+  return true;
+}
+
+void
+Backprop::releaseMemory()
+{
+  free(memory_);
+  memory_ = nullptr;
+  scratch_ = nullptr;
+  parameterGradients_ = nullptr;
+  for (uint8_t i = 0; i < NN_MAX_REGS; i++) {
+    gradients_[i] = nullptr;
+  }
+}
+
+auto
+Backprop::getGradient(const uint8_t reg, const uint16_t sample) -> float*
+{
+  return gradients_[reg] + static_cast<uint32_t>(sample) * net_->regSizes[reg];
+}
+
+auto
+Backprop::getParameterGradients() const -> const float*
+{
+  return parameterGradients_;
+}
+
+void
+Backprop::zeroParameterGradients()
+{
+  memset(parameterGradients_, 0, sizeof(float) * net_->numParameters);
+}
+
+void
+Backprop::reset()
+{
+  for (uint8_t i = 0; i < NN_MAX_REGS; i++) {
+    memset(gradients_[i], 0, sizeof(float) * net_->regSizes[i] * net_->batchSize);
+  }
+  entryIndex_ = tape_->getNumEntries();
+  entry_ = nullptr;
+}
+
+void
+Backprop::beginAssignment(const uint8_t dstReg)
+{
+  currentReg_ = dstReg;
+  entry_ = (entryIndex_ > 0) ? &tape_->getEntry(--entryIndex_) : nullptr;
+}
+
+auto
+Backprop::takeGradient(const Activation activation) -> const float*
+{
+  const auto size = entry_->outputSize;
+  const auto stride = net_->regSizes[currentReg_];
+  const auto batchSize = tape_->getBatchSize();
+
+  for (uint32_t b = 0; b < batchSize; b++) {
+    auto* grad = gradients_[currentReg_] + b * stride;
+    auto* delta = scratch_ + b * size;
+    if ((activation == Activation::kNone) || (entry_->output == TapeEntry::kNotSaved)) {
+      for (uint32_t i = 0; i < size; i++) {
+        delta[i] = grad[i];
+      }
+    } else {
+      const auto* y = tape_->getValues(entry_->output + b * size);
+      for (uint32_t i = 0; i < size; i++) {
+        delta[i] = grad[i] * activationDerivative(y[i], activation);
+      }
+    }
+    memset(grad, 0, sizeof(float) * size);
+  }
+
+  return scratch_;
+}
+
+void
+Backprop::interpret(const LinearExpr& expr)
+{
+  if (!entry_) {
+    return;
+  }
+
+  const auto* delta = takeGradient(expr.activation);
+
+  const uint32_t in = expr.inFeatures;
+  const uint32_t out = expr.outFeatures;
+  const auto stride = linearRowStride(expr.inFeatures, net_->weightLayout);
+  const auto* weights = net_->parameters + entry_->parameters;
+  auto* weightGrads = parameterGradients_ + entry_->parameters;
+  auto* biasGrads = weightGrads + stride * out;
+  const auto inStride = net_->regSizes[expr.inRegister];
+
+  for (uint32_t b = 0; b < tape_->getBatchSize(); b++) {
+    const auto* dy = delta + b * out;
+    const auto* x = tape_->getValues(entry_->left + b * in);
+    auto* dx = gradients_[expr.inRegister] + b * inStride;
+    for (uint32_t i = 0; i < out; i++) {
+      const auto g = dy[i];
+      if (g == 0.0F) {
+        continue;
+      }
+      const auto* w = weights + i * stride;
+      auto* dw = weightGrads + i * stride;
+      for (uint32_t j = 0; j < in; j++) {
+        dw[j] += g * x[j];
+        dx[j] += g * w[j];
+      }
+      biasGrads[i] += g;
+    }
+  }
+}
+
+void
+Backprop::interpret(const MatMulExpr& expr)
+{
+  if (!entry_) {
+    return;
+  }
+
+  const auto* delta = takeGradient(expr.activation);
+
+  const uint32_t m = expr.leftRows;
+  const uint32_t k = (m > 0) ? (entry_->leftSize / m) : 0;
+  const uint32_t n = (k > 0) ? (entry_->rightSize / k) : 0;
+  const auto lStride = net_->regSizes[expr.leftOpReg];
+  const auto rStride = net_->regSizes[expr.rightOpReg];
+
+  for (uint32_t b = 0; b < tape_->getBatchSize(); b++) {
+    const auto* dc = delta + b * m * n;
+    const auto* a = tape_->getValues(entry_->left + b * entry_->leftSize);
+    const auto* bMat = tape_->getValues(entry_->right + b * entry_->rightSize);
+    auto* da = gradients_[expr.leftOpReg] + b * lStride;
+    auto* db = gradients_[expr.rightOpReg] + b * rStride;
+    for (uint32_t i = 0; i < m; i++) {
+      for (uint32_t p = 0; p < k; p++) {
+        float sum{};
+        for (uint32_t j = 0; j < n; j++) {
+          const auto g = dc[i * n + j];
+          sum += g * bMat[p * n + j];
+          db[p * n + j] += a[i * k + p] * g;
+        }
+        da[i * k + p] += sum;
+      }
+    }
+  }
+}
+
+void
+Backprop::interpret(const ConcatExpr& expr)
+{
+  if (!entry_) {
+    return;
+  }
+
+  const auto* delta = takeGradient(expr.activation);
+
+  const uint32_t lSize = entry_->leftSize;
+  const uint32_t rSize = entry_->rightSize;
+  const auto lStride = net_->regSizes[expr.leftOpReg];
+  const auto rStride = net_->regSizes[expr.rightOpReg];
+
+  for (uint32_t b = 0; b < tape_->getBatchSize(); b++) {
+    const auto* dc = delta + b * entry_->outputSize;
+    auto* dl = gradients_[expr.leftOpReg] + b * lStride;
+    auto* dr = gradients_[expr.rightOpReg] + b * rStride;
+    for (uint32_t i = 0; i < lSize; i++) {
+      dl[i] += dc[i];
+    }
+    for (uint32_t i = 0; i < rSize; i++) {
+      dr[i] += dc[lSize + i];
+    }
+  }
+}
+
+void
+Backprop::interpret(const CompAddExpr& expr)
+{
+  if (!entry_) {
+    return;
+  }
+
+  const auto* delta = takeGradient(expr.activation);
+
+  const uint32_t size = entry_->outputSize;
+  const auto lStride = net_->regSizes[expr.leftOpReg];
+  const auto rStride = net_->regSizes[expr.rightOpReg];
+
+  for (uint32_t b = 0; b < tape_->getBatchSize(); b++) {
+    const auto* dc = delta + b * size;
+    auto* dl = gradients_[expr.leftOpReg] + b * lStride;
+    auto* dr = gradients_[expr.rightOpReg] + b * rStride;
+    for (uint32_t i = 0; i < size; i++) {
+      dl[i] += dc[i];
+      dr[i] += dc[i];
+    }
+  }
+}
+
+void
+Backprop::interpret(const CompMulExpr& expr)
+{
+  if (!entry_) {
+    return;
+  }
+
+  const auto* delta = takeGradient(expr.activation);
+
+  const uint32_t size = entry_->outputSize;
+  const auto lStride = net_->regSizes[expr.leftOpReg];
+  const auto rStride = net_->regSizes[expr.rightOpReg];
+
+  for (uint32_t b = 0; b < tape_->getBatchSize(); b++) {
+    const auto* dc = delta + b * size;
+    const auto* l = tape_->getValues(entry_->left + b * size);
+    const auto* r = tape_->getValues(entry_->right + b * size);
+    auto* dl = gradients_[expr.leftOpReg] + b * lStride;
+    auto* dr = gradients_[expr.rightOpReg] + b * rStride;
+    for (uint32_t i = 0; i < size; i++) {
+      dl[i] += dc[i] * r[i];
+      dr[i] += dc[i] * l[i];
+    }
+  }
+}
+
+void
+Backprop::unary(const uint8_t inReg, const Activation activation)
+{
+  if (!entry_) {
+    return;
+  }
+
+  const auto* delta = takeGradient(activation);
+
+  const uint32_t size = entry_->outputSize;
+  const auto inStride = net_->regSizes[inReg];
+
+  for (uint32_t b = 0; b < tape_->getBatchSize(); b++) {
+    const auto* dy = delta + b * size;
+    auto* dx = gradients_[inReg] + b * inStride;
+    for (uint32_t i = 0; i < size; i++) {
+      dx[i] += dy[i];
+    }
+  }
+}
+
+void
+Backprop::interpret(const ReLUExpr& expr)
+{
+  unary(expr.inRegister, Activation::kReLU);
+}
+
+void
+Backprop::interpret(const SigmoidExpr& expr)
+{
+  unary(expr.inRegister, Activation::kSigmoid);
+}
+
+void
+Backprop::interpret(const TanhExpr& expr)
+{
+  unary(expr.inRegister, Activation::kTanh);
+}
+
+void
+Backprop::interpret(const GRUExpr&)
+{
+  if (entry_) {
+    // The gradient stops here, but the register still held a different value before this instruction.
+    takeGradient(Activation::kNone);
+  }
+}
+
+void
+Backprop::interpret(const Conv1DExpr&)
+{
+  if (entry_) {
+    takeGradient(Activation::kNone);
+  }
+}
+
+} // namespace NN
@@ -0,0 +1,256 @@
+#pragma once
+
+#include "NN_Interpreter.h"
+#include "NN_Net.h"
+#include "NN_NetRunner.h"
+
+#include <stdint.h>
+
+namespace NN {
+
+/**
+ * @brief What the @ref GradientTape saved for one instruction.
+ *
+ * @details The offsets are in floats from the start of the tape. Each saved value holds every sample of the batch,
+ *          one after another, so sample `b` of the left operand starts at `left + b * leftSize`.
+ * */
+struct TapeEntry final
+{
+  static constexpr uint32_t kNotSaved{ 0xffffffff };
+
+  /**
+   * @brief The left operand, or the only operand of a unary instruction.
+   * */
+  uint32_t left{ kNotSaved };
+
+  uint32_t right{ kNotSaved };
+
+  /**
+   * @brief The result, which is saved when an activation has to be differentiated.
+   * */
+  uint32_t output{ kNotSaved };
+
+  /**
+   * @brief Where the parameters of a Linear instruction start.
+   * */
+  uint32_t parameters{};
+
+  FeatureSize leftSize{};
+
+  FeatureSize rightSize{};
+
+  FeatureSize outputSize{};
+};
+
+/**
+ * @brief Runs a network forward, while saving the values that @ref Backprop needs to compute the gradients.
+ *
+ * @details Values are copied into the tape before they can be overwritten, so registers may be reused and may share
+ *          memory. Before the memory is allocated, call @ref GradientTape::reset and execute the program once, so that
+ *          the size of the tape is known. That pass does not run the network. The same program has to be executed
+ *          afterwards.
+ * */
+class GradientTape final : public Interpreter
+{
+public:
+  explicit GradientTape(const Net* net);
+
+  /**
+   * @brief Allocates the tape, with room for the batch size of the network.
+   *
+   * @return True on success, false on failure.
+   * */
+  [[nodiscard]] auto allocMemory() -> bool;
+
+  void releaseMemory();
+
+  [[nodiscard]] auto getRegister(uint8_t reg, uint16_t sample) -> float*;
+
+  /**
+   * @brief Sets the number of samples to run. This can not exceed the batch size of the network.
+   * */
+  void setBatchSize(uint16_t batchSize);
+
+  [[nodiscard]] auto getBatchSize() const -> uint16_t;
+
+  /**
+   * @brief Clears the tape. Call this before running the program.
+   * */
+  void reset();
+
+  [[nodiscard]] auto getNumEntries() const -> InstrIndex;
+
+  [[nodiscard]] auto getEntry(InstrIndex index) const -> const TapeEntry&;
+
+  [[nodiscard]] auto getValues(uint32_t offset) const -> const float*;
+
+  void beginAssignment(uint8_t dstReg) override;
+
+  void interpret(const LinearExpr& expr) override;
+
+  void interpret(const MatMulExpr& expr) override;
+
+  void interpret(const ConcatExpr& expr) override;
+
+  void interpret(const CompAddExpr& expr) override;
+
+  void interpret(const CompMulExpr& expr) override;
+
+  void interpret(const ReLUExpr& expr) override;
+
+  void interpret(const SigmoidExpr& expr) override;
+
+  void interpret(const TanhExpr& expr) override;
+
+  void interpret(const GRUExpr& expr) override;
+
+  void interpret(const Conv1DExpr& expr) override;
+
+protected:
+  /**
+   * @brief Starts the entry of the current instruction.
+   *
+   * @return The entry, or a null pointer if the tape is only being measured.
+   * */
+  auto beginEntry() -> TapeEntry*;
+
+  /**
+   * @brief Copies the first values of each sample of a register to the end of the tape.
+   *
+   * @return The offset of the copy.
+   * */
+  auto save(uint8_t reg, FeatureSize size) -> uint32_t;
+
+  [[nodiscard]] auto isMeasuring() const -> bool;
+
+  /**
+   * @brief Runs an instruction that gradients do not flow through, which only needs an entry to keep the tape in step
+   *        with the program.
+   * */
+  template<typename ExprT>
+  void runConstant(const ExprT& expr, FeatureSize outputSize, uint32_t numParameters);
+
+private:
+  NetRunner runner_;
+
+  const Net* net_{};
+
+  uint16_t batchSize_{ 1 };
+
+  uint8_t currentReg_{};
+
+  /**
+   * @brief The number of values per sample written to each register so far, as tracked by @ref NetRunner.
+   * */
+  FeatureSize sizes_[NN_MAX_REGS]{};
+
+  uint32_t parameterOffset_{};
+
+  TapeEntry* entries_{};
+
+  InstrIndex numEntries_{};
+
+  InstrIndex maxEntries_{};
+
+  float* values_{};
+
+  uint32_t numValues_{};
+
+  /**
+   * @brief The number of values per sample that the measuring pass found.
+   * */
+  uint32_t valuesPerSample_{};
+};
+
+/**
+ * @brief Computes the gradients of a loss with respect to the registers and the parameters of a network.
+ *
+ * @details After running the program forward through a @ref GradientTape, write the gradient of the loss with respect
+ *          to each output into @ref Backprop::getGradient, then run the program backwards with @ref reverseExec. The
+ *          parameter gradients are added to the ones from earlier passes until they are cleared.
+ *
+ *          GRU and Conv1D are run forward, but they are treated as constants: no gradient flows through them to their
+ *          input, and the gradients of their parameters stay zero. Training through time would need the state of
+ *          every earlier run.
+ * */
+class Backprop final : public Interpreter
+{
+public:
+  Backprop(const Net* net, const GradientTape* tape);
+
+  [[nodiscard]] auto allocMemory() -> bool;
+
+  void releaseMemory();
+
+  /**
+   * @brief Gets the gradient of the loss with respect to one sample of a register.
+   * */
+  [[nodiscard]] auto getGradient(uint8_t reg, uint16_t sample) -> float*;
+
+  /**
+   * @brief Gets the gradient of the loss with respect to each parameter, in the same layout as the parameters.
+   * */
+  [[nodiscard]] auto getParameterGradients() const -> const float*;
+
+  void zeroParameterGradients();
+
+  /**
+   * @brief Clears the register gradients. Call this before writing the gradients of the outputs.
+   * */
+  void reset();
+
+  void beginAssignment(uint8_t dstReg) override;
+
+  void interpret(const LinearExpr& expr) override;
+
+  void interpret(const MatMulExpr& expr) override;
+
+  void interpret(const ConcatExpr& expr) override;
+
+  void interpret(const CompAddExpr& expr) override;
+
+  void interpret(const CompMulExpr& expr) override;
+
+  void interpret(const ReLUExpr& expr) override;
+
+  void interpret(const SigmoidExpr& expr) override;
+
+  void interpret(const TanhExpr& expr) override;
+
+  void interpret(const GRUExpr& expr) override;
+
+  void interpret(const Conv1DExpr& expr) override;
+
+protected:
+  /**
+   * @brief Moves the gradient of the current register into the scratch buffer and clears it, since the register held
+   *        a different value before this instruction. The gradient is then multiplied by the derivative of the
+   *        activation.
+   *
+   * @return The gradient, with `outputSize` values per sample.
+   * */
+  auto takeGradient(Activation activation) -> const float*;
+
+  void unary(uint8_t inReg, Activation activation);
+
+private:
+  const Net* net_{};
+
+  const GradientTape* tape_{};
+
+  uint8_t currentReg_{};
+
+  InstrIndex entryIndex_{};
+
+  const TapeEntry* entry_{};
+
+  float* gradients_[NN_MAX_REGS]{};
+
+  float* parameterGradients_{};
+
+  float* scratch_{};
+
+  void* memory_{};
+};
+
+} // namespace NN
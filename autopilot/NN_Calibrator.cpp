@@ -0,0 +1,250 @@
+#include "NN_Calibrator.h"
+
+#include "NN_Kernels.h"
+
+#include <stdlib.h>
+
+namespace NN {
+
+void
+ValueRange::include(const float value)
+{
+  if (!observed) {
+    minValue = value;
+    maxValue = value;
+    observed = true;
+    return;
+  }
+  minValue = (value < minValue) ? value : minValue;
+  maxValue = (value > maxValue) ? value : maxValue;
+}
+
+auto
+ValueRange::getInt8Scale() const -> float
+{
+  const auto lo = (minValue < 0.0F) ? -minValue : minValue;
+  const auto hi = (maxValue < 0.0F) ? -maxValue : maxValue;
+  const auto absMax = (lo > hi) ? lo : hi;
+  if (!observed || (absMax == 0.0F)) {
+    return 1.0F;
+  }
+  return absMax / 127.0F;
+}
+
+Calibrator::Calibrator(const Net* net, const InstrIndex numInstructions)
+  : net_(net)
+  , runner_(net)
+  , numInstructions_(numInstructions)
+{
+}
+
+auto
+Calibrator::allocMemory() -> bool
+{
+  if (numInstructions_ == 0) {
+    return true;
+  }
+  const auto size = sizeof(ValueRange) * static_cast<size_t>(numInstructions_) * 2;
+  outputRanges_ = static_cast<ValueRange*>(malloc(size));
+  if (!outputRanges_) {
+    return false;
+  }
+  preActivationRanges_ = outputRanges_ + numInstructions_;
+  for (uint32_t i = 0; i < static_cast<uint32_t>(numInstructions_) * 2; i++) {
+    outputRanges_[i] = ValueRange();
+  }
+  return true;
+}
+
+void
+Calibrator::releaseMemory()
+{
+  free(outputRanges_);
+  outputRanges_ = nullptr;
+  preActivationRanges_ = nullptr;
+}
+
+auto
+Calibrator::getRegister(const uint8_t reg, const uint16_t sample) -> float*
+{
+  return runner_.getRegister(reg, sample);
+}
+
+void
+Calibrator::setBatchSize(const uint16_t batchSize)
+{
+  runner_.setBatchSize(batchSize);
+  batchSize_ = (batchSize < net_->batchSize) ? batchSize : net_->batchSize;
+}
+
+void
+Calibrator::reset()
+{
+  runner_.reset();
+  written_ = 0;
+  instruction_ = 0;
+}
+
+auto
+Calibrator::getNumInstructions() const -> InstrIndex
+{
+  return numInstructions_;
+}
+
+auto
+Calibrator::getInputRange(const uint8_t reg) const -> ValueRange
+{
+  return inputRanges_[reg];
+}
+
+auto
+Calibrator::getOutputRange(const InstrIndex instruction) const -> ValueRange
+{
+  return outputRanges_[instruction];
+}
+
+auto
+Calibrator::getPreActivationRange(const InstrIndex instruction) const -> ValueRange
+{
+  return preActivationRanges_[instruction];
+}
+
+void
+Calibrator::beginAssignment(const uint8_t dstReg)
+{
+  currentReg_ = dstReg;
+  runner_.beginAssignment(dstReg);
+}
+
+void
+Calibrator::interpret(const LinearExpr& expr)
+{
+  observeInput(expr.inRegister);
+  LinearExpr plainExpr = expr;
+  plainExpr.activation = Activation::kNone;
+  run(plainExpr, expr.activation);
+}
+
+void
+Calibrator::interpret(const MatMulExpr& expr)
+{
+  runBinary(expr);
+}
+
+void
+Calibrator::interpret(const ConcatExpr& expr)
+{
+  runBinary(expr);
+}
+
+void
+Calibrator::interpret(const CompAddExpr& expr)
+{
+  runBinary(expr);
+}
+
+void
+Calibrator::interpret(const CompMulExpr& expr)
+{
+  runBinary(expr);
+}
+
+void
+Calibrator::interpret(const ReLUExpr& expr)
+{
+  observeInput(expr.inRegister);
+  run(expr, Activation::kNone);
+}
+
+void
+Calibrator::interpret(const SigmoidExpr& expr)
+{
+  observeInput(expr.inRegister);
+  run(expr, Activation::kNone);
+}
+
+void
+Calibrator::interpret(const TanhExpr& expr)
+{
+  observeInput(expr.inRegister);
+  run(expr, Activation::kNone);
+}
+
+void
+Calibrator::interpret(const GRUExpr& expr)
+{
+  observeInput(expr.inRegister);
+  run(expr, Activation::kNone);
+}
+
+void
+Calibrator::interpret(const Conv1DExpr& expr)
+{
+  observeInput(expr.inRegister);
+  run(expr, Activation::kNone);
+}
+
+template<typename ExprT>
+void
+Calibrator::runBinary(const ExprT& expr)
+{
+  observeInput(expr.leftOpReg);
+  observeInput(expr.rightOpReg);
+  ExprT plainExpr = expr;
+  plainExpr.activation = Activation::kNone;
+  run(plainExpr, expr.activation);
+}
+
+template<typename ExprT>
+void
+Calibrator::run(const ExprT& plainExpr, const Activation activation)
+{
+  if (instruction_ >= numInstructions_) {
+    return;
+  }
+
+  runner_.interpret(plainExpr);
+
+  observe(&preActivationRanges_[instruction_]);
+
+  const auto size = runner_.getRegisterSize(currentReg_);
+  for (uint16_t b = 0; b < batchSize_; b++) {
+    auto* values = runner_.getRegister(currentReg_, b);
+    activate(values, values, size, activation, net_->activationMode);
+  }
+
+  observe(&outputRanges_[instruction_]);
+
+  written_ |= regBit(currentReg_);
+
+  instruction_++;
+}
+
+void
+Calibrator::observeInput(const uint8_t reg)
+{
+  if (written_ & regBit(reg)) {
+    return;
+  }
+  const auto size = net_->regSizes[reg];
+  for (uint16_t b = 0; b < batchSize_; b++) {
+    const auto* values = runner_.getRegister(reg, b);
+    for (FeatureSize i = 0; i < size; i++) {
+      inputRanges_[reg].include(values[i]);
+    }
+  }
+}
+
+void
+Calibrator::observe(ValueRange* range)
+{
+  const auto size = runner_.getRegisterSize(currentReg_);
+  for (uint16_t b = 0; b < batchSize_; b++) {
+    const auto* values = runner_.getRegister(currentReg_, b);
+    for (FeatureSize i = 0; i < size; i++) {
+      range->include(values[i]);
+    }
+  }
+}
+
+} // namespace NN
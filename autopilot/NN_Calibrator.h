@@ -0,0 +1,154 @@
+#pragma once
+
+#include "NN_Interpreter.h"
+#include "NN_Net.h"
+#include "NN_NetRunner.h"
+
+#include <stdint.h>
+
+namespace NN {
+
+/**
+ * @brief The smallest and largest value that was observed somewhere in a network.
+ * */
+struct ValueRange final
+{
+  float minValue{};
+
+  float maxValue{};
+
+  /**
+   * @brief Whether or not any value was observed.
+   * */
+  bool observed{ false };
+
+  void include(float value);
+
+  /**
+   * @brief Gets the scale that maps this range onto [-127, 127].
+   *
+   * @return The scale, or one if the range is empty or zero.
+   * */
+  [[nodiscard]] auto getInt8Scale() const -> float;
+};
+
+/**
+ * @brief Runs a float network while recording the range of every value it computes.
+ *
+ * @details The ranges are recorded per instruction, so that a register that is assigned more than once gets a range
+ *          for each assignment. For instructions with a fused activation, the range before the activation is recorded
+ *          as well. Registers that are read before they are written are the inputs, and their ranges are recorded per
+ *          register.
+ *
+ *          To calibrate, call @ref Calibrator::reset, write the sample inputs and execute the program. Repeat with as
+ *          many samples as needed. The ranges accumulate across runs.
+ * */
+class Calibrator final : public Interpreter
+{
+public:
+  Calibrator(const Net* net, InstrIndex numInstructions);
+
+  /**
+   * @brief Attempts to allocate space for the ranges of each instruction.
+   *
+   * @return True on success, false on failure.
+   * */
+  [[nodiscard]] auto allocMemory() -> bool;
+
+  void releaseMemory();
+
+  [[nodiscard]] auto getRegister(uint8_t reg, uint16_t sample) -> float*;
+
+  /**
+   * @brief Sets the number of samples that are run at once. See @ref NetRunner::setBatchSize.
+   * */
+  void setBatchSize(uint16_t batchSize);
+
+  /**
+   * @brief Prepares for another run of the program. The recorded ranges are kept.
+   * */
+  void reset();
+
+  [[nodiscard]] auto getNumInstructions() const -> InstrIndex;
+
+  [[nodiscard]] auto getInputRange(uint8_t reg) const -> ValueRange;
+
+  /**
+   * @brief Gets the range of the result of an instruction, after its activation.
+   * */
+  [[nodiscard]] auto getOutputRange(InstrIndex instruction) const -> ValueRange;
+
+  /**
+   * @brief Gets the range of the result of an instruction, before its activation.
+   * */
+  [[nodiscard]] auto getPreActivationRange(InstrIndex instruction) const -> ValueRange;
+
+  void beginAssignment(uint8_t dstReg) override;
+
+  void interpret(const LinearExpr&) override;
+
+  void interpret(const MatMulExpr&) override;
+
+  void interpret(const ConcatExpr&) override;
+
+  void interpret(const CompAddExpr&) override;
+
+  void interpret(const CompMulExpr&) override;
+
+  void interpret(const ReLUExpr&) override;
+
+  void interpret(const SigmoidExpr&) override;
+
+  void interpret(const TanhExpr&) override;
+
+  void interpret(const GRUExpr&) override;
+
+  void interpret(const Conv1DExpr&) override;
+
+protected:
+  /**
+   * @brief Runs an expression that has had its activation removed, then applies the activation, recording the range
+   *        before and after.
+   * */
+  template<typename ExprT>
+  void run(const ExprT& plainExpr, Activation activation);
+
+  template<typename ExprT>
+  void runBinary(const ExprT& expr);
+
+  void observeInput(uint8_t reg);
+
+  void observe(ValueRange* range);
+
+private:
+  const Net* net_{};
+
+  NetRunner runner_;
+
+  InstrIndex numInstructions_{};
+
+  /**
+   * @brief The range of each instruction after its activation.
+   * */
+  ValueRange* outputRanges_{};
+
+  /**
+   * @brief The range of each instruction before its activation.
+   * */
+  ValueRange* preActivationRanges_{};
+
+  ValueRange inputRanges_[NN_MAX_REGS]{};
+
+  /**
+   * @brief One bit per register, set once the register is written in the current run.
+   * */
+  RegMask written_{};
+
+  uint16_t batchSize_{ 1 };
+
+  InstrIndex instruction_{};
+
+  uint8_t currentReg_{};
+};
+
+} // namespace NN
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief Whether the program text, the feature counts and the register masks use wide integers.
+ *
+ * @details The compact mode is meant for the boards. It limits the program text to 64 KiB, registers to 65535 floats
+ *          and a program to 16 registers, which keeps every structure that holds a size or an offset small. The wide
+ *          mode is meant for desktops, where the critics and value networks used in training are far larger than the
+ *          network that runs on the boat. It is set for the whole library, since it changes the layout of the
+ *          structures in the headers. The CMake option ARC_AUTOPILOT_WIDE_INDEX sets it.
+ * */
+#ifndef NN_WIDE_INDEX
+#define NN_WIDE_INDEX 0
+#endif
+
+/**
+ * @brief The number of registers that a program can use. This can not be more than the number of bits in
+ *        @ref NN::RegMask.
+ * */
+#ifndef NN_MAX_REGS
+#if NN_WIDE_INDEX
+#define NN_MAX_REGS 64
+#else
+#define NN_MAX_REGS 16
+#endif
+#endif
+
+namespace NN {
+
+#if NN_WIDE_INDEX
+
+/**
+ * @brief The type of sizes and offsets in the program text.
+ * */
+using SourceSize = uint32_t;
+
+/**
+ * @brief The type of the number of floats in a register, and of the features of a layer.
+ * */
+using FeatureSize = uint32_t;
+
+/**
+ * @brief The type of the number of instructions in a program, and of the index of an instruction.
+ *
+ * @details Every instruction takes more than one byte of source, so this is never smaller than @ref SourceSize.
+ * */
+using InstrIndex = uint32_t;
+
+/**
+ * @brief A set of registers, one bit per register.
+ * */
+using RegMask = uint64_t;
+
+#else
+
+using SourceSize = uint16_t;
+
+using FeatureSize = uint16_t;
+
+using InstrIndex = uint16_t;
+
+using RegMask = uint32_t;
+
+#endif
+
+static_assert(NN_MAX_REGS <= (sizeof(RegMask) * 8), "NN_MAX_REGS does not fit in a register mask.");
+
+/**
+ * @brief The longest program text, in bytes.
+ * */
+constexpr SourceSize maxSourceSize = static_cast<SourceSize>(~static_cast<SourceSize>(0));
+
+/**
+ * @brief The largest number of floats that a register can hold.
+ * */
+constexpr FeatureSize maxFeatures = static_cast<FeatureSize>(~static_cast<FeatureSize>(0));
+
+/**
+ * @brief The largest number of instructions in a program.
+ * */
+constexpr InstrIndex maxInstructions = static_cast<InstrIndex>(~static_cast<InstrIndex>(0));
+
+static_assert(sizeof(InstrIndex) >= sizeof(SourceSize), "A program can have more instructions than InstrIndex holds.");
+
+/**
+ * @brief Gets the mask of a single register.
+ * */
+constexpr auto
+regBit(const uint8_t reg) -> RegMask
+{
+  return static_cast<RegMask>(1) << reg;
+}
+
+} // namespace NN
@@ -0,0 +1,325 @@
+#include "NN_CostModel.h"
+
+#include "NN_Liveness.h"
+
+namespace NN {
+
+namespace {
+
+auto
+makeTable(const uint32_t clockHz,
+          const float instructionCycles,
+          const float macCycles,
+          const float elementCycles,
+          const float reluCycles,
+          const float sigmoidCycles,
+          const float tanhCycles) -> CostTable
+{
+  CostTable table;
+  table.clockHz = clockHz;
+  table.instructionCycles = instructionCycles;
+  table.macCycles = macCycles;
+  table.elementCycles = elementCycles;
+  table.reluCycles = reluCycles;
+  table.sigmoidCycles = sigmoidCycles;
+  table.tanhCycles = tanhCycles;
+  return table;
+}
+
+/**
+ * @brief Fitted to the BM_Run benchmarks of each instruction and to BM_DDPGComputeAction. Most of the time of a small
+ *        network is spent dispatching instructions.
+ * */
+const CostTable desktopTable = makeTable(3000000000U, 250.0F, 0.35F, 1.0F, 0.7F, 6.0F, 8.0F);
+
+/**
+ * @brief Software floats take about 50 cycles for an add and 40 for a multiply. The activations are a polynomial of
+ *        about a dozen operations, and sigmoid and tanh add a software division.
+ * */
+const CostTable cortexM0PlusTable = makeTable(48000000U, 300.0F, 100.0F, 60.0F, 15.0F, 1100.0F, 1200.0F);
+
+/**
+ * @brief A fused multiply-add takes three cycles and two loads, and a division takes fourteen.
+ * */
+const CostTable cortexM4FTable = makeTable(120000000U, 150.0F, 4.0F, 5.0F, 4.0F, 45.0F, 50.0F);
+
+} // namespace
+
+auto
+getCostTable(const CostTarget target) -> const CostTable&
+{
+  switch (target) {
+    case CostTarget::kDesktop:
+      break;
+    case CostTarget::kCortexM0Plus:
+      return cortexM0PlusTable;
+    case CostTarget::kCortexM4F:
+      return cortexM4FTable;
+  }
+  return desktopTable;
+}
+
+CostModel::CostModel(const CostTable& table, const WeightLayout weightLayout)
+  : table_(&table)
+  , weightLayout_(weightLayout)
+{
+}
+
+void
+CostModel::setInputSize(const uint8_t reg, const FeatureSize size)
+{
+  regSizes_[reg] = size;
+}
+
+void
+CostModel::setLiveness(const Liveness* liveness)
+{
+  liveness_ = liveness;
+}
+
+auto
+CostModel::getMacs() const -> uint64_t
+{
+  return macs_;
+}
+
+auto
+CostModel::getTranscendentals() const -> uint64_t
+{
+  return transcendentals_;
+}
+
+auto
+CostModel::getElementOps() const -> uint64_t
+{
+  return elementOps_;
+}
+
+auto
+CostModel::getParameterBytes() const -> uint64_t
+{
+  return parameters_ * sizeof(float);
+}
+
+auto
+CostModel::getActivationBytes() const -> uint64_t
+{
+  uint64_t peak{};
+
+  if (!liveness_) {
+    for (uint8_t r = 0; r < NN_MAX_REGS; r++) {
+      peak += regSizes_[r];
+    }
+    return peak * sizeof(float);
+  }
+
+  // The inputs are live at instruction zero, before the program starts.
+  for (uint32_t i = 0; i <= numInstructions_; i++) {
+    uint64_t live{};
+    for (uint8_t r = 0; r < NN_MAX_REGS; r++) {
+      const auto interval = liveness_->getInterval(r);
+      if (interval.used && (interval.begin <= i) && (i <= interval.end)) {
+        live += regSizes_[r];
+      }
+    }
+    peak = (live > peak) ? live : peak;
+  }
+
+  return peak * sizeof(float);
+}
+
+auto
+CostModel::getStateBytes() const -> uint64_t
+{
+  return state_ * sizeof(float);
+}
+
+auto
+CostModel::getWorkingBytes() const -> uint64_t
+{
+  return getActivationBytes() + getStateBytes();
+}
+
+auto
+CostModel::getCycles() const -> float
+{
+  return cycles_;
+}
+
+auto
+CostModel::getMicroseconds() const -> float
+{
+  return cycles_ / (static_cast<float>(table_->clockHz) * 1.0e-6F);
+}
+
+auto
+CostModel::hasShapeError() const -> bool
+{
+  return shapeError_;
+}
+
+void
+CostModel::beginAssignment(const uint8_t dstReg)
+{
+  dstReg_ = dstReg;
+  numInstructions_++;
+  cycles_ += table_->instructionCycles;
+}
+
+void
+CostModel::interpret(const LinearExpr& expr)
+{
+  const auto macs = static_cast<uint64_t>(expr.inFeatures) * expr.outFeatures;
+  macs_ += macs;
+  cycles_ += static_cast<float>(macs) * table_->macCycles;
+  parameters_ += linearParameterCount(expr.inFeatures, expr.outFeatures, weightLayout_);
+  activate(expr.activation, expr.outFeatures);
+  define(expr.outFeatures);
+}
+
+void
+CostModel::interpret(const MatMulExpr& expr)
+{
+  const uint64_t lSize = regSizes_[expr.leftOpReg];
+  const uint64_t rSize = regSizes_[expr.rightOpReg];
+  const uint64_t m = expr.leftRows;
+  const auto k = ((m > 0) && ((lSize % m) == 0)) ? (lSize / m) : 0;
+  if ((k == 0) || ((rSize % k) != 0)) {
+    shapeError_ = true;
+    return;
+  }
+
+  const auto n = rSize / k;
+  const auto macs = m * k * n;
+  macs_ += macs;
+  cycles_ += static_cast<float>(macs) * table_->macCycles;
+  activate(expr.activation, m * n);
+  define(m * n);
+}
+
+void
+CostModel::interpret(const ConcatExpr& expr)
+{
+  const auto size = static_cast<uint64_t>(regSizes_[expr.leftOpReg]) + regSizes_[expr.rightOpReg];
+  elementWise(expr, size, size);
+}
+
+void
+CostModel::interpret(const CompAddExpr& expr)
+{
+  const auto lSize = regSizes_[expr.leftOpReg];
+  const auto rSize = regSizes_[expr.rightOpReg];
+  const auto size = (lSize < rSize) ? lSize : rSize;
+  elementWise(expr, size, size);
+}
+
+void
+CostModel::interpret(const CompMulExpr& expr)
+{
+  const auto lSize = regSizes_[expr.leftOpReg];
+  const auto rSize = regSizes_[expr.rightOpReg];
+  const auto size = (lSize < rSize) ? lSize : rSize;
+  elementWise(expr, size, size);
+}
+
+void
+CostModel::interpret(const ReLUExpr& expr)
+{
+  activate(Activation::kReLU, regSizes_[expr.inRegister]);
+  define(regSizes_[expr.inRegister]);
+}
+
+void
+CostModel::interpret(const SigmoidExpr& expr)
+{
+  activate(Activation::kSigmoid, regSizes_[expr.inRegister]);
+  define(regSizes_[expr.inRegister]);
+}
+
+void
+CostModel::interpret(const TanhExpr& expr)
+{
+  activate(Activation::kTanh, regSizes_[expr.inRegister]);
+  define(regSizes_[expr.inRegister]);
+}
+
+void
+CostModel::interpret(const GRUExpr& expr)
+{
+  const uint64_t h = expr.hiddenSize;
+  const auto macs = (static_cast<uint64_t>(expr.inFeatures) + h) * 3 * h;
+  macs_ += macs;
+  cycles_ += static_cast<float>(macs) * table_->macCycles;
+  parameters_ += gruParameterCount(expr.inFeatures, expr.hiddenSize, weightLayout_);
+  state_ += h;
+  activate(Activation::kSigmoid, 2 * h);
+  activate(Activation::kTanh, h);
+  // Adding the two sets of gates, the reset gate and the interpolation of the new state.
+  elementOps_ += 6 * h;
+  cycles_ += static_cast<float>(6 * h) * table_->elementCycles;
+  define(h);
+}
+
+void
+CostModel::interpret(const Conv1DExpr& expr)
+{
+  const auto window = static_cast<uint64_t>(expr.kernelSize) * expr.inChannels;
+  if (window > maxFeatures) {
+    shapeError_ = true;
+    return;
+  }
+  const auto macs = window * expr.outChannels;
+  macs_ += macs;
+  cycles_ += static_cast<float>(macs) * table_->macCycles;
+  parameters_ += conv1DParameterCount(expr.inChannels, expr.outChannels, expr.kernelSize, weightLayout_);
+  // The last kernelSize inputs.
+  state_ += window;
+  // Moving the window along by one input.
+  elementOps_ += window;
+  cycles_ += static_cast<float>(window) * table_->elementCycles;
+  define(expr.outChannels);
+}
+
+void
+CostModel::activate(const Activation activation, const uint64_t numValues)
+{
+  const auto values = static_cast<float>(numValues);
+  switch (activation) {
+    case Activation::kNone:
+      break;
+    case Activation::kReLU:
+      elementOps_ += numValues;
+      cycles_ += values * table_->reluCycles;
+      break;
+    case Activation::kSigmoid:
+      transcendentals_ += numValues;
+      cycles_ += values * table_->sigmoidCycles;
+      break;
+    case Activation::kTanh:
+      transcendentals_ += numValues;
+      cycles_ += values * table_->tanhCycles;
+      break;
+  }
+}
+
+void
+CostModel::elementWise(const BinaryExpr& expr, const uint64_t outSize, const uint64_t numElementOps)
+{
+  elementOps_ += numElementOps;
+  cycles_ += static_cast<float>(numElementOps) * table_->elementCycles;
+  activate(expr.activation, outSize);
+  define(outSize);
+}
+
+void
+CostModel::define(const uint64_t size)
+{
+  if (size > maxFeatures) {
+    shapeError_ = true;
+    return;
+  }
+  // Registers keep their largest size, the same as in the network builder.
+  regSizes_[dstReg_] = (regSizes_[dstReg_] < size) ? static_cast<FeatureSize>(size) : regSizes_[dstReg_];
+}
+
+} // namespace NN
@@ -0,0 +1,198 @@
+#pragma once
+
+#include "NN_Interpreter.h"
+#include "NN_Net.h"
+
+#include <stdint.h>
+
+namespace NN {
+
+class Liveness;
+
+/**
+ * @brief The approximate cost of each kind of work on one target, in clock cycles.
+ *
+ * @details These are averages over the inner loops of the kernels, including the loads and stores. They are meant for
+ *          telling whether a network fits in a control loop, not for comparing two kernels.
+ * */
+struct CostTable final
+{
+  /**
+   * @brief The clock frequency of the target, for converting cycles to time.
+   * */
+  uint32_t clockHz{};
+
+  /**
+   * @brief The fixed cost of dispatching one instruction.
+   * */
+  float instructionCycles{};
+
+  /**
+   * @brief Each multiply-accumulate of Linear and MatMul.
+   * */
+  float macCycles{};
+
+  /**
+   * @brief Each value of an element-wise add, multiply or copy.
+   * */
+  float elementCycles{};
+
+  float reluCycles{};
+
+  float sigmoidCycles{};
+
+  float tanhCycles{};
+};
+
+enum class CostTarget : uint8_t
+{
+  /**
+   * @brief A 3 GHz x86-64 core with AVX2.
+   * */
+  kDesktop,
+
+  /**
+   * @brief A 48 MHz Cortex-M0+, which has no FPU, so every float operation is done in software.
+   * */
+  kCortexM0Plus,
+
+  /**
+   * @brief A 120 MHz Cortex-M4F, with a single precision FPU.
+   * */
+  kCortexM4F
+};
+
+/**
+ * @brief Gets the cost table of a target, for the precise activations.
+ * */
+[[nodiscard]] auto
+getCostTable(CostTarget target) -> const CostTable&;
+
+/**
+ * @brief Estimates the work, memory and time of a program without running it.
+ *
+ * @details Register sizes are tracked the same way as by @ref NetBuilder, so the sizes of the inputs have to be set
+ *          first. All of the numbers are for a single sample.
+ * */
+class CostModel final : public Interpreter
+{
+public:
+  explicit CostModel(const CostTable& table, WeightLayout weightLayout = WeightLayout::kPacked);
+
+  void setInputSize(uint8_t reg, FeatureSize size);
+
+  /**
+   * @brief Uses the live intervals of a liveness analysis of the same program for the activation memory.
+   *
+   * @details Without this, every register is taken to be live for the whole program, which is how a network is
+   *          allocated when the offsets are not assigned. The liveness has to outlive this object.
+   * */
+  void setLiveness(const Liveness* liveness);
+
+  [[nodiscard]] auto getMacs() const -> uint64_t;
+
+  /**
+   * @brief Gets the number of sigmoid and tanh values, which cost far more than any other element-wise operation.
+   * */
+  [[nodiscard]] auto getTranscendentals() const -> uint64_t;
+
+  /**
+   * @brief Gets the number of values that are added, multiplied, copied or passed through ReLU.
+   * */
+  [[nodiscard]] auto getElementOps() const -> uint64_t;
+
+  [[nodiscard]] auto getParameterBytes() const -> uint64_t;
+
+  /**
+   * @brief Gets the most register memory that is live at any point in the program.
+   *
+   * @details With a liveness analysis, this is a lower bound of the arena that @ref Liveness::assignOffsets lays
+   *          out. The arena can be larger when registers of different sizes leave gaps.
+   * */
+  [[nodiscard]] auto getActivationBytes() const -> uint64_t;
+
+  /**
+   * @brief Gets the memory kept by the GRU and Conv1D instructions between runs, which is never shared with a register.
+   * */
+  [[nodiscard]] auto getStateBytes() const -> uint64_t;
+
+  /**
+   * @brief Gets the memory that a run needs apart from the parameters, which is the activations and the state.
+   *
+   * @details This is what has to fit in RAM when the parameters are kept in flash.
+   * */
+  [[nodiscard]] auto getWorkingBytes() const -> uint64_t;
+
+  [[nodiscard]] auto getCycles() const -> float;
+
+  [[nodiscard]] auto getMicroseconds() const -> float;
+
+  /**
+   * @brief Gets whether the shapes of some operands did not fit together, in which case the estimate is incomplete.
+   * */
+  [[nodiscard]] auto hasShapeError() const -> bool;
+
+  void beginAssignment(uint8_t dstReg) override;
+
+  void interpret(const LinearExpr& expr) override;
+
+  void interpret(const MatMulExpr& expr) override;
+
+  void interpret(const ConcatExpr& expr) override;
+
+  void interpret(const CompAddExpr& expr) override;
+
+  void interpret(const CompMulExpr& expr) override;
+
+  void interpret(const ReLUExpr& expr) override;
+
+  void interpret(const SigmoidExpr& expr) override;
+
+  void interpret(const TanhExpr& expr) override;
+
+  void interpret(const GRUExpr& expr) override;
+
+  void interpret(const Conv1DExpr& expr) override;
+
+protected:
+  /**
+   * @brief Adds the cost of an activation over a number of values.
+   * */
+  void activate(Activation activation, uint64_t numValues);
+
+  void elementWise(const BinaryExpr& expr, uint64_t outSize, uint64_t numElementOps);
+
+  /**
+   * @brief Grows the destination register, which is a shape error if the size does not fit in @ref FeatureSize.
+   * */
+  void define(uint64_t size);
+
+private:
+  const CostTable* table_{};
+
+  WeightLayout weightLayout_{ WeightLayout::kPacked };
+
+  const Liveness* liveness_{};
+
+  FeatureSize regSizes_[NN_MAX_REGS]{};
+
+  InstrIndex numInstructions_{};
+
+  uint8_t dstReg_{};
+
+  bool shapeError_{ false };
+
+  uint64_t macs_{};
+
+  uint64_t transcendentals_{};
+
+  uint64_t elementOps_{};
+
+  uint64_t parameters_{};
+
+  uint64_t state_{};
+
+  float cycles_{};
+};
+
+} // namespace NN
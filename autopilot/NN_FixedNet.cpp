@@ -0,0 +1,241 @@
+#include "NN_FixedNet.h"
+
+#include "NN_Interpreter.h"
+#include "NN_Program.h"
+
+#include <stdlib.h>
+
+namespace NN {
+
+namespace {
+
+/**
+ * @brief The sigmoid of `-8 + i / 8`, in Q15.
+ * */
+const int16_t sigmoidTable[129]{
+  11, 12, 14, 16, 18, 21, 23, 26, 30, 34, 38, 43, 49, 56, 63, 72, 81, 92, 104, 118, 133, 151, 171, 194, 219, 248, 281,
+  318, 360, 407, 461, 521, 589, 666, 753, 851, 961, 1084, 1223, 1379, 1554, 1750, 1969, 2213, 2486, 2789, 3124, 3496,
+  3906, 4357, 4851, 5391, 5978, 6613, 7297, 8031, 8813, 9641, 10513, 11424, 12371, 13348, 14347, 15361, 16384, 17407,
+  18421, 19420, 20397, 21344, 22255, 23127, 23955, 24737, 25471, 26155, 26790, 27377, 27917, 28411, 28862, 29272,
+  29644, 29979, 30282, 30555, 30799, 31018, 31214, 31389, 31545, 31684, 31807, 31917, 32015, 32102, 32179, 32247,
+  32307, 32361, 32408, 32450, 32487, 32520, 32549, 32574, 32597, 32617, 32635, 32650, 32664, 32676, 32687, 32696,
+  32705, 32712, 32719, 32725, 32730, 32734, 32738, 32742, 32745, 32747, 32750, 32752, 32754, 32756, 32757
+};
+
+/**
+ * @brief The hyperbolic tangent of `-4 + i / 16`, in Q15.
+ * */
+const int16_t tanhTable[129]{
+  -32746, -32743, -32740, -32736, -32732, -32727, -32721, -32715, -32708, -32700, -32691, -32681, -32670, -32657,
+  -32642, -32625, -32606, -32584, -32560, -32532, -32501, -32466, -32426, -32381, -32329, -32271, -32206, -32132,
+  -32048, -31953, -31846, -31726, -31589, -31435, -31262, -31067, -30847, -30600, -30322, -30010, -29660, -29268,
+  -28830, -28341, -27797, -27191, -26519, -25776, -24956, -24054, -23066, -21986, -20813, -19542, -18173, -16706,
+  -15143, -13486, -11743, -9919, -8025, -6073, -4075, -2045, 0, 2045, 4075, 6073, 8025, 9919, 11743, 13486, 15143,
+  16706, 18173, 19542, 20813, 21986, 23066, 24054, 24956, 25776, 26519, 27191, 27797, 28341, 28830, 29268, 29660,
+  30010, 30322, 30600, 30847, 31067, 31262, 31435, 31589, 31726, 31846, 31953, 32048, 32132, 32206, 32271, 32329,
+  32381, 32426, 32466, 32501, 32532, 32560, 32584, 32606, 32625, 32642, 32657, 32670, 32681, 32691, 32700, 32708,
+  32715, 32721, 32727, 32732, 32736, 32740, 32743, 32746
+};
+
+/**
+ * @brief Interpolates a table of 129 points that starts at `-range` and has `2^stepBits` points per unit.
+ *
+ * @return The interpolated value, in Q15.
+ * */
+auto
+interpolate(const int16_t* table, const int32_t x, const uint8_t fracBits, const int32_t range, const uint8_t stepBits)
+  -> int32_t
+{
+  const int32_t t = x + (range << fracBits);
+  if (t <= 0) {
+    return table[0];
+  }
+  const int32_t position = t << stepBits;
+  const int32_t index = position >> fracBits;
+  if (index >= 128) {
+    return table[128];
+  }
+  const int32_t frac = position & ((static_cast<int32_t>(1) << fracBits) - 1);
+  return table[index] + (((table[index + 1] - table[index]) * frac) >> fracBits);
+}
+
+auto
+q15ToFixed(const int32_t x, const uint8_t fracBits) -> int16_t
+{
+  const uint8_t shift = 15 - fracBits;
+  return static_cast<int16_t>((x + ((static_cast<int32_t>(1) << shift) >> 1)) >> shift);
+}
+
+/**
+ * @brief Writes the fixed-point parameters of each linear layer.
+ *
+ * @details When no network is given, the parameters are only counted. This allows the network to be allocated with
+ *          its exact size.
+ * */
+class Converter final : public Interpreter
+{
+public:
+  Converter(const Net& net, FixedNet* fixedNet)
+    : net_(net)
+    , fixedNet_(fixedNet)
+    , floatParameters_(net.parameters)
+  {
+  }
+
+  [[nodiscard]] auto getNumWeights() const -> uint32_t { return numWeights_; }
+
+  [[nodiscard]] auto getNumRows() const -> uint32_t { return numRows_; }
+
+  void beginAssignment(uint8_t) override {}
+
+  void interpret(const LinearExpr& expr) override
+  {
+    const auto stride = linearRowStride(expr.inFeatures, net_.weightLayout);
+    const auto* bias = floatParameters_ + stride * expr.outFeatures;
+
+    if (fixedNet_) {
+      for (uint32_t row = 0; row < expr.outFeatures; row++) {
+        const auto* w = floatParameters_ + row * stride;
+        auto absMax = 0.0F;
+        for (uint32_t j = 0; j < expr.inFeatures; j++) {
+          const auto a = (w[j] < 0.0F) ? -w[j] : w[j];
+          absMax = (a > absMax) ? a : absMax;
+        }
+        uint8_t shift = 0;
+        while ((shift < 15) && (absMax >= static_cast<float>(1 << shift))) {
+          shift++;
+        }
+        const auto rowScale = static_cast<float>(1 << (15 - shift));
+        auto* qw = fixedNet_->weights + numWeights_ + row * expr.inFeatures;
+        for (uint32_t j = 0; j < expr.inFeatures; j++) {
+          const auto q = w[j] * rowScale;
+          const auto clamped = (q > 32767.0F) ? 32767.0F : ((q < -32767.0F) ? -32767.0F : q);
+          qw[j] = static_cast<int16_t>((clamped >= 0.0F) ? (clamped + 0.5F) : (clamped - 0.5F));
+        }
+        fixedNet_->biases[numRows_ + row] = toFixed(bias[row], fixedNet_->fracBits);
+        fixedNet_->rowShifts[numRows_ + row] = shift;
+      }
+    }
+
+    numWeights_ += static_cast<uint32_t>(expr.inFeatures) * expr.outFeatures;
+    numRows_ += expr.outFeatures;
+    floatParameters_ += linearParameterCount(expr.inFeatures, expr.outFeatures, net_.weightLayout);
+  }
+
+  void interpret(const MatMulExpr&) override {}
+
+  void interpret(const ConcatExpr&) override {}
+
+  void interpret(const CompAddExpr&) override {}
+
+  void interpret(const CompMulExpr&) override {}
+
+  void interpret(const ReLUExpr&) override {}
+
+  void interpret(const SigmoidExpr&) override {}
+
+  void interpret(const TanhExpr&) override {}
+
+  void interpret(const GRUExpr&) override {}
+
+  void interpret(const Conv1DExpr&) override {}
+
+private:
+  const Net& net_;
+
+  FixedNet* fixedNet_{};
+
+  const float* floatParameters_{};
+
+  uint32_t numWeights_{};
+
+  uint32_t numRows_{};
+};
+
+} // namespace
+
+auto
+FixedNet::allocMemory() -> bool
+{
+  const size_t numValues = static_cast<size_t>(numWeights) + numRows + static_cast<size_t>(arenaSize) * batchSize;
+  memory = malloc(numValues * sizeof(int16_t) + numRows);
+  if (!memory) {
+    return false;
+  }
+  weights = static_cast<int16_t*>(memory);
+  biases = weights + numWeights;
+  auto* arena = biases + numRows;
+  for (uint8_t i = 0; i < NN_MAX_REGS; i++) {
+    regs[i] = arena + static_cast<size_t>(regOffsets[i]) * batchSize;
+  }
+  rowShifts = reinterpret_cast<uint8_t*>(arena + static_cast<size_t>(arenaSize) * batchSize);
+  return true;
+}
+
+void
+FixedNet::releaseMemory()
+{
+  free(memory);
+  memory = nullptr;
+  weights = nullptr;
+  biases = nullptr;
+  rowShifts = nullptr;
+}
+
+auto
+toFixed(const float x, const uint8_t fracBits) -> int16_t
+{
+  const auto scaled = x * static_cast<float>(1 << fracBits);
+  const auto clamped = (scaled > 32767.0F) ? 32767.0F : ((scaled < -32768.0F) ? -32768.0F : scaled);
+  return static_cast<int16_t>((clamped >= 0.0F) ? (clamped + 0.5F) : (clamped - 0.5F));
+}
+
+auto
+fromFixed(const int16_t x, const uint8_t fracBits) -> float
+{
+  return static_cast<float>(x) / static_cast<float>(1 << fracBits);
+}
+
+auto
+fixedSigmoid(const int16_t x, const uint8_t fracBits) -> int16_t
+{
+  return q15ToFixed(interpolate(sigmoidTable, x, fracBits, 8, 3), fracBits);
+}
+
+auto
+fixedTanh(const int16_t x, const uint8_t fracBits) -> int16_t
+{
+  return q15ToFixed(interpolate(tanhTable, x, fracBits, 4, 4), fracBits);
+}
+
+auto
+convertToFixed(const Program& program, const Net& net, const uint8_t fracBits, FixedNet* fixedNet) -> bool
+{
+  if ((fracBits > NN_MAX_FRAC_BITS) || (net.stateSize != 0)) {
+    return false;
+  }
+
+  Converter counter(net, nullptr);
+  exec(program, counter);
+
+  fixedNet->fracBits = fracBits;
+  fixedNet->numWeights = counter.getNumWeights();
+  fixedNet->numRows = counter.getNumRows();
+  fixedNet->arenaSize = net.arenaSize;
+  fixedNet->batchSize = net.batchSize;
+  for (uint8_t i = 0; i < NN_MAX_REGS; i++) {
+    fixedNet->regSizes[i] = net.regSizes[i];
+    fixedNet->regOffsets[i] = net.regOffsets[i];
+  }
+
+  if (!fixedNet->allocMemory()) {
+    return false;
+  }
+
+  Converter writer(net, fixedNet);
+  exec(program, writer);
+
+  return true;
+}
+
+} // namespace NN
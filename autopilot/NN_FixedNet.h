@@ -0,0 +1,116 @@
+#pragma once
+
+#include "NN_Net.h"
+
+#include <stdint.h>
+
+namespace NN {
+
+struct Program;
+
+/**
+ * @brief The largest number of fractional bits that a fixed-point network can use.
+ * */
+#define NN_MAX_FRAC_BITS 14
+
+/**
+ * @brief A network stored in fixed-point, for processors without a floating point unit.
+ *
+ * @details Registers and biases are 16 bit signed values with @ref FixedNet::fracBits fractional bits. With the
+ *          default of 12, values range from -8 to 8 in steps of 1/4096. Results that fall outside of the range
+ *          saturate.
+ *
+ *          Each row of weights is stored in Q15 with its own shift, as in `w = q * 2^(shift - 15)`, where the shift is
+ *          the smallest that fits the largest weight of the row. The products of each row are accumulated in 64
+ *          bits, so that no fan-in can overflow.
+ *
+ *          The registers have the same sizes and offsets as the float network they were converted from.
+ * */
+struct FixedNet final
+{
+  uint8_t fracBits{ 12 };
+
+  uint32_t numWeights{};
+
+  /**
+   * @brief The number of rows over all of the linear layers. There is one bias and one shift per row.
+   * */
+  uint32_t numRows{};
+
+  FeatureSize regSizes[NN_MAX_REGS]{};
+
+  uint32_t regOffsets[NN_MAX_REGS]{};
+
+  uint32_t arenaSize{};
+
+  uint16_t batchSize{ 1 };
+
+  /**
+   * @brief The weights of each linear layer, in Q15, with the rows packed back to back.
+   * */
+  int16_t* weights{};
+
+  int16_t* biases{};
+
+  /**
+   * @brief The shift of each row of weights.
+   * */
+  uint8_t* rowShifts{};
+
+  int16_t* regs[NN_MAX_REGS]{};
+
+  void* memory{};
+
+  /**
+   * @brief Attempts to allocate the parameters and registers.
+   *
+   * @return True on success, false on failure.
+   * */
+  [[nodiscard]] auto allocMemory() -> bool;
+
+  void releaseMemory();
+};
+
+/**
+ * @brief Converts a value to fixed-point, rounding to the nearest value and saturating.
+ * */
+[[nodiscard]] auto
+toFixed(float x, uint8_t fracBits) -> int16_t;
+
+[[nodiscard]] auto
+fromFixed(int16_t x, uint8_t fracBits) -> float;
+
+/**
+ * @brief Computes the sigmoid of a fixed-point value.
+ *
+ * @details This interpolates between 129 points from -8 to 8, and is within 4e-4 of the exact result before the
+ *          output is rounded.
+ * */
+[[nodiscard]] auto
+fixedSigmoid(int16_t x, uint8_t fracBits) -> int16_t;
+
+/**
+ * @brief Computes the hyperbolic tangent of a fixed-point value.
+ *
+ * @details This interpolates between 129 points from -4 to 4, and is within 7e-4 of the exact result before the
+ *          output is rounded.
+ * */
+[[nodiscard]] auto
+fixedTanh(int16_t x, uint8_t fracBits) -> int16_t;
+
+/**
+ * @brief Converts a float network to fixed-point.
+ *
+ * @param program The program that the network was built from.
+ *
+ * @param fracBits The number of fractional bits of the registers, at most @ref NN_MAX_FRAC_BITS.
+ *
+ * @param fixedNet The network to write to. It has to be released with @ref FixedNet::releaseMemory.
+ *
+ * @return False if the number of fractional bits is out of range, if the network has a GRU or Conv1D, which are not
+ *         converted, or if the memory could not be allocated.
+ * */
+[[nodiscard]] auto
+convertToFixed(const Program& program, const Net& net, uint8_t fracBits, FixedNet* fixedNet) -> bool;
+
+} // namespace NN
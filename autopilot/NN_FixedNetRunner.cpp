@@ -0,0 +1,273 @@
+#include "NN_FixedNetRunner.h"
+
+namespace NN {
+
+namespace {
+
+auto
+saturate16(const int64_t x) -> int16_t
+{
+  return static_cast<int16_t>((x > 32767) ? 32767 : ((x < -32768) ? -32768 : x));
+}
+
+/**
+ * @brief Shifts right, rounding to the nearest value.
+ * */
+auto
+roundingShift(const int64_t x, const uint8_t shift) -> int64_t
+{
+  return (shift == 0) ? x : ((x + (static_cast<int64_t>(1) << (shift - 1))) >> shift);
+}
+
+auto
+fixedReLU(const int16_t x) -> int16_t
+{
+  return (x > 0) ? x : 0;
+}
+
+} // namespace
+
+FixedNetRunner::FixedNetRunner(const FixedNet* net)
+  : net_(net)
+{
+}
+
+auto
+FixedNetRunner::getRegister(const uint8_t reg, const uint16_t sample) -> int16_t*
+{
+  return net_->regs[reg] + static_cast<uint32_t>(sample) * net_->regSizes[reg];
+}
+
+void
+FixedNetRunner::setInput(const uint8_t reg, const uint16_t sample, const float* values)
+{
+  auto* output = getRegister(reg, sample);
+  for (FeatureSize i = 0; i < net_->regSizes[reg]; i++) {
+    output[i] = toFixed(values[i], net_->fracBits);
+  }
+}
+
+void
+FixedNetRunner::getOutput(const uint8_t reg, const uint16_t sample, float* values) const
+{
+  const auto* input = net_->regs[reg] + static_cast<uint32_t>(sample) * net_->regSizes[reg];
+  for (FeatureSize i = 0; i < regSizes_[reg]; i++) {
+    values[i] = fromFixed(input[i], net_->fracBits);
+  }
+}
+
+void
+FixedNetRunner::setBatchSize(const uint16_t batchSize)
+{
+  batchSize_ = (batchSize < net_->batchSize) ? batchSize : net_->batchSize;
+}
+
+void
+FixedNetRunner::reset()
+{
+  currentReg_ = 0;
+  currentWeights_ = net_->weights;
+  currentBiases_ = net_->biases;
+  currentShifts_ = net_->rowShifts;
+  for (uint8_t i = 0; i < NN_MAX_REGS; i++) {
+    regSizes_[i] = net_->regSizes[i];
+  }
+}
+
+void
+FixedNetRunner::beginAssignment(const uint8_t dstReg)
+{
+  currentReg_ = dstReg;
+}
+
+template<typename Func>
+void
+FixedNetRunner::applyUnary(const uint8_t inReg, Func func)
+{
+  const auto numFeatures = regSizes_[inReg];
+  for (uint16_t b = 0; b < batchSize_; b++) {
+    const auto* in = getRegister(inReg, b);
+    auto* out = getRegister(currentReg_, b);
+    for (FeatureSize i = 0; i < numFeatures; i++) {
+      out[i] = func(in[i]);
+    }
+  }
+  regSizes_[currentReg_] = numFeatures;
+}
+
+template<typename Func>
+void
+FixedNetRunner::applyBinary(const BinaryExpr& expr, Func func)
+{
+  const auto lSize = regSizes_[expr.leftOpReg];
+  const auto rSize = regSizes_[expr.rightOpReg];
+  const auto minSize = (lSize < rSize) ? lSize : rSize;
+  for (uint16_t b = 0; b < batchSize_; b++) {
+    const auto* leftOp = getRegister(expr.leftOpReg, b);
+    const auto* rightOp = getRegister(expr.rightOpReg, b);
+    auto* output = getRegister(currentReg_, b);
+    for (FeatureSize i = 0; i < minSize; i++) {
+      output[i] = func(leftOp[i], rightOp[i]);
+    }
+  }
+  regSizes_[currentReg_] = minSize;
+  applyFusedActivation(expr.activation);
+}
+
+void
+FixedNetRunner::applyFusedActivation(const Activation activation)
+{
+  const auto fracBits = net_->fracBits;
+  const auto size = regSizes_[currentReg_];
+  for (uint16_t b = 0; b < batchSize_; b++) {
+    auto* values = getRegister(currentReg_, b);
+    switch (activation) {
+      case Activation::kNone:
+        return;
+      case Activation::kReLU:
+        for (FeatureSize i = 0; i < size; i++) {
+          values[i] = fixedReLU(values[i]);
+        }
+        break;
+      case Activation::kSigmoid:
+        for (FeatureSize i = 0; i < size; i++) {
+          values[i] = fixedSigmoid(values[i], fracBits);
+        }
+        break;
+      case Activation::kTanh:
+        for (FeatureSize i = 0; i < size; i++) {
+          values[i] = fixedTanh(values[i], fracBits);
+        }
+        break;
+    }
+  }
+}
+
+void
+FixedNetRunner::interpret(const LinearExpr& expr)
+{
+  for (uint16_t b = 0; b < batchSize_; b++) {
+    const auto* input = getRegister(expr.inRegister, b);
+    auto* output = getRegister(currentReg_, b);
+    for (uint32_t row = 0; row < expr.outFeatures; row++) {
+      const auto* w = currentWeights_ + row * expr.inFeatures;
+      // The products are in Q(15 - shift + fracBits), so the bias is brought up to the same scale.
+      const uint8_t productShift = 15 - currentShifts_[row];
+      int64_t acc = static_cast<int64_t>(currentBiases_[row]) * (static_cast<int64_t>(1) << productShift);
+      for (uint32_t j = 0; j < expr.inFeatures; j++) {
+        acc += static_cast<int32_t>(w[j]) * static_cast<int32_t>(input[j]);
+      }
+      output[row] = saturate16(roundingShift(acc, productShift));
+    }
+  }
+
+  currentWeights_ += static_cast<uint32_t>(expr.inFeatures) * expr.outFeatures;
+  currentBiases_ += expr.outFeatures;
+  currentShifts_ += expr.outFeatures;
+
+  regSizes_[currentReg_] = expr.outFeatures;
+
+  applyFusedActivation(expr.activation);
+}
+
+void
+FixedNetRunner::interpret(const MatMulExpr& expr)
+{
+  const uint32_t m = expr.leftRows;
+  const uint32_t k = (m > 0) ? (regSizes_[expr.leftOpReg] / m) : 0;
+  const uint32_t n = (k > 0) ? (regSizes_[expr.rightOpReg] / k) : 0;
+  const auto fracBits = net_->fracBits;
+
+  for (uint16_t b = 0; b < batchSize_; b++) {
+    const auto* a = getRegister(expr.leftOpReg, b);
+    const auto* bMatrix = getRegister(expr.rightOpReg, b);
+    auto* c = getRegister(currentReg_, b);
+    for (uint32_t i = 0; i < m; i++) {
+      for (uint32_t j = 0; j < n; j++) {
+        int64_t acc = 0;
+        for (uint32_t p = 0; p < k; p++) {
+          acc += static_cast<int32_t>(a[i * k + p]) * static_cast<int32_t>(bMatrix[p * n + j]);
+        }
+        c[i * n + j] = saturate16(roundingShift(acc, fracBits));
+      }
+    }
+  }
+
+  regSizes_[currentReg_] = static_cast<FeatureSize>(m * n);
+
+  applyFusedActivation(expr.activation);
+}
+
+void
+FixedNetRunner::interpret(const ConcatExpr& expr)
+{
+  const auto lSize = regSizes_[expr.leftOpReg];
+  const auto rSize = regSizes_[expr.rightOpReg];
+
+  for (uint16_t b = 0; b < batchSize_; b++) {
+    const auto* leftOp = getRegister(expr.leftOpReg, b);
+    const auto* rightOp = getRegister(expr.rightOpReg, b);
+    auto* output = getRegister(currentReg_, b);
+    for (FeatureSize i = 0; i < lSize; i++) {
+      output[i] = leftOp[i];
+    }
+    for (FeatureSize i = 0; i < rSize; i++) {
+      output[lSize + i] = rightOp[i];
+    }
+  }
+
+  regSizes_[currentReg_] = lSize + rSize;
+
+  applyFusedActivation(expr.activation);
+}
+
+void
+FixedNetRunner::interpret(const CompAddExpr& expr)
+{
+  applyBinary(expr, [](const int16_t l, const int16_t r) -> int16_t {
+    return saturate16(static_cast<int32_t>(l) + static_cast<int32_t>(r));
+  });
+}
+
+void
+FixedNetRunner::interpret(const CompMulExpr& expr)
+{
+  const auto fracBits = net_->fracBits;
+  applyBinary(expr, [fracBits](const int16_t l, const int16_t r) -> int16_t {
+    return saturate16(roundingShift(static_cast<int32_t>(l) * static_cast<int32_t>(r), fracBits));
+  });
+}
+
+void
+FixedNetRunner::interpret(const ReLUExpr& expr)
+{
+  applyUnary(expr.inRegister, fixedReLU);
+}
+
+void
+FixedNetRunner::interpret(const SigmoidExpr& expr)
+{
+  const auto fracBits = net_->fracBits;
+  applyUnary(expr.inRegister, [fracBits](const int16_t in) -> int16_t { return fixedSigmoid(in, fracBits); });
+}
+
+void
+FixedNetRunner::interpret(const TanhExpr& expr)
+{
+  const auto fracBits = net_->fracBits;
+  applyUnary(expr.inRegister, [fracBits](const int16_t in) -> int16_t { return fixedTanh(in, fracBits); });
+}
+
+void
+FixedNetRunner::interpret(const GRUExpr&)
+{
+  // Never reached, since networks with state are not converted to fixed-point.
+}
+
+void
+FixedNetRunner::interpret(const Conv1DExpr&)
+{
+  // Never reached, since networks with state are not converted to fixed-point.
+}
+
+} // namespace NN
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "NN_FixedNet.h"
+#include "NN_Interpreter.h"
+
+#include <stdint.h>
+
+namespace NN {
+
+/**
+ * @brief Runs a network that was converted with @ref convertToFixed, using only integer arithmetic.
+ *
+ * @details This has to be driven by the same program that the network was converted from. Every operation saturates
+ *          instead of wrapping around.
+ * */
+class FixedNetRunner final : public Interpreter
+{
+public:
+  FixedNetRunner(const FixedNet* net);
+
+  [[nodiscard]] auto getRegister(uint8_t reg, uint16_t sample) -> int16_t*;
+
+  /**
+   * @brief Converts an input to fixed-point and writes it to a register.
+   *
+   * @details The number of values is the size of the register.
+   * */
+  void setInput(uint8_t reg, uint16_t sample, const float* values);
+
+  /**
+   * @brief Reads a register back as float values.
+   *
+   * @details The number of values is the size of the register.
+   * */
+  void getOutput(uint8_t reg, uint16_t sample, float* values) const;
+
+  /**
+   * @brief Sets the number of samples that each instruction is applied to. See @ref NetRunner::setBatchSize.
+   * */
+  void setBatchSize(uint16_t batchSize);
+
+  void reset();
+
+  void beginAssignment(uint8_t dstReg) override;
+
+  void interpret(const LinearExpr&) override;
+
+  void interpret(const MatMulExpr&) override;
+
+  void interpret(const ConcatExpr&) override;
+
+  void interpret(const CompAddExpr&) override;
+
+  void interpret(const CompMulExpr&) override;
+
+  void interpret(const ReLUExpr&) override;
+
+  void interpret(const SigmoidExpr&) override;
+
+  void interpret(const TanhExpr&) override;
+
+  void interpret(const GRUExpr&) override;
+
+  void interpret(const Conv1DExpr&) override;
+
+protected:
+  template<typename Func>
+  void applyUnary(uint8_t inReg, Func func);
+
+  template<typename Func>
+  void applyBinary(const BinaryExpr& expr, Func func);
+
+  /**
+   * @brief Applies the fused activation of an expression to the result of the current instruction.
+   * */
+  void applyFusedActivation(Activation activation);
+
+private:
+  const FixedNet* net_{};
+
+  uint16_t batchSize_{ 1 };
+
+  uint8_t currentReg_{};
+
+  const int16_t* currentWeights_{};
+
+  const int16_t* currentBiases_{};
+
+  const uint8_t* currentShifts_{};
+
+  FeatureSize regSizes_[NN_MAX_REGS]{};
+};
+
+} // namespace NN
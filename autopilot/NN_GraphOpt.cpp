@@ -0,0 +1,518 @@
+#include "NN_GraphOpt.h"
+
+#include "NN_Interpreter.h"
+#include "NN_NetBuilder.h"
+#include "NN_NetRunner.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace NN {
+
+namespace {
+
+/**
+ * @brief An instruction along with where its parameters start in the working copy of the parameters.
+ * */
+struct Node final
+{
+  Instruction instr;
+
+  uint32_t parameterOffset{};
+
+  bool removed{ false };
+};
+
+auto
+isBinary(const OpCode op) -> bool
+{
+  return (op == OpCode::kMatMul) || (op == OpCode::kConcat) || (op == OpCode::kCompAdd) || (op == OpCode::kCompMul);
+}
+
+/**
+ * @brief Whether or not an instruction has to run even when its result is never read.
+ * */
+auto
+hasState(const OpCode op) -> bool
+{
+  return (op == OpCode::kGRU) || (op == OpCode::kConv1D);
+}
+
+auto
+readMask(const Instruction& instr) -> RegMask
+{
+  return regBit(instr.leftReg) | (isBinary(instr.op) ? regBit(instr.rightReg) : 0);
+}
+
+auto
+parameterCount(const Instruction& instr, const WeightLayout layout) -> uint32_t
+{
+  switch (instr.op) {
+    case OpCode::kLinear:
+      return linearParameterCount(instr.inFeatures, instr.outFeatures, layout);
+    case OpCode::kGRU:
+      return gruParameterCount(instr.inFeatures, instr.outFeatures, layout);
+    case OpCode::kConv1D:
+      return conv1DParameterCount(instr.inFeatures, instr.outFeatures, instr.kernelSize, layout);
+    case OpCode::kMatMul:
+    case OpCode::kConcat:
+    case OpCode::kCompAdd:
+    case OpCode::kCompMul:
+    case OpCode::kReLU:
+    case OpCode::kSigmoid:
+    case OpCode::kTanh:
+      break;
+  }
+  return 0;
+}
+
+/**
+ * @brief Gets the registers that are read before they are written, which are the inputs of a program.
+ * */
+auto
+findInputs(const Program& program) -> RegMask
+{
+  RegMask written{};
+  RegMask inputs{ regBit(0) };
+  for (InstrIndex i = 0; i < program.numInstructions; i++) {
+    const auto& instr = program.instructions[i];
+    inputs |= readMask(instr) & ~written;
+    written |= regBit(instr.dstReg);
+  }
+  return inputs;
+}
+
+/**
+ * @brief Does the work of @ref optimizeGraph on a working copy of the instructions and parameters.
+ * */
+class GraphOptimizer final
+{
+public:
+  GraphOptimizer(const Program& program, const Net& net, const RegMask liveOut)
+    : program_(program)
+    , net_(net)
+    , liveOut_(liveOut)
+  {
+  }
+
+  ~GraphOptimizer()
+  {
+    free(nodes_);
+    free(parameters_);
+  }
+
+  GraphOptimizer(const GraphOptimizer&) = delete;
+
+  auto operator=(const GraphOptimizer&) -> GraphOptimizer& = delete;
+
+  [[nodiscard]] auto allocMemory() -> bool
+  {
+    numNodes_ = program_.numInstructions;
+    nodes_ = static_cast<Node*>(malloc((numNodes_ > 0 ? numNodes_ : 1) * sizeof(Node)));
+    parameters_ = static_cast<float*>(malloc((net_.numParameters > 0 ? net_.numParameters : 1) * sizeof(float)));
+    if (!nodes_ || !parameters_) {
+      return false;
+    }
+
+    memcpy(parameters_, net_.parameters, net_.numParameters * sizeof(float));
+    numParameters_ = net_.numParameters;
+
+    uint32_t offset{};
+    for (InstrIndex i = 0; i < numNodes_; i++) {
+      nodes_[i] = Node{};
+      nodes_[i].instr = program_.instructions[i];
+      nodes_[i].parameterOffset = offset;
+      offset += parameterCount(nodes_[i].instr, net_.weightLayout);
+    }
+    return true;
+  }
+
+  void forwardCopies()
+  {
+    for (InstrIndex i = 0; i < numNodes_; i++) {
+      auto& node = nodes_[i];
+      if (node.removed || (node.instr.op != OpCode::kReLU)) {
+        continue;
+      }
+
+      const auto* producer = findDefinition(i, node.instr.leftReg);
+      if (!producer || ((producer->instr.op != OpCode::kReLU) && (producer->instr.activation != Activation::kReLU))) {
+        continue;
+      }
+
+      const auto src = node.instr.leftReg;
+      const auto dst = node.instr.dstReg;
+      if (src == dst) {
+        node.removed = true;
+        stats_.numForwarded++;
+        continue;
+      }
+
+      // The reads of each instruction happen before its write, so an instruction that overwrites the source can
+      // still be forwarded to.
+      auto forwarded = false;
+      for (InstrIndex j = i + 1; j < numNodes_; j++) {
+        auto& reader = nodes_[j];
+        if (reader.removed) {
+          continue;
+        }
+        if (reader.instr.leftReg == dst) {
+          reader.instr.leftReg = src;
+          forwarded = true;
+        }
+        if (isBinary(reader.instr.op) && (reader.instr.rightReg == dst)) {
+          reader.instr.rightReg = src;
+          forwarded = true;
+        }
+        if ((reader.instr.dstReg == dst) || (reader.instr.dstReg == src)) {
+          break;
+        }
+      }
+
+      if (forwarded) {
+        stats_.numForwarded++;
+      }
+    }
+  }
+
+  [[nodiscard]] auto foldLinearChains() -> bool
+  {
+    for (InstrIndex j = 0; j < numNodes_; j++) {
+      auto& outer = nodes_[j];
+      if (outer.removed || (outer.instr.op != OpCode::kLinear)) {
+        continue;
+      }
+
+      auto* inner = findDefinition(j, outer.instr.leftReg);
+      if (!inner || (inner->instr.op != OpCode::kLinear) || (inner->instr.activation != Activation::kNone) ||
+          (inner->instr.outFeatures != outer.instr.inFeatures)) {
+        continue;
+      }
+
+      // The folded layer reads the input of the inner one, so that input has to survive until the outer one runs,
+      // which it does not if the inner one wrote over it.
+      const auto innerIndex = static_cast<InstrIndex>(inner - nodes_);
+      if ((inner->instr.leftReg == inner->instr.dstReg) || isWrittenBetween(innerIndex, j, inner->instr.leftReg) ||
+          isReadOtherThan(innerIndex, j)) {
+        continue;
+      }
+
+      const uint64_t in = inner->instr.inFeatures;
+      const uint64_t mid = inner->instr.outFeatures;
+      const uint64_t out = outer.instr.outFeatures;
+      if ((in * out) >= (in * mid + mid * out)) {
+        continue;
+      }
+
+      if (!fold(*inner, &outer)) {
+        return false;
+      }
+
+      stats_.numFolded++;
+    }
+    return true;
+  }
+
+  void eliminateDeadCode()
+  {
+    auto live = liveOut_;
+    for (InstrIndex i = numNodes_; i > 0; i--) {
+      auto& node = nodes_[i - 1];
+      if (node.removed) {
+        continue;
+      }
+      if (((live & regBit(node.instr.dstReg)) == 0) && !hasState(node.instr.op)) {
+        node.removed = true;
+        stats_.numRemoved++;
+        continue;
+      }
+      live &= ~regBit(node.instr.dstReg);
+      live |= readMask(node.instr);
+    }
+  }
+
+  [[nodiscard]] auto write(Program* optimized, Net* optimizedNet) -> bool
+  {
+    optimized->numInstructions = 0;
+    for (InstrIndex i = 0; i < numNodes_; i++) {
+      optimized->numInstructions += nodes_[i].removed ? 0 : 1;
+    }
+
+    if (!optimized->allocMemory()) {
+      return false;
+    }
+
+    InstrIndex numKept{};
+    for (InstrIndex i = 0; i < numNodes_; i++) {
+      if (!nodes_[i].removed) {
+        optimized->instructions[numKept] = nodes_[i].instr;
+        numKept++;
+      }
+    }
+
+    optimizedNet->batchSize = net_.batchSize;
+    optimizedNet->weightLayout = net_.weightLayout;
+    optimizedNet->activationMode = net_.activationMode;
+
+    NetBuilder builder(optimizedNet, net_.regSizes[0]);
+    const auto inputs = findInputs(program_);
+    for (uint8_t r = 1; r < NN_MAX_REGS; r++) {
+      if ((inputs & regBit(r)) != 0) {
+        optimizedNet->regSizes[r] = net_.regSizes[r];
+      }
+    }
+    exec(*optimized, builder);
+    if (!builder.finish()) {
+      optimized->releaseMemory();
+      return false;
+    }
+
+    auto* dst = optimizedNet->parameters;
+    for (InstrIndex i = 0; i < numNodes_; i++) {
+      if (nodes_[i].removed) {
+        continue;
+      }
+      const auto count = parameterCount(nodes_[i].instr, net_.weightLayout);
+      memcpy(dst, parameters_ + nodes_[i].parameterOffset, count * sizeof(float));
+      dst += count;
+    }
+
+    return true;
+  }
+
+  [[nodiscard]] auto getStats() const -> const GraphOptStats& { return stats_; }
+
+protected:
+  /**
+   * @brief Finds the instruction before another one that last wrote to a register.
+   *
+   * @return The instruction, or null if the register is an input at that point.
+   * */
+  [[nodiscard]] auto findDefinition(const InstrIndex before, const uint8_t reg) -> Node*
+  {
+    for (InstrIndex i = before; i > 0; i--) {
+      auto& node = nodes_[i - 1];
+      if (!node.removed && (node.instr.dstReg == reg)) {
+        return &node;
+      }
+    }
+    return nullptr;
+  }
+
+  /**
+   * @brief Checks whether a register is written by an instruction in `(first, last)`.
+   * */
+  [[nodiscard]] auto isWrittenBetween(const InstrIndex first, const InstrIndex last, const uint8_t reg) const -> bool
+  {
+    for (InstrIndex i = first + 1; i < last; i++) {
+      if (!nodes_[i].removed && (nodes_[i].instr.dstReg == reg)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief Checks whether the result of an instruction is read by anything other than one reader, including by the
+   *        caller after the program finishes.
+   * */
+  [[nodiscard]] auto isReadOtherThan(const InstrIndex producer, const InstrIndex reader) const -> bool
+  {
+    const auto reg = nodes_[producer].instr.dstReg;
+    for (InstrIndex i = producer + 1; i < numNodes_; i++) {
+      const auto& instr = nodes_[i].instr;
+      if (nodes_[i].removed) {
+        continue;
+      }
+      if ((i != reader) && ((readMask(instr) & regBit(reg)) != 0)) {
+        return true;
+      }
+      if (instr.dstReg == reg) {
+        return false;
+      }
+    }
+    return (liveOut_ & regBit(reg)) != 0;
+  }
+
+  /**
+   * @brief Replaces `outer(inner(x))` with a single Linear, whose parameters are appended to the working copy.
+   * */
+  [[nodiscard]] auto fold(const Node& inner, Node* outer) -> bool
+  {
+    const auto layout = net_.weightLayout;
+    const uint32_t in = inner.instr.inFeatures;
+    const uint32_t mid = inner.instr.outFeatures;
+    const uint32_t out = outer->instr.outFeatures;
+    const auto count = linearParameterCount(inner.instr.inFeatures, outer->instr.outFeatures, layout);
+
+    const auto bytes = (static_cast<size_t>(numParameters_) + count) * sizeof(float);
+    auto* grown = static_cast<float*>(realloc(parameters_, bytes));
+    if (!grown) {
+      return false;
+    }
+    parameters_ = grown;
+
+    const auto innerStride = linearRowStride(inner.instr.inFeatures, layout);
+    const auto outerStride = linearRowStride(outer->instr.inFeatures, layout);
+    const auto* innerWeights = parameters_ + inner.parameterOffset;
+    const auto* innerBias = innerWeights + innerStride * mid;
+    const auto* outerWeights = parameters_ + outer->parameterOffset;
+    const auto* outerBias = outerWeights + outerStride * out;
+    auto* weights = parameters_ + numParameters_;
+    auto* bias = weights + innerStride * out;
+
+    // The padding has to stay zero, since the kernels may read it.
+    memset(weights, 0, count * sizeof(float));
+
+    for (uint32_t o = 0; o < out; o++) {
+      const auto* w = outerWeights + o * outerStride;
+      for (uint32_t i = 0; i < in; i++) {
+        double sum{};
+        for (uint32_t k = 0; k < mid; k++) {
+          sum += static_cast<double>(w[k]) * innerWeights[k * innerStride + i];
+        }
+        weights[o * innerStride + i] = static_cast<float>(sum);
+      }
+      double sum = outerBias[o];
+      for (uint32_t k = 0; k < mid; k++) {
+        sum += static_cast<double>(w[k]) * innerBias[k];
+      }
+      bias[o] = static_cast<float>(sum);
+    }
+
+    outer->instr.leftReg = inner.instr.leftReg;
+    outer->instr.inFeatures = inner.instr.inFeatures;
+    outer->parameterOffset = numParameters_;
+    numParameters_ += count;
+    return true;
+  }
+
+private:
+  const Program& program_;
+
+  const Net& net_;
+
+  RegMask liveOut_{};
+
+  Node* nodes_{};
+
+  InstrIndex numNodes_{};
+
+  /**
+   * @brief The parameters of the network, followed by the parameters of each folded layer.
+   * */
+  float* parameters_{};
+
+  uint32_t numParameters_{};
+
+  GraphOptStats stats_;
+};
+
+} // namespace
+
+auto
+optimizeGraph(const Program& program,
+              const Net& net,
+              const RegMask liveOut,
+              Program* optimized,
+              Net* optimizedNet,
+              GraphOptStats* stats) -> bool
+{
+  GraphOptimizer optimizer(program, net, liveOut);
+  if (!optimizer.allocMemory()) {
+    return false;
+  }
+
+  optimizer.forwardCopies();
+
+  if (!optimizer.foldLinearChains()) {
+    return false;
+  }
+
+  optimizer.eliminateDeadCode();
+
+  if (!optimizer.write(optimized, optimizedNet)) {
+    return false;
+  }
+
+  if (stats) {
+    *stats = optimizer.getStats();
+  }
+
+  return true;
+}
+
+auto
+verifyGraph(const Program& original,
+            const Net& net,
+            const Program& optimized,
+            const Net& optimizedNet,
+            const RegMask liveOut,
+            const uint16_t numRuns,
+            void* rngData,
+            auto (*rngFunc)(void*) -> float) -> float
+{
+  Activations activations;
+  Activations optimizedActivations;
+  if (!activations.allocMemory(net) || !optimizedActivations.allocMemory(optimizedNet)) {
+    activations.releaseMemory();
+    optimizedActivations.releaseMemory();
+    return HUGE_VALF;
+  }
+
+  NetRunner runner(&net, &activations);
+  NetRunner optimizedRunner(&optimizedNet, &optimizedActivations);
+
+  const auto inputs = findInputs(original);
+
+  auto maxError = 0.0F;
+
+  for (uint16_t run = 0; run < numRuns; run++) {
+    for (uint8_t r = 0; r < NN_MAX_REGS; r++) {
+      if ((inputs & regBit(r)) == 0) {
+        continue;
+      }
+      for (uint32_t i = 0; i < net.regSizes[r]; i++) {
+        const auto x = rngFunc(rngData);
+        runner.getRegister(r)[i] = x;
+        optimizedRunner.getRegister(r)[i] = x;
+      }
+    }
+
+    runner.reset();
+    exec(original, runner);
+    optimizedRunner.reset();
+    exec(optimized, optimizedRunner);
+
+    for (uint8_t r = 0; r < NN_MAX_REGS; r++) {
+      if ((liveOut & regBit(r)) == 0) {
+        continue;
+      }
+      const auto size = runner.getRegisterSize(r);
+      if (optimizedRunner.getRegisterSize(r) != size) {
+        maxError = HUGE_VALF;
+        continue;
+      }
+      for (uint32_t i = 0; i < size; i++) {
+        const auto expected = runner.getRegister(r)[i];
+        const auto actual = optimizedRunner.getRegister(r)[i];
+        if ((expected != expected) && (actual != actual)) {
+          continue;
+        }
+        const auto error = fabsf(actual - expected);
+        // A NaN on one side fails every comparison, so it counts as infinite.
+        if (!(error <= maxError)) {
+          maxError = (error > maxError) ? error : HUGE_VALF;
+        }
+      }
+    }
+  }
+
+  activations.releaseMemory();
+  optimizedActivations.releaseMemory();
+
+  return maxError;
+}
+
+} // namespace NN
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "NN_Config.h"
+#include "NN_Net.h"
+#include "NN_Program.h"
+
+#include <stdint.h>
+
+namespace NN {
+
+/**
+ * @brief The number of changes made by each pass of @ref optimizeGraph.
+ * */
+struct GraphOptStats final
+{
+  /**
+   * @brief Instructions whose result was never read, and that were removed.
+   * */
+  InstrIndex numRemoved{};
+
+  /**
+   * @brief Instructions that copy their input, whose readers were changed to read the input instead.
+   * */
+  InstrIndex numForwarded{};
+
+  /**
+   * @brief Pairs of Linear instructions that were folded into one.
+   * */
+  InstrIndex numFolded{};
+};
+
+/**
+ * @brief Rewrites a program into a smaller one that computes the same outputs, along with the network that it runs.
+ *
+ * @details The passes run in this order:
+ *
+ *          - Copy forwarding. A ReLU whose input already went through a ReLU returns its input unchanged, so the
+ *            instructions after it read the input instead, for as long as neither register is overwritten.
+ *          - Constant folding. A Linear that reads the result of another Linear without an activation, where that
+ *            result is read by nothing else, is replaced by a single Linear. Its weights are the product of the two
+ *            weight matrices, which only depends on the parameters, so it is computed here instead of on every run.
+ *            Pairs are only folded when that takes fewer multiply-adds, so a bottleneck layer is kept.
+ *          - Dead code elimination. Instructions whose result is overwritten or dropped before it is read are
+ *            removed, along with their parameters. GRU and Conv1D are always kept, since they update their state
+ *            whether or not their output is read.
+ *
+ *          The optimized network has the same batch size, layout and modes as the original, with each register given
+ *          its own memory. Folding changes the rounding of the outputs, so the result should be checked with
+ *          @ref verifyGraph. The parameters of folded layers no longer match the program the network was trained
+ *          with, so this is only meant for running a trained network.
+ *
+ * @param program The program that the network was built from.
+ *
+ * @param net The network to optimize. It is only read from.
+ *
+ * @param liveOut A mask of the registers that are read after the program finishes, one bit per register. Everything
+ *                that does not lead to one of them, or to a GRU or Conv1D, is removed.
+ *
+ * @param optimized The program to write. It has to be released with @ref Program::releaseMemory.
+ *
+ * @param optimizedNet The network to build for the optimized program. It has to be released with
+ *                     @ref Net::releaseMemory.
+ *
+ * @param stats If not null, is given the number of changes made by each pass.
+ *
+ * @return False if memory could not be allocated, or if the optimized network could not be built.
+ * */
+[[nodiscard]] auto
+optimizeGraph(const Program& program,
+              const Net& net,
+              RegMask liveOut,
+              Program* optimized,
+              Net* optimizedNet,
+              GraphOptStats* stats = nullptr) -> bool;
+
+/**
+ * @brief Runs two programs on the same random inputs, and gets the largest difference between their outputs.
+ *
+ * @details Both networks are run in their own @ref Activations, starting from a cleared state, so neither is changed.
+ *          The runs follow each other without clearing the state again, so the GRU and Conv1D instructions are
+ *          compared over a sequence.
+ *
+ * @param original The program that the optimized one was made from, and its network.
+ *
+ * @param optimized The program written by @ref optimizeGraph, and its network.
+ *
+ * @param liveOut The registers that are compared, which is the same mask that was given to @ref optimizeGraph.
+ *
+ * @param numRuns The number of times to run both programs.
+ *
+ * @param rngFunc Gets each input value, given `rngData`.
+ *
+ * @return The largest absolute difference of any output. This is infinite if an output only came out as NaN on one
+ *         side, if the outputs do not have the same size, or if the activations could not be allocated.
+ * */
+[[nodiscard]] auto
+verifyGraph(const Program& original,
+            const Net& net,
+            const Program& optimized,
+            const Net& optimizedNet,
+            RegMask liveOut,
+            uint16_t numRuns,
+            void* rngData,
+            auto (*rngFunc)(void*) -> float) -> float;
+
+} // namespace NN
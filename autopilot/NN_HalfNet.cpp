@@ -0,0 +1,44 @@
+#include "NN_HalfNet.h"
+
+#include <stdlib.h>
+
+namespace NN {
+
+auto
+HalfNet::allocMemory() -> bool
+{
+  memory = malloc((numParameters > 0 ? numParameters : 1) * sizeof(uint16_t));
+  if (!memory) {
+    return false;
+  }
+  parameters = static_cast<uint16_t*>(memory);
+  return true;
+}
+
+void
+HalfNet::releaseMemory()
+{
+  free(memory);
+  memory = nullptr;
+  parameters = nullptr;
+}
+
+auto
+convertToHalf(const Net& net, const HalfFormat format, HalfNet* halfNet) -> bool
+{
+  halfNet->shape = net.getShape();
+  halfNet->format = format;
+  halfNet->numParameters = net.numParameters;
+
+  if (!halfNet->allocMemory()) {
+    return false;
+  }
+
+  for (uint32_t i = 0; i < net.numParameters; i++) {
+    halfNet->parameters[i] = floatToHalf(net.parameters[i], format);
+  }
+
+  return true;
+}
+
+} // namespace NN
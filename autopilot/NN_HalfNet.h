@@ -0,0 +1,58 @@
+#pragma once
+
+#include "NN_Kernels.h"
+#include "NN_Net.h"
+
+#include <stdint.h>
+
+namespace NN {
+
+/**
+ * @brief A network whose parameters are stored as 16 bit floats, which halves the memory that they take up and the
+ *        bandwidth needed to run them.
+ *
+ * @details The parameters are laid out exactly the same as in the float network that they were converted from,
+ *          including the padding of @ref WeightLayout::kPadded, so they are consumed in program order by the
+ *          @ref HalfNetRunner in the same way that the float parameters are consumed by the @ref NetRunner. See
+ *          @ref HalfFormat for the accuracy of each format.
+ * */
+struct HalfNet final
+{
+  /**
+   * @brief The registers, batch size and modes of the network that this was converted from. See @ref Net::getShape.
+   * */
+  Net shape;
+
+  HalfFormat format{ HalfFormat::kFloat16 };
+
+  uint32_t numParameters{};
+
+  uint16_t* parameters{};
+
+  void* memory{};
+
+  /**
+   * @brief Attempts to allocate the parameters.
+   *
+   * @return True on success, false on failure.
+   * */
+  [[nodiscard]] auto allocMemory() -> bool;
+
+  void releaseMemory();
+};
+
+/**
+ * @brief Rounds the parameters of a float network to 16 bit floats.
+ *
+ * @param net The float network, with its parameters.
+ *
+ * @param format The format to store the parameters in.
+ *
+ * @param halfNet The network to write the parameters to. It has to be released with @ref HalfNet::releaseMemory.
+ *
+ * @return False if the memory could not be allocated.
+ * */
+[[nodiscard]] auto
+convertToHalf(const Net& net, HalfFormat format, HalfNet* halfNet) -> bool;
+
+} // namespace NN
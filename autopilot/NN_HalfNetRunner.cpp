@@ -0,0 +1,200 @@
+#include "NN_HalfNetRunner.h"
+
+#include "NN_Kernels.h"
+
+namespace NN {
+
+HalfNetRunner::HalfNetRunner(const HalfNet* net, Activations* activations)
+  : net_(net)
+  , runner_(&net->shape, activations)
+{
+}
+
+auto
+HalfNetRunner::getRegister(const uint8_t reg) -> float*
+{
+  return runner_.getRegister(reg);
+}
+
+auto
+HalfNetRunner::getRegister(const uint8_t reg, const uint16_t sample) -> float*
+{
+  return runner_.getRegister(reg, sample);
+}
+
+auto
+HalfNetRunner::getRegisterSize(const uint8_t reg) const -> FeatureSize
+{
+  return runner_.getRegisterSize(reg);
+}
+
+void
+HalfNetRunner::setBatchSize(const uint16_t batchSize)
+{
+  runner_.setBatchSize(batchSize);
+}
+
+auto
+HalfNetRunner::getBatchSize() const -> uint16_t
+{
+  return runner_.getBatchSize();
+}
+
+void
+HalfNetRunner::reset()
+{
+  runner_.reset();
+  currentReg_ = 0;
+  currentParameters_ = net_->parameters;
+}
+
+void
+HalfNetRunner::clearState()
+{
+  runner_.clearState();
+}
+
+void
+HalfNetRunner::clearState(const uint16_t sample)
+{
+  runner_.clearState(sample);
+}
+
+void
+HalfNetRunner::beginAssignment(const uint8_t dstReg)
+{
+  currentReg_ = dstReg;
+  runner_.beginAssignment(dstReg);
+}
+
+void
+HalfNetRunner::interpret(const LinearExpr& expr)
+{
+  const auto& shape = net_->shape;
+  const auto stride = linearRowStride(expr.inFeatures, shape.weightLayout);
+  const auto* weights = currentParameters_;
+  const auto* bias = weights + stride * expr.outFeatures;
+
+  // There is no batched kernel, since batches are mostly used for training, which is done on the float network.
+  const auto batchSize = runner_.getBatchSize();
+  for (uint16_t b = 0; b < batchSize; b++) {
+    linearHalf(weights,
+               bias,
+               runner_.getRegister(expr.inRegister, b),
+               runner_.getRegister(currentReg_, b),
+               expr.inFeatures,
+               expr.outFeatures,
+               stride,
+               net_->format,
+               expr.activation,
+               shape.activationMode);
+  }
+
+  runner_.setRegisterSize(currentReg_, expr.outFeatures);
+
+  currentParameters_ += linearParameterCount(expr.inFeatures, expr.outFeatures, shape.weightLayout);
+}
+
+void
+HalfNetRunner::interpret(const MatMulExpr& expr)
+{
+  runner_.interpret(expr);
+}
+
+void
+HalfNetRunner::interpret(const ConcatExpr& expr)
+{
+  runner_.interpret(expr);
+}
+
+void
+HalfNetRunner::interpret(const CompAddExpr& expr)
+{
+  runner_.interpret(expr);
+}
+
+void
+HalfNetRunner::interpret(const CompMulExpr& expr)
+{
+  runner_.interpret(expr);
+}
+
+void
+HalfNetRunner::interpret(const ReLUExpr& expr)
+{
+  runner_.interpret(expr);
+}
+
+void
+HalfNetRunner::interpret(const SigmoidExpr& expr)
+{
+  runner_.interpret(expr);
+}
+
+void
+HalfNetRunner::interpret(const TanhExpr& expr)
+{
+  runner_.interpret(expr);
+}
+
+void
+HalfNetRunner::interpret(const GRUExpr& expr)
+{
+  const auto& shape = net_->shape;
+  const auto* inputWeights = currentParameters_;
+  const auto gates = static_cast<FeatureSize>(3 * static_cast<uint32_t>(expr.hiddenSize));
+  const auto* hiddenWeights = inputWeights + linearParameterCount(expr.inFeatures, gates, shape.weightLayout);
+
+  const auto batchSize = runner_.getBatchSize();
+  for (uint16_t b = 0; b < batchSize; b++) {
+    gruHalf(inputWeights,
+            hiddenWeights,
+            runner_.getRegister(expr.inRegister, b),
+            runner_.getState(b),
+            runner_.getRegister(currentReg_, b),
+            expr.inFeatures,
+            expr.hiddenSize,
+            linearRowStride(expr.inFeatures, shape.weightLayout),
+            linearRowStride(expr.hiddenSize, shape.weightLayout),
+            net_->format,
+            shape.activationMode);
+  }
+
+  runner_.setRegisterSize(currentReg_, expr.hiddenSize);
+  runner_.skipState(expr.hiddenSize);
+
+  currentParameters_ += gruParameterCount(expr.inFeatures, expr.hiddenSize, shape.weightLayout);
+}
+
+void
+HalfNetRunner::interpret(const Conv1DExpr& expr)
+{
+  const auto& shape = net_->shape;
+  const auto window = static_cast<FeatureSize>(static_cast<uint32_t>(expr.kernelSize) * expr.inChannels);
+  const auto stride = linearRowStride(window, shape.weightLayout);
+  const auto* weights = currentParameters_;
+  const auto* bias = weights + stride * expr.outChannels;
+
+  const auto batchSize = runner_.getBatchSize();
+  for (uint16_t b = 0; b < batchSize; b++) {
+    auto* state = runner_.getState(b);
+    pushFrame(state, runner_.getRegister(expr.inRegister, b), expr.inChannels, expr.kernelSize);
+    linearHalf(weights,
+               bias,
+               state,
+               runner_.getRegister(currentReg_, b),
+               window,
+               expr.outChannels,
+               stride,
+               net_->format,
+               Activation::kNone,
+               shape.activationMode);
+  }
+
+  runner_.setRegisterSize(currentReg_, expr.outChannels);
+  runner_.skipState(window);
+
+  currentParameters_ += conv1DParameterCount(expr.inChannels, expr.outChannels, expr.kernelSize, shape.weightLayout);
+}
+
+} // namespace NN
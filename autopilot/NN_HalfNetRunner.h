@@ -0,0 +1,83 @@
+#pragma once
+
+#include "NN_Interpreter.h"
+#include "NN_NetRunner.h"
+#include "NN_HalfNet.h"
+
+#include <stdint.h>
+
+namespace NN {
+
+/**
+ * @brief Runs a network that was converted with @ref convertToHalf.
+ *
+ * @details This has to be driven by the same program that the network was converted from. Linear layers widen their
+ *          weights to float as they load them, and every other instruction is run by a @ref NetRunner on the same
+ *          registers. GRU and Conv1D are run the same way as Linear, and keep their state in the activations.
+ * */
+class HalfNetRunner final : public Interpreter
+{
+public:
+  /**
+   * @param activations Registers allocated for the shape of the network. See @ref HalfNet::shape.
+   * */
+  HalfNetRunner(const HalfNet* net, Activations* activations);
+
+  [[nodiscard]] auto getRegister(uint8_t reg) -> float*;
+
+  [[nodiscard]] auto getRegister(uint8_t reg, uint16_t sample) -> float*;
+
+  [[nodiscard]] auto getRegisterSize(uint8_t reg) const -> FeatureSize;
+
+  /**
+   * @brief Sets the number of samples that each instruction is applied to. See @ref NetRunner::setBatchSize.
+   * */
+  void setBatchSize(uint16_t batchSize);
+
+  [[nodiscard]] auto getBatchSize() const -> uint16_t;
+
+  void reset();
+
+  /**
+   * @brief Zeroes the state of the GRU and Conv1D instructions. See @ref NetRunner::clearState.
+   * */
+  void clearState();
+
+  void clearState(uint16_t sample);
+
+  void beginAssignment(uint8_t dstReg) override;
+
+  void interpret(const LinearExpr&) override;
+
+  void interpret(const MatMulExpr&) override;
+
+  void interpret(const ConcatExpr&) override;
+
+  void interpret(const CompAddExpr&) override;
+
+  void interpret(const CompMulExpr&) override;
+
+  void interpret(const ReLUExpr&) override;
+
+  void interpret(const SigmoidExpr&) override;
+
+  void interpret(const TanhExpr&) override;
+
+  void interpret(const GRUExpr&) override;
+
+  void interpret(const Conv1DExpr&) override;
+
+private:
+  const HalfNet* net_{};
+
+  /**
+   * @brief Runs the instructions that have no parameters.
+   * */
+  NetRunner runner_;
+
+  uint8_t currentReg_{};
+
+  const uint16_t* currentParameters_{};
+};
+
+} // namespace NN
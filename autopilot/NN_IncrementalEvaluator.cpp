@@ -0,0 +1,306 @@
+#include "NN_IncrementalEvaluator.h"
+
+#include "NN_Program.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace NN {
+
+namespace {
+
+auto
+isBinary(const OpCode op) -> bool
+{
+  return (op == OpCode::kMatMul) || (op == OpCode::kConcat) || (op == OpCode::kCompAdd) || (op == OpCode::kCompMul);
+}
+
+} // namespace
+
+IncrementalEvaluator::IncrementalEvaluator(Net* net, const Program* program)
+  : net_(net)
+  , program_(program)
+  , runner_(net)
+{
+}
+
+void
+IncrementalEvaluator::markOutput(const uint8_t reg)
+{
+  outputs_ |= regBit(reg);
+}
+
+auto
+IncrementalEvaluator::allocMemory() -> bool
+{
+  if (net_->stateSize != 0) {
+    return false;
+  }
+
+  const uint32_t n = program_->numInstructions;
+  const uint32_t batchSize = net_->batchSize;
+
+  RegMask written{};
+  inputs_ = 0;
+  uint32_t numFloats{};
+  for (uint32_t i = 0; i < n; i++) {
+    const auto& instr = program_->instructions[i];
+    const auto left = regBit(instr.leftReg);
+    const auto right = isBinary(instr.op) ? regBit(instr.rightReg) : 0;
+    inputs_ |= (left | right) & ~written;
+    written |= regBit(instr.dstReg);
+    numFloats += 2 * static_cast<uint32_t>(net_->regSizes[instr.dstReg]) * batchSize;
+  }
+  for (uint8_t r = 0; r < NN_MAX_REGS; r++) {
+    if (inputs_ & regBit(r)) {
+      numFloats += static_cast<uint32_t>(net_->regSizes[r]) * batchSize;
+    }
+  }
+
+  // The arrays are ordered from the largest alignment to the smallest.
+  const size_t size = 2 * n * sizeof(float*) + n * sizeof(uint32_t) + numFloats * sizeof(float) +
+                      2 * n * sizeof(FeatureSize) + n * sizeof(bool);
+  memory_ = malloc((size > 0) ? size : 1);
+  if (!memory_) {
+    return false;
+  }
+
+  auto* pointers = static_cast<float**>(memory_);
+  values_ = pointers;
+  pendingValues_ = pointers + n;
+  parameterOffsets_ = reinterpret_cast<uint32_t*>(pointers + 2 * n);
+  auto* floats = reinterpret_cast<float*>(parameterOffsets_ + n);
+  sizes_ = reinterpret_cast<FeatureSize*>(floats + numFloats);
+  pendingSizes_ = sizes_ + n;
+  dirty_ = reinterpret_cast<bool*>(pendingSizes_ + n);
+
+  uint32_t parameterOffset{};
+  for (uint32_t i = 0; i < n; i++) {
+    const auto& instr = program_->instructions[i];
+    const auto regFloats = static_cast<uint32_t>(net_->regSizes[instr.dstReg]) * batchSize;
+    values_[i] = floats;
+    pendingValues_[i] = floats + regFloats;
+    floats += 2 * regFloats;
+    sizes_[i] = 0;
+    pendingSizes_[i] = 0;
+    dirty_[i] = false;
+    parameterOffsets_[i] = parameterOffset;
+    if (instr.op == OpCode::kLinear) {
+      parameterOffset += linearParameterCount(instr.inFeatures, instr.outFeatures, net_->weightLayout);
+    }
+  }
+  for (uint8_t r = 0; r < NN_MAX_REGS; r++) {
+    inputValues_[r] = nullptr;
+    if (inputs_ & regBit(r)) {
+      inputValues_[r] = floats;
+      floats += static_cast<uint32_t>(net_->regSizes[r]) * batchSize;
+    }
+  }
+
+  filled_ = false;
+
+  return true;
+}
+
+void
+IncrementalEvaluator::releaseMemory()
+{
+  free(memory_);
+  memory_ = nullptr;
+  values_ = nullptr;
+  pendingValues_ = nullptr;
+  parameterOffsets_ = nullptr;
+  sizes_ = nullptr;
+  pendingSizes_ = nullptr;
+  dirty_ = nullptr;
+  for (uint8_t r = 0; r < NN_MAX_REGS; r++) {
+    inputValues_[r] = nullptr;
+  }
+  filled_ = false;
+}
+
+auto
+IncrementalEvaluator::getRegister(const uint8_t reg, const uint16_t sample) -> float*
+{
+  return runner_.getRegister(reg, sample);
+}
+
+void
+IncrementalEvaluator::setBatchSize(const uint16_t batchSize)
+{
+  runner_.setBatchSize(batchSize);
+  batchSize_ = (batchSize < net_->batchSize) ? batchSize : net_->batchSize;
+  filled_ = false;
+}
+
+auto
+IncrementalEvaluator::getNumRecomputed() const -> InstrIndex
+{
+  return numRecomputed_;
+}
+
+auto
+IncrementalEvaluator::evaluate(void* lossData, LossFunc loss) -> float
+{
+  for (uint8_t r = 0; r < NN_MAX_REGS; r++) {
+    producers_[r] = kInput;
+    if (inputValues_[r]) {
+      memcpy(inputValues_[r], net_->regs[r], sizeof(float) * net_->regSizes[r] * batchSize_);
+    }
+  }
+
+  runner_.reset();
+
+  const auto n = program_->numInstructions;
+  for (InstrIndex i = 0; i < n; i++) {
+    const auto& instr = program_->instructions[i];
+    execInstruction(instr, runner_);
+    memcpy(values_[i], net_->regs[instr.dstReg], sizeof(float) * net_->regSizes[instr.dstReg] * batchSize_);
+    sizes_[i] = runner_.getRegisterSize(instr.dstReg);
+    dirty_[i] = false;
+    producers_[instr.dstReg] = i;
+  }
+
+  filled_ = true;
+  numRecomputed_ = n;
+
+  return finish(lossData, loss);
+}
+
+auto
+IncrementalEvaluator::evaluateChanged(const uint32_t* indices, const uint32_t count, void* lossData, LossFunc loss)
+  -> float
+{
+  if (!filled_) {
+    return evaluate(lossData, loss);
+  }
+
+  const auto n = program_->numInstructions;
+  for (InstrIndex i = 0; i < n; i++) {
+    dirty_[i] = false;
+  }
+
+  InstrIndex first = n;
+  for (uint32_t k = 0; k < count; k++) {
+    const auto owner = findOwner(indices[k]);
+    if (owner < n) {
+      dirty_[owner] = true;
+      first = (owner < first) ? owner : first;
+    }
+  }
+
+  for (uint8_t r = 0; r < NN_MAX_REGS; r++) {
+    producers_[r] = kInput;
+  }
+  for (InstrIndex i = 0; i < first; i++) {
+    producers_[program_->instructions[i].dstReg] = i;
+  }
+
+  auto isDirty = [this](const uint8_t reg) -> bool {
+    const auto producer = producers_[reg];
+    return (producer != kInput) && dirty_[producer];
+  };
+
+  numRecomputed_ = 0;
+
+  for (InstrIndex i = first; i < n; i++) {
+    const auto& instr = program_->instructions[i];
+    const auto binary = isBinary(instr.op);
+    if (dirty_[i] || isDirty(instr.leftReg) || (binary && isDirty(instr.rightReg))) {
+      load(instr.leftReg);
+      if (binary) {
+        load(instr.rightReg);
+      }
+      runner_.seek(parameterOffsets_[i]);
+      execInstruction(instr, runner_);
+      memcpy(pendingValues_[i], net_->regs[instr.dstReg], sizeof(float) * net_->regSizes[instr.dstReg] * batchSize_);
+      pendingSizes_[i] = runner_.getRegisterSize(instr.dstReg);
+      dirty_[i] = true;
+      numRecomputed_++;
+    }
+    producers_[instr.dstReg] = i;
+  }
+
+  return finish(lossData, loss);
+}
+
+void
+IncrementalEvaluator::commit()
+{
+  for (InstrIndex i = 0; i < program_->numInstructions; i++) {
+    if (!dirty_[i]) {
+      continue;
+    }
+    auto* values = values_[i];
+    values_[i] = pendingValues_[i];
+    pendingValues_[i] = values;
+    sizes_[i] = pendingSizes_[i];
+    dirty_[i] = false;
+  }
+}
+
+auto
+IncrementalEvaluator::findOwner(const uint32_t parameter) const -> InstrIndex
+{
+  const auto n = program_->numInstructions;
+
+  // The offsets never decrease, so find the last instruction that starts at or before the parameter.
+  InstrIndex lo = 0;
+  InstrIndex hi = n;
+  while (lo < hi) {
+    const auto mid = static_cast<InstrIndex>(lo + (hi - lo) / 2);
+    if (parameterOffsets_[mid] <= parameter) {
+      lo = static_cast<InstrIndex>(mid + 1);
+    } else {
+      hi = mid;
+    }
+  }
+
+  // Instructions without parameters share the offset of the next Linear instruction.
+  while (lo > 0) {
+    lo--;
+    if (program_->instructions[lo].op == OpCode::kLinear) {
+      return lo;
+    }
+  }
+
+  return n;
+}
+
+void
+IncrementalEvaluator::load(const uint8_t reg)
+{
+  const auto producer = producers_[reg];
+  const float* values{};
+  FeatureSize size{};
+  if (producer == kInput) {
+    values = inputValues_[reg];
+    size = net_->regSizes[reg];
+  } else if (dirty_[producer]) {
+    values = pendingValues_[producer];
+    size = pendingSizes_[producer];
+  } else {
+    values = values_[producer];
+    size = sizes_[producer];
+  }
+
+  if (!values) {
+    return;
+  }
+
+  memcpy(net_->regs[reg], values, sizeof(float) * net_->regSizes[reg] * batchSize_);
+  runner_.setRegisterSize(reg, size);
+}
+
+auto
+IncrementalEvaluator::finish(void* lossData, LossFunc loss) -> float
+{
+  for (uint8_t r = 0; r < NN_MAX_REGS; r++) {
+    if (outputs_ & regBit(r)) {
+      load(r);
+    }
+  }
+  return loss(lossData, *net_);
+}
+
+} // namespace NN
@@ -0,0 +1,153 @@
+#pragma once
+
+#include "NN_Net.h"
+#include "NN_NetRunner.h"
+
+#include <stdint.h>
+
+namespace NN {
+
+struct Program;
+
+/**
+ * @brief Evaluates a loss on a fixed set of inputs, and after a few parameters change, re-runs only the instructions
+ *        that depend on them.
+ *
+ * @details The result of every instruction is cached for the whole batch. When parameters change, the Linear
+ *          instructions that own them are marked dirty, along with every instruction that reads a dirty result. Only
+ *          those are run again, with their operands copied back from the cache. Perturbing the last layer then costs
+ *          one layer, instead of the whole network.
+ *
+ *          Write the inputs with @ref IncrementalEvaluator::getRegister, then call @ref IncrementalEvaluator::evaluate
+ *          once. After that, @ref IncrementalEvaluator::evaluateChanged gives the loss of a change, and
+ *          @ref IncrementalEvaluator::commit keeps that change in the cache. If the change is undone instead, the
+ *          cache is still valid and nothing has to be done.
+ * */
+class IncrementalEvaluator final
+{
+public:
+  /**
+   * @brief Computes the loss from the output registers of the network. Unlike @ref LSOptimizer::LossFunc, this must
+   *        not run the network.
+   * */
+  using LossFunc = auto (*)(void*, const Net& net) -> float;
+
+  IncrementalEvaluator(Net* net, const Program* program);
+
+  /**
+   * @brief Marks a register that the loss function reads. This has to be done before the memory is allocated.
+   * */
+  void markOutput(uint8_t reg);
+
+  /**
+   * @return False if the memory could not be allocated, or if the network has a GRU or Conv1D. Running those again
+   *         would move their state along, so they can not be re-run on their own.
+   * */
+  [[nodiscard]] auto allocMemory() -> bool;
+
+  void releaseMemory();
+
+  [[nodiscard]] auto getRegister(uint8_t reg, uint16_t sample) -> float*;
+
+  /**
+   * @brief Sets the number of samples in the evaluation set. See @ref NetRunner::setBatchSize.
+   * */
+  void setBatchSize(uint16_t batchSize);
+
+  /**
+   * @brief Runs the whole network on the inputs and fills the cache.
+   *
+   * @details The inputs are copied out of their registers here, so they have to be written right before. Running the
+   *          network in between may overwrite them, if registers share memory.
+   * */
+  auto evaluate(void* lossData, LossFunc loss) -> float;
+
+  /**
+   * @brief Re-runs the instructions that depend on the given parameters.
+   *
+   * @details If the cache has not been filled yet, this runs the whole network.
+   *
+   * @param indices The indices of the parameters that changed since the cache was last filled or committed.
+   * */
+  auto evaluateChanged(const uint32_t* indices, uint32_t count, void* lossData, LossFunc loss) -> float;
+
+  /**
+   * @brief Keeps the results of the last call to @ref IncrementalEvaluator::evaluateChanged in the cache.
+   * */
+  void commit();
+
+  /**
+   * @brief Gets the number of instructions that the last evaluation ran.
+   * */
+  [[nodiscard]] auto getNumRecomputed() const -> InstrIndex;
+
+protected:
+  /**
+   * @brief Finds the Linear instruction that owns a parameter.
+   * */
+  [[nodiscard]] auto findOwner(uint32_t parameter) const -> InstrIndex;
+
+  /**
+   * @brief Copies the value that a register holds at the current point of the evaluation back into the register.
+   * */
+  void load(uint8_t reg);
+
+  auto finish(void* lossData, LossFunc loss) -> float;
+
+private:
+  static constexpr InstrIndex kInput{ maxInstructions };
+
+  Net* net_{};
+
+  const Program* program_{};
+
+  NetRunner runner_;
+
+  uint16_t batchSize_{ 1 };
+
+  RegMask outputs_{};
+
+  /**
+   * @brief Registers that are read before they are written, one bit per register.
+   * */
+  RegMask inputs_{};
+
+  bool filled_{ false };
+
+  InstrIndex numRecomputed_{};
+
+  /**
+   * @brief The instruction whose result each register holds, or @ref kInput.
+   * */
+  InstrIndex producers_[NN_MAX_REGS]{};
+
+  float* inputValues_[NN_MAX_REGS]{};
+
+  /**
+   * @brief The result of each instruction, in the layout of its destination register.
+   * */
+  float** values_{};
+
+  /**
+   * @brief The results of the instructions that were re-run by the last evaluation.
+   * */
+  float** pendingValues_{};
+
+  FeatureSize* sizes_{};
+
+  FeatureSize* pendingSizes_{};
+
+  /**
+   * @brief Where the parameters of each instruction start, for the Linear instructions.
+   * */
+  uint32_t* parameterOffsets_{};
+
+  /**
+   * @brief Whether each instruction was re-run by the last evaluation.
+   * */
+  bool* dirty_{};
+
+  void* memory_{};
+};
+
+} // namespace NN
@@ -53,8 +53,20 @@ TanhExpr::accept(Interpreter& interp) const
   interp.interpret(*this);
 }
 
+void
+GRUExpr::accept(Interpreter& interp) const
+{
+  interp.interpret(*this);
+}
+
+void
+Conv1DExpr::accept(Interpreter& interp) const
+{
+  interp.interpret(*this);
+}
+
 auto
-exec(const char* source, const uint16_t length, Interpreter& interp) -> SyntaxError
+exec(const char* source, const SourceSize length, Interpreter& interp) -> SyntaxError
 {
   Lexer lexer(source, length);
 
@@ -64,24 +76,24 @@ exec(const char* source, const uint16_t length, Interpreter& interp) -> SyntaxEr
 }
 
 auto
-reverseExec(const char* source, const uint16_t length, Interpreter& interp) -> SyntaxError
+reverseExec(const char* source, const SourceSize length, Interpreter& interp) -> SyntaxError
 {
   // Execute each line of code, starting from the last until the first.
 
   auto lastEnd = length;
 
-  for (uint8_t i = length; i > 0; i--) {
+  for (SourceSize i = length; i > 0; i--) {
     const auto c = source[i - 1];
     const auto first = i == 1;
     if ((c != '\n') && !first) {
       continue;
     }
     const auto offset = first ? 0 : i;
-    const auto err = exec(source + offset, lastEnd - offset, interp);
+    const auto err = exec(source + offset, static_cast<SourceSize>(lastEnd - offset), interp);
     if (err != SyntaxError::kNone) {
       return err;
     }
-    lastEnd = i - 1;
+    lastEnd = static_cast<SourceSize>(i - 1);
   }
 
   return SyntaxError::kNone;
@@ -1,5 +1,8 @@
 #pragma once
 
+#include "NN_Activation.h"
+#include "NN_Config.h"
+
 #include <stdint.h>
 
 namespace NN {
@@ -14,6 +17,8 @@ struct CompMulExpr;
 struct ReLUExpr;
 struct SigmoidExpr;
 struct TanhExpr;
+struct GRUExpr;
+struct Conv1DExpr;
 
 class Interpreter
 {
@@ -38,6 +43,10 @@ public:
   virtual void interpret(const SigmoidExpr&) = 0;
 
   virtual void interpret(const TanhExpr&) = 0;
+
+  virtual void interpret(const GRUExpr&) = 0;
+
+  virtual void interpret(const Conv1DExpr&) = 0;
 };
 
 struct Expr
@@ -49,12 +58,18 @@ struct Expr
 
 struct LinearExpr final : public Expr
 {
-  uint16_t inFeatures{};
+  FeatureSize inFeatures{};
 
-  uint16_t outFeatures{};
+  FeatureSize outFeatures{};
 
   uint8_t inRegister{};
 
+  /**
+   * @brief Applied to each output feature. This can not be written in the source, and is only set by
+   *        @ref fuseActivations.
+   * */
+  Activation activation{ Activation::kNone };
+
   void accept(Interpreter& interp) const override;
 };
 
@@ -63,10 +78,27 @@ struct BinaryExpr : public Expr
   uint8_t leftOpReg{};
 
   uint8_t rightOpReg{};
+
+  /**
+   * @brief Applied to each element of the result. This can not be written in the source, and is only set by
+   *        @ref fuseActivations.
+   * */
+  Activation activation{ Activation::kNone };
 };
 
+/**
+ * @brief Multiplies two row-major matrices.
+ *
+ * @details The left operand has @ref MatMulExpr::leftRows rows. The number of columns of the left operand, which is
+ *          also the number of rows of the right operand, is inferred from the size of the left operand. In the
+ *          source, the number of rows comes before the operands and defaults to one (a vector-matrix product):
+ *
+ *          `%2 = MatMul 4 %0 %1`
+ * */
 struct MatMulExpr final : public BinaryExpr
 {
+  FeatureSize leftRows{ 1 };
+
   void accept(Interpreter& interp) const override;
 };
 
@@ -107,8 +139,50 @@ struct TanhExpr final : public UnaryExpr
   void accept(Interpreter& interp) const override;
 };
 
+/**
+ * @brief One step of a gated recurrent unit, whose hidden state is kept between runs of the network.
+ *
+ * @details The result is the new hidden state. The gates follow PyTorch: the parameters are a linear layer from the
+ *          input to the reset, update and new gates (`3 * hiddenSize` outputs), followed by a linear layer from the
+ *          hidden state to the same gates. In the source, the input features come before the hidden size:
+ *
+ *          `%2 = GRU 8 16 %1`
+ * */
+struct GRUExpr final : public Expr
+{
+  FeatureSize inFeatures{};
+
+  FeatureSize hiddenSize{};
+
+  uint8_t inRegister{};
+
+  void accept(Interpreter& interp) const override;
+};
+
+/**
+ * @brief A causal convolution over time, which sees the input of this run and of the `kernelSize - 1` runs before it.
+ *
+ * @details The past inputs are kept between runs of the network, and start out as zero. The parameters are those of
+ *          a linear layer with `kernelSize * inChannels` inputs, which are the inputs from the oldest to the newest.
+ *          In the source, the operands are the input channels, the output channels and the kernel size:
+ *
+ *          `%2 = Conv1D 4 8 3 %1`
+ * */
+struct Conv1DExpr final : public Expr
+{
+  FeatureSize inChannels{};
+
+  FeatureSize outChannels{};
+
+  FeatureSize kernelSize{ 1 };
+
+  uint8_t inRegister{};
+
+  void accept(Interpreter& interp) const override;
+};
+
 [[nodiscard]] auto
-exec(const char* source, const uint16_t length, Interpreter& interp) -> SyntaxError;
+exec(const char* source, const SourceSize length, Interpreter& interp) -> SyntaxError;
 
 /**
  * @brief Executes the IR in reverse.
@@ -116,6 +190,6 @@ exec(const char* source, const uint16_t length, Interpreter& interp) -> SyntaxEr
  * @note This is primarily useful for backpropagation and not meant to be used for inference.
  * */
 [[nodiscard]] auto
-reverseExec(const char* source, const uint16_t length, Interpreter& interp) -> SyntaxError;
+reverseExec(const char* source, const SourceSize length, Interpreter& interp) -> SyntaxError;
 
 } // namespace NN
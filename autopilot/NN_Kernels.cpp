@@ -0,0 +1,2092 @@
+#include "NN_Kernels.h"
+
+#include <string.h>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define NN_KERNELS_X86 1
+#include <immintrin.h>
+#else
+#define NN_KERNELS_X86 0
+#endif
+
+namespace NN {
+
+namespace {
+
+template<typename Func>
+void
+activateLoop(const float* input, float* output, const uint32_t count, Func func)
+{
+  for (uint32_t i = 0; i < count; i++) {
+    output[i] = func(input[i]);
+  }
+}
+
+void
+activatePortable(const float* input,
+                 float* output,
+                 const uint32_t count,
+                 const Activation activation,
+                 const ActivationMode mode)
+{
+  switch (activation) {
+    case Activation::kNone:
+      if (input != output) {
+        activateLoop(input, output, count, [](const float x) -> float { return x; });
+      }
+      break;
+    case Activation::kReLU:
+      activateLoop(input, output, count, applyReLU);
+      break;
+    case Activation::kSigmoid:
+      if (mode == ActivationMode::kPrecise) {
+        activateLoop(input, output, count, [](const float x) -> float { return applySigmoid(x); });
+      } else {
+        activateLoop(
+          input, output, count, [](const float x) -> float { return applySigmoid(x, ActivationMode::kFast); });
+      }
+      break;
+    case Activation::kTanh:
+      if (mode == ActivationMode::kPrecise) {
+        activateLoop(input, output, count, [](const float x) -> float { return applyTanh(x); });
+      } else {
+        activateLoop(input, output, count, [](const float x) -> float { return applyTanh(x, ActivationMode::kFast); });
+      }
+      break;
+  }
+}
+
+/**
+ * @note Four rows are computed at a time so that each input is loaded once for every four weights. The separate
+ *       accumulators also give the FPU independent work without reassociating any sums.
+ * */
+void
+linearPortable(const float* weights,
+               const float* bias,
+               const float* input,
+               float* output,
+               const uint32_t inFeatures,
+               const uint32_t outFeatures,
+               const uint32_t stride,
+               const Activation activation,
+               const ActivationMode mode)
+{
+  uint32_t i = 0;
+
+  for (; (i + 4) <= outFeatures; i += 4) {
+    const auto* w0 = weights + i * stride;
+    const auto* w1 = w0 + stride;
+    const auto* w2 = w1 + stride;
+    const auto* w3 = w2 + stride;
+    float acc0{};
+    float acc1{};
+    float acc2{};
+    float acc3{};
+    for (uint32_t j = 0; j < inFeatures; j++) {
+      const auto in = input[j];
+      acc0 += w0[j] * in;
+      acc1 += w1[j] * in;
+      acc2 += w2[j] * in;
+      acc3 += w3[j] * in;
+    }
+    output[i + 0] = acc0 + bias[i + 0];
+    output[i + 1] = acc1 + bias[i + 1];
+    output[i + 2] = acc2 + bias[i + 2];
+    output[i + 3] = acc3 + bias[i + 3];
+    activatePortable(output + i, output + i, 4, activation, mode);
+  }
+
+  for (; i < outFeatures; i++) {
+    const auto* w = weights + i * stride;
+    float acc{};
+    for (uint32_t j = 0; j < inFeatures; j++) {
+      acc += w[j] * input[j];
+    }
+    output[i] = applyActivation(acc + bias[i], activation, mode);
+  }
+}
+
+/**
+ * @brief Computes four rows of a linear layer for two samples at a time.
+ *
+ * @details This is the inner block of the batched kernels. The four rows are read once for both samples.
+ * */
+using LinearTile = void (*)(const float* weights,
+                            const float* bias,
+                            const float* in0,
+                            const float* in1,
+                            float* out0,
+                            float* out1,
+                            uint32_t inFeatures,
+                            uint32_t stride,
+                            Activation activation,
+                            ActivationMode mode);
+
+void
+linearTilePortable(const float* weights,
+                   const float* bias,
+                   const float* in0,
+                   const float* in1,
+                   float* out0,
+                   float* out1,
+                   const uint32_t inFeatures,
+                   const uint32_t stride,
+                   const Activation activation,
+                   const ActivationMode mode)
+{
+  const auto* w0 = weights;
+  const auto* w1 = w0 + stride;
+  const auto* w2 = w1 + stride;
+  const auto* w3 = w2 + stride;
+  float acc[2][4]{};
+  for (uint32_t j = 0; j < inFeatures; j++) {
+    const auto a = in0[j];
+    const auto b = in1[j];
+    acc[0][0] += w0[j] * a;
+    acc[0][1] += w1[j] * a;
+    acc[0][2] += w2[j] * a;
+    acc[0][3] += w3[j] * a;
+    acc[1][0] += w0[j] * b;
+    acc[1][1] += w1[j] * b;
+    acc[1][2] += w2[j] * b;
+    acc[1][3] += w3[j] * b;
+  }
+  for (uint32_t i = 0; i < 4; i++) {
+    out0[i] = acc[0][i] + bias[i];
+    out1[i] = acc[1][i] + bias[i];
+  }
+  activatePortable(out0, out0, 4, activation, mode);
+  activatePortable(out1, out1, 4, activation, mode);
+}
+
+/**
+ * @brief The number of bytes of weights to keep in cache while they are applied to the whole batch.
+ * */
+constexpr uint32_t kBlockBytes = 16384;
+
+void
+linearBatchDriver(const LinearTile tile,
+                  const LinearKernel gemv,
+                  const float* weights,
+                  const float* bias,
+                  const float* input,
+                  const uint32_t inputStride,
+                  float* output,
+                  const uint32_t outputStride,
+                  const uint32_t inFeatures,
+                  const uint32_t outFeatures,
+                  const uint32_t stride,
+                  const uint32_t batchSize,
+                  const Activation activation,
+                  const ActivationMode mode)
+{
+  const uint32_t rowBytes = ((stride > 0) ? stride : 1) * sizeof(float);
+  uint32_t blockRows = (kBlockBytes / rowBytes) & ~3U;
+  blockRows = (blockRows < 4) ? 4 : blockRows;
+
+  for (uint32_t row = 0; row < outFeatures; row += blockRows) {
+    const auto rows = ((outFeatures - row) < blockRows) ? (outFeatures - row) : blockRows;
+    const auto tileRows = rows & ~3U;
+    const auto* w = weights + row * stride;
+    const auto* b = bias + row;
+
+    uint32_t sample = 0;
+
+    for (; (sample + 2) <= batchSize; sample += 2) {
+      const auto* in0 = input + sample * inputStride;
+      const auto* in1 = in0 + inputStride;
+      auto* out0 = output + sample * outputStride + row;
+      auto* out1 = out0 + outputStride;
+      for (uint32_t i = 0; i < tileRows; i += 4) {
+        tile(w + i * stride, b + i, in0, in1, out0 + i, out1 + i, inFeatures, stride, activation, mode);
+      }
+      if (tileRows < rows) {
+        const auto edgeRows = rows - tileRows;
+        gemv(w + tileRows * stride, b + tileRows, in0, out0 + tileRows, inFeatures, edgeRows, stride, activation, mode);
+        gemv(w + tileRows * stride, b + tileRows, in1, out1 + tileRows, inFeatures, edgeRows, stride, activation, mode);
+      }
+    }
+
+    if (sample < batchSize) {
+      auto* out = output + sample * outputStride + row;
+      gemv(w, b, input + sample * inputStride, out, inFeatures, rows, stride, activation, mode);
+    }
+  }
+}
+
+void
+linearBatchPortable(const float* weights,
+                    const float* bias,
+                    const float* input,
+                    const uint32_t inputStride,
+                    float* output,
+                    const uint32_t outputStride,
+                    const uint32_t inFeatures,
+                    const uint32_t outFeatures,
+                    const uint32_t stride,
+                    const uint32_t batchSize,
+                    const Activation activation,
+                    const ActivationMode mode)
+{
+  linearBatchDriver(linearTilePortable,
+                    linearPortable,
+                    weights,
+                    bias,
+                    input,
+                    inputStride,
+                    output,
+                    outputStride,
+                    inFeatures,
+                    outFeatures,
+                    stride,
+                    batchSize,
+                    activation,
+                    mode);
+}
+
+/**
+ * @brief Computes a block of four rows of a matrix product.
+ *
+ * @details The width of the block depends on the instruction set. When accumulating, the block is added to the
+ *          existing contents of the output instead of overwriting them.
+ * */
+using MatMulTile = void (*)(const float* a,
+                            const float* b,
+                            float* c,
+                            uint32_t depth,
+                            uint32_t lda,
+                            uint32_t ldb,
+                            uint32_t ldc,
+                            bool accumulate);
+
+void
+matMulTilePortable(const float* a,
+                   const float* b,
+                   float* c,
+                   const uint32_t depth,
+                   const uint32_t lda,
+                   const uint32_t ldb,
+                   const uint32_t ldc,
+                   const bool accumulate)
+{
+  float acc[4][4]{};
+  if (accumulate) {
+    for (uint32_t r = 0; r < 4; r++) {
+      for (uint32_t j = 0; j < 4; j++) {
+        acc[r][j] = c[r * ldc + j];
+      }
+    }
+  }
+  for (uint32_t p = 0; p < depth; p++) {
+    const auto* bRow = b + p * ldb;
+    const float b0 = bRow[0];
+    const float b1 = bRow[1];
+    const float b2 = bRow[2];
+    const float b3 = bRow[3];
+    for (uint32_t r = 0; r < 4; r++) {
+      const auto ar = a[r * lda + p];
+      acc[r][0] += ar * b0;
+      acc[r][1] += ar * b1;
+      acc[r][2] += ar * b2;
+      acc[r][3] += ar * b3;
+    }
+  }
+  for (uint32_t r = 0; r < 4; r++) {
+    for (uint32_t j = 0; j < 4; j++) {
+      c[r * ldc + j] = acc[r][j];
+    }
+  }
+}
+
+/**
+ * @brief Computes the parts of a matrix product that do not fill a whole tile.
+ * */
+void
+matMulEdge(const float* a,
+           const float* b,
+           float* c,
+           const uint32_t rowBegin,
+           const uint32_t rowEnd,
+           const uint32_t colBegin,
+           const uint32_t colEnd,
+           const uint32_t depthBegin,
+           const uint32_t depthEnd,
+           const uint32_t k,
+           const uint32_t n,
+           const bool accumulate)
+{
+  // Rows of the right operand are scaled and added to the output, so that the inner loop is contiguous.
+  for (uint32_t i = rowBegin; i < rowEnd; i++) {
+    auto* cRow = c + i * n;
+    if (!accumulate) {
+      for (uint32_t j = colBegin; j < colEnd; j++) {
+        cRow[j] = 0.0F;
+      }
+    }
+    for (uint32_t p = depthBegin; p < depthEnd; p++) {
+      const auto ap = a[i * k + p];
+      const auto* bRow = b + p * n;
+      for (uint32_t j = colBegin; j < colEnd; j++) {
+        cRow[j] += ap * bRow[j];
+      }
+    }
+  }
+}
+
+/**
+ * @brief The number of rows of the right operand that are applied to the output at a time.
+ * */
+constexpr uint32_t kMatMulDepth = 256;
+
+/**
+ * @brief Computes part of one row of a matrix product.
+ *
+ * @details This handles the rows that are left over after the four row tiles, such as in a vector-matrix product.
+ * */
+using MatMulRowTile = void (*)(const float* a, const float* b, float* c, uint32_t depth, uint32_t ldb, bool accumulate);
+
+void
+matMulDriver(const MatMulTile tile,
+             const uint32_t tileCols,
+             const MatMulRowTile rowTile,
+             const uint32_t rowTileCols,
+             const float* a,
+             const float* b,
+             float* c,
+             const uint32_t m,
+             const uint32_t k,
+             const uint32_t n)
+{
+  if (k == 0) {
+    for (uint32_t i = 0; i < (m * n); i++) {
+      c[i] = 0.0F;
+    }
+    return;
+  }
+
+  const auto tileRowsEnd = m & ~3U;
+  const auto tileColsEnd = n - (n % tileCols);
+
+  for (uint32_t depthBegin = 0; depthBegin < k; depthBegin += kMatMulDepth) {
+    const auto depth = ((k - depthBegin) < kMatMulDepth) ? (k - depthBegin) : kMatMulDepth;
+    const auto accumulate = depthBegin > 0;
+    // The panel of the right operand is reused for every row of the left operand, while it is still in cache.
+    for (uint32_t j = 0; j < tileColsEnd; j += tileCols) {
+      for (uint32_t i = 0; i < tileRowsEnd; i += 4) {
+        tile(a + i * k + depthBegin, b + depthBegin * n + j, c + i * n + j, depth, k, n, n, accumulate);
+      }
+    }
+    matMulEdge(a, b, c, 0, tileRowsEnd, tileColsEnd, n, depthBegin, depthBegin + depth, k, n, accumulate);
+    const auto rowTileColsEnd = n - (n % rowTileCols);
+    for (uint32_t i = tileRowsEnd; i < m; i++) {
+      for (uint32_t j = 0; j < rowTileColsEnd; j += rowTileCols) {
+        rowTile(a + i * k + depthBegin, b + depthBegin * n + j, c + i * n + j, depth, n, accumulate);
+      }
+    }
+    matMulEdge(a, b, c, tileRowsEnd, m, rowTileColsEnd, n, depthBegin, depthBegin + depth, k, n, accumulate);
+  }
+}
+
+void
+matMulRowTilePortable(const float* a,
+                      const float* b,
+                      float* c,
+                      const uint32_t depth,
+                      const uint32_t ldb,
+                      const bool accumulate)
+{
+  float acc[4]{};
+  if (accumulate) {
+    for (uint32_t j = 0; j < 4; j++) {
+      acc[j] = c[j];
+    }
+  }
+  for (uint32_t p = 0; p < depth; p++) {
+    const auto ap = a[p];
+    const auto* bRow = b + p * ldb;
+    for (uint32_t j = 0; j < 4; j++) {
+      acc[j] += ap * bRow[j];
+    }
+  }
+  for (uint32_t j = 0; j < 4; j++) {
+    c[j] = acc[j];
+  }
+}
+
+void
+matMulPortable(const float* a, const float* b, float* c, const uint32_t m, const uint32_t k, const uint32_t n)
+{
+  matMulDriver(matMulTilePortable, 4, matMulRowTilePortable, 4, a, b, c, m, k, n);
+}
+
+void
+linearInt8Portable(const int8_t* weights,
+                   const int32_t* bias,
+                   const float* multipliers,
+                   const int8_t* input,
+                   int8_t* output,
+                   const uint32_t inFeatures,
+                   const uint32_t outFeatures,
+                   const int32_t minValue)
+{
+  for (uint32_t i = 0; i < outFeatures; i++) {
+    const auto* w = weights + i * inFeatures;
+    int32_t acc = bias[i];
+    for (uint32_t j = 0; j < inFeatures; j++) {
+      acc += static_cast<int32_t>(w[j]) * static_cast<int32_t>(input[j]);
+    }
+    output[i] = roundToInt8(static_cast<float>(acc) * multipliers[i], minValue);
+  }
+}
+
+/**
+ * @note Cortex-M4F and later FPUs convert binary16 in one instruction, which the compiler emits for `__fp16`.
+ * */
+inline auto
+widenFloat16(const uint16_t h) -> float
+{
+#if defined(__ARM_FP16_FORMAT_IEEE)
+  __fp16 x;
+  memcpy(&x, &h, sizeof(x));
+  return x;
+#else
+  // Moves the exponent and mantissa into place, then fixes up the cases where the exponent is all zeros or all ones.
+  const uint32_t shiftedExp = 0x7c00U << 13;
+  uint32_t bits = (h & 0x7fffU) << 13;
+  const auto exp = bits & shiftedExp;
+  bits += (127U - 15U) << 23;
+  if (exp == shiftedExp) {
+    bits += (128U - 16U) << 23;
+  } else if (exp == 0) {
+    // Subnormals are renormalized by subtracting the implicit one that was added.
+    bits += 1U << 23;
+    float x;
+    memcpy(&x, &bits, sizeof(x));
+    x -= 6.103515625e-05F;
+    memcpy(&bits, &x, sizeof(x));
+  }
+  bits |= static_cast<uint32_t>(h & 0x8000U) << 16;
+  float x;
+  memcpy(&x, &bits, sizeof(x));
+  return x;
+#endif
+}
+
+inline auto
+widenBFloat16(const uint16_t h) -> float
+{
+  const uint32_t bits = static_cast<uint32_t>(h) << 16;
+  float x;
+  memcpy(&x, &bits, sizeof(x));
+  return x;
+}
+
+template<HalfFormat Format>
+inline auto
+widenHalf(const uint16_t h) -> float
+{
+  return (Format == HalfFormat::kBFloat16) ? widenBFloat16(h) : widenFloat16(h);
+}
+
+/**
+ * @note This is the same as @ref linearPortable, apart from widening each weight as it is loaded.
+ * */
+template<HalfFormat Format>
+void
+linearHalfLoop(const uint16_t* weights,
+               const uint16_t* bias,
+               const float* input,
+               float* output,
+               const uint32_t inFeatures,
+               const uint32_t outFeatures,
+               const uint32_t stride,
+               const Activation activation,
+               const ActivationMode mode)
+{
+  uint32_t i = 0;
+
+  for (; (i + 4) <= outFeatures; i += 4) {
+    const auto* w0 = weights + i * stride;
+    const auto* w1 = w0 + stride;
+    const auto* w2 = w1 + stride;
+    const auto* w3 = w2 + stride;
+    float acc0{};
+    float acc1{};
+    float acc2{};
+    float acc3{};
+    for (uint32_t j = 0; j < inFeatures; j++) {
+      const auto in = input[j];
+      acc0 += widenHalf<Format>(w0[j]) * in;
+      acc1 += widenHalf<Format>(w1[j]) * in;
+      acc2 += widenHalf<Format>(w2[j]) * in;
+      acc3 += widenHalf<Format>(w3[j]) * in;
+    }
+    output[i + 0] = acc0 + widenHalf<Format>(bias[i + 0]);
+    output[i + 1] = acc1 + widenHalf<Format>(bias[i + 1]);
+    output[i + 2] = acc2 + widenHalf<Format>(bias[i + 2]);
+    output[i + 3] = acc3 + widenHalf<Format>(bias[i + 3]);
+    activatePortable(output + i, output + i, 4, activation, mode);
+  }
+
+  for (; i < outFeatures; i++) {
+    const auto* w = weights + i * stride;
+    float acc{};
+    for (uint32_t j = 0; j < inFeatures; j++) {
+      acc += widenHalf<Format>(w[j]) * input[j];
+    }
+    output[i] = applyActivation(acc + widenHalf<Format>(bias[i]), activation, mode);
+  }
+}
+
+void
+linearHalfPortable(const uint16_t* weights,
+                   const uint16_t* bias,
+                   const float* input,
+                   float* output,
+                   const uint32_t inFeatures,
+                   const uint32_t outFeatures,
+                   const uint32_t stride,
+                   const HalfFormat format,
+                   const Activation activation,
+                   const ActivationMode mode)
+{
+  if (format == HalfFormat::kBFloat16) {
+    linearHalfLoop<HalfFormat::kBFloat16>(
+      weights, bias, input, output, inFeatures, outFeatures, stride, activation, mode);
+  } else {
+    linearHalfLoop<HalfFormat::kFloat16>(
+      weights, bias, input, output, inFeatures, outFeatures, stride, activation, mode);
+  }
+}
+
+#if NN_KERNELS_X86
+
+/**
+ * @note The SIMD activations below perform the same operations as the scalar ones in @ref NN_Activation.h, in the same
+ *       order and without fused multiply-adds, so that they produce the same bits.
+ * */
+__attribute__((target("sse2"))) inline auto
+selectSSE2(const __m128 mask, const __m128 a, const __m128 b) -> __m128
+{
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+__attribute__((target("sse2"))) inline auto
+roundToIntegralSSE2(const __m128 x) -> __m128
+{
+  const auto magic = _mm_set1_ps(12582912.0F);
+  return _mm_sub_ps(_mm_add_ps(x, magic), magic);
+}
+
+__attribute__((target("sse2"))) inline auto
+pow2SSE2(const __m128i n) -> __m128
+{
+  return _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23));
+}
+
+__attribute__((target("sse2"))) inline auto
+preciseExpSSE2(const __m128 x) -> __m128
+{
+  const auto hi = _mm_set1_ps(88.7228394F);
+  const auto lo = _mm_set1_ps(-87.3365479F);
+  const auto c = _mm_max_ps(_mm_min_ps(x, hi), lo);
+  const auto n = roundToIntegralSSE2(_mm_mul_ps(c, _mm_set1_ps(1.44269504F)));
+  const auto r0 = _mm_sub_ps(c, _mm_mul_ps(n, _mm_set1_ps(0.693359375F)));
+  const auto r = _mm_sub_ps(r0, _mm_mul_ps(n, _mm_set1_ps(-2.12194440e-4F)));
+  auto p = _mm_set1_ps(1.9875691500e-4F);
+  p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(1.3981999507e-3F));
+  p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(8.3334519073e-3F));
+  p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(4.1665795894e-2F));
+  p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(1.6666665459e-1F));
+  p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(5.0000001201e-1F));
+  auto y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(p, _mm_mul_ps(r, r)), r), _mm_set1_ps(1.0F));
+  const auto ni = _mm_cvttps_epi32(n);
+  const auto n1 = _mm_srai_epi32(ni, 1);
+  y = _mm_mul_ps(_mm_mul_ps(y, pow2SSE2(n1)), pow2SSE2(_mm_sub_epi32(ni, n1)));
+  y = _mm_and_ps(_mm_cmpgt_ps(x, lo), y);
+  y = selectSSE2(_mm_cmplt_ps(x, hi), y, _mm_castsi128_ps(_mm_set1_epi32(0x7f800000)));
+  return selectSSE2(_mm_cmpeq_ps(x, x), y, x);
+}
+
+__attribute__((target("sse2"))) inline auto
+fastExpSSE2(const __m128 x) -> __m128
+{
+  const auto c = _mm_max_ps(_mm_min_ps(x, _mm_set1_ps(88.0F)), _mm_set1_ps(-86.0F));
+  const auto n = roundToIntegralSSE2(_mm_mul_ps(c, _mm_set1_ps(1.44269504F)));
+  const auto r = _mm_sub_ps(c, _mm_mul_ps(n, _mm_set1_ps(0.693147182F)));
+  auto p = _mm_set1_ps(4.12777211e-2F);
+  p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(1.67535328e-1F));
+  p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(5.00051179e-1F));
+  const auto y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(p, _mm_mul_ps(r, r)), r), _mm_set1_ps(1.0F));
+  return _mm_mul_ps(y, pow2SSE2(_mm_cvttps_epi32(n)));
+}
+
+__attribute__((target("sse2"))) inline auto
+expSSE2(const __m128 x, const ActivationMode mode) -> __m128
+{
+  return (mode == ActivationMode::kPrecise) ? preciseExpSSE2(x) : fastExpSSE2(x);
+}
+
+__attribute__((target("sse2"))) inline auto
+sigmoidSSE2(const __m128 x, const ActivationMode mode) -> __m128
+{
+  const auto one = _mm_set1_ps(1.0F);
+  return _mm_div_ps(one, _mm_add_ps(one, expSSE2(_mm_xor_ps(x, _mm_set1_ps(-0.0F)), mode)));
+}
+
+__attribute__((target("sse2"))) inline auto
+tanhSSE2(const __m128 x, const ActivationMode mode) -> __m128
+{
+  const auto sign = _mm_set1_ps(-0.0F);
+  const auto one = _mm_set1_ps(1.0F);
+  const auto a = _mm_andnot_ps(sign, x);
+  const auto z = _mm_mul_ps(a, a);
+  auto p = _mm_set1_ps(-5.70498872745e-3F);
+  p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(2.06390887954e-2F));
+  p = _mm_sub_ps(_mm_mul_ps(p, z), _mm_set1_ps(5.37397155531e-2F));
+  p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(1.33314422036e-1F));
+  p = _mm_sub_ps(_mm_mul_ps(p, z), _mm_set1_ps(3.33332819422e-1F));
+  const auto small = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(p, z), a), a);
+  const auto ex = expSSE2(_mm_add_ps(a, a), mode);
+  const auto large = _mm_sub_ps(one, _mm_div_ps(_mm_set1_ps(2.0F), _mm_add_ps(ex, one)));
+  const auto t = selectSSE2(_mm_cmplt_ps(a, _mm_set1_ps(0.625F)), small, large);
+  return _mm_or_ps(t, _mm_and_ps(x, sign));
+}
+
+__attribute__((target("sse2"))) void
+activateSSE2(const float* input,
+             float* output,
+             const uint32_t count,
+             const Activation activation,
+             const ActivationMode mode)
+{
+  uint32_t i = 0;
+
+  switch (activation) {
+    case Activation::kNone:
+      break;
+    case Activation::kReLU:
+      for (; (i + 4) <= count; i += 4) {
+        const auto x = _mm_loadu_ps(input + i);
+        _mm_storeu_ps(output + i, _mm_and_ps(_mm_cmpge_ps(x, _mm_setzero_ps()), x));
+      }
+      break;
+    case Activation::kSigmoid:
+      for (; (i + 4) <= count; i += 4) {
+        _mm_storeu_ps(output + i, sigmoidSSE2(_mm_loadu_ps(input + i), mode));
+      }
+      break;
+    case Activation::kTanh:
+      for (; (i + 4) <= count; i += 4) {
+        _mm_storeu_ps(output + i, tanhSSE2(_mm_loadu_ps(input + i), mode));
+      }
+      break;
+  }
+
+  activatePortable(input + i, output + i, count - i, activation, mode);
+}
+
+__attribute__((target("avx2"))) inline auto
+roundToIntegralAVX2(const __m256 x) -> __m256
+{
+  const auto magic = _mm256_set1_ps(12582912.0F);
+  return _mm256_sub_ps(_mm256_add_ps(x, magic), magic);
+}
+
+__attribute__((target("avx2"))) inline auto
+pow2AVX2(const __m256i n) -> __m256
+{
+  return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(n, _mm256_set1_epi32(127)), 23));
+}
+
+__attribute__((target("avx2"))) inline auto
+preciseExpAVX2(const __m256 x) -> __m256
+{
+  const auto hi = _mm256_set1_ps(88.7228394F);
+  const auto lo = _mm256_set1_ps(-87.3365479F);
+  const auto c = _mm256_max_ps(_mm256_min_ps(x, hi), lo);
+  const auto n = roundToIntegralAVX2(_mm256_mul_ps(c, _mm256_set1_ps(1.44269504F)));
+  const auto r0 = _mm256_sub_ps(c, _mm256_mul_ps(n, _mm256_set1_ps(0.693359375F)));
+  const auto r = _mm256_sub_ps(r0, _mm256_mul_ps(n, _mm256_set1_ps(-2.12194440e-4F)));
+  auto p = _mm256_set1_ps(1.9875691500e-4F);
+  p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(1.3981999507e-3F));
+  p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(8.3334519073e-3F));
+  p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(4.1665795894e-2F));
+  p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(1.6666665459e-1F));
+  p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(5.0000001201e-1F));
+  auto y = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(p, _mm256_mul_ps(r, r)), r), _mm256_set1_ps(1.0F));
+  const auto ni = _mm256_cvttps_epi32(n);
+  const auto n1 = _mm256_srai_epi32(ni, 1);
+  y = _mm256_mul_ps(_mm256_mul_ps(y, pow2AVX2(n1)), pow2AVX2(_mm256_sub_epi32(ni, n1)));
+  y = _mm256_and_ps(_mm256_cmp_ps(x, lo, _CMP_GT_OQ), y);
+  y = _mm256_blendv_ps(_mm256_castsi256_ps(_mm256_set1_epi32(0x7f800000)), y, _mm256_cmp_ps(x, hi, _CMP_LT_OQ));
+  return _mm256_blendv_ps(x, y, _mm256_cmp_ps(x, x, _CMP_EQ_OQ));
+}
+
+__attribute__((target("avx2"))) inline auto
+fastExpAVX2(const __m256 x) -> __m256
+{
+  const auto c = _mm256_max_ps(_mm256_min_ps(x, _mm256_set1_ps(88.0F)), _mm256_set1_ps(-86.0F));
+  const auto n = roundToIntegralAVX2(_mm256_mul_ps(c, _mm256_set1_ps(1.44269504F)));
+  const auto r = _mm256_sub_ps(c, _mm256_mul_ps(n, _mm256_set1_ps(0.693147182F)));
+  auto p = _mm256_set1_ps(4.12777211e-2F);
+  p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(1.67535328e-1F));
+  p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(5.00051179e-1F));
+  const auto y = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(p, _mm256_mul_ps(r, r)), r), _mm256_set1_ps(1.0F));
+  return _mm256_mul_ps(y, pow2AVX2(_mm256_cvttps_epi32(n)));
+}
+
+__attribute__((target("avx2"))) inline auto
+expAVX2(const __m256 x, const ActivationMode mode) -> __m256
+{
+  return (mode == ActivationMode::kPrecise) ? preciseExpAVX2(x) : fastExpAVX2(x);
+}
+
+__attribute__((target("avx2"))) inline auto
+sigmoidAVX2(const __m256 x, const ActivationMode mode) -> __m256
+{
+  const auto one = _mm256_set1_ps(1.0F);
+  return _mm256_div_ps(one, _mm256_add_ps(one, expAVX2(_mm256_xor_ps(x, _mm256_set1_ps(-0.0F)), mode)));
+}
+
+__attribute__((target("avx2"))) inline auto
+tanhAVX2(const __m256 x, const ActivationMode mode) -> __m256
+{
+  const auto sign = _mm256_set1_ps(-0.0F);
+  const auto one = _mm256_set1_ps(1.0F);
+  const auto a = _mm256_andnot_ps(sign, x);
+  const auto z = _mm256_mul_ps(a, a);
+  auto p = _mm256_set1_ps(-5.70498872745e-3F);
+  p = _mm256_add_ps(_mm256_mul_ps(p, z), _mm256_set1_ps(2.06390887954e-2F));
+  p = _mm256_sub_ps(_mm256_mul_ps(p, z), _mm256_set1_ps(5.37397155531e-2F));
+  p = _mm256_add_ps(_mm256_mul_ps(p, z), _mm256_set1_ps(1.33314422036e-1F));
+  p = _mm256_sub_ps(_mm256_mul_ps(p, z), _mm256_set1_ps(3.33332819422e-1F));
+  const auto small = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(p, z), a), a);
+  const auto ex = expAVX2(_mm256_add_ps(a, a), mode);
+  const auto large = _mm256_sub_ps(one, _mm256_div_ps(_mm256_set1_ps(2.0F), _mm256_add_ps(ex, one)));
+  const auto t = _mm256_blendv_ps(large, small, _mm256_cmp_ps(a, _mm256_set1_ps(0.625F), _CMP_LT_OQ));
+  return _mm256_or_ps(t, _mm256_and_ps(x, sign));
+}
+
+/**
+ * @note This is also used by the AVX-512 kernels, since the activations are a small part of their work.
+ * */
+__attribute__((target("avx2"))) void
+activateAVX2(const float* input,
+             float* output,
+             const uint32_t count,
+             const Activation activation,
+             const ActivationMode mode)
+{
+  uint32_t i = 0;
+
+  switch (activation) {
+    case Activation::kNone:
+      break;
+    case Activation::kReLU:
+      for (; (i + 8) <= count; i += 8) {
+        const auto x = _mm256_loadu_ps(input + i);
+        _mm256_storeu_ps(output + i, _mm256_and_ps(_mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_GE_OQ), x));
+      }
+      break;
+    case Activation::kSigmoid:
+      for (; (i + 8) <= count; i += 8) {
+        _mm256_storeu_ps(output + i, sigmoidAVX2(_mm256_loadu_ps(input + i), mode));
+      }
+      break;
+    case Activation::kTanh:
+      for (; (i + 8) <= count; i += 8) {
+        _mm256_storeu_ps(output + i, tanhAVX2(_mm256_loadu_ps(input + i), mode));
+      }
+      break;
+  }
+
+  activateSSE2(input + i, output + i, count - i, activation, mode);
+}
+
+__attribute__((target("sse2"))) void
+linearSSE2(const float* weights,
+           const float* bias,
+           const float* input,
+           float* output,
+           const uint32_t inFeatures,
+           const uint32_t outFeatures,
+           const uint32_t stride,
+           const Activation activation,
+           const ActivationMode mode)
+{
+  const uint32_t vecEnd = inFeatures & ~3U;
+
+  uint32_t i = 0;
+
+  for (; (i + 4) <= outFeatures; i += 4) {
+    const auto* w0 = weights + i * stride;
+    const auto* w1 = w0 + stride;
+    const auto* w2 = w1 + stride;
+    const auto* w3 = w2 + stride;
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    __m128 acc2 = _mm_setzero_ps();
+    __m128 acc3 = _mm_setzero_ps();
+    for (uint32_t j = 0; j < vecEnd; j += 4) {
+      const __m128 in = _mm_loadu_ps(input + j);
+      acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(w0 + j), in));
+      acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(w1 + j), in));
+      acc2 = _mm_add_ps(acc2, _mm_mul_ps(_mm_loadu_ps(w2 + j), in));
+      acc3 = _mm_add_ps(acc3, _mm_mul_ps(_mm_loadu_ps(w3 + j), in));
+    }
+    _MM_TRANSPOSE4_PS(acc0, acc1, acc2, acc3);
+    __m128 sum = _mm_add_ps(_mm_add_ps(acc0, acc1), _mm_add_ps(acc2, acc3));
+    sum = _mm_add_ps(sum, _mm_loadu_ps(bias + i));
+    float tail[4];
+    _mm_storeu_ps(tail, sum);
+    for (uint32_t j = vecEnd; j < inFeatures; j++) {
+      const auto in = input[j];
+      tail[0] += w0[j] * in;
+      tail[1] += w1[j] * in;
+      tail[2] += w2[j] * in;
+      tail[3] += w3[j] * in;
+    }
+    output[i + 0] = tail[0];
+    output[i + 1] = tail[1];
+    output[i + 2] = tail[2];
+    output[i + 3] = tail[3];
+    activateSSE2(output + i, output + i, 4, activation, mode);
+  }
+
+  for (; i < outFeatures; i++) {
+    const auto* w = weights + i * stride;
+    __m128 acc = _mm_setzero_ps();
+    for (uint32_t j = 0; j < vecEnd; j += 4) {
+      acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(w + j), _mm_loadu_ps(input + j)));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc);
+    float sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    for (uint32_t j = vecEnd; j < inFeatures; j++) {
+      sum += w[j] * input[j];
+    }
+    output[i] = applyActivation(sum + bias[i], activation, mode);
+  }
+}
+
+__attribute__((target("avx2,fma"))) void
+linearAVX2(const float* weights,
+           const float* bias,
+           const float* input,
+           float* output,
+           const uint32_t inFeatures,
+           const uint32_t outFeatures,
+           const uint32_t stride,
+           const Activation activation,
+           const ActivationMode mode)
+{
+  const uint32_t vecEnd = inFeatures & ~7U;
+
+  uint32_t i = 0;
+
+  for (; (i + 4) <= outFeatures; i += 4) {
+    const auto* w0 = weights + i * stride;
+    const auto* w1 = w0 + stride;
+    const auto* w2 = w1 + stride;
+    const auto* w3 = w2 + stride;
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    __m256 acc2 = _mm256_setzero_ps();
+    __m256 acc3 = _mm256_setzero_ps();
+    for (uint32_t j = 0; j < vecEnd; j += 8) {
+      const __m256 in = _mm256_loadu_ps(input + j);
+      acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(w0 + j), in, acc0);
+      acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(w1 + j), in, acc1);
+      acc2 = _mm256_fmadd_ps(_mm256_loadu_ps(w2 + j), in, acc2);
+      acc3 = _mm256_fmadd_ps(_mm256_loadu_ps(w3 + j), in, acc3);
+    }
+    // Reduces the four accumulators into one vector, with one lane per row.
+    const __m256 s01 = _mm256_hadd_ps(acc0, acc1);
+    const __m256 s23 = _mm256_hadd_ps(acc2, acc3);
+    const __m256 s = _mm256_hadd_ps(s01, s23);
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(s), _mm256_extractf128_ps(s, 1));
+    sum = _mm_add_ps(sum, _mm_loadu_ps(bias + i));
+    float tail[4];
+    _mm_storeu_ps(tail, sum);
+    for (uint32_t j = vecEnd; j < inFeatures; j++) {
+      const auto in = input[j];
+      tail[0] += w0[j] * in;
+      tail[1] += w1[j] * in;
+      tail[2] += w2[j] * in;
+      tail[3] += w3[j] * in;
+    }
+    output[i + 0] = tail[0];
+    output[i + 1] = tail[1];
+    output[i + 2] = tail[2];
+    output[i + 3] = tail[3];
+    activateAVX2(output + i, output + i, 4, activation, mode);
+  }
+
+  for (; i < outFeatures; i++) {
+    const auto* w = weights + i * stride;
+    __m256 acc = _mm256_setzero_ps();
+    for (uint32_t j = 0; j < vecEnd; j += 8) {
+      acc = _mm256_fmadd_ps(_mm256_loadu_ps(w + j), _mm256_loadu_ps(input + j), acc);
+    }
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    half = _mm_hadd_ps(half, half);
+    half = _mm_hadd_ps(half, half);
+    float sum = _mm_cvtss_f32(half);
+    for (uint32_t j = vecEnd; j < inFeatures; j++) {
+      sum += w[j] * input[j];
+    }
+    output[i] = applyActivation(sum + bias[i], activation, mode);
+  }
+}
+
+/**
+ * @note This does the same as _mm512_reduce_add_ps. The shuffles that it uses trip -Wmaybe-uninitialized in some GCC
+ *       versions, so the upper half goes through memory instead.
+ * */
+__attribute__((target("avx512f"))) inline auto
+reduceAVX512(const __m512 v) -> float
+{
+  alignas(64) float lanes[16];
+  _mm512_store_ps(lanes, v);
+  const __m256 h = _mm256_add_ps(_mm256_load_ps(lanes), _mm256_load_ps(lanes + 8));
+  __m128 q = _mm_add_ps(_mm256_castps256_ps128(h), _mm256_extractf128_ps(h, 1));
+  q = _mm_add_ps(q, _mm_movehl_ps(q, q));
+  q = _mm_add_ss(q, _mm_shuffle_ps(q, q, 1));
+  return _mm_cvtss_f32(q);
+}
+
+__attribute__((target("avx512f"))) void
+linearAVX512(const float* weights,
+             const float* bias,
+             const float* input,
+             float* output,
+             const uint32_t inFeatures,
+             const uint32_t outFeatures,
+             const uint32_t stride,
+             const Activation activation,
+             const ActivationMode mode)
+{
+  const uint32_t vecEnd = inFeatures & ~15U;
+
+  const auto tailMask = static_cast<__mmask16>((1U << (inFeatures - vecEnd)) - 1U);
+
+  uint32_t i = 0;
+
+  for (; (i + 4) <= outFeatures; i += 4) {
+    const auto* w0 = weights + i * stride;
+    const auto* w1 = w0 + stride;
+    const auto* w2 = w1 + stride;
+    const auto* w3 = w2 + stride;
+    __m512 acc0 = _mm512_setzero_ps();
+    __m512 acc1 = _mm512_setzero_ps();
+    __m512 acc2 = _mm512_setzero_ps();
+    __m512 acc3 = _mm512_setzero_ps();
+    for (uint32_t j = 0; j < vecEnd; j += 16) {
+      const __m512 in = _mm512_loadu_ps(input + j);
+      acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(w0 + j), in, acc0);
+      acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(w1 + j), in, acc1);
+      acc2 = _mm512_fmadd_ps(_mm512_loadu_ps(w2 + j), in, acc2);
+      acc3 = _mm512_fmadd_ps(_mm512_loadu_ps(w3 + j), in, acc3);
+    }
+    if (tailMask) {
+      const __m512 in = _mm512_maskz_loadu_ps(tailMask, input + vecEnd);
+      acc0 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(tailMask, w0 + vecEnd), in, acc0);
+      acc1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(tailMask, w1 + vecEnd), in, acc1);
+      acc2 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(tailMask, w2 + vecEnd), in, acc2);
+      acc3 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(tailMask, w3 + vecEnd), in, acc3);
+    }
+    output[i + 0] = reduceAVX512(acc0) + bias[i + 0];
+    output[i + 1] = reduceAVX512(acc1) + bias[i + 1];
+    output[i + 2] = reduceAVX512(acc2) + bias[i + 2];
+    output[i + 3] = reduceAVX512(acc3) + bias[i + 3];
+    activateAVX2(output + i, output + i, 4, activation, mode);
+  }
+
+  for (; i < outFeatures; i++) {
+    const auto* w = weights + i * stride;
+    __m512 acc = _mm512_setzero_ps();
+    for (uint32_t j = 0; j < vecEnd; j += 16) {
+      acc = _mm512_fmadd_ps(_mm512_loadu_ps(w + j), _mm512_loadu_ps(input + j), acc);
+    }
+    if (tailMask) {
+      acc = _mm512_fmadd_ps(
+        _mm512_maskz_loadu_ps(tailMask, w + vecEnd), _mm512_maskz_loadu_ps(tailMask, input + vecEnd), acc);
+    }
+    output[i] = applyActivation(reduceAVX512(acc) + bias[i], activation, mode);
+  }
+}
+
+__attribute__((target("sse2"))) void
+linearTileSSE2(const float* weights,
+               const float* bias,
+               const float* in0,
+               const float* in1,
+               float* out0,
+               float* out1,
+               const uint32_t inFeatures,
+               const uint32_t stride,
+               const Activation activation,
+               const ActivationMode mode)
+{
+  const uint32_t vecEnd = inFeatures & ~3U;
+  const float* w[4]{ weights, weights + stride, weights + 2 * stride, weights + 3 * stride };
+  __m128 acc0[4]{ _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps() };
+  __m128 acc1[4]{ _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps() };
+  for (uint32_t j = 0; j < vecEnd; j += 4) {
+    const __m128 a = _mm_loadu_ps(in0 + j);
+    const __m128 b = _mm_loadu_ps(in1 + j);
+    for (uint32_t r = 0; r < 4; r++) {
+      const __m128 wr = _mm_loadu_ps(w[r] + j);
+      acc0[r] = _mm_add_ps(acc0[r], _mm_mul_ps(wr, a));
+      acc1[r] = _mm_add_ps(acc1[r], _mm_mul_ps(wr, b));
+    }
+  }
+  _MM_TRANSPOSE4_PS(acc0[0], acc0[1], acc0[2], acc0[3]);
+  _MM_TRANSPOSE4_PS(acc1[0], acc1[1], acc1[2], acc1[3]);
+  const __m128 bv = _mm_loadu_ps(bias);
+  const __m128 sum0 = _mm_add_ps(_mm_add_ps(_mm_add_ps(acc0[0], acc0[1]), _mm_add_ps(acc0[2], acc0[3])), bv);
+  const __m128 sum1 = _mm_add_ps(_mm_add_ps(_mm_add_ps(acc1[0], acc1[1]), _mm_add_ps(acc1[2], acc1[3])), bv);
+  _mm_storeu_ps(out0, sum0);
+  _mm_storeu_ps(out1, sum1);
+  for (uint32_t j = vecEnd; j < inFeatures; j++) {
+    for (uint32_t r = 0; r < 4; r++) {
+      out0[r] += w[r][j] * in0[j];
+      out1[r] += w[r][j] * in1[j];
+    }
+  }
+  activateSSE2(out0, out0, 4, activation, mode);
+  activateSSE2(out1, out1, 4, activation, mode);
+}
+
+__attribute__((target("avx2,fma"))) void
+linearTileAVX2(const float* weights,
+               const float* bias,
+               const float* in0,
+               const float* in1,
+               float* out0,
+               float* out1,
+               const uint32_t inFeatures,
+               const uint32_t stride,
+               const Activation activation,
+               const ActivationMode mode)
+{
+  const uint32_t vecEnd = inFeatures & ~7U;
+  const float* w[4]{ weights, weights + stride, weights + 2 * stride, weights + 3 * stride };
+  __m256 acc0[4]{ _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps() };
+  __m256 acc1[4]{ _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps() };
+  for (uint32_t j = 0; j < vecEnd; j += 8) {
+    const __m256 a = _mm256_loadu_ps(in0 + j);
+    const __m256 b = _mm256_loadu_ps(in1 + j);
+    for (uint32_t r = 0; r < 4; r++) {
+      const __m256 wr = _mm256_loadu_ps(w[r] + j);
+      acc0[r] = _mm256_fmadd_ps(wr, a, acc0[r]);
+      acc1[r] = _mm256_fmadd_ps(wr, b, acc1[r]);
+    }
+  }
+  const __m128 bv = _mm_loadu_ps(bias);
+  const __m256 s0 = _mm256_hadd_ps(_mm256_hadd_ps(acc0[0], acc0[1]), _mm256_hadd_ps(acc0[2], acc0[3]));
+  const __m256 s1 = _mm256_hadd_ps(_mm256_hadd_ps(acc1[0], acc1[1]), _mm256_hadd_ps(acc1[2], acc1[3]));
+  _mm_storeu_ps(out0, _mm_add_ps(_mm_add_ps(_mm256_castps256_ps128(s0), _mm256_extractf128_ps(s0, 1)), bv));
+  _mm_storeu_ps(out1, _mm_add_ps(_mm_add_ps(_mm256_castps256_ps128(s1), _mm256_extractf128_ps(s1, 1)), bv));
+  for (uint32_t j = vecEnd; j < inFeatures; j++) {
+    for (uint32_t r = 0; r < 4; r++) {
+      out0[r] += w[r][j] * in0[j];
+      out1[r] += w[r][j] * in1[j];
+    }
+  }
+  activateAVX2(out0, out0, 4, activation, mode);
+  activateAVX2(out1, out1, 4, activation, mode);
+}
+
+__attribute__((target("avx512f"))) void
+linearTileAVX512(const float* weights,
+                 const float* bias,
+                 const float* in0,
+                 const float* in1,
+                 float* out0,
+                 float* out1,
+                 const uint32_t inFeatures,
+                 const uint32_t stride,
+                 const Activation activation,
+                 const ActivationMode mode)
+{
+  const uint32_t vecEnd = inFeatures & ~15U;
+  const auto tailMask = static_cast<__mmask16>((1U << (inFeatures - vecEnd)) - 1U);
+  const float* w[4]{ weights, weights + stride, weights + 2 * stride, weights + 3 * stride };
+  __m512 acc0[4]{ _mm512_setzero_ps(), _mm512_setzero_ps(), _mm512_setzero_ps(), _mm512_setzero_ps() };
+  __m512 acc1[4]{ _mm512_setzero_ps(), _mm512_setzero_ps(), _mm512_setzero_ps(), _mm512_setzero_ps() };
+  for (uint32_t j = 0; j < vecEnd; j += 16) {
+    const __m512 a = _mm512_loadu_ps(in0 + j);
+    const __m512 b = _mm512_loadu_ps(in1 + j);
+    for (uint32_t r = 0; r < 4; r++) {
+      const __m512 wr = _mm512_loadu_ps(w[r] + j);
+      acc0[r] = _mm512_fmadd_ps(wr, a, acc0[r]);
+      acc1[r] = _mm512_fmadd_ps(wr, b, acc1[r]);
+    }
+  }
+  if (tailMask) {
+    const __m512 a = _mm512_maskz_loadu_ps(tailMask, in0 + vecEnd);
+    const __m512 b = _mm512_maskz_loadu_ps(tailMask, in1 + vecEnd);
+    for (uint32_t r = 0; r < 4; r++) {
+      const __m512 wr = _mm512_maskz_loadu_ps(tailMask, w[r] + vecEnd);
+      acc0[r] = _mm512_fmadd_ps(wr, a, acc0[r]);
+      acc1[r] = _mm512_fmadd_ps(wr, b, acc1[r]);
+    }
+  }
+  for (uint32_t r = 0; r < 4; r++) {
+    out0[r] = reduceAVX512(acc0[r]) + bias[r];
+    out1[r] = reduceAVX512(acc1[r]) + bias[r];
+  }
+  activateAVX2(out0, out0, 4, activation, mode);
+  activateAVX2(out1, out1, 4, activation, mode);
+}
+
+#define NN_DEFINE_LINEAR_BATCH(isaName)                                                                               \
+  void linearBatch##isaName(const float* weights,                                                                    \
+                            const float* bias,                                                                       \
+                            const float* input,                                                                      \
+                            const uint32_t inputStride,                                                              \
+                            float* output,                                                                           \
+                            const uint32_t outputStride,                                                             \
+                            const uint32_t inFeatures,                                                               \
+                            const uint32_t outFeatures,                                                              \
+                            const uint32_t stride,                                                                   \
+                            const uint32_t batchSize,                                                                \
+                            const Activation activation,                                                             \
+                            const ActivationMode mode)                                                               \
+  {                                                                                                                  \
+    linearBatchDriver(linearTile##isaName,                                                                           \
+                      linear##isaName,                                                                               \
+                      weights,                                                                                       \
+                      bias,                                                                                          \
+                      input,                                                                                         \
+                      inputStride,                                                                                   \
+                      output,                                                                                        \
+                      outputStride,                                                                                  \
+                      inFeatures,                                                                                    \
+                      outFeatures,                                                                                   \
+                      stride,                                                                                        \
+                      batchSize,                                                                                     \
+                      activation,                                                                                    \
+                      mode);                                                                                         \
+  }
+
+NN_DEFINE_LINEAR_BATCH(SSE2)
+NN_DEFINE_LINEAR_BATCH(AVX2)
+NN_DEFINE_LINEAR_BATCH(AVX512)
+
+#undef NN_DEFINE_LINEAR_BATCH
+
+__attribute__((target("sse2"))) void
+matMulTileSSE2(const float* a,
+              const float* b,
+              float* c,
+              const uint32_t depth,
+              const uint32_t lda,
+              const uint32_t ldb,
+              const uint32_t ldc,
+              const bool accumulate)
+{
+  __m128 acc[4][2];
+  for (uint32_t r = 0; r < 4; r++) {
+    acc[r][0] = accumulate ? _mm_loadu_ps(c + r * ldc) : _mm_setzero_ps();
+    acc[r][1] = accumulate ? _mm_loadu_ps(c + r * ldc + 4) : _mm_setzero_ps();
+  }
+  for (uint32_t p = 0; p < depth; p++) {
+    const __m128 b0 = _mm_loadu_ps(b + p * ldb);
+    const __m128 b1 = _mm_loadu_ps(b + p * ldb + 4);
+    for (uint32_t r = 0; r < 4; r++) {
+      const __m128 ar = _mm_set1_ps(a[r * lda + p]);
+      acc[r][0] = _mm_add_ps(acc[r][0], _mm_mul_ps(ar, b0));
+      acc[r][1] = _mm_add_ps(acc[r][1], _mm_mul_ps(ar, b1));
+    }
+  }
+  for (uint32_t r = 0; r < 4; r++) {
+    _mm_storeu_ps(c + r * ldc, acc[r][0]);
+    _mm_storeu_ps(c + r * ldc + 4, acc[r][1]);
+  }
+}
+
+__attribute__((target("sse2"))) void
+matMulRowTileSSE2(const float* a,
+                 const float* b,
+                 float* c,
+                 const uint32_t depth,
+                 const uint32_t ldb,
+                 const bool accumulate)
+{
+  __m128 acc[4];
+  for (uint32_t v = 0; v < 4; v++) {
+    acc[v] = accumulate ? _mm_loadu_ps(c + v * 4) : _mm_setzero_ps();
+  }
+  for (uint32_t p = 0; p < depth; p++) {
+    const __m128 ap = _mm_set1_ps(a[p]);
+    const auto* bRow = b + p * ldb;
+    for (uint32_t v = 0; v < 4; v++) {
+      acc[v] = _mm_add_ps(acc[v], _mm_mul_ps(ap, _mm_loadu_ps(bRow + v * 4)));
+    }
+  }
+  for (uint32_t v = 0; v < 4; v++) {
+    _mm_storeu_ps(c + v * 4, acc[v]);
+  }
+}
+
+void
+matMulSSE2(const float* a, const float* b, float* c, const uint32_t m, const uint32_t k, const uint32_t n)
+{
+  matMulDriver(matMulTileSSE2, 2 * 4, matMulRowTileSSE2, 4 * 4, a, b, c, m, k, n);
+}
+
+__attribute__((target("avx2,fma"))) void
+matMulTileAVX2(const float* a,
+              const float* b,
+              float* c,
+              const uint32_t depth,
+              const uint32_t lda,
+              const uint32_t ldb,
+              const uint32_t ldc,
+              const bool accumulate)
+{
+  __m256 acc[4][2];
+  for (uint32_t r = 0; r < 4; r++) {
+    acc[r][0] = accumulate ? _mm256_loadu_ps(c + r * ldc) : _mm256_setzero_ps();
+    acc[r][1] = accumulate ? _mm256_loadu_ps(c + r * ldc + 8) : _mm256_setzero_ps();
+  }
+  for (uint32_t p = 0; p < depth; p++) {
+    const __m256 b0 = _mm256_loadu_ps(b + p * ldb);
+    const __m256 b1 = _mm256_loadu_ps(b + p * ldb + 8);
+    for (uint32_t r = 0; r < 4; r++) {
+      const __m256 ar = _mm256_set1_ps(a[r * lda + p]);
+      acc[r][0] = _mm256_fmadd_ps(ar, b0, acc[r][0]);
+      acc[r][1] = _mm256_fmadd_ps(ar, b1, acc[r][1]);
+    }
+  }
+  for (uint32_t r = 0; r < 4; r++) {
+    _mm256_storeu_ps(c + r * ldc, acc[r][0]);
+    _mm256_storeu_ps(c + r * ldc + 8, acc[r][1]);
+  }
+}
+
+__attribute__((target("avx2,fma"))) void
+matMulRowTileAVX2(const float* a,
+                 const float* b,
+                 float* c,
+                 const uint32_t depth,
+                 const uint32_t ldb,
+                 const bool accumulate)
+{
+  __m256 acc[4];
+  for (uint32_t v = 0; v < 4; v++) {
+    acc[v] = accumulate ? _mm256_loadu_ps(c + v * 8) : _mm256_setzero_ps();
+  }
+  for (uint32_t p = 0; p < depth; p++) {
+    const __m256 ap = _mm256_set1_ps(a[p]);
+    const auto* bRow = b + p * ldb;
+    for (uint32_t v = 0; v < 4; v++) {
+      acc[v] = _mm256_fmadd_ps(ap, _mm256_loadu_ps(bRow + v * 8), acc[v]);
+    }
+  }
+  for (uint32_t v = 0; v < 4; v++) {
+    _mm256_storeu_ps(c + v * 8, acc[v]);
+  }
+}
+
+void
+matMulAVX2(const float* a, const float* b, float* c, const uint32_t m, const uint32_t k, const uint32_t n)
+{
+  matMulDriver(matMulTileAVX2, 2 * 8, matMulRowTileAVX2, 4 * 8, a, b, c, m, k, n);
+}
+
+__attribute__((target("avx512f"))) void
+matMulTileAVX512(const float* a,
+              const float* b,
+              float* c,
+              const uint32_t depth,
+              const uint32_t lda,
+              const uint32_t ldb,
+              const uint32_t ldc,
+              const bool accumulate)
+{
+  __m512 acc[4][2];
+  for (uint32_t r = 0; r < 4; r++) {
+    acc[r][0] = accumulate ? _mm512_loadu_ps(c + r * ldc) : _mm512_setzero_ps();
+    acc[r][1] = accumulate ? _mm512_loadu_ps(c + r * ldc + 16) : _mm512_setzero_ps();
+  }
+  for (uint32_t p = 0; p < depth; p++) {
+    const __m512 b0 = _mm512_loadu_ps(b + p * ldb);
+    const __m512 b1 = _mm512_loadu_ps(b + p * ldb + 16);
+    for (uint32_t r = 0; r < 4; r++) {
+      const __m512 ar = _mm512_set1_ps(a[r * lda + p]);
+      acc[r][0] = _mm512_fmadd_ps(ar, b0, acc[r][0]);
+      acc[r][1] = _mm512_fmadd_ps(ar, b1, acc[r][1]);
+    }
+  }
+  for (uint32_t r = 0; r < 4; r++) {
+    _mm512_storeu_ps(c + r * ldc, acc[r][0]);
+    _mm512_storeu_ps(c + r * ldc + 16, acc[r][1]);
+  }
+}
+
+__attribute__((target("avx512f"))) void
+matMulRowTileAVX512(const float* a,
+                 const float* b,
+                 float* c,
+                 const uint32_t depth,
+                 const uint32_t ldb,
+                 const bool accumulate)
+{
+  __m512 acc[4];
+  for (uint32_t v = 0; v < 4; v++) {
+    acc[v] = accumulate ? _mm512_loadu_ps(c + v * 16) : _mm512_setzero_ps();
+  }
+  for (uint32_t p = 0; p < depth; p++) {
+    const __m512 ap = _mm512_set1_ps(a[p]);
+    const auto* bRow = b + p * ldb;
+    for (uint32_t v = 0; v < 4; v++) {
+      acc[v] = _mm512_fmadd_ps(ap, _mm512_loadu_ps(bRow + v * 16), acc[v]);
+    }
+  }
+  for (uint32_t v = 0; v < 4; v++) {
+    _mm512_storeu_ps(c + v * 16, acc[v]);
+  }
+}
+
+void
+matMulAVX512(const float* a, const float* b, float* c, const uint32_t m, const uint32_t k, const uint32_t n)
+{
+  matMulDriver(matMulTileAVX512, 2 * 16, matMulRowTileAVX512, 4 * 16, a, b, c, m, k, n);
+}
+
+/**
+ * @brief Sign extends the lower eight bytes of a vector to 16 bits.
+ * */
+__attribute__((target("sse2"))) inline auto
+widenLowSSE2(const __m128i v) -> __m128i
+{
+  return _mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8);
+}
+
+__attribute__((target("sse2"))) inline auto
+widenHighSSE2(const __m128i v) -> __m128i
+{
+  return _mm_srai_epi16(_mm_unpackhi_epi8(v, v), 8);
+}
+
+__attribute__((target("sse2"))) void
+linearInt8SSE2(const int8_t* weights,
+               const int32_t* bias,
+               const float* multipliers,
+               const int8_t* input,
+               int8_t* output,
+               const uint32_t inFeatures,
+               const uint32_t outFeatures,
+               const int32_t minValue)
+{
+  const uint32_t vecEnd = inFeatures & ~15U;
+
+  for (uint32_t i = 0; i < outFeatures; i++) {
+    const auto* w = weights + i * inFeatures;
+    __m128i acc = _mm_setzero_si128();
+    for (uint32_t j = 0; j < vecEnd; j += 16) {
+      const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + j));
+      const __m128i wv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(w + j));
+      acc = _mm_add_epi32(acc, _mm_madd_epi16(widenLowSSE2(wv), widenLowSSE2(in)));
+      acc = _mm_add_epi32(acc, _mm_madd_epi16(widenHighSSE2(wv), widenHighSSE2(in)));
+    }
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+    int32_t sum = _mm_cvtsi128_si32(acc) + bias[i];
+    for (uint32_t j = vecEnd; j < inFeatures; j++) {
+      sum += static_cast<int32_t>(w[j]) * static_cast<int32_t>(input[j]);
+    }
+    output[i] = roundToInt8(static_cast<float>(sum) * multipliers[i], minValue);
+  }
+}
+
+__attribute__((target("avx2"))) inline auto
+loadInt8AVX2(const int8_t* p) -> __m256i
+{
+  return _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+}
+
+__attribute__((target("avx2"))) void
+linearInt8AVX2(const int8_t* weights,
+               const int32_t* bias,
+               const float* multipliers,
+               const int8_t* input,
+               int8_t* output,
+               const uint32_t inFeatures,
+               const uint32_t outFeatures,
+               const int32_t minValue)
+{
+  const uint32_t vecEnd = inFeatures & ~15U;
+
+  uint32_t i = 0;
+
+  for (; (i + 4) <= outFeatures; i += 4) {
+    const auto* w0 = weights + i * inFeatures;
+    const auto* w1 = w0 + inFeatures;
+    const auto* w2 = w1 + inFeatures;
+    const auto* w3 = w2 + inFeatures;
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+    __m256i acc2 = _mm256_setzero_si256();
+    __m256i acc3 = _mm256_setzero_si256();
+    for (uint32_t j = 0; j < vecEnd; j += 16) {
+      const __m256i in = loadInt8AVX2(input + j);
+      acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(loadInt8AVX2(w0 + j), in));
+      acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(loadInt8AVX2(w1 + j), in));
+      acc2 = _mm256_add_epi32(acc2, _mm256_madd_epi16(loadInt8AVX2(w2 + j), in));
+      acc3 = _mm256_add_epi32(acc3, _mm256_madd_epi16(loadInt8AVX2(w3 + j), in));
+    }
+    // Reduces the four accumulators into one vector, with one lane per row.
+    const __m256i s = _mm256_hadd_epi32(_mm256_hadd_epi32(acc0, acc1), _mm256_hadd_epi32(acc2, acc3));
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(s), _mm256_extracti128_si256(s, 1));
+    sum = _mm_add_epi32(sum, _mm_loadu_si128(reinterpret_cast<const __m128i*>(bias + i)));
+    int32_t tail[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(tail), sum);
+    for (uint32_t j = vecEnd; j < inFeatures; j++) {
+      const int32_t in = input[j];
+      tail[0] += w0[j] * in;
+      tail[1] += w1[j] * in;
+      tail[2] += w2[j] * in;
+      tail[3] += w3[j] * in;
+    }
+    for (uint32_t r = 0; r < 4; r++) {
+      output[i + r] = roundToInt8(static_cast<float>(tail[r]) * multipliers[i + r], minValue);
+    }
+  }
+
+  for (; i < outFeatures; i++) {
+    const auto* w = weights + i * inFeatures;
+    __m256i acc = _mm256_setzero_si256();
+    for (uint32_t j = 0; j < vecEnd; j += 16) {
+      acc = _mm256_add_epi32(acc, _mm256_madd_epi16(loadInt8AVX2(w + j), loadInt8AVX2(input + j)));
+    }
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+    int32_t sum = _mm_cvtsi128_si32(half) + bias[i];
+    for (uint32_t j = vecEnd; j < inFeatures; j++) {
+      sum += static_cast<int32_t>(w[j]) * static_cast<int32_t>(input[j]);
+    }
+    output[i] = roundToInt8(static_cast<float>(sum) * multipliers[i], minValue);
+  }
+}
+
+template<HalfFormat Format>
+__attribute__((target("avx2,f16c"))) inline auto
+loadHalfAVX2(const uint16_t* p) -> __m256
+{
+  const auto h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  if (Format == HalfFormat::kBFloat16) {
+    return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(h), 16));
+  }
+  return _mm256_cvtph_ps(h);
+}
+
+/**
+ * @note This is the same as @ref linearAVX2, apart from widening the weights as they are loaded. F16C converts eight
+ *       binary16 values in one instruction, and bfloat16 only needs a zero extension and a shift.
+ * */
+template<HalfFormat Format>
+__attribute__((target("avx2,fma,f16c"))) void
+linearHalfLoopAVX2(const uint16_t* weights,
+                   const uint16_t* bias,
+                   const float* input,
+                   float* output,
+                   const uint32_t inFeatures,
+                   const uint32_t outFeatures,
+                   const uint32_t stride,
+                   const Activation activation,
+                   const ActivationMode mode)
+{
+  const uint32_t vecEnd = inFeatures & ~7U;
+
+  uint32_t i = 0;
+
+  for (; (i + 4) <= outFeatures; i += 4) {
+    const auto* w0 = weights + i * stride;
+    const auto* w1 = w0 + stride;
+    const auto* w2 = w1 + stride;
+    const auto* w3 = w2 + stride;
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    __m256 acc2 = _mm256_setzero_ps();
+    __m256 acc3 = _mm256_setzero_ps();
+    for (uint32_t j = 0; j < vecEnd; j += 8) {
+      const __m256 in = _mm256_loadu_ps(input + j);
+      acc0 = _mm256_fmadd_ps(loadHalfAVX2<Format>(w0 + j), in, acc0);
+      acc1 = _mm256_fmadd_ps(loadHalfAVX2<Format>(w1 + j), in, acc1);
+      acc2 = _mm256_fmadd_ps(loadHalfAVX2<Format>(w2 + j), in, acc2);
+      acc3 = _mm256_fmadd_ps(loadHalfAVX2<Format>(w3 + j), in, acc3);
+    }
+    const __m256 s01 = _mm256_hadd_ps(acc0, acc1);
+    const __m256 s23 = _mm256_hadd_ps(acc2, acc3);
+    const __m256 s = _mm256_hadd_ps(s01, s23);
+    float tail[4];
+    _mm_storeu_ps(tail, _mm_add_ps(_mm256_castps256_ps128(s), _mm256_extractf128_ps(s, 1)));
+    for (uint32_t r = 0; r < 4; r++) {
+      tail[r] += widenHalf<Format>(bias[i + r]);
+    }
+    for (uint32_t j = vecEnd; j < inFeatures; j++) {
+      const auto in = input[j];
+      tail[0] += widenHalf<Format>(w0[j]) * in;
+      tail[1] += widenHalf<Format>(w1[j]) * in;
+      tail[2] += widenHalf<Format>(w2[j]) * in;
+      tail[3] += widenHalf<Format>(w3[j]) * in;
+    }
+    output[i + 0] = tail[0];
+    output[i + 1] = tail[1];
+    output[i + 2] = tail[2];
+    output[i + 3] = tail[3];
+    activateAVX2(output + i, output + i, 4, activation, mode);
+  }
+
+  for (; i < outFeatures; i++) {
+    const auto* w = weights + i * stride;
+    __m256 acc = _mm256_setzero_ps();
+    for (uint32_t j = 0; j < vecEnd; j += 8) {
+      acc = _mm256_fmadd_ps(loadHalfAVX2<Format>(w + j), _mm256_loadu_ps(input + j), acc);
+    }
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    half = _mm_hadd_ps(half, half);
+    half = _mm_hadd_ps(half, half);
+    float sum = _mm_cvtss_f32(half);
+    for (uint32_t j = vecEnd; j < inFeatures; j++) {
+      sum += widenHalf<Format>(w[j]) * input[j];
+    }
+    output[i] = applyActivation(sum + widenHalf<Format>(bias[i]), activation, mode);
+  }
+}
+
+void
+linearHalfAVX2(const uint16_t* weights,
+               const uint16_t* bias,
+               const float* input,
+               float* output,
+               const uint32_t inFeatures,
+               const uint32_t outFeatures,
+               const uint32_t stride,
+               const HalfFormat format,
+               const Activation activation,
+               const ActivationMode mode)
+{
+  if (format == HalfFormat::kBFloat16) {
+    linearHalfLoopAVX2<HalfFormat::kBFloat16>(
+      weights, bias, input, output, inFeatures, outFeatures, stride, activation, mode);
+  } else {
+    linearHalfLoopAVX2<HalfFormat::kFloat16>(
+      weights, bias, input, output, inFeatures, outFeatures, stride, activation, mode);
+  }
+}
+
+#endif // NN_KERNELS_X86
+
+auto
+selectLinearHalfKernel() -> LinearHalfKernel
+{
+  // An AVX2 machine without F16C falls back to the portable kernel.
+  const auto kernel = getLinearHalfKernel(detectKernelISA());
+  return kernel ? kernel : linearHalfPortable;
+}
+
+} // namespace
+
+auto
+detectKernelISA() -> KernelISA
+{
+#if NN_KERNELS_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return KernelISA::kAVX512;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return KernelISA::kAVX2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return KernelISA::kSSE2;
+  }
+#endif
+  return KernelISA::kPortable;
+}
+
+auto
+getLinearKernel(const KernelISA isa) -> LinearKernel
+{
+  switch (isa) {
+    case KernelISA::kPortable:
+      return linearPortable;
+#if NN_KERNELS_X86
+    case KernelISA::kSSE2:
+      return __builtin_cpu_supports("sse2") ? linearSSE2 : nullptr;
+    case KernelISA::kAVX2:
+      return (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) ? linearAVX2 : nullptr;
+    case KernelISA::kAVX512:
+      return __builtin_cpu_supports("avx512f") ? linearAVX512 : nullptr;
+#else
+    case KernelISA::kSSE2:
+    case KernelISA::kAVX2:
+    case KernelISA::kAVX512:
+      break;
+#endif
+  }
+  return nullptr;
+}
+
+auto
+getLinearBatchKernel(const KernelISA isa) -> LinearBatchKernel
+{
+  switch (isa) {
+    case KernelISA::kPortable:
+      return linearBatchPortable;
+#if NN_KERNELS_X86
+    case KernelISA::kSSE2:
+      return __builtin_cpu_supports("sse2") ? linearBatchSSE2 : nullptr;
+    case KernelISA::kAVX2:
+      return (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) ? linearBatchAVX2 : nullptr;
+    case KernelISA::kAVX512:
+      return __builtin_cpu_supports("avx512f") ? linearBatchAVX512 : nullptr;
+#else
+    case KernelISA::kSSE2:
+    case KernelISA::kAVX2:
+    case KernelISA::kAVX512:
+      break;
+#endif
+  }
+  return nullptr;
+}
+
+auto
+getMatMulKernel(const KernelISA isa) -> MatMulKernel
+{
+  switch (isa) {
+    case KernelISA::kPortable:
+      return matMulPortable;
+#if NN_KERNELS_X86
+    case KernelISA::kSSE2:
+      return __builtin_cpu_supports("sse2") ? matMulSSE2 : nullptr;
+    case KernelISA::kAVX2:
+      return (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) ? matMulAVX2 : nullptr;
+    case KernelISA::kAVX512:
+      return __builtin_cpu_supports("avx512f") ? matMulAVX512 : nullptr;
+#else
+    case KernelISA::kSSE2:
+    case KernelISA::kAVX2:
+    case KernelISA::kAVX512:
+      break;
+#endif
+  }
+  return nullptr;
+}
+
+auto
+getActivationKernel(const KernelISA isa) -> ActivationKernel
+{
+  switch (isa) {
+    case KernelISA::kPortable:
+      return activatePortable;
+#if NN_KERNELS_X86
+    case KernelISA::kSSE2:
+      return __builtin_cpu_supports("sse2") ? activateSSE2 : nullptr;
+    case KernelISA::kAVX2:
+    case KernelISA::kAVX512:
+      return __builtin_cpu_supports("avx2") ? activateAVX2 : nullptr;
+#else
+    case KernelISA::kSSE2:
+    case KernelISA::kAVX2:
+    case KernelISA::kAVX512:
+      break;
+#endif
+  }
+  return nullptr;
+}
+
+auto
+getLinearInt8Kernel(const KernelISA isa) -> LinearInt8Kernel
+{
+  switch (isa) {
+    case KernelISA::kPortable:
+      return linearInt8Portable;
+#if NN_KERNELS_X86
+    case KernelISA::kSSE2:
+      return __builtin_cpu_supports("sse2") ? linearInt8SSE2 : nullptr;
+    case KernelISA::kAVX2:
+    case KernelISA::kAVX512:
+      // Widening 32 bytes at a time needs AVX-512BW, so the AVX2 kernel is used for both.
+      return __builtin_cpu_supports("avx2") ? linearInt8AVX2 : nullptr;
+#else
+    case KernelISA::kSSE2:
+    case KernelISA::kAVX2:
+    case KernelISA::kAVX512:
+      break;
+#endif
+  }
+  return nullptr;
+}
+
+auto
+floatToHalf(const float x, const HalfFormat format) -> uint16_t
+{
+  uint32_t bits{};
+  memcpy(&bits, &x, sizeof(bits));
+  const auto sign = bits & 0x80000000U;
+  bits ^= sign;
+
+  if (format == HalfFormat::kBFloat16) {
+    if (bits > 0x7f800000U) {
+      // Keeps NaN a NaN, since rounding could carry it into infinity.
+      return static_cast<uint16_t>(((sign | bits) >> 16) | 0x40U);
+    }
+    bits += 0x7fffU + ((bits >> 16) & 1U);
+    return static_cast<uint16_t>((sign | bits) >> 16);
+  }
+
+  uint32_t h{};
+  if (bits >= (143U << 23)) {
+    // At least 65536, which is past the largest binary16 even after rounding, or infinity or NaN.
+    h = (bits > 0x7f800000U) ? 0x7e00U : 0x7c00U;
+  } else if (bits < (113U << 23)) {
+    // Below the smallest normal binary16. Adding one half lines the mantissa up so that the FPU does the rounding.
+    float f{};
+    memcpy(&f, &bits, sizeof(f));
+    f += 0.5F;
+    memcpy(&h, &f, sizeof(h));
+    h -= 0x3f000000U;
+  } else {
+    const auto odd = (bits >> 13) & 1U;
+    bits += (static_cast<uint32_t>(15 - 127) << 23) + 0xfffU + odd;
+    h = bits >> 13;
+  }
+  return static_cast<uint16_t>(h | (sign >> 16));
+}
+
+auto
+halfToFloat(const uint16_t x, const HalfFormat format) -> float
+{
+  return (format == HalfFormat::kBFloat16) ? widenBFloat16(x) : widenFloat16(x);
+}
+
+auto
+getLinearHalfKernel(const KernelISA isa) -> LinearHalfKernel
+{
+  switch (isa) {
+    case KernelISA::kPortable:
+      return linearHalfPortable;
+#if NN_KERNELS_X86
+    case KernelISA::kSSE2:
+      return __builtin_cpu_supports("sse2") ? linearHalfPortable : nullptr;
+    case KernelISA::kAVX2:
+    case KernelISA::kAVX512:
+      return (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("f16c"))
+               ? linearHalfAVX2
+               : nullptr;
+#else
+    case KernelISA::kSSE2:
+    case KernelISA::kAVX2:
+    case KernelISA::kAVX512:
+      break;
+#endif
+  }
+  return nullptr;
+}
+
+void
+linear(const float* weights,
+       const float* bias,
+       const float* input,
+       float* output,
+       const uint32_t inFeatures,
+       const uint32_t outFeatures,
+       const uint32_t stride,
+       const Activation activation,
+       const ActivationMode mode)
+{
+  // Function-local statics are initialized once, even when the first calls come from several threads.
+  static const LinearKernel selectedLinearKernel{ getLinearKernel(detectKernelISA()) };
+
+  selectedLinearKernel(weights, bias, input, output, inFeatures, outFeatures, stride, activation, mode);
+}
+
+void
+linearBatch(const float* weights,
+            const float* bias,
+            const float* input,
+            const uint32_t inputStride,
+            float* output,
+            const uint32_t outputStride,
+            const uint32_t inFeatures,
+            const uint32_t outFeatures,
+            const uint32_t stride,
+            const uint32_t batchSize,
+            const Activation activation,
+            const ActivationMode mode)
+{
+  static const LinearBatchKernel selectedLinearBatchKernel{ getLinearBatchKernel(detectKernelISA()) };
+
+  selectedLinearBatchKernel(weights,
+                            bias,
+                            input,
+                            inputStride,
+                            output,
+                            outputStride,
+                            inFeatures,
+                            outFeatures,
+                            stride,
+                            batchSize,
+                            activation,
+                            mode);
+}
+
+void
+matMul(const float* a, const float* b, float* c, const uint32_t m, const uint32_t k, const uint32_t n)
+{
+  static const MatMulKernel selectedMatMulKernel{ getMatMulKernel(detectKernelISA()) };
+
+  selectedMatMulKernel(a, b, c, m, k, n);
+}
+
+void
+activate(const float* input,
+         float* output,
+         const uint32_t count,
+         const Activation activation,
+         const ActivationMode mode)
+{
+  static const ActivationKernel selectedActivationKernel{ getActivationKernel(detectKernelISA()) };
+
+  selectedActivationKernel(input, output, count, activation, mode);
+}
+
+void
+linearInt8(const int8_t* weights,
+           const int32_t* bias,
+           const float* multipliers,
+           const int8_t* input,
+           int8_t* output,
+           const uint32_t inFeatures,
+           const uint32_t outFeatures,
+           const int32_t minValue)
+{
+  static const LinearInt8Kernel selectedLinearInt8Kernel{ getLinearInt8Kernel(detectKernelISA()) };
+
+  selectedLinearInt8Kernel(weights, bias, multipliers, input, output, inFeatures, outFeatures, minValue);
+}
+
+void
+linearHalf(const uint16_t* weights,
+           const uint16_t* bias,
+           const float* input,
+           float* output,
+           const uint32_t inFeatures,
+           const uint32_t outFeatures,
+           const uint32_t stride,
+           const HalfFormat format,
+           const Activation activation,
+           const ActivationMode mode)
+{
+  static const LinearHalfKernel selectedLinearHalfKernel{ selectLinearHalfKernel() };
+
+  selectedLinearHalfKernel(weights, bias, input, output, inFeatures, outFeatures, stride, format, activation, mode);
+}
+
+void
+sparseLinear(const float* values,
+             const uint32_t* blockStarts,
+             const FeatureSize* blockColumns,
+             const float* bias,
+             const float* input,
+             float* output,
+             const uint32_t outFeatures,
+             const Activation activation,
+             const ActivationMode mode)
+{
+  const uint32_t numBlockRows = (outFeatures + NN_SPARSE_BLOCK_ROWS - 1) / NN_SPARSE_BLOCK_ROWS;
+
+  for (uint32_t i = 0; i < numBlockRows; i++) {
+    // Two sets of sums, so that each addition does not have to wait for the one before it.
+    float sums[2][NN_SPARSE_BLOCK_ROWS]{};
+    const auto end = blockStarts[i + 1];
+    auto k = blockStarts[i];
+    for (; (k + 1) < end; k += 2) {
+      const auto x0 = input[blockColumns[k]];
+      const auto x1 = input[blockColumns[k + 1]];
+      const auto* w = values + k * NN_SPARSE_BLOCK_ROWS;
+      for (uint32_t r = 0; r < NN_SPARSE_BLOCK_ROWS; r++) {
+        sums[0][r] += w[r] * x0;
+        sums[1][r] += w[NN_SPARSE_BLOCK_ROWS + r] * x1;
+      }
+    }
+    if (k < end) {
+      const auto x = input[blockColumns[k]];
+      const auto* w = values + k * NN_SPARSE_BLOCK_ROWS;
+      for (uint32_t r = 0; r < NN_SPARSE_BLOCK_ROWS; r++) {
+        sums[0][r] += w[r] * x;
+      }
+    }
+    const auto row = i * NN_SPARSE_BLOCK_ROWS;
+    const auto rows = ((outFeatures - row) < NN_SPARSE_BLOCK_ROWS) ? (outFeatures - row) : NN_SPARSE_BLOCK_ROWS;
+    for (uint32_t r = 0; r < rows; r++) {
+      output[row + r] = (sums[0][r] + sums[1][r]) + bias[row + r];
+    }
+  }
+
+  if (activation != Activation::kNone) {
+    activate(output, output, outFeatures, activation, mode);
+  }
+}
+
+namespace {
+
+/**
+ * @brief The number of hidden features whose gates are computed at once by @ref gru.
+ * */
+constexpr uint32_t gruBlockSize = 16;
+
+/**
+ * @param rows Computes some rows of the input weights, or of the hidden weights when its first argument is true.
+ * */
+template<typename RowsFunc>
+void
+gruStep(RowsFunc rows, float* hidden, float* output, const uint32_t hiddenSize, const ActivationMode mode)
+{
+  float inputGates[3 * gruBlockSize];
+  float hiddenGates[3 * gruBlockSize];
+
+  for (uint32_t first = 0; first < hiddenSize; first += gruBlockSize) {
+    const auto n = ((hiddenSize - first) < gruBlockSize) ? (hiddenSize - first) : gruBlockSize;
+
+    for (uint32_t g = 0; g < 3; g++) {
+      rows(false, g * hiddenSize + first, n, inputGates + g * gruBlockSize);
+      rows(true, g * hiddenSize + first, n, hiddenGates + g * gruBlockSize);
+    }
+
+    auto* r = inputGates;
+    auto* z = inputGates + gruBlockSize;
+    auto* c = inputGates + 2 * gruBlockSize;
+
+    for (uint32_t i = 0; i < n; i++) {
+      r[i] += hiddenGates[i];
+      z[i] += hiddenGates[gruBlockSize + i];
+    }
+
+    activate(r, r, n, Activation::kSigmoid, mode);
+    activate(z, z, n, Activation::kSigmoid, mode);
+
+    for (uint32_t i = 0; i < n; i++) {
+      c[i] += r[i] * hiddenGates[2 * gruBlockSize + i];
+    }
+
+    activate(c, c, n, Activation::kTanh, mode);
+
+    for (uint32_t i = 0; i < n; i++) {
+      output[first + i] = c[i] + z[i] * (hidden[first + i] - c[i]);
+    }
+  }
+
+  // The old hidden state is read by every block, so it can only be replaced at the end.
+  memcpy(hidden, output, hiddenSize * sizeof(float));
+}
+
+} // namespace
+
+void
+gru(const float* inputWeights,
+    const float* hiddenWeights,
+    const float* input,
+    float* hidden,
+    float* output,
+    const uint32_t inFeatures,
+    const uint32_t hiddenSize,
+    const uint32_t inputStride,
+    const uint32_t hiddenStride,
+    const ActivationMode mode)
+{
+  const auto* inputBias = inputWeights + inputStride * 3 * hiddenSize;
+  const auto* hiddenBias = hiddenWeights + hiddenStride * 3 * hiddenSize;
+
+  auto rows = [&](const bool fromHidden, const uint32_t row, const uint32_t n, float* out) {
+    if (fromHidden) {
+      linear(hiddenWeights + row * hiddenStride,
+             hiddenBias + row,
+             hidden,
+             out,
+             hiddenSize,
+             n,
+             hiddenStride,
+             Activation::kNone,
+             mode);
+    } else {
+      linear(inputWeights + row * inputStride,
+             inputBias + row,
+             input,
+             out,
+             inFeatures,
+             n,
+             inputStride,
+             Activation::kNone,
+             mode);
+    }
+  };
+
+  gruStep(rows, hidden, output, hiddenSize, mode);
+}
+
+void
+gruHalf(const uint16_t* inputWeights,
+        const uint16_t* hiddenWeights,
+        const float* input,
+        float* hidden,
+        float* output,
+        const uint32_t inFeatures,
+        const uint32_t hiddenSize,
+        const uint32_t inputStride,
+        const uint32_t hiddenStride,
+        const HalfFormat format,
+        const ActivationMode mode)
+{
+  const auto* inputBias = inputWeights + inputStride * 3 * hiddenSize;
+  const auto* hiddenBias = hiddenWeights + hiddenStride * 3 * hiddenSize;
+
+  auto rows = [&](const bool fromHidden, const uint32_t row, const uint32_t n, float* out) {
+    if (fromHidden) {
+      linearHalf(hiddenWeights + row * hiddenStride,
+                 hiddenBias + row,
+                 hidden,
+                 out,
+                 hiddenSize,
+                 n,
+                 hiddenStride,
+                 format,
+                 Activation::kNone,
+                 mode);
+    } else {
+      linearHalf(inputWeights + row * inputStride,
+                 inputBias + row,
+                 input,
+                 out,
+                 inFeatures,
+                 n,
+                 inputStride,
+                 format,
+                 Activation::kNone,
+                 mode);
+    }
+  };
+
+  gruStep(rows, hidden, output, hiddenSize, mode);
+}
+
+void
+pushFrame(float* window, const float* frame, const uint32_t frameSize, const uint32_t numFrames)
+{
+  if (numFrames == 0) {
+    return;
+  }
+  const auto kept = (numFrames - 1) * frameSize;
+  memmove(window, window + frameSize, kept * sizeof(float));
+  memcpy(window + kept, frame, frameSize * sizeof(float));
+}
+
+} // namespace NN
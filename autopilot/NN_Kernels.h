@@ -0,0 +1,433 @@
+#pragma once
+
+#include "NN_Activation.h"
+#include "NN_Config.h"
+
+#include <stdint.h>
+
+/**
+ * @brief The number of output rows that share one column index in a sparse weight matrix.
+ *
+ * @details Four rows keep the index to an eighth of the size of the weights in the compact mode, and give the four
+ *          accumulators that one SSE register or the FPU of a Cortex-M4F can keep in registers.
+ * */
+#ifndef NN_SPARSE_BLOCK_ROWS
+#define NN_SPARSE_BLOCK_ROWS 4
+#endif
+
+namespace NN {
+
+/**
+ * @brief The instruction sets that the dense kernels are specialized for.
+ * */
+enum class KernelISA : uint8_t
+{
+  kPortable,
+  kSSE2,
+  kAVX2,
+  kAVX512
+};
+
+/**
+ * @brief The 16 bit float formats that parameters can be stored in.
+ *
+ * @details Both formats halve the size of the weights. Every stored value is rounded to the nearest value of the
+ *          format, so the error of each output of a linear layer is at most the relative error below times the sum
+ *          of `|w * x|` over its inputs and bias, before the activation.
+ * */
+enum class HalfFormat : uint8_t
+{
+  /**
+   * @brief IEEE 754 binary16. The relative error is at most 2^-11 (about 0.05%). Values above 65504 become infinite,
+   *        and values below 2^-24 become zero, which is not a problem for weights that are initialized near one.
+   * */
+  kFloat16,
+
+  /**
+   * @brief The upper half of a float. The relative error is at most 2^-8 (about 0.4%), but the range is the same as
+   *        a float, and widening is only a shift.
+   * */
+  kBFloat16
+};
+
+/**
+ * @brief Rounds a float to the nearest 16 bit float, with ties to even.
+ * */
+[[nodiscard]] auto
+floatToHalf(float x, HalfFormat format) -> uint16_t;
+
+[[nodiscard]] auto
+halfToFloat(uint16_t x, HalfFormat format) -> float;
+
+/**
+ * @brief Computes a matrix-vector product followed by a bias, as in `output = weights * input + bias`.
+ *
+ * @param weights The row-major weight matrix, with one row per output feature.
+ *
+ * @param bias The bias of each output feature.
+ *
+ * @param input The input features.
+ *
+ * @param output Where to write the output features. May not overlap with the input.
+ *
+ * @param inFeatures The number of input features.
+ *
+ * @param outFeatures The number of output features.
+ *
+ * @param stride The number of floats between the start of each row of weights. This is at least the number of input
+ *               features, and larger when the rows are padded.
+ *
+ * @param activation An activation to apply to each output as it is written, so that the outputs do not have to be
+ *                   read back again.
+ * */
+using LinearKernel = void (*)(const float* weights,
+                              const float* bias,
+                              const float* input,
+                              float* output,
+                              uint32_t inFeatures,
+                              uint32_t outFeatures,
+                              uint32_t stride,
+                              Activation activation,
+                              ActivationMode mode);
+
+/**
+ * @brief Computes a linear layer for a batch of samples, as in `output[b] = weights * input[b] + bias`.
+ *
+ * @details The weights are blocked so that each block stays in cache while it is applied to every sample, and pairs
+ *          of samples are multiplied against groups of four rows at a time, so that every load is used for several
+ *          multiplications.
+ *
+ * @param inputStride The number of floats between the start of each input sample.
+ *
+ * @param outputStride The number of floats between the start of each output sample.
+ *
+ * @param batchSize The number of samples.
+ *
+ * See @ref LinearKernel for a description of the other parameters.
+ * */
+using LinearBatchKernel = void (*)(const float* weights,
+                                   const float* bias,
+                                   const float* input,
+                                   uint32_t inputStride,
+                                   float* output,
+                                   uint32_t outputStride,
+                                   uint32_t inFeatures,
+                                   uint32_t outFeatures,
+                                   uint32_t stride,
+                                   uint32_t batchSize,
+                                   Activation activation,
+                                   ActivationMode mode);
+
+/**
+ * @brief Computes the product of two row-major matrices, as in `c = a * b`.
+ *
+ * @details The product is blocked along the shared dimension so that a panel of the right operand stays in cache,
+ *          and each block of the output is accumulated in registers, four rows at a time.
+ *
+ * @param a The left operand, with `m` rows and `k` columns.
+ *
+ * @param b The right operand, with `k` rows and `n` columns.
+ *
+ * @param c Where to write the `m` by `n` product. May not overlap with either operand.
+ * */
+using MatMulKernel = void (*)(const float* a, const float* b, float* c, uint32_t m, uint32_t k, uint32_t n);
+
+/**
+ * @brief Applies an activation to an array of values, as in `output[i] = activation(input[i])`.
+ *
+ * @details Every kernel gives the same result as the scalar functions in @ref NN_Activation.h.
+ *
+ * @param input The values to apply the activation to.
+ *
+ * @param output Where to write the results. This may be the same array as the input, but may not overlap it otherwise.
+ *
+ * @param count The number of values.
+ *
+ * @param mode Whether to use the precise or the fast approximations.
+ * */
+using ActivationKernel = void (*)(const float* input,
+                                  float* output,
+                                  uint32_t count,
+                                  Activation activation,
+                                  ActivationMode mode);
+
+/**
+ * @brief Computes a linear layer on int8 values, as in `output = requantize(weights * input + bias)`.
+ *
+ * @details The products are accumulated in 32 bits. Each output row is then scaled by its multiplier, which combines
+ *          the scales of the input, of the row of weights and of the output, and is rounded to the nearest int8.
+ *
+ * @param weights The row-major weight matrix, with one row per output feature and no padding between rows.
+ *
+ * @param bias The bias of each output feature, already scaled by the input scale and the weight scale of its row.
+ *
+ * @param multipliers The requantization multiplier of each output feature.
+ *
+ * @param minValue The smallest value of the output. This is -127, or zero for a fused ReLU.
+ * */
+using LinearInt8Kernel = void (*)(const int8_t* weights,
+                                  const int32_t* bias,
+                                  const float* multipliers,
+                                  const int8_t* input,
+                                  int8_t* output,
+                                  uint32_t inFeatures,
+                                  uint32_t outFeatures,
+                                  int32_t minValue);
+
+/**
+ * @brief Computes a linear layer whose weights and biases are stored as 16 bit floats.
+ *
+ * @details The weights are widened to float as they are loaded, and everything else is computed the same way as in
+ *          @ref LinearKernel. The parameters are the same, apart from the format of the weights and biases.
+ * */
+using LinearHalfKernel = void (*)(const uint16_t* weights,
+                                  const uint16_t* bias,
+                                  const float* input,
+                                  float* output,
+                                  uint32_t inFeatures,
+                                  uint32_t outFeatures,
+                                  uint32_t stride,
+                                  HalfFormat format,
+                                  Activation activation,
+                                  ActivationMode mode);
+
+/**
+ * @brief Rounds a value to the nearest int8, saturating at a minimum value and at 127.
+ *
+ * @details The range is symmetric (-128 is never produced), so that negating a value can not overflow.
+ * */
+inline auto
+roundToInt8(float x, const int32_t minValue) -> int8_t
+{
+  const auto lo = static_cast<float>(minValue);
+  x = (x < lo) ? lo : x;
+  x = (x > 127.0F) ? 127.0F : x;
+  return static_cast<int8_t>((x >= 0.0F) ? (x + 0.5F) : (x - 0.5F));
+}
+
+/**
+ * @brief Gets the fastest instruction set that is supported by both the build and the CPU running it.
+ * */
+[[nodiscard]] auto
+detectKernelISA() -> KernelISA;
+
+/**
+ * @brief Gets the linear kernel for a specific instruction set.
+ *
+ * @return The kernel, or a null pointer if the build or the CPU does not support the instruction set.
+ * */
+[[nodiscard]] auto
+getLinearKernel(KernelISA isa) -> LinearKernel;
+
+/**
+ * @brief Gets the batched linear kernel for a specific instruction set.
+ *
+ * @return The kernel, or a null pointer if the build or the CPU does not support the instruction set.
+ * */
+[[nodiscard]] auto
+getLinearBatchKernel(KernelISA isa) -> LinearBatchKernel;
+
+/**
+ * @brief Gets the matrix multiplication kernel for a specific instruction set.
+ *
+ * @return The kernel, or a null pointer if the build or the CPU does not support the instruction set.
+ * */
+[[nodiscard]] auto
+getMatMulKernel(KernelISA isa) -> MatMulKernel;
+
+/**
+ * @brief Gets the activation kernel for a specific instruction set.
+ *
+ * @return The kernel, or a null pointer if the build or the CPU does not support the instruction set.
+ * */
+[[nodiscard]] auto
+getActivationKernel(KernelISA isa) -> ActivationKernel;
+
+/**
+ * @brief Gets the int8 linear kernel for a specific instruction set.
+ *
+ * @return The kernel, or a null pointer if the build or the CPU does not support the instruction set.
+ * */
+[[nodiscard]] auto
+getLinearInt8Kernel(KernelISA isa) -> LinearInt8Kernel;
+
+/**
+ * @brief Gets the 16 bit float linear kernel for a specific instruction set.
+ *
+ * @details SSE2 has no conversion from binary16, so it uses the portable kernel. The AVX2 kernel also needs F16C.
+ *
+ * @return The kernel, or a null pointer if the build or the CPU does not support the instruction set.
+ * */
+[[nodiscard]] auto
+getLinearHalfKernel(KernelISA isa) -> LinearHalfKernel;
+
+/**
+ * @brief Runs the fastest linear kernel available on this machine.
+ *
+ * @details The CPU is probed on the first call. See @ref LinearKernel for a description of the parameters.
+ * */
+void
+linear(const float* weights,
+       const float* bias,
+       const float* input,
+       float* output,
+       uint32_t inFeatures,
+       uint32_t outFeatures,
+       uint32_t stride,
+       Activation activation,
+       ActivationMode mode);
+
+/**
+ * @brief Runs the fastest batched linear kernel available on this machine.
+ *
+ * @details See @ref LinearBatchKernel for a description of the parameters.
+ * */
+void
+linearBatch(const float* weights,
+            const float* bias,
+            const float* input,
+            uint32_t inputStride,
+            float* output,
+            uint32_t outputStride,
+            uint32_t inFeatures,
+            uint32_t outFeatures,
+            uint32_t stride,
+            uint32_t batchSize,
+            Activation activation,
+            ActivationMode mode);
+
+/**
+ * @brief Runs the fastest matrix multiplication kernel available on this machine.
+ *
+ * @details See @ref MatMulKernel for a description of the parameters.
+ * */
+void
+matMul(const float* a, const float* b, float* c, uint32_t m, uint32_t k, uint32_t n);
+
+/**
+ * @brief Runs the fastest activation kernel available on this machine.
+ *
+ * @details See @ref ActivationKernel for a description of the parameters.
+ * */
+void
+activate(const float* input, float* output, uint32_t count, Activation activation, ActivationMode mode);
+
+/**
+ * @brief Runs the fastest int8 linear kernel available on this machine.
+ *
+ * @details See @ref LinearInt8Kernel for a description of the parameters.
+ * */
+void
+linearInt8(const int8_t* weights,
+           const int32_t* bias,
+           const float* multipliers,
+           const int8_t* input,
+           int8_t* output,
+           uint32_t inFeatures,
+           uint32_t outFeatures,
+           int32_t minValue);
+
+/**
+ * @brief Runs the fastest 16 bit float linear kernel available on this machine.
+ *
+ * @details See @ref LinearHalfKernel for a description of the parameters.
+ * */
+void
+linearHalf(const uint16_t* weights,
+           const uint16_t* bias,
+           const float* input,
+           float* output,
+           uint32_t inFeatures,
+           uint32_t outFeatures,
+           uint32_t stride,
+           HalfFormat format,
+           Activation activation,
+           ActivationMode mode);
+
+/**
+ * @brief Computes a linear layer whose weights are stored as blocks of @ref NN_SPARSE_BLOCK_ROWS rows by one column,
+ *        so that only the blocks that were kept have to be multiplied.
+ *
+ * @details This is the block-CSR form: the blocks of block row `i` are `blockStarts[i]` up to `blockStarts[i + 1]`.
+ *          There is a single, portable version of this kernel. The inner loop over the rows of a block is simple
+ *          enough for the compiler to vectorize.
+ *
+ * @param values The weights of each block, one after another. The rows of the last block row that are past the
+ *               number of output features are zero.
+ *
+ * @param blockStarts The first block of each block row, followed by the number of blocks.
+ *
+ * @param blockColumns The input feature that each block is multiplied with.
+ *
+ * @param bias The bias of each output feature.
+ *
+ * @param output Where to write the output features. May not overlap with the input.
+ * */
+void
+sparseLinear(const float* values,
+             const uint32_t* blockStarts,
+             const FeatureSize* blockColumns,
+             const float* bias,
+             const float* input,
+             float* output,
+             uint32_t outFeatures,
+             Activation activation,
+             ActivationMode mode);
+
+/**
+ * @brief Runs one step of a gated recurrent unit, with the gates in the order reset, update, new.
+ *
+ * @details The gates are computed a few hidden features at a time with @ref linear, into buffers on the stack, so no
+ *          scratch memory is needed and each weight is only read once.
+ *
+ * @param inputWeights The `3 * hiddenSize` rows of weights from the input to the gates, followed by their biases.
+ *
+ * @param hiddenWeights The `3 * hiddenSize` rows of weights from the hidden state to the gates, followed by their
+ *                      biases.
+ *
+ * @param hidden The hidden state, which is read and then updated to the new one.
+ *
+ * @param output Where to write the new hidden state. May not overlap with the input or the hidden state.
+ *
+ * @param inputStride The number of floats between the rows of the input weights.
+ *
+ * @param hiddenStride The number of floats between the rows of the hidden weights.
+ * */
+void
+gru(const float* inputWeights,
+    const float* hiddenWeights,
+    const float* input,
+    float* hidden,
+    float* output,
+    uint32_t inFeatures,
+    uint32_t hiddenSize,
+    uint32_t inputStride,
+    uint32_t hiddenStride,
+    ActivationMode mode);
+
+/**
+ * @brief The same as @ref gru, with 16 bit float weights that are widened with @ref linearHalf.
+ * */
+void
+gruHalf(const uint16_t* inputWeights,
+        const uint16_t* hiddenWeights,
+        const float* input,
+        float* hidden,
+        float* output,
+        uint32_t inFeatures,
+        uint32_t hiddenSize,
+        uint32_t inputStride,
+        uint32_t hiddenStride,
+        HalfFormat format,
+        ActivationMode mode);
+
+/**
+ * @brief Moves the frames of a window one frame towards the start, dropping the oldest, and copies the newest frame to
+ *        the end. This is the state of a causal convolution.
+ *
+ * @param window `numFrames` frames of `frameSize` floats, from the oldest to the newest.
+ * */
+void
+pushFrame(float* window, const float* frame, uint32_t frameSize, uint32_t numFrames);
+
+} // namespace NN
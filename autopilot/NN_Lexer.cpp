@@ -30,7 +30,7 @@ isAlpha(const char c) -> bool
 
 } // namespace
 
-Lexer::Lexer(const char* source, uint16_t length)
+Lexer::Lexer(const char* source, SourceSize length)
   : source_(source)
   , length_(length)
 {
@@ -61,7 +61,7 @@ Lexer::lex() -> Token
   }
 
   if (c == '%') {
-    uint16_t len = 1;
+    SourceSize len = 1;
     while ((offset_ + len) < length_) {
       const auto c = peek(len);
       if (!isDigit(c)) {
@@ -73,7 +73,7 @@ Lexer::lex() -> Token
   }
 
   if (isDigit(c)) {
-    uint16_t len = 1;
+    SourceSize len = 1;
     while ((offset_ + len) < length_) {
       const auto c = peek(len);
       if (!isDigit(c)) {
@@ -85,7 +85,7 @@ Lexer::lex() -> Token
   }
 
   if (isAlpha(c)) {
-    uint16_t len = 1;
+    SourceSize len = 1;
     while ((offset_ + len) < length_) {
       const auto c = peek(len);
       if (!(isDigit(c) || isAlpha(c) || (c == '_'))) {
@@ -100,19 +100,19 @@ Lexer::lex() -> Token
 }
 
 auto
-Lexer::toPointer(const uint16_t offset) const -> const char*
+Lexer::toPointer(const SourceSize offset) const -> const char*
 {
   return source_ + offset;
 }
 
 auto
-Lexer::remaining() const -> uint16_t
+Lexer::remaining() const -> SourceSize
 {
   return (offset_ > length_) ? 0 : (length_ - offset_);
 }
 
 auto
-Lexer::produceToken(const TokenKind kind, const uint8_t length) -> Token
+Lexer::produceToken(const TokenKind kind, const SourceSize length) -> Token
 {
   Token token;
   token.kind = kind;
@@ -123,7 +123,7 @@ Lexer::produceToken(const TokenKind kind, const uint8_t length) -> Token
 }
 
 auto
-Lexer::peek(uint16_t relativeOffset) const -> char
+Lexer::peek(SourceSize relativeOffset) const -> char
 {
   const auto absOffset = offset_ + relativeOffset;
   if (absOffset < length_) {
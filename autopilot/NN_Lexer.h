@@ -1,5 +1,7 @@
 #pragma once
 
+#include "NN_Config.h"
+
 #include <stdint.h>
 
 namespace NN {
@@ -19,9 +21,9 @@ struct Token final
 {
   TokenKind kind{ TokenKind::kNone };
 
-  uint8_t length{};
+  SourceSize length{};
 
-  uint16_t offset{};
+  SourceSize offset{};
 
   auto operator==(const TokenKind otherKind) const -> bool;
 
@@ -31,25 +33,25 @@ struct Token final
 class Lexer final
 {
 public:
-  Lexer(const char* source, uint16_t length);
+  Lexer(const char* source, SourceSize length);
 
   [[nodiscard]] auto lex() -> Token;
 
-  [[nodiscard]] auto remaining() const -> uint16_t;
+  [[nodiscard]] auto remaining() const -> SourceSize;
 
-  [[nodiscard]] auto toPointer(const uint16_t offset) const -> const char*;
+  [[nodiscard]] auto toPointer(const SourceSize offset) const -> const char*;
 
 protected:
-  [[nodiscard]] auto produceToken(TokenKind kind, uint8_t length) -> Token;
+  [[nodiscard]] auto produceToken(TokenKind kind, SourceSize length) -> Token;
 
-  [[nodiscard]] auto peek(uint16_t relativeOffset) const -> char;
+  [[nodiscard]] auto peek(SourceSize relativeOffset) const -> char;
 
 private:
   const char* source_{};
 
-  uint16_t length_{};
+  SourceSize length_{};
 
-  uint16_t offset_{};
+  SourceSize offset_{};
 };
 
 } // namespace NN
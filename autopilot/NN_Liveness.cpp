@@ -0,0 +1,200 @@
+#include "NN_Liveness.h"
+
+namespace NN {
+
+auto
+LiveInterval::overlaps(const LiveInterval& other) const -> bool
+{
+  return used && other.used && (begin <= other.end) && (other.begin <= end);
+}
+
+void
+Liveness::markLiveOut(const uint8_t reg)
+{
+  liveOut_ |= regBit(reg);
+}
+
+auto
+Liveness::getInterval(const uint8_t reg) const -> LiveInterval
+{
+  auto interval = intervals_[reg];
+  if (!interval.used) {
+    return interval;
+  }
+  const auto readAfterLastDef = (lastDef_[reg] == 0) || (interval.end > lastDef_[reg]);
+  if (!readAfterLastDef || (liveOut_ & regBit(reg))) {
+    interval.end = LiveInterval::kEnd;
+  }
+  return interval;
+}
+
+void
+Liveness::assignOffsets(Net* net) const
+{
+  LiveInterval intervals[NN_MAX_REGS];
+  uint8_t order[NN_MAX_REGS];
+  uint8_t numRegs = 0;
+  for (uint8_t i = 0; i < NN_MAX_REGS; i++) {
+    net->regOffsets[i] = 0;
+    intervals[i] = getInterval(i);
+    if (!intervals[i].used || (net->regSizes[i] == 0)) {
+      continue;
+    }
+    // Insertion sort, largest register first.
+    uint8_t j = numRegs;
+    while ((j > 0) && (net->regSizes[order[j - 1]] < net->regSizes[i])) {
+      order[j] = order[j - 1];
+      j--;
+    }
+    order[j] = i;
+    numRegs++;
+  }
+
+  uint32_t arenaSize = 0;
+
+  for (uint8_t i = 0; i < numRegs; i++) {
+    const auto reg = order[i];
+    const uint32_t size = net->regSizes[reg];
+    uint32_t offset = 0;
+    // Each time the candidate offset collides with a placed register, it moves past it and the search starts over.
+    // There are few enough registers that this is cheaper than keeping the placed registers sorted.
+    auto moved = true;
+    while (moved) {
+      moved = false;
+      for (uint8_t j = 0; j < i; j++) {
+        const auto other = order[j];
+        if (!intervals[reg].overlaps(intervals[other])) {
+          continue;
+        }
+        const auto otherBegin = net->regOffsets[other];
+        const auto otherEnd = otherBegin + net->regSizes[other];
+        if ((offset < otherEnd) && (otherBegin < offset + size)) {
+          offset = otherEnd;
+          moved = true;
+        }
+      }
+    }
+    net->regOffsets[reg] = offset;
+    arenaSize = (arenaSize < offset + size) ? (offset + size) : arenaSize;
+  }
+
+  net->arenaSize = arenaSize;
+}
+
+void
+Liveness::beginAssignment(const uint8_t dstReg)
+{
+  instruction_++;
+  dstReg_ = dstReg;
+}
+
+void
+Liveness::define()
+{
+  auto& interval = intervals_[dstReg_];
+  if (!interval.used) {
+    interval.used = true;
+    interval.begin = instruction_;
+  }
+  interval.end = instruction_;
+  lastDef_[dstReg_] = instruction_;
+}
+
+void
+Liveness::interpret(const LinearExpr& expr)
+{
+  use(expr.inRegister);
+  define();
+}
+
+void
+Liveness::interpret(const MatMulExpr& expr)
+{
+  use(expr);
+  define();
+}
+
+void
+Liveness::interpret(const ConcatExpr& expr)
+{
+  use(expr);
+  define();
+}
+
+void
+Liveness::interpret(const CompAddExpr& expr)
+{
+  use(expr);
+  define();
+}
+
+void
+Liveness::interpret(const CompMulExpr& expr)
+{
+  use(expr);
+  define();
+}
+
+void
+Liveness::interpret(const ReLUExpr& expr)
+{
+  use(expr);
+  define();
+}
+
+void
+Liveness::interpret(const SigmoidExpr& expr)
+{
+  use(expr);
+  define();
+}
+
+void
+Liveness::interpret(const TanhExpr& expr)
+{
+  use(expr);
+  define();
+}
+
+void
+Liveness::interpret(const GRUExpr& expr)
+{
+  use(expr.inRegister);
+  define();
+}
+
+void
+Liveness::interpret(const Conv1DExpr& expr)
+{
+  use(expr.inRegister);
+  define();
+}
+
+void
+Liveness::use(const UnaryExpr& expr)
+{
+  use(expr.inRegister);
+}
+
+void
+Liveness::use(const BinaryExpr& expr)
+{
+  use(expr.leftOpReg);
+  use(expr.rightOpReg);
+}
+
+void
+Liveness::use(const uint8_t reg)
+{
+  auto& interval = intervals_[reg];
+  if (!interval.used) {
+    // Read before being written, so this is an input.
+    interval.used = true;
+    interval.begin = 0;
+  }
+  if (interval.end < instruction_) {
+    interval.end = instruction_;
+  }
+}
+
+} // namespace NN
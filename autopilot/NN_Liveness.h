@@ -0,0 +1,121 @@
+#pragma once
+
+#include "NN_Interpreter.h"
+#include "NN_Net.h"
+
+#include <stdint.h>
+
+namespace NN {
+
+/**
+ * @brief The range of instructions that a register holds a value for.
+ *
+ * @details Both ends are inclusive. Instructions are numbered from one, so that zero refers to the point before the
+ *          program starts, where the inputs are written. An end of @ref LiveInterval::kEnd means the register is read
+ *          after the program finishes.
+ * */
+struct LiveInterval final
+{
+  static constexpr InstrIndex kEnd{ maxInstructions };
+
+  InstrIndex begin{};
+
+  InstrIndex end{};
+
+  /**
+   * @brief Whether or not the register is used by the program at all.
+   * */
+  bool used{ false };
+
+  [[nodiscard]] auto overlaps(const LiveInterval& other) const -> bool;
+};
+
+/**
+ * @brief Finds the instructions that each register is live across, so that registers which are never live at the
+ *        same time can share memory.
+ *
+ * @details Registers that are read before they are written are the inputs of the network, and are live from the start
+ *          of the program. Registers that are written and never read afterwards are the outputs of the network, and
+ *          are live until the end. Registers that are both read by the program and by the caller afterwards have to
+ *          be marked with @ref Liveness::markLiveOut.
+ *
+ *          After running the program through this interpreter and the @ref NetBuilder, call
+ *          @ref Liveness::assignOffsets before @ref NetBuilder::finish.
+ * */
+class Liveness final : public Interpreter
+{
+public:
+  /**
+   * @brief Marks a register as being read after the program finishes.
+   * */
+  void markLiveOut(uint8_t reg);
+
+  [[nodiscard]] auto getInterval(uint8_t reg) const -> LiveInterval;
+
+  /**
+   * @brief Places the registers of the network in a shared arena, so that registers that are live at the same time
+   *        never overlap.
+   *
+   * @details The register sizes of the network have to be known already. Registers are placed largest first, each at
+   *          the lowest offset that does not overlap with a register already placed there that is live at the same
+   *          time.
+   * */
+  void assignOffsets(Net* net) const;
+
+  void beginAssignment(uint8_t dstReg) override;
+
+  void interpret(const LinearExpr& expr) override;
+
+  void interpret(const MatMulExpr& expr) override;
+
+  void interpret(const ConcatExpr& expr) override;
+
+  void interpret(const CompAddExpr& expr) override;
+
+  void interpret(const CompMulExpr& expr) override;
+
+  void interpret(const ReLUExpr& expr) override;
+
+  void interpret(const SigmoidExpr& expr) override;
+
+  void interpret(const TanhExpr& expr) override;
+
+  void interpret(const GRUExpr& expr) override;
+
+  void interpret(const Conv1DExpr& expr) override;
+
+protected:
+  void use(const UnaryExpr& expr);
+
+  void use(const BinaryExpr& expr);
+
+  void use(uint8_t reg);
+
+  /**
+   * @brief Records the write to the destination register. This comes after the operands are read, so that a register
+   *        which is read and then overwritten by the same instruction is still seen as an input.
+   * */
+  void define();
+
+private:
+  LiveInterval intervals_[NN_MAX_REGS]{};
+
+  /**
+   * @brief The last instruction that wrote to each register.
+   * */
+  InstrIndex lastDef_[NN_MAX_REGS]{};
+
+  /**
+   * @brief Registers marked with @ref Liveness::markLiveOut, one bit per register.
+   * */
+  RegMask liveOut_{};
+
+  /**
+   * @brief The number of the current instruction.
+   * */
+  InstrIndex instruction_{};
+
+  uint8_t dstReg_{};
+};
+
+} // namespace NN
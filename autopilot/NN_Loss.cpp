@@ -3,11 +3,11 @@
 namespace NN {
 
 auto
-l1Loss(const float* predicted, const float* target, const uint16_t size) -> float
+l1Loss(const float* predicted, const float* target, const FeatureSize size) -> float
 {
   float loss{};
 
-  for (uint16_t i = 0; i < size; i++) {
+  for (FeatureSize i = 0; i < size; i++) {
     const auto p = predicted[i];
     const auto t = target[i];
     if (p > t) {
@@ -21,11 +21,11 @@ l1Loss(const float* predicted, const float* target, const uint16_t size) -> floa
 }
 
 auto
-mseLoss(const float* predicted, const float* target, const uint16_t size) -> float
+mseLoss(const float* predicted, const float* target, const FeatureSize size) -> float
 {
   float loss{};
 
-  for (uint16_t i = 0; i < size; i++) {
+  for (FeatureSize i = 0; i < size; i++) {
     const auto delta = target[i] - predicted[i];
     loss += delta * delta;
   }
@@ -33,4 +33,24 @@ mseLoss(const float* predicted, const float* target, const uint16_t size) -> flo
   return loss / size;
 }
 
+void
+l1LossGradient(const float* predicted, const float* target, const FeatureSize size, float* gradient)
+{
+  for (FeatureSize i = 0; i < size; i++) {
+    const auto p = predicted[i];
+    const auto t = target[i];
+    gradient[i] = (p > t) ? 1.0F : ((p < t) ? -1.0F : 0.0F);
+  }
+}
+
+void
+mseLossGradient(const float* predicted, const float* target, const FeatureSize size, float* gradient)
+{
+  const auto scale = 2.0F / size;
+
+  for (FeatureSize i = 0; i < size; i++) {
+    gradient[i] = scale * (predicted[i] - target[i]);
+  }
+}
+
 } // namespace NN
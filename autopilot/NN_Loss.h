@@ -1,13 +1,27 @@
 #pragma once
 
+#include "NN_Config.h"
+
 #include <stdint.h>
 
 namespace NN {
 
 [[nodiscard]] auto
-l1Loss(const float* predicted, const float* target, const uint16_t size) -> float;
+l1Loss(const float* predicted, const float* target, const FeatureSize size) -> float;
 
 [[nodiscard]] auto
-mseLoss(const float* predicted, const float* target, const uint16_t size) -> float;
+mseLoss(const float* predicted, const float* target, const FeatureSize size) -> float;
+
+/**
+ * @brief Computes the gradient of @ref l1Loss with respect to each prediction.
+ * */
+void
+l1LossGradient(const float* predicted, const float* target, FeatureSize size, float* gradient);
+
+/**
+ * @brief Computes the gradient of @ref mseLoss with respect to each prediction.
+ * */
+void
+mseLossGradient(const float* predicted, const float* target, FeatureSize size, float* gradient);
 
 } // namespace NN
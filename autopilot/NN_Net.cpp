@@ -2,33 +2,135 @@
 
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 
 namespace NN {
 
+namespace {
+
 auto
-Net::allocMemory() -> bool
+alignUp(const uint64_t size, const uint64_t alignment) -> uint64_t
+{
+  return ((size + alignment - 1) / alignment) * alignment;
+}
+
+/**
+ * @brief The row stride before it is narrowed to 32 bits, which it only is once the layer is known to fit.
+ * */
+auto
+rowStride(const FeatureSize inFeatures, const WeightLayout layout) -> uint64_t
+{
+  switch (layout) {
+    case WeightLayout::kPacked:
+      break;
+    case WeightLayout::kPadded:
+      return alignUp(inFeatures, NN_ROW_ALIGNMENT);
+  }
+  return inFeatures;
+}
+
+/**
+ * @brief The alignment of each activation arena, in bytes.
+ * */
+constexpr uintptr_t cacheLineSize = 64;
+
+} // namespace
+
+auto
+linearRowStride(const FeatureSize inFeatures, const WeightLayout layout) -> uint32_t
+{
+  return static_cast<uint32_t>(rowStride(inFeatures, layout));
+}
+
+auto
+linearParameterCount(const FeatureSize inFeatures, const FeatureSize outFeatures, const WeightLayout layout) -> uint64_t
+{
+  const auto weights = rowStride(inFeatures, layout) * outFeatures;
+  switch (layout) {
+    case WeightLayout::kPacked:
+      break;
+    case WeightLayout::kPadded:
+      return weights + alignUp(outFeatures, NN_ROW_ALIGNMENT);
+  }
+  return weights + outFeatures;
+}
+
+auto
+gruParameterCount(const FeatureSize inFeatures, const FeatureSize hiddenSize, const WeightLayout layout) -> uint64_t
+{
+  const auto gates = static_cast<FeatureSize>(3 * static_cast<uint32_t>(hiddenSize));
+  return linearParameterCount(inFeatures, gates, layout) + linearParameterCount(hiddenSize, gates, layout);
+}
+
+auto
+conv1DParameterCount(const FeatureSize inChannels,
+                     const FeatureSize outChannels,
+                     const FeatureSize kernelSize,
+                     const WeightLayout layout) -> uint64_t
+{
+  const auto window = static_cast<FeatureSize>(static_cast<uint32_t>(kernelSize) * inChannels);
+  return linearParameterCount(window, outChannels, layout);
+}
+
+void
+Net::assignRegisters()
 {
-  size_t allocSize = numParameters * sizeof(float);
+  if (arenaSize != 0) {
+    return;
+  }
   for (uint8_t i = 0; i < NN_MAX_REGS; i++) {
-    allocSize += regSizes[i] * sizeof(float);
+    regOffsets[i] = arenaSize;
+    arenaSize += regSizes[i];
   }
-  auto* memory = static_cast<float*>(malloc(allocSize));
+}
+
+auto
+Net::allocMemory() -> bool
+{
+  assignRegisters();
+  const size_t alignment = (weightLayout == WeightLayout::kPadded) ? (NN_ROW_ALIGNMENT * sizeof(float)) : 0;
+  const size_t numStates = static_cast<size_t>(stateSize) * batchSize;
+  const size_t allocSize =
+    (numParameters + arenaSize * static_cast<size_t>(batchSize) + numStates) * sizeof(float) + alignment;
+  memory = malloc(allocSize);
   if (!memory) {
     return false;
   }
-  parameters = memory;
-  memory += numParameters;
+  auto address = reinterpret_cast<uintptr_t>(memory);
+  if (alignment > 0) {
+    address = (address + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+  }
+  parameters = reinterpret_cast<float*>(address);
+  auto* arena = parameters + numParameters;
   for (uint8_t i = 0; i < NN_MAX_REGS; i++) {
-    regs[i] = memory;
-    memory += regSizes[i];
+    regs[i] = arena + static_cast<size_t>(regOffsets[i]) * batchSize;
   }
+  state = arena + arenaSize * static_cast<size_t>(batchSize);
+  memset(state, 0, numStates * sizeof(float));
   return true;
 }
 
 void
 Net::releaseMemory()
 {
-  free(parameters);
+  free(memory);
+  memory = nullptr;
+  parameters = nullptr;
+  state = nullptr;
+}
+
+auto
+Net::getShape() const -> Net
+{
+  Net shape = *this;
+  shape.numParameters = 0;
+  shape.parameters = nullptr;
+  shape.memory = nullptr;
+  shape.state = nullptr;
+  for (uint8_t i = 0; i < NN_MAX_REGS; i++) {
+    shape.regs[i] = nullptr;
+  }
+  return shape;
 }
 
 void
@@ -41,4 +143,35 @@ Net::randomize(void* rngData, auto(*rngFunc)(void*)->float)
   }
 }
 
+auto
+Activations::allocMemory(const Net& net) -> bool
+{
+  const auto arenaBytes = static_cast<size_t>(net.arenaSize) * net.batchSize * sizeof(float);
+  const auto stateBytes = static_cast<size_t>(net.stateSize) * net.batchSize * sizeof(float);
+  const auto paddedBytes = (arenaBytes + stateBytes + cacheLineSize - 1) & ~static_cast<size_t>(cacheLineSize - 1);
+  memory = malloc(paddedBytes + cacheLineSize);
+  if (!memory) {
+    return false;
+  }
+  const auto address = (reinterpret_cast<uintptr_t>(memory) + cacheLineSize - 1) & ~(cacheLineSize - 1);
+  auto* arena = reinterpret_cast<float*>(address);
+  for (uint8_t i = 0; i < NN_MAX_REGS; i++) {
+    regs[i] = arena + static_cast<size_t>(net.regOffsets[i]) * net.batchSize;
+  }
+  state = arena + arenaBytes / sizeof(float);
+  memset(state, 0, stateBytes);
+  return true;
+}
+
+void
+Activations::releaseMemory()
+{
+  free(memory);
+  memory = nullptr;
+  state = nullptr;
+  for (uint8_t i = 0; i < NN_MAX_REGS; i++) {
+    regs[i] = nullptr;
+  }
+}
+
 } // namespace NN
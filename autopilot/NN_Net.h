@@ -1,21 +1,119 @@
 #pragma once
 
+#include "NN_Activation.h"
+#include "NN_Config.h"
+
 #include <stdint.h>
 
-#define NN_MAX_REGS 16
+/**
+ * @brief The number of floats that rows are aligned to in @ref NN::WeightLayout::kPadded (64 bytes).
+ * */
+#define NN_ROW_ALIGNMENT 16
 
 namespace NN {
 
+enum class WeightLayout : uint8_t
+{
+  /**
+   * @brief The rows of each weight matrix are stored back to back. This is the smallest layout.
+   * */
+  kPacked,
+
+  /**
+   * @brief Each row of weights and each bias vector starts on a 64 byte boundary, so that SIMD loads never split a
+   *        cache line. This costs up to @ref NN_ROW_ALIGNMENT - 1 floats per row.
+   * */
+  kPadded
+};
+
+/**
+ * @brief Gets the number of floats between the start of each row of a linear layer's weights.
+ * */
+[[nodiscard]] auto
+linearRowStride(FeatureSize inFeatures, WeightLayout layout) -> uint32_t;
+
+/**
+ * @brief Gets the number of parameters (weights and bias) taken up by a linear layer.
+ *
+ * @details The parameter counts are 64-bit, so that @ref NetBuilder can tell when a layer would not fit in the 32-bit
+ *          count of a network.
+ * */
+[[nodiscard]] auto
+linearParameterCount(FeatureSize inFeatures, FeatureSize outFeatures, WeightLayout layout) -> uint64_t;
+
+/**
+ * @brief Gets the number of parameters taken up by a GRU, which is a linear layer from the input to the three gates
+ *        followed by one from the hidden state to the three gates. `3 * hiddenSize` has to fit in @ref FeatureSize.
+ * */
+[[nodiscard]] auto
+gruParameterCount(FeatureSize inFeatures, FeatureSize hiddenSize, WeightLayout layout) -> uint64_t;
+
+/**
+ * @brief Gets the number of parameters taken up by a Conv1D, which is a linear layer over the last `kernelSize`
+ *        inputs. `kernelSize * inChannels` has to fit in @ref FeatureSize.
+ * */
+[[nodiscard]] auto
+conv1DParameterCount(FeatureSize inChannels, FeatureSize outChannels, FeatureSize kernelSize, WeightLayout layout)
+  -> uint64_t;
+
 struct Net final
 {
   uint32_t numParameters{};
 
-  uint16_t regSizes[NN_MAX_REGS]{};
+  /**
+   * @brief How the weights of the linear layers are laid out. This has to be set before the network is built.
+   * */
+  WeightLayout weightLayout{ WeightLayout::kPacked };
+
+  /**
+   * @brief How accurately the sigmoid and tanh activations are computed when the network is run.
+   * */
+  ActivationMode activationMode{ ActivationMode::kPrecise };
+
+  FeatureSize regSizes[NN_MAX_REGS]{};
+
+  /**
+   * @brief The number of samples that each register holds.
+   *
+   * @details The samples of a register are stored one after another, so sample `b` of register `r` starts at
+   *          `regs[r] + b * regSizes[r]`. This has to be set before the memory is allocated.
+   * */
+  uint16_t batchSize{ 1 };
+
+  /**
+   * @brief Where each register starts in the register arena, in floats per sample.
+   *
+   * @details Registers that are never live at the same time may share memory. See @ref Liveness::assignOffsets.
+   * */
+  uint32_t regOffsets[NN_MAX_REGS]{};
+
+  /**
+   * @brief The size of the register arena, in floats per sample.
+   *
+   * @details If this is zero when the memory is allocated, each register is given its own memory and the offsets are
+   *          filled in by @ref Net::allocMemory.
+   * */
+  uint32_t arenaSize{};
+
+  /**
+   * @brief The number of floats per sample kept by the GRU and Conv1D instructions between runs of the network.
+   *
+   * @details Each of them takes its part of the state in program order, the same way that parameters are taken. The
+   *          state of sample `b` starts at `state + b * stateSize`. It is zero when the memory is allocated.
+   * */
+  uint32_t stateSize{};
 
   float* parameters{};
 
   float* regs[NN_MAX_REGS]{};
 
+  float* state{};
+
+  /**
+   * @brief The start of the allocated memory, which may come before the aligned parameters.
+   * */
+  void* memory{};
+
   /**
    * @brief Attempts to allocate the parameters and registers in the network.
    *
@@ -23,15 +121,56 @@ struct Net final
    * */
   [[nodiscard]] auto allocMemory() -> bool;
 
+  /**
+   * @brief Gives each register its own part of the arena, unless the arena has already been laid out.
+   * */
+  void assignRegisters();
+
   /**
    * @brief Releases memory allocated by the registers and parameters.
    * */
   void releaseMemory();
 
+  /**
+   * @brief Gets a copy of the layout of the registers, the batch size and the modes, without any parameters or memory.
+   *
+   * @details This is what the networks converted from this one keep for running their other instructions.
+   * */
+  [[nodiscard]] auto getShape() const -> Net;
+
   /**
    * @brief Randomizes the parameters.
    * */
   void randomize(void* rngData, auto(*rngFunc)(void*)->float);
 };
 
+/**
+ * @brief The registers for one run of a network, apart from its parameters.
+ *
+ * @details Each @ref NetRunner that is given its own activations only reads from the network, so any number of them
+ *          can run at once on one copy of the parameters. The memory starts and ends on a cache line, so that arenas
+ *          used by different threads never share one.
+ * */
+struct Activations final
+{
+  float* regs[NN_MAX_REGS]{};
+
+  /**
+   * @brief The state of the GRU and Conv1D instructions. See @ref Net::stateSize.
+   * */
+  float* state{};
+
+  void* memory{};
+
+  /**
+   * @brief Allocates the registers and the state with the layout and batch size of a network. The network has to be
+   *        built first.
+   *
+   * @return True on success, false on failure.
+   * */
+  [[nodiscard]] auto allocMemory(const Net& net) -> bool;
+
+  void releaseMemory();
+};
+
 } // namespace NN
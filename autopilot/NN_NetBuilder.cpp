@@ -1,5 +1,6 @@
 #include "NN_NetBuilder.h"
 
+#include <stdint.h>
 #include <stdlib.h>
 
 namespace NN {
@@ -7,17 +8,19 @@ namespace NN {
 namespace {
 
 auto
-minValue16(uint16_t x, uint16_t y) -> uint16_t
+minFeatures(FeatureSize x, FeatureSize y) -> FeatureSize
 {
   return (x < y) ? x : y;
 }
 
 } // namespace
 
-NetBuilder::NetBuilder(Net* net, const uint16_t inputSize)
+NetBuilder::NetBuilder(Net* net, const FeatureSize inputSize)
   : net_(net)
 {
   net_->numParameters = 0;
+  net_->arenaSize = 0;
+  net_->stateSize = 0;
   net_->regSizes[0] = inputSize;
   for (uint8_t i = 1; i < NN_MAX_REGS; i++) {
     net_->regSizes[i] = 0;
@@ -27,6 +30,19 @@ NetBuilder::NetBuilder(Net* net, const uint16_t inputSize)
 auto
 NetBuilder::finish() -> bool
 {
+  if (shapeError_) {
+    return false;
+  }
+
+  // The registers are laid out in a 32-bit arena, and sharing registers never makes it larger than this.
+  uint64_t totalRegSize{};
+  for (uint8_t i = 0; i < NN_MAX_REGS; i++) {
+    totalRegSize += net_->regSizes[i];
+  }
+  if (totalRegSize > UINT32_MAX) {
+    return false;
+  }
+
   return net_->allocMemory();
 }
 
@@ -40,31 +56,45 @@ void
 NetBuilder::interpret(const LinearExpr& expr)
 {
   expandCurrentRegSize(expr.outFeatures);
-  net_->numParameters += expr.inFeatures * expr.outFeatures + expr.outFeatures;
+  addParameters(linearParameterCount(expr.inFeatures, expr.outFeatures, net_->weightLayout));
 }
 
 void
 NetBuilder::interpret(const MatMulExpr& expr)
 {
-  (void)expr;
+  const auto lSize = net_->regSizes[expr.leftOpReg];
+  const auto rSize = net_->regSizes[expr.rightOpReg];
+  const auto m = expr.leftRows;
+  if ((m == 0) || ((lSize % m) != 0)) {
+    shapeError_ = true;
+    return;
+  }
+
+  const auto k = lSize / m;
+  if ((k == 0) || ((rSize % k) != 0)) {
+    shapeError_ = true;
+    return;
+  }
+
+  expandCurrentRegSize(static_cast<uint64_t>(m) * (rSize / k));
 }
 
 void
 NetBuilder::interpret(const ConcatExpr& expr)
 {
-  expandCurrentRegSize(expr.leftOpReg + expr.rightOpReg);
+  expandCurrentRegSize(static_cast<uint64_t>(net_->regSizes[expr.leftOpReg]) + net_->regSizes[expr.rightOpReg]);
 }
 
 void
 NetBuilder::interpret(const CompAddExpr& expr)
 {
-  expandCurrentRegSize(minValue16(net_->regSizes[expr.leftOpReg], net_->regSizes[expr.rightOpReg]));
+  expandCurrentRegSize(minFeatures(net_->regSizes[expr.leftOpReg], net_->regSizes[expr.rightOpReg]));
 }
 
 void
 NetBuilder::interpret(const CompMulExpr& expr)
 {
-  expandCurrentRegSize(minValue16(net_->regSizes[expr.leftOpReg], net_->regSizes[expr.rightOpReg]));
+  expandCurrentRegSize(minFeatures(net_->regSizes[expr.leftOpReg], net_->regSizes[expr.rightOpReg]));
 }
 
 void
@@ -86,10 +116,60 @@ NetBuilder::interpret(const TanhExpr& expr)
 }
 
 void
-NetBuilder::expandCurrentRegSize(const uint16_t size)
+NetBuilder::interpret(const GRUExpr& expr)
+{
+  // The weights of the three gates are one linear layer.
+  if ((3 * static_cast<uint64_t>(expr.hiddenSize)) > maxFeatures) {
+    shapeError_ = true;
+    return;
+  }
+  expandCurrentRegSize(expr.hiddenSize);
+  addParameters(gruParameterCount(expr.inFeatures, expr.hiddenSize, net_->weightLayout));
+  addState(expr.hiddenSize);
+}
+
+void
+NetBuilder::interpret(const Conv1DExpr& expr)
+{
+  const auto window = static_cast<uint64_t>(expr.kernelSize) * expr.inChannels;
+  if (window > maxFeatures) {
+    shapeError_ = true;
+    return;
+  }
+  expandCurrentRegSize(expr.outChannels);
+  addParameters(conv1DParameterCount(expr.inChannels, expr.outChannels, expr.kernelSize, net_->weightLayout));
+  addState(window);
+}
+
+void
+NetBuilder::expandCurrentRegSize(const uint64_t size)
 {
+  if (size > maxFeatures) {
+    shapeError_ = true;
+    return;
+  }
   const auto v = net_->regSizes[currentReg_];
-  net_->regSizes[currentReg_] = (v < size) ? size : v;
+  net_->regSizes[currentReg_] = (v < size) ? static_cast<FeatureSize>(size) : v;
+}
+
+void
+NetBuilder::addParameters(const uint64_t count)
+{
+  if (count > (UINT32_MAX - net_->numParameters)) {
+    shapeError_ = true;
+    return;
+  }
+  net_->numParameters += static_cast<uint32_t>(count);
+}
+
+void
+NetBuilder::addState(const uint64_t size)
+{
+  if (size > (UINT32_MAX - net_->stateSize)) {
+    shapeError_ = true;
+    return;
+  }
+  net_->stateSize += static_cast<uint32_t>(size);
 }
 
 } // namespace NN
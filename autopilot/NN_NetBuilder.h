@@ -10,7 +10,7 @@ namespace NN {
 class NetBuilder final : public Interpreter
 {
 public:
-  NetBuilder(Net* net, uint16_t inputSize);
+  NetBuilder(Net* net, FeatureSize inputSize);
 
   void beginAssignment(uint8_t dstReg) override;
 
@@ -30,15 +30,43 @@ public:
 
   void interpret(const TanhExpr&) override;
 
+  void interpret(const GRUExpr&) override;
+
+  void interpret(const Conv1DExpr&) override;
+
+  /**
+   * @brief Allocates the memory of the network.
+   *
+   * @return False if the shapes of the operands were invalid, if the parameters, the registers or the state do not
+   *         fit in their 32-bit counts, or if the memory could not be allocated.
+   * */
   [[nodiscard]] auto finish() -> bool;
 
 protected:
-  void expandCurrentRegSize(uint16_t size);
+  /**
+   * @brief Grows the current register to a size, which is a shape error if it does not fit in @ref FeatureSize.
+   * */
+  void expandCurrentRegSize(uint64_t size);
+
+  /**
+   * @brief Adds the parameters of a layer, which is a shape error if the total does not fit in 32 bits.
+   * */
+  void addParameters(uint64_t count);
+
+  /**
+   * @brief Adds the state of a GRU or Conv1D, which is a shape error if the total does not fit in 32 bits.
+   * */
+  void addState(uint64_t size);
 
 private:
   Net* net_{};
 
   uint8_t currentReg_{};
+
+  /**
+   * @brief Whether or not an expression had operands with incompatible shapes.
+   * */
+  bool shapeError_{ false };
 };
 
 } // namespace NN
@@ -1,20 +1,68 @@
 #include "NN_NetRunner.h"
 
+#include "NN_Kernels.h"
 #include "NN_Net.h"
 
-#include <math.h>
+#include <string.h>
 
 namespace NN {
 
 NetRunner::NetRunner(const Net* net)
   : net_(net)
+  , regs_(net->regs)
+  , state_(net->state)
+{
+}
+
+NetRunner::NetRunner(const Net* net, Activations* activations)
+  : net_(net)
+  , regs_(activations->regs)
+  , state_(activations->state)
 {
 }
 
 auto
 NetRunner::getRegister(const uint8_t reg) -> float*
 {
-  return net_->regs[reg];
+  return regs_[reg];
+}
+
+auto
+NetRunner::getRegister(const uint8_t reg, const uint16_t sample) -> float*
+{
+  return regs_[reg] + static_cast<size_t>(sample) * net_->regSizes[reg];
+}
+
+auto
+NetRunner::getRegisterSize(const uint8_t reg) const -> FeatureSize
+{
+  return regSizes_[reg];
+}
+
+void
+NetRunner::setBatchSize(const uint16_t batchSize)
+{
+  batchSize_ = (batchSize < net_->batchSize) ? batchSize : net_->batchSize;
+}
+
+auto
+NetRunner::getBatchSize() const -> uint16_t
+{
+  return batchSize_;
+}
+
+auto
+NetRunner::getNet() const -> const Net*
+{
+  return net_;
+}
+
+void
+NetRunner::setParallel(void* executorData, ParallelForFunc parallelFor, const uint32_t minParallelMACs)
+{
+  executorData_ = executorData;
+  parallelFor_ = parallelFor;
+  minParallelMACs_ = minParallelMACs;
 }
 
 void
@@ -22,151 +70,301 @@ NetRunner::reset()
 {
   currentReg_ = 0;
   currentParameters_ = net_->parameters;
+  stateOffset_ = 0;
+  // Registers that are not assigned by the program, such as the inputs, are used at their full size.
+  for (uint8_t i = 0; i < NN_MAX_REGS; i++) {
+    regSizes_[i] = net_->regSizes[i];
+  }
 }
 
 void
-NetRunner::beginAssignment(uint8_t dstReg)
+NetRunner::clearState()
 {
-  currentReg_ = dstReg;
+  memset(state_, 0, static_cast<size_t>(net_->stateSize) * net_->batchSize * sizeof(float));
 }
 
 void
-NetRunner::interpret(const LinearExpr& expr)
+NetRunner::clearState(const uint16_t sample)
 {
-  const auto* input = net_->regs[expr.inRegister];
+  memset(state_ + static_cast<size_t>(sample) * net_->stateSize, 0, net_->stateSize * sizeof(float));
+}
 
-  const auto* params = currentParameters_;
+auto
+NetRunner::getState(const uint16_t sample) -> float*
+{
+  return state_ + static_cast<size_t>(sample) * net_->stateSize + stateOffset_;
+}
 
-  const auto* weights = params;
+void
+NetRunner::skipState(const uint32_t size)
+{
+  stateOffset_ += size;
+}
 
-  const auto* bias = weights + expr.inFeatures * expr.outFeatures;
+void
+NetRunner::seek(const uint32_t parameterOffset)
+{
+  currentParameters_ = net_->parameters + parameterOffset;
+}
 
-  for (uint32_t i = 0; i < static_cast<uint32_t>(expr.outFeatures); i++) {
+void
+NetRunner::setRegisterSize(const uint8_t reg, const FeatureSize size)
+{
+  regSizes_[reg] = size;
+}
 
-    float out{};
+void
+NetRunner::beginAssignment(uint8_t dstReg)
+{
+  currentReg_ = dstReg;
+}
 
-    for (uint32_t j = 0; j < static_cast<uint32_t>(expr.inFeatures); j++) {
-      const auto in = input[j];
-      const auto weight = params[i * static_cast<uint32_t>(expr.inFeatures) + j];
-      const auto v = in * weight;
-      out += v;
+void
+NetRunner::applyUnary(const uint8_t inReg, const Activation activation)
+{
+  const auto numFeatures = regSizes_[inReg];
+  const auto inStride = net_->regSizes[inReg];
+  const auto outStride = net_->regSizes[currentReg_];
+  const auto* input = regs_[inReg];
+  auto* output = regs_[currentReg_];
+
+  if ((numFeatures == inStride) && (numFeatures == outStride)) {
+    // The samples are contiguous, so the whole batch can be done in one call.
+    activate(input, output, static_cast<uint32_t>(numFeatures) * batchSize_, activation, net_->activationMode);
+  } else {
+    for (uint32_t b = 0; b < batchSize_; b++) {
+      activate(input + b * inStride, output + b * outStride, numFeatures, activation, net_->activationMode);
     }
+  }
+
+  regSizes_[currentReg_] = numFeatures;
+}
 
-    net_->regs[currentReg_][i] = out + bias[i];
+template<typename Func>
+void
+NetRunner::applyBinary(const BinaryExpr& expr, Func func)
+{
+  const auto lSize = regSizes_[expr.leftOpReg];
+  const auto rSize = regSizes_[expr.rightOpReg];
+  const auto minSize = (lSize < rSize) ? lSize : rSize;
+  const auto lStride = net_->regSizes[expr.leftOpReg];
+  const auto rStride = net_->regSizes[expr.rightOpReg];
+  const auto outStride = net_->regSizes[currentReg_];
+
+  for (uint32_t b = 0; b < batchSize_; b++) {
+    const auto* leftOp = regs_[expr.leftOpReg] + b * lStride;
+    const auto* rightOp = regs_[expr.rightOpReg] + b * rStride;
+    auto* output = regs_[currentReg_] + b * outStride;
+    for (uint32_t i = 0; i < minSize; i++) {
+      output[i] = func(leftOp[i], rightOp[i]);
+    }
+    if (expr.activation != Activation::kNone) {
+      activate(output, output, minSize, expr.activation, net_->activationMode);
+    }
   }
 
-  regSizes_[currentReg_] = expr.outFeatures;
+  regSizes_[currentReg_] = minSize;
+}
 
-  currentParameters_ += expr.inFeatures * expr.outFeatures + expr.outFeatures;
+void
+NetRunner::runLinearRows(const LinearExpr& expr, const uint32_t firstRow, const uint32_t numRows) const
+{
+  const auto stride = linearRowStride(expr.inFeatures, net_->weightLayout);
+
+  const auto* weights = currentParameters_ + firstRow * stride;
+
+  const auto* bias = currentParameters_ + stride * expr.outFeatures + firstRow;
+
+  const auto* input = regs_[expr.inRegister];
+
+  auto* output = regs_[currentReg_] + firstRow;
+
+  if (batchSize_ == 1) {
+    linear(weights, bias, input, output, expr.inFeatures, numRows, stride, expr.activation, net_->activationMode);
+  } else {
+    linearBatch(weights,
+                bias,
+                input,
+                net_->regSizes[expr.inRegister],
+                output,
+                net_->regSizes[currentReg_],
+                expr.inFeatures,
+                numRows,
+                stride,
+                batchSize_,
+                expr.activation,
+                net_->activationMode);
+  }
 }
 
 void
-NetRunner::interpret(const MatMulExpr& expr)
+NetRunner::runLinearChunk(void* selfPtr, const uint32_t chunk)
 {
-  (void)expr;
+  const auto* self = static_cast<const NetRunner*>(selfPtr);
+  const auto firstRow = chunk * parallelChunkRows;
+  const uint32_t left = self->parallelExpr_->outFeatures - firstRow;
+  self->runLinearRows(*self->parallelExpr_, firstRow, (left < parallelChunkRows) ? left : parallelChunkRows);
 }
 
 void
-NetRunner::interpret(const ConcatExpr& expr)
+NetRunner::interpret(const LinearExpr& expr)
 {
-  const auto* leftOp = net_->regs[expr.leftOpReg];
-  const auto* rightOp = net_->regs[expr.rightOpReg];
-  auto* output = net_->regs[currentReg_];
-  const auto lSize = regSizes_[expr.leftOpReg];
-  const auto rSize = regSizes_[expr.rightOpReg];
+  const uint32_t outFeatures = expr.outFeatures;
 
-  for (uint32_t i = 0; i < lSize; i++) {
-    output[i] = leftOp[i];
-  }
+  const auto macs = static_cast<uint64_t>(expr.inFeatures) * outFeatures * batchSize_;
 
-  for (uint32_t i = 0; i < rSize; i++) {
-    output[lSize + i] = rightOp[i];
+  if ((parallelFor_ != serialFor) && (macs >= minParallelMACs_) && (outFeatures > parallelChunkRows)) {
+    parallelExpr_ = &expr;
+    parallelFor_(executorData_, (outFeatures + parallelChunkRows - 1) / parallelChunkRows, runLinearChunk, this);
+    parallelExpr_ = nullptr;
+  } else {
+    runLinearRows(expr, 0, outFeatures);
   }
 
-  regSizes_[currentReg_] = lSize + rSize;
+  regSizes_[currentReg_] = expr.outFeatures;
+
+  currentParameters_ += linearParameterCount(expr.inFeatures, expr.outFeatures, net_->weightLayout);
 }
 
 void
-NetRunner::interpret(const CompAddExpr& expr)
+NetRunner::interpret(const MatMulExpr& expr)
 {
-  const auto* leftOp = net_->regs[expr.leftOpReg];
-  const auto* rightOp = net_->regs[expr.rightOpReg];
-  auto* output = net_->regs[currentReg_];
-  const auto lSize = regSizes_[expr.leftOpReg];
-  const auto rSize = regSizes_[expr.rightOpReg];
-
-  const auto minSize = (lSize < rSize) ? lSize : rSize;
-
-  for (uint32_t i = 0; i < minSize; i++) {
-    output[i] = leftOp[i] + rightOp[i];
+  const uint32_t m = expr.leftRows;
+  const uint32_t k = (m > 0) ? (regSizes_[expr.leftOpReg] / m) : 0;
+  const uint32_t n = (k > 0) ? (regSizes_[expr.rightOpReg] / k) : 0;
+  const auto lStride = net_->regSizes[expr.leftOpReg];
+  const auto rStride = net_->regSizes[expr.rightOpReg];
+  const auto outStride = net_->regSizes[currentReg_];
+
+  for (uint32_t b = 0; b < batchSize_; b++) {
+    const auto* leftOp = regs_[expr.leftOpReg] + b * lStride;
+    const auto* rightOp = regs_[expr.rightOpReg] + b * rStride;
+    auto* output = regs_[currentReg_] + b * outStride;
+    matMul(leftOp, rightOp, output, m, k, n);
+    activate(output, output, m * n, expr.activation, net_->activationMode);
   }
 
-  regSizes_[currentReg_] = lSize + rSize;
+  regSizes_[currentReg_] = static_cast<FeatureSize>(m * n);
 }
 
 void
-NetRunner::interpret(const CompMulExpr& expr)
+NetRunner::interpret(const ConcatExpr& expr)
 {
-  const auto* leftOp = net_->regs[expr.leftOpReg];
-  const auto* rightOp = net_->regs[expr.rightOpReg];
-  auto* output = net_->regs[currentReg_];
   const auto lSize = regSizes_[expr.leftOpReg];
   const auto rSize = regSizes_[expr.rightOpReg];
+  const auto lStride = net_->regSizes[expr.leftOpReg];
+  const auto rStride = net_->regSizes[expr.rightOpReg];
+  const auto outStride = net_->regSizes[currentReg_];
 
-  const auto minSize = (lSize < rSize) ? lSize : rSize;
+  for (uint32_t b = 0; b < batchSize_; b++) {
+    const auto* leftOp = regs_[expr.leftOpReg] + b * lStride;
+    const auto* rightOp = regs_[expr.rightOpReg] + b * rStride;
+    auto* output = regs_[currentReg_] + b * outStride;
 
-  for (uint32_t i = 0; i < minSize; i++) {
-    output[i] = leftOp[i] * rightOp[i];
+    for (uint32_t i = 0; i < lSize; i++) {
+      output[i] = leftOp[i];
+    }
+
+    for (uint32_t i = 0; i < rSize; i++) {
+      output[lSize + i] = rightOp[i];
+    }
+
+    activate(output, output, lSize + rSize, expr.activation, net_->activationMode);
   }
 
   regSizes_[currentReg_] = lSize + rSize;
 }
 
 void
-NetRunner::interpret(const ReLUExpr& expr)
+NetRunner::interpret(const CompAddExpr& expr)
 {
-  const auto numFeatures = regSizes_[expr.inRegister];
-
-  const auto* input = net_->regs[expr.inRegister];
-
-  auto* output = net_->regs[currentReg_];
+  applyBinary(expr, [](const float l, const float r) -> float { return l + r; });
+}
 
-  for (uint32_t i = 0; i < numFeatures; i++) {
-    const auto in = input[i];
-    output[i] = (in >= 0.0F) ? in : 0.0F;
-  }
+void
+NetRunner::interpret(const CompMulExpr& expr)
+{
+  applyBinary(expr, [](const float l, const float r) -> float { return l * r; });
+}
 
-  regSizes_[currentReg_] = regSizes_[expr.inRegister];
+void
+NetRunner::interpret(const ReLUExpr& expr)
+{
+  applyUnary(expr.inRegister, Activation::kReLU);
 }
 
 void
 NetRunner::interpret(const SigmoidExpr& expr)
 {
-  const auto numFeatures = regSizes_[expr.inRegister];
-  const auto* input = net_->regs[expr.inRegister];
-  auto* output = net_->regs[currentReg_];
+  applyUnary(expr.inRegister, Activation::kSigmoid);
+}
+
+void
+NetRunner::interpret(const TanhExpr& expr)
+{
+  applyUnary(expr.inRegister, Activation::kTanh);
+}
 
-  for (uint32_t i = 0; i < numFeatures; i++) {
-    const auto ex = expf(input[i]);
-    output[i] = ex / (1.0F + ex);
+void
+NetRunner::interpret(const GRUExpr& expr)
+{
+  const auto layout = net_->weightLayout;
+  const auto* inputWeights = currentParameters_;
+  const auto gates = static_cast<FeatureSize>(3 * static_cast<uint32_t>(expr.hiddenSize));
+  const auto* hiddenWeights = inputWeights + linearParameterCount(expr.inFeatures, gates, layout);
+
+  // Each sample has its own hidden state, so there is no batched kernel.
+  for (uint16_t b = 0; b < batchSize_; b++) {
+    gru(inputWeights,
+        hiddenWeights,
+        getRegister(expr.inRegister, b),
+        getState(b),
+        getRegister(currentReg_, b),
+        expr.inFeatures,
+        expr.hiddenSize,
+        linearRowStride(expr.inFeatures, layout),
+        linearRowStride(expr.hiddenSize, layout),
+        net_->activationMode);
   }
 
-  regSizes_[currentReg_] = regSizes_[expr.inRegister];
+  regSizes_[currentReg_] = expr.hiddenSize;
+
+  currentParameters_ += gruParameterCount(expr.inFeatures, expr.hiddenSize, layout);
+
+  skipState(expr.hiddenSize);
 }
 
 void
-NetRunner::interpret(const TanhExpr& expr)
+NetRunner::interpret(const Conv1DExpr& expr)
 {
-  const auto numFeatures = regSizes_[expr.inRegister];
-  const auto* input = net_->regs[expr.inRegister];
-  auto* output = net_->regs[currentReg_];
+  const auto window = static_cast<FeatureSize>(static_cast<uint32_t>(expr.kernelSize) * expr.inChannels);
+  const auto stride = linearRowStride(window, net_->weightLayout);
+  const auto* weights = currentParameters_;
+  const auto* bias = weights + stride * expr.outChannels;
 
-  for (uint32_t i = 0; i < numFeatures; i++) {
-    const auto a = expf(input[i]);
-    const auto b = expf(-input[i]);
-    output[i] = (a - b) / (a + b);
+  for (uint16_t b = 0; b < batchSize_; b++) {
+    pushFrame(getState(b), getRegister(expr.inRegister, b), expr.inChannels, expr.kernelSize);
   }
-  regSizes_[currentReg_] = regSizes_[expr.inRegister];
+
+  // The windows of the samples are a state apart, so the whole batch is one batched linear layer over them.
+  linearBatch(weights,
+              bias,
+              getState(0),
+              net_->stateSize,
+              regs_[currentReg_],
+              net_->regSizes[currentReg_],
+              window,
+              expr.outChannels,
+              stride,
+              batchSize_,
+              Activation::kNone,
+              net_->activationMode);
+
+  regSizes_[currentReg_] = expr.outChannels;
+
+  currentParameters_ += conv1DParameterCount(expr.inChannels, expr.outChannels, expr.kernelSize, net_->weightLayout);
+
+  skipState(window);
 }
 
 } // namespace NN
@@ -2,18 +2,111 @@
 
 #include "NN_Interpreter.h"
 #include "NN_Net.h"
+#include "NN_Parallel.h"
 
 namespace NN {
 
+/**
+ * @brief The number of output features of a Linear instruction that each parallel job computes. This is a multiple of
+ *        the four rows that the kernels compute at once, so that splitting a layer does not change its outputs.
+ * */
+constexpr uint32_t parallelChunkRows{ 32 };
+
+/**
+ * @brief The default number of multiply-adds, over the whole batch, below which a Linear instruction is run on the
+ *        calling thread.
+ * */
+constexpr uint32_t defaultMinParallelMACs{ static_cast<uint32_t>(1) << 17 };
+
 class NetRunner final : public Interpreter
 {
 public:
+  /**
+   * @brief Runs the network in the registers that it was allocated with.
+   * */
   NetRunner(const Net* net);
 
+  /**
+   * @brief Runs the network in a separate set of registers, so that the network is only read from.
+   *
+   * @param activations Registers allocated for this network. See @ref Activations::allocMemory.
+   * */
+  NetRunner(const Net* net, Activations* activations);
+
   [[nodiscard]] auto getRegister(uint8_t reg) -> float*;
 
+  /**
+   * @brief Gets one sample of a register, when running a batch.
+   * */
+  [[nodiscard]] auto getRegister(uint8_t reg, uint16_t sample) -> float*;
+
+  /**
+   * @brief Gets the number of values that were last written to a register, per sample.
+   * */
+  [[nodiscard]] auto getRegisterSize(uint8_t reg) const -> FeatureSize;
+
+  /**
+   * @brief Sets the number of samples that each instruction is applied to.
+   *
+   * @details Each instruction is executed once for the whole batch. The batch size can not exceed the batch size
+   *          that the network was allocated with. The default is one sample.
+   * */
+  void setBatchSize(uint16_t batchSize);
+
+  [[nodiscard]] auto getBatchSize() const -> uint16_t;
+
+  [[nodiscard]] auto getNet() const -> const Net*;
+
+  /**
+   * @brief Sets how large Linear instructions are split over threads. The default is @ref serialFor.
+   *
+   * @details The output features of a Linear instruction are split into jobs of @ref parallelChunkRows features, when
+   *          the instruction has at least `minParallelMACs` multiply-adds over the batch. Smaller instructions, and
+   *          every other kind of instruction, run on the calling thread, since waking the workers would take longer
+   *          than the work itself. The outputs are the same as on one thread.
+   * */
+  void setParallel(void* executorData, ParallelForFunc parallelFor, uint32_t minParallelMACs = defaultMinParallelMACs);
+
+  /**
+   * @brief Starts another run of the program.
+   *
+   * @details The state of the GRU and Conv1D instructions is kept, so that each run continues from the one before.
+   * */
   void reset();
 
+  /**
+   * @brief Zeroes the state of the GRU and Conv1D instructions of every sample, such as at the start of an episode.
+   * */
+  void clearState();
+
+  /**
+   * @brief Zeroes the state of the GRU and Conv1D instructions of one sample.
+   * */
+  void clearState(uint16_t sample);
+
+  /**
+   * @brief Gets the state of the next GRU or Conv1D instruction, for one sample.
+   * */
+  [[nodiscard]] auto getState(uint16_t sample) -> float*;
+
+  /**
+   * @brief Moves on to the state of the instruction after the next one, which has a state of `size` floats per
+   *        sample. This is for runners that run the GRU and Conv1D instructions themselves.
+   * */
+  void skipState(uint32_t size);
+
+  /**
+   * @brief Positions the runner in the middle of a program, so that a single instruction can be run on its own.
+   *
+   * @param parameterOffset Where the parameters of the next Linear instruction start.
+   * */
+  void seek(uint32_t parameterOffset);
+
+  /**
+   * @brief Sets the number of values per sample that the next instruction sees in a register.
+   * */
+  void setRegisterSize(uint8_t reg, FeatureSize size);
+
   void beginAssignment(const uint8_t dstReg) override;
 
   // deprecated
@@ -33,9 +126,44 @@ public:
 
   void interpret(const TanhExpr&) override;
 
+  void interpret(const GRUExpr&) override;
+
+  void interpret(const Conv1DExpr&) override;
+
+protected:
+  void applyUnary(uint8_t inReg, Activation activation);
+
+  /**
+   * @brief Applies an element-wise function, followed by the activation of the expression.
+   * */
+  template<typename Func>
+  void applyBinary(const BinaryExpr& expr, Func func);
+
+  /**
+   * @brief Computes a range of the output features of a Linear instruction, for the whole batch.
+   * */
+  void runLinearRows(const LinearExpr& expr, uint32_t firstRow, uint32_t numRows) const;
+
+  static void runLinearChunk(void* selfPtr, uint32_t chunk);
+
 private:
   const Net* net_{};
 
+  /**
+   * @brief The registers that the network is run in.
+   * */
+  float* const* regs_{};
+
+  /**
+   * @brief The state of the GRU and Conv1D instructions, which is not reset between runs.
+   * */
+  float* state_{};
+
+  /**
+   * @brief The number of samples to run each instruction on.
+   * */
+  uint16_t batchSize_{ 1 };
+
   /**
    * @brief Where to write the next output.
    * */
@@ -46,10 +174,26 @@ private:
    * */
   float* currentParameters_{};
 
+  /**
+   * @brief Where the state of the next GRU or Conv1D instruction starts, in floats per sample.
+   * */
+  uint32_t stateOffset_{};
+
   /**
    * @brief The current size of each register.
    * */
-  uint16_t regSizes_[NN_MAX_REGS]{};
+  FeatureSize regSizes_[NN_MAX_REGS]{};
+
+  void* executorData_{};
+
+  ParallelForFunc parallelFor_{ serialFor };
+
+  uint32_t minParallelMACs_{ defaultMinParallelMACs };
+
+  /**
+   * @brief The Linear instruction being split over threads, which is read by @ref NetRunner::runLinearChunk.
+   * */
+  const LinearExpr* parallelExpr_{};
 };
 
 } // namespace NN
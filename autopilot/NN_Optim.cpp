@@ -1,12 +1,45 @@
 #include "NN_Optim.h"
 
+#include "NN_IncrementalEvaluator.h"
 #include "NN_Net.h"
 
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 
 namespace NN {
 
+namespace {
+
+/**
+ * @brief The number of parameters that each job of the ES update works on.
+ * */
+constexpr uint32_t esChunkSize{ 1024 };
+
+/**
+ * @brief A small generator for the noise table, so that the table only depends on its seed and not on the platform.
+ * */
+auto
+splitMix32(uint32_t* state) -> uint32_t
+{
+  *state += 0x9e3779b9U;
+  auto z = *state;
+  z = (z ^ (z >> 16)) * 0x85ebca6bU;
+  z = (z ^ (z >> 13)) * 0xc2b2ae35U;
+  return z ^ (z >> 16);
+}
+
+/**
+ * @brief Gets a uniform float in (0, 1].
+ * */
+auto
+uniformOpen(uint32_t* state) -> float
+{
+  return (static_cast<float>(splitMix32(state) >> 8) + 1.0F) * (1.0F / 16777216.0F);
+}
+
+} // namespace
+
 LSOptimizer::LSOptimizer(Net* net,
                          const uint32_t batchSize,
                          const float noiseMin,
@@ -23,15 +56,15 @@ LSOptimizer::LSOptimizer(Net* net,
 auto
 LSOptimizer::allocMemory() -> bool
 {
-  bestParameters_ = static_cast<float*>(malloc(net_->numParameters * sizeof(float)));
-  if (!bestParameters_) {
+  undoValues_ = static_cast<float*>(malloc((batchSize_ > 0 ? batchSize_ : 1) * sizeof(float)));
+  if (!undoValues_) {
     return false;
   }
 
   indices_ = static_cast<uint32_t*>(malloc(net_->numParameters * sizeof(uint32_t)));
   if (!indices_) {
-    free(bestParameters_);
-    bestParameters_ = nullptr;
+    free(undoValues_);
+    undoValues_ = nullptr;
     return false;
   }
 
@@ -39,7 +72,30 @@ LSOptimizer::allocMemory() -> bool
     indices_[i] = i;
   }
 
-  memcpy(bestParameters_, net_->parameters, net_->numParameters * sizeof(float));
+  if (populationSize_ <= 1) {
+    return true;
+  }
+
+  candidates_ = static_cast<Net*>(malloc(populationSize_ * sizeof(Net)));
+  candidateLosses_ = static_cast<float*>(malloc(populationSize_ * sizeof(float)));
+  if (!candidates_ || !candidateLosses_) {
+    releaseMemory();
+    return false;
+  }
+
+  for (uint32_t i = 0; i < populationSize_; i++) {
+    candidates_[i] = *net_;
+    candidates_[i].memory = nullptr;
+    candidates_[i].parameters = nullptr;
+  }
+
+  for (uint32_t i = 0; i < populationSize_; i++) {
+    if (!candidates_[i].allocMemory()) {
+      releaseMemory();
+      return false;
+    }
+    memcpy(candidates_[i].parameters, net_->parameters, net_->numParameters * sizeof(float));
+  }
 
   return true;
 }
@@ -47,12 +103,29 @@ LSOptimizer::allocMemory() -> bool
 void
 LSOptimizer::releaseMemory()
 {
-  free(bestParameters_);
+  if (candidates_) {
+    for (uint32_t i = 0; i < populationSize_; i++) {
+      candidates_[i].releaseMemory();
+    }
+  }
+  free(candidates_);
+  free(candidateLosses_);
+  free(undoValues_);
   free(indices_);
-  bestParameters_ = nullptr;
+  candidates_ = nullptr;
+  candidateLosses_ = nullptr;
+  undoValues_ = nullptr;
   indices_ = nullptr;
 }
 
+void
+LSOptimizer::setPopulation(const uint32_t populationSize, void* executorData, ParallelForFunc parallelFor)
+{
+  populationSize_ = (populationSize > 0) ? populationSize : 1;
+  executorData_ = executorData;
+  parallelFor_ = parallelFor;
+}
+
 auto
 LSOptimizer::getBestLoss() const -> float
 {
@@ -62,30 +135,69 @@ LSOptimizer::getBestLoss() const -> float
 auto
 LSOptimizer::step(void* rngData, RngIntFunc rngInt, RngFloatFunc rngFloat, void* lossData, LossFunc loss) -> float
 {
-  if (batchIndex_ == 0) {
-    shuffleIndices(rngData, rngInt);
-  }
+  beginStep(rngData, rngInt);
 
-  const auto paramOffset = batchIndex_ * batchSize_;
-  const auto paramEnd = paramOffset + batchSize_;
-  const auto safeParamEnd = (paramEnd > net_->numParameters) ? net_->numParameters : paramEnd;
+  float l{};
 
-  for (auto i = paramOffset; i < safeParamEnd; i++) {
-    const auto noise = rngFloat(rngData, noiseMin_, noiseMax_);
-    const auto idx = indices_[i];
-    net_->parameters[idx] += noise;
+  if (candidates_) {
+    l = stepPopulation(rngData, rngFloat, lossData, loss);
+  } else {
+    perturb(rngData, rngFloat);
+
+    l = loss(lossData, *net_);
+    if (l < bestLoss_) {
+      bestLoss_ = l;
+    } else {
+      undo();
+    }
   }
 
-  const auto l = loss(lossData, *net_);
+  endStep();
+
+  return l;
+}
+
+auto
+LSOptimizer::step(void* rngData,
+                  RngIntFunc rngInt,
+                  RngFloatFunc rngFloat,
+                  IncrementalEvaluator* evaluator,
+                  void* lossData,
+                  LossFunc loss) -> float
+{
+  beginStep(rngData, rngInt);
+
+  perturb(rngData, rngFloat);
+
+  const auto l = evaluator->evaluateChanged(indices_ + stepBegin_, stepEnd_ - stepBegin_, lossData, loss);
   if (l < bestLoss_) {
     bestLoss_ = l;
-    memcpy(bestParameters_, net_->parameters, net_->numParameters * sizeof(float));
+    evaluator->commit();
+    syncCandidates();
   } else {
-    // restore best model
-    // TODO : find a faster way to do this
-    memcpy(net_->parameters, bestParameters_, net_->numParameters * sizeof(float));
+    undo();
+  }
+
+  endStep();
+
+  return l;
+}
+
+void
+LSOptimizer::beginStep(void* rngData, RngIntFunc rngInt)
+{
+  if (batchIndex_ == 0) {
+    shuffleIndices(rngData, rngInt);
   }
 
+  stepBegin_ = batchIndex_ * batchSize_;
+  const auto stepEnd = stepBegin_ + batchSize_;
+  stepEnd_ = (stepEnd > net_->numParameters) ? net_->numParameters : stepEnd;
+}
+
+void
+LSOptimizer::endStep()
+{
   bestLoss_ += penalty_;
 
   batchIndex_++;
@@ -93,10 +205,87 @@ LSOptimizer::step(void* rngData, RngIntFunc rngInt, RngFloatFunc rngFloat, void*
   if ((batchIndex_ * batchSize_) >= net_->numParameters) {
     batchIndex_ = 0;
   }
+}
+
+void
+LSOptimizer::perturb(void* rngData, RngFloatFunc rngFloat)
+{
+  for (auto i = stepBegin_; i < stepEnd_; i++) {
+    const auto noise = rngFloat(rngData, noiseMin_, noiseMax_);
+    const auto idx = indices_[i];
+    undoValues_[i - stepBegin_] = net_->parameters[idx];
+    net_->parameters[idx] += noise;
+  }
+}
+
+void
+LSOptimizer::undo()
+{
+  for (auto i = stepBegin_; i < stepEnd_; i++) {
+    net_->parameters[indices_[i]] = undoValues_[i - stepBegin_];
+  }
+}
+
+void
+LSOptimizer::syncCandidates()
+{
+  if (!candidates_) {
+    return;
+  }
+  for (uint32_t c = 0; c < populationSize_; c++) {
+    for (auto i = stepBegin_; i < stepEnd_; i++) {
+      const auto idx = indices_[i];
+      candidates_[c].parameters[idx] = net_->parameters[idx];
+    }
+  }
+}
+
+auto
+LSOptimizer::stepPopulation(void* rngData, RngFloatFunc rngFloat, void* lossData, LossFunc loss) -> float
+{
+  // The candidates match the network outside of the current batch, so only the batch has to be written. The noise is
+  // drawn up front on this thread, so that the result does not depend on how the candidates are scheduled.
+  for (uint32_t c = 0; c < populationSize_; c++) {
+    auto* parameters = candidates_[c].parameters;
+    for (auto i = stepBegin_; i < stepEnd_; i++) {
+      const auto idx = indices_[i];
+      parameters[idx] = net_->parameters[idx] + rngFloat(rngData, noiseMin_, noiseMax_);
+    }
+  }
+
+  lossData_ = lossData;
+  loss_ = loss;
+
+  parallelFor_(executorData_, populationSize_, evaluateCandidate, this);
+
+  uint32_t best{};
+  for (uint32_t c = 1; c < populationSize_; c++) {
+    if (candidateLosses_[c] < candidateLosses_[best]) {
+      best = c;
+    }
+  }
+
+  const auto l = candidateLosses_[best];
+  if (l < bestLoss_) {
+    bestLoss_ = l;
+    for (auto i = stepBegin_; i < stepEnd_; i++) {
+      const auto idx = indices_[i];
+      net_->parameters[idx] = candidates_[best].parameters[idx];
+    }
+  }
+
+  syncCandidates();
 
   return l;
 }
 
+void
+LSOptimizer::evaluateCandidate(void* selfPtr, const uint32_t index)
+{
+  auto* self = static_cast<LSOptimizer*>(selfPtr);
+  self->candidateLosses_[index] = self->loss_(self->lossData_, self->candidates_[index]);
+}
+
 void
 LSOptimizer::shuffleIndices(void* rngData, RngIntFunc func)
 {
@@ -108,4 +297,274 @@ LSOptimizer::shuffleIndices(void* rngData, RngIntFunc func)
   }
 }
 
+ESOptimizer::ESOptimizer(Net* net,
+                         const uint32_t numPairs,
+                         const float sigma,
+                         const float learningRate,
+                         const uint32_t noiseTableSize,
+                         const uint32_t noiseSeed)
+  : net_(net)
+  , numPairs_((numPairs > 0) ? numPairs : 1)
+  , sigma_(sigma)
+  , learningRate_(learningRate)
+  , noiseTableSize_(noiseTableSize)
+  , noiseSeed_(noiseSeed)
+{
+}
+
+void
+ESOptimizer::setParallel(void* executorData, ParallelForFunc parallelFor)
+{
+  executorData_ = executorData;
+  parallelFor_ = parallelFor;
+}
+
+auto
+ESOptimizer::allocMemory() -> bool
+{
+  if (noiseTableSize_ <= net_->numParameters) {
+    return false;
+  }
+
+  const auto populationSize = 2 * numPairs_;
+
+  noise_ = static_cast<float*>(malloc(noiseTableSize_ * sizeof(float)));
+  offsets_ = static_cast<uint32_t*>(malloc(numPairs_ * sizeof(uint32_t)));
+  members_ = static_cast<Net*>(malloc(populationSize * sizeof(Net)));
+  losses_ = static_cast<float*>(malloc(populationSize * sizeof(float)));
+  utilities_ = static_cast<float*>(malloc(populationSize * sizeof(float)));
+  order_ = static_cast<uint32_t*>(malloc(populationSize * sizeof(uint32_t)));
+  if (!noise_ || !offsets_ || !members_ || !losses_ || !utilities_ || !order_) {
+    free(members_);
+    members_ = nullptr;
+    releaseMemory();
+    return false;
+  }
+
+  for (uint32_t i = 0; i < populationSize; i++) {
+    members_[i] = *net_;
+    members_[i].memory = nullptr;
+    members_[i].parameters = nullptr;
+    utilities_[i] = 0.0F;
+  }
+
+  for (uint32_t i = 0; i < populationSize; i++) {
+    if (!members_[i].allocMemory()) {
+      for (uint32_t j = 0; j < i; j++) {
+        members_[j].releaseMemory();
+      }
+      free(members_);
+      members_ = nullptr;
+      releaseMemory();
+      return false;
+    }
+  }
+
+  fillNoiseTable();
+
+  return true;
+}
+
+void
+ESOptimizer::releaseMemory()
+{
+  if (members_) {
+    for (uint32_t i = 0; i < 2 * numPairs_; i++) {
+      members_[i].releaseMemory();
+    }
+  }
+  free(noise_);
+  free(offsets_);
+  free(members_);
+  free(losses_);
+  free(utilities_);
+  free(order_);
+  noise_ = nullptr;
+  offsets_ = nullptr;
+  members_ = nullptr;
+  losses_ = nullptr;
+  utilities_ = nullptr;
+  order_ = nullptr;
+}
+
+void
+ESOptimizer::fillNoiseTable()
+{
+  // Box-Muller, which gives two values per pair of uniform values.
+  uint32_t state = noiseSeed_;
+  for (uint32_t i = 0; i < noiseTableSize_; i += 2) {
+    const auto radius = sqrtf(-2.0F * logf(uniformOpen(&state)));
+    const auto angle = 6.28318531F * uniformOpen(&state);
+    noise_[i] = radius * cosf(angle);
+    if ((i + 1) < noiseTableSize_) {
+      noise_[i + 1] = radius * sinf(angle);
+    }
+  }
+}
+
+auto
+ESOptimizer::getNoise(const uint32_t offset) const -> const float*
+{
+  return noise_ + offset;
+}
+
+auto
+ESOptimizer::getUtility(const uint32_t member) const -> float
+{
+  return utilities_[member];
+}
+
+auto
+ESOptimizer::step(void* rngData, RngIntFunc rngInt, void* lossData, LossFunc loss) -> float
+{
+  const auto maxOffset = static_cast<int32_t>(noiseTableSize_ - net_->numParameters);
+  for (uint32_t k = 0; k < numPairs_; k++) {
+    offsets_[k] = static_cast<uint32_t>(rngInt(rngData, 0, maxOffset));
+  }
+
+  lossData_ = lossData;
+  loss_ = loss;
+
+  const auto populationSize = 2 * numPairs_;
+
+  parallelFor_(executorData_, populationSize, evaluateMember, this);
+
+  float meanLoss{};
+  for (uint32_t i = 0; i < populationSize; i++) {
+    meanLoss += losses_[i];
+  }
+  meanLoss /= static_cast<float>(populationSize);
+
+  shapeFitness();
+
+  const auto numChunks = (net_->numParameters + esChunkSize - 1) / esChunkSize;
+
+  parallelFor_(executorData_, numChunks, updateChunk, this);
+
+  return meanLoss;
+}
+
+void
+ESOptimizer::shapeFitness()
+{
+  const auto populationSize = 2 * numPairs_;
+
+  // Insertion sort, from the lowest loss to the highest. The population is small.
+  for (uint32_t i = 0; i < populationSize; i++) {
+    order_[i] = i;
+  }
+  for (uint32_t i = 1; i < populationSize; i++) {
+    const auto member = order_[i];
+    auto j = i;
+    while ((j > 0) && (losses_[order_[j - 1]] > losses_[member])) {
+      order_[j] = order_[j - 1];
+      j--;
+    }
+    order_[j] = member;
+  }
+
+  const auto scale = 1.0F / static_cast<float>(populationSize - 1);
+
+  uint32_t first = 0;
+  while (first < populationSize) {
+    auto last = first + 1;
+    while ((last < populationSize) && (losses_[order_[last]] == losses_[order_[first]])) {
+      last++;
+    }
+    // The lowest loss gets the highest utility.
+    const auto meanRank = 0.5F * static_cast<float>(first + last - 1);
+    const auto utility = 0.5F - meanRank * scale;
+    for (auto i = first; i < last; i++) {
+      utilities_[order_[i]] = utility;
+    }
+    first = last;
+  }
+}
+
+void
+ESOptimizer::evaluateMember(void* selfPtr, const uint32_t member)
+{
+  auto* self = static_cast<ESOptimizer*>(selfPtr);
+  const auto* noise = self->noise_ + self->offsets_[member / 2];
+  const auto scale = ((member % 2) == 0) ? self->sigma_ : -self->sigma_;
+  const auto* parameters = self->net_->parameters;
+  auto& net = self->members_[member];
+  for (uint32_t i = 0; i < net.numParameters; i++) {
+    net.parameters[i] = parameters[i] + scale * noise[i];
+  }
+  self->losses_[member] = self->loss_(self->lossData_, net);
+}
+
+void
+ESOptimizer::updateChunk(void* selfPtr, const uint32_t chunk)
+{
+  auto* self = static_cast<ESOptimizer*>(selfPtr);
+  const auto begin = chunk * esChunkSize;
+  const auto numParameters = self->net_->numParameters;
+  const auto end = (begin + esChunkSize < numParameters) ? (begin + esChunkSize) : numParameters;
+  const auto scale = self->learningRate_ / (static_cast<float>(2 * self->numPairs_) * self->sigma_);
+  auto* parameters = self->net_->parameters;
+
+  for (uint32_t k = 0; k < self->numPairs_; k++) {
+    const auto weight = scale * (self->utilities_[2 * k] - self->utilities_[2 * k + 1]);
+    if (weight == 0.0F) {
+      continue;
+    }
+    const auto* noise = self->noise_ + self->offsets_[k];
+    for (auto i = begin; i < end; i++) {
+      parameters[i] += weight * noise[i];
+    }
+  }
+}
+
+SGDOptimizer::SGDOptimizer(Net* net, const float learningRate, const float momentum, const float weightDecay)
+  : net_(net)
+  , learningRate_(learningRate)
+  , momentum_(momentum)
+  , weightDecay_(weightDecay)
+{
+}
+
+auto
+SGDOptimizer::allocMemory() -> bool
+{
+  if (net_->numParameters == 0) {
+    return true;
+  }
+
+  velocity_ = static_cast<float*>(malloc(net_->numParameters * sizeof(float)));
+  if (!velocity_) {
+    return false;
+  }
+
+  memset(velocity_, 0, net_->numParameters * sizeof(float));
+
+  return true;
+}
+
+void
+SGDOptimizer::releaseMemory()
+{
+  free(velocity_);
+  velocity_ = nullptr;
+}
+
+void
+SGDOptimizer::setLearningRate(const float learningRate)
+{
+  learningRate_ = learningRate;
+}
+
+void
+SGDOptimizer::step(const float* gradients)
+{
+  auto* parameters = net_->parameters;
+
+  for (uint32_t i = 0; i < net_->numParameters; i++) {
+    const auto g = gradients[i] + weightDecay_ * parameters[i];
+    velocity_[i] = momentum_ * velocity_[i] + g;
+    parameters[i] -= learningRate_ * velocity_[i];
+  }
+}
+
 } // namespace NN
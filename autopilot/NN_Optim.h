@@ -1,11 +1,15 @@
 #pragma once
 
+#include "NN_Parallel.h"
+
 #include <stdint.h>
 
 namespace NN {
 
 struct Net;
 
+class IncrementalEvaluator;
+
 /**
  * @brief The "Local Search" optimizer, based on "Derivative-Free Optimization of Neural Networks using Local Search".
  * */
@@ -34,17 +38,80 @@ public:
    * */
   LSOptimizer(Net* net, uint32_t batchSize = 4, float noiseMin = -0.1F, float noiseMax = 0.1F, float penalty = 1.0e-3F);
 
+  /**
+   * @brief Evaluates several perturbations per step instead of one. This has to be called before the memory is
+   *        allocated.
+   *
+   * @details Each candidate is a copy of the network, with its own parameters and registers, and receives its own
+   *          noise on the same batch of weights. The candidates are evaluated through the parallel-for function, and
+   *          the best one is kept if it beats the best loss so far. The loss function is then called from several
+   *          threads at once, on a different network each time, so it must not modify the loss data.
+   *
+   * @param populationSize The number of candidates per step. One disables the population.
+   *
+   * @param executorData Passed to the parallel-for function.
+   *
+   * @param parallelFor Runs the evaluations. @ref serialFor runs them on the calling thread.
+   * */
+  void setPopulation(uint32_t populationSize, void* executorData = nullptr, ParallelForFunc parallelFor = serialFor);
+
   [[nodiscard]] auto allocMemory() -> bool;
 
   void releaseMemory();
 
+  /**
+   * @brief Perturbs the next batch of weights and keeps the change if it lowers the loss.
+   *
+   * @details A rejected change is undone from a log of the weights it touched, so a step costs one evaluation of the
+   *          loss plus the size of the batch, not the size of the network.
+   *
+   * @return The loss of the perturbed network, or the lowest loss among the candidates.
+   * */
   auto step(void* rngData, RngIntFunc rngInt, RngFloatFunc rngFloat, void* lossData, LossFunc loss) -> float;
 
+  /**
+   * @brief Like the other overload, but the loss is evaluated by re-running only the instructions that depend on the
+   *        perturbed weights. The population is not used.
+   *
+   * @param evaluator Holds the evaluation set. It has to be built on the same network.
+   *
+   * @param loss Computes the loss from the output registers. See @ref IncrementalEvaluator::LossFunc.
+   * */
+  auto step(void* rngData,
+            RngIntFunc rngInt,
+            RngFloatFunc rngFloat,
+            IncrementalEvaluator* evaluator,
+            void* lossData,
+            LossFunc loss) -> float;
+
   [[nodiscard]] auto getBestLoss() const -> float;
 
 protected:
   void shuffleIndices(void* rngData, RngIntFunc rng);
 
+  /**
+   * @brief Shuffles the weights if needed and picks the batch of weights for this step.
+   * */
+  void beginStep(void* rngData, RngIntFunc rngInt);
+
+  void endStep();
+
+  /**
+   * @brief Adds noise to the batch of weights, and saves their old values in the undo log.
+   * */
+  void perturb(void* rngData, RngFloatFunc rngFloat);
+
+  void undo();
+
+  /**
+   * @brief Copies the batch of weights from the network into each candidate.
+   * */
+  void syncCandidates();
+
+  auto stepPopulation(void* rngData, RngFloatFunc rngFloat, void* lossData, LossFunc loss) -> float;
+
+  static void evaluateCandidate(void* selfPtr, uint32_t index);
+
 private:
   Net* net_{};
 
@@ -60,9 +127,209 @@ private:
 
   float bestLoss_{ static_cast<float>(1.0e6F) };
 
-  float* bestParameters_{};
+  /**
+   * @brief The values that the weights of the current batch had before they were perturbed.
+   * */
+  float* undoValues_{};
 
   uint32_t* indices_{};
+
+  /**
+   * @brief The range of @ref LSOptimizer::indices_ that the current step perturbs.
+   * */
+  uint32_t stepBegin_{};
+
+  uint32_t stepEnd_{};
+
+  uint32_t populationSize_{ 1 };
+
+  void* executorData_{};
+
+  ParallelForFunc parallelFor_{ serialFor };
+
+  Net* candidates_{};
+
+  float* candidateLosses_{};
+
+  /**
+   * @brief The loss of the step that is being evaluated.
+   * */
+  void* lossData_{};
+
+  LossFunc loss_{};
+};
+
+/**
+ * @brief An evolution strategies optimizer, as in "Evolution Strategies as a Scalable Alternative to Reinforcement
+ *        Learning".
+ *
+ * @details Each step samples pairs of mirrored perturbations, `+sigma * e` and `-sigma * e`, and moves the parameters
+ *          along the perturbations weighted by their fitness. The fitness is shaped by rank, so the scale of the loss
+ *          does not matter and outliers do not dominate.
+ *
+ *          Each perturbation is a slice of a table of Gaussian noise, identified only by where the slice starts. The
+ *          table is generated from a seed, so every worker that uses the same seed holds the same table. A worker only
+ *          needs the offset to rebuild a perturbation, and only reports back a loss, which is what lets the members
+ *          be evaluated in parallel through @ref ParallelForFunc. The update is split over the parameters, so it runs
+ *          in parallel too, and the result does not depend on the number of threads.
+ * */
+class ESOptimizer final
+{
+public:
+  using RngIntFunc = auto (*)(void*, int32_t minValue, int32_t maxValue) -> int32_t;
+
+  /**
+   * @brief Computes the loss of a network. Members are evaluated at the same time on different networks, so this must
+   *        not modify the loss data.
+   * */
+  using LossFunc = auto (*)(void*, const Net& net) -> float;
+
+  /**
+   * @brief Constructs a new optimizer object.
+   *
+   * @param net The neural network to optimize.
+   *
+   * @param numPairs The number of mirrored pairs per step. The population is twice as large.
+   *
+   * @param sigma The standard deviation of the perturbations.
+   *
+   * @param learningRate The size of the update.
+   *
+   * @param noiseTableSize The number of values in the noise table. This has to exceed the number of parameters.
+   *
+   * @param noiseSeed The seed of the noise table. Workers that share the table have to use the same seed.
+   * */
+  ESOptimizer(Net* net,
+              uint32_t numPairs = 16,
+              float sigma = 0.02F,
+              float learningRate = 0.01F,
+              uint32_t noiseTableSize = static_cast<uint32_t>(1) << 18,
+              uint32_t noiseSeed = 1);
+
+  /**
+   * @brief Sets how the members of the population and the update are run. The default is @ref serialFor.
+   * */
+  void setParallel(void* executorData, ParallelForFunc parallelFor);
+
+  /**
+   * @brief Allocates the noise table and a network for each member of the population, and fills the noise table.
+   *
+   * @return True on success, false on failure or if the noise table is too small.
+   * */
+  [[nodiscard]] auto allocMemory() -> bool;
+
+  void releaseMemory();
+
+  /**
+   * @brief Evaluates one population and updates the parameters.
+   *
+   * @return The mean loss of the population.
+   * */
+  auto step(void* rngData, RngIntFunc rngInt, void* lossData, LossFunc loss) -> float;
+
+  /**
+   * @brief Gets the perturbation that starts at a given offset of the noise table, before it is scaled by sigma.
+   * */
+  [[nodiscard]] auto getNoise(uint32_t offset) const -> const float*;
+
+  /**
+   * @brief Gets the shaped fitness of each member in the last step, in [-0.5, 0.5]. Members `2k` and `2k + 1` are the
+   *        positive and negative perturbation of pair `k`.
+   * */
+  [[nodiscard]] auto getUtility(uint32_t member) const -> float;
+
+protected:
+  void fillNoiseTable();
+
+  /**
+   * @brief Ranks the losses of the members. Members with the same loss share the mean of their utilities, so that a
+   *        pair with equal losses does not move the parameters.
+   * */
+  void shapeFitness();
+
+  static void evaluateMember(void* selfPtr, uint32_t member);
+
+  static void updateChunk(void* selfPtr, uint32_t chunk);
+
+private:
+  Net* net_{};
+
+  uint32_t numPairs_{};
+
+  float sigma_{};
+
+  float learningRate_{};
+
+  uint32_t noiseTableSize_{};
+
+  uint32_t noiseSeed_{};
+
+  void* executorData_{};
+
+  ParallelForFunc parallelFor_{ serialFor };
+
+  float* noise_{};
+
+  /**
+   * @brief Where the perturbation of each pair starts in the noise table.
+   * */
+  uint32_t* offsets_{};
+
+  Net* members_{};
+
+  float* losses_{};
+
+  float* utilities_{};
+
+  uint32_t* order_{};
+
+  void* lossData_{};
+
+  LossFunc loss_{};
+};
+
+/**
+ * @brief Stochastic gradient descent with momentum, for the gradients computed by @ref Backprop.
+ * */
+class SGDOptimizer final
+{
+public:
+  /**
+   * @brief Constructs a new optimizer object.
+   *
+   * @param net The neural network to optimize.
+   *
+   * @param learningRate How far to move the parameters along the velocity at each step.
+   *
+   * @param momentum How much of the previous velocity is kept at each step. Zero gives plain gradient descent.
+   *
+   * @param weightDecay How strongly the parameters are pulled towards zero.
+   * */
+  SGDOptimizer(Net* net, float learningRate = 1.0e-2F, float momentum = 0.9F, float weightDecay = 0.0F);
+
+  [[nodiscard]] auto allocMemory() -> bool;
+
+  void releaseMemory();
+
+  /**
+   * @brief Updates the parameters.
+   *
+   * @param gradients The gradient of the loss with respect to each parameter of the network.
+   * */
+  void step(const float* gradients);
+
+  void setLearningRate(float learningRate);
+
+private:
+  Net* net_{};
+
+  float learningRate_{};
+
+  float momentum_{};
+
+  float weightDecay_{};
+
+  float* velocity_{};
 };
 
 } // namespace NN
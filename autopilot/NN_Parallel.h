@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace NN {
+
+/**
+ * @brief One unit of work, identified by its index.
+ * */
+using ParallelJob = void (*)(void* jobData, uint32_t index);
+
+/**
+ * @brief Runs a job once for each index in `[0, count)`, possibly at the same time, and returns once every index is
+ *        done.
+ *
+ * @details The library does not create threads itself, since most of the boards it runs on have none. Desktop builds
+ *          can pass `ThreadPool::parallelFor` from `threads/ThreadPool.h`.
+ * */
+using ParallelForFunc = void (*)(void* executorData, uint32_t count, ParallelJob job, void* jobData);
+
+/**
+ * @brief Runs each index one after another, on the calling thread.
+ * */
+inline void
+serialFor(void*, const uint32_t count, ParallelJob job, void* jobData)
+{
+  for (uint32_t i = 0; i < count; i++) {
+    job(jobData, i);
+  }
+}
+
+} // namespace NN
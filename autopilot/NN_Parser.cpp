@@ -10,7 +10,7 @@ namespace NN {
 namespace {
 
 [[nodiscard]] auto
-matchIdentifier(const char* aPtr, const uint16_t aLen, const char* bPtr, const uint16_t bLen) -> bool
+matchIdentifier(const char* aPtr, const SourceSize aLen, const char* bPtr, const SourceSize bLen) -> bool
 {
   return (aLen == bLen) && (memcmp(aPtr, bPtr, aLen) == 0);
 }
@@ -25,7 +25,9 @@ enum class KnownIdentifier : uint8_t
   kCompMul,
   kReLU,
   kSigmoid,
-  kTanh
+  kTanh,
+  kGRU,
+  kConv1D
 };
 
 [[nodiscard]] auto
@@ -48,6 +50,8 @@ parseIdentifier(const Lexer& lexer, const Token& identifier) -> KnownIdentifier
   MATCH_IDENTIFIER(kReLU, "ReLU");
   MATCH_IDENTIFIER(kSigmoid, "Sigmoid");
   MATCH_IDENTIFIER(kTanh, "Tanh");
+  MATCH_IDENTIFIER(kGRU, "GRU");
+  MATCH_IDENTIFIER(kConv1D, "Conv1D");
 
 #undef MATCH_IDENTIFIER
 
@@ -68,21 +72,21 @@ nextToken(Lexer& lexer) -> Token
 }
 
 [[nodiscard]] auto
-parseNumber(const Lexer& lexer, const Token& token, uint16_t* out) -> SyntaxError
+parseNumber(const Lexer& lexer, const Token& token, FeatureSize* out) -> SyntaxError
 {
   const auto* ptr = lexer.toPointer(token.offset);
   const auto len = token.length;
-  uint16_t v{};
-  for (uint8_t i = 0; i < len; i++) {
+  FeatureSize v{};
+  for (SourceSize i = 0; i < len; i++) {
     const auto c = ptr[i];
-    auto next = static_cast<uint32_t>(v);
+    auto next = static_cast<uint64_t>(v);
     next *= 10;
     next += static_cast<uint8_t>(c - '0');
-    if (next > 65535) {
+    if (next > maxFeatures) {
       // overflow
       return SyntaxError::kNumberOutOfBounds;
     }
-    v = next;
+    v = static_cast<FeatureSize>(next);
   }
   *out = v;
   return SyntaxError::kNone;
@@ -95,7 +99,7 @@ parseRegister(const Lexer& lexer, const Token& regToken, uint8_t* out) -> Syntax
   const auto* ptr = lexer.toPointer(regToken.offset) + 1;
   const auto len = regToken.length - 1;
   uint8_t v{};
-  for (uint8_t i = 0; i < len; i++) {
+  for (SourceSize i = 0; i < len; i++) {
     const auto c = ptr[i];
     auto next = static_cast<uint16_t>(v);
     next *= 10;
@@ -110,6 +114,32 @@ parseRegister(const Lexer& lexer, const Token& regToken, uint8_t* out) -> Syntax
   return SyntaxError::kNone;
 }
 
+/**
+ * @brief Parses the next token, which has to be a number.
+ * */
+[[nodiscard]] auto
+parseNumberOperand(Lexer& lexer, FeatureSize* out) -> SyntaxError
+{
+  const auto token = nextToken(lexer);
+  if (token != TokenKind::kNumber) {
+    return SyntaxError::kInvalidOperand;
+  }
+  return parseNumber(lexer, token, out);
+}
+
+/**
+ * @brief Parses the next token, which has to be a register.
+ * */
+[[nodiscard]] auto
+parseRegisterOperand(Lexer& lexer, uint8_t* out) -> SyntaxError
+{
+  const auto token = nextToken(lexer);
+  if (token != TokenKind::kRegister) {
+    return SyntaxError::kInvalidOperand;
+  }
+  return parseRegister(lexer, token, out);
+}
+
 [[nodiscard]] auto
 matchEndOfStmt(Lexer& lexer) -> bool
 {
@@ -263,7 +293,7 @@ Parser::parseFunctionExpr(Lexer& lexer, const Token& funcId) -> SyntaxError
     case KnownIdentifier::kLinear:
       return parseLinearExpr(lexer);
     case KnownIdentifier::kMatMul:
-      return parseBinaryExpr<MatMulExpr>(lexer, *interpreter_);
+      return parseMatMulExpr(lexer);
     case KnownIdentifier::kConcat:
       return parseBinaryExpr<ConcatExpr>(lexer, *interpreter_);
     case KnownIdentifier::kCompAdd:
@@ -276,6 +306,10 @@ Parser::parseFunctionExpr(Lexer& lexer, const Token& funcId) -> SyntaxError
       return parseActivation<SigmoidExpr>(lexer, nextToken(lexer), *interpreter_);
     case KnownIdentifier::kTanh:
       return parseActivation<TanhExpr>(lexer, nextToken(lexer), *interpreter_);
+    case KnownIdentifier::kGRU:
+      return parseGRUExpr(lexer);
+    case KnownIdentifier::kConv1D:
+      return parseConv1DExpr(lexer);
   }
   return SyntaxError::kUnknownFunction;
 }
@@ -320,6 +354,105 @@ Parser::parseLinearExpr(Lexer& lexer) -> SyntaxError
   return SyntaxError::kNone;
 }
 
+auto
+Parser::parseMatMulExpr(Lexer& lexer) -> SyntaxError
+{
+  MatMulExpr expr;
+
+  auto lToken = nextToken(lexer);
+
+  if (lToken == TokenKind::kNumber) {
+    const auto err = parseNumber(lexer, lToken, &expr.leftRows);
+    if (err != SyntaxError::kNone) {
+      return err;
+    }
+    if (expr.leftRows == 0) {
+      return SyntaxError::kInvalidOperand;
+    }
+    lToken = nextToken(lexer);
+  }
+
+  if (lToken != TokenKind::kRegister) {
+    return SyntaxError::kInvalidOperand;
+  }
+  auto err = parseRegister(lexer, lToken, &expr.leftOpReg);
+  if (err != SyntaxError::kNone) {
+    return err;
+  }
+
+  const auto rToken = nextToken(lexer);
+  if (rToken != TokenKind::kRegister) {
+    return SyntaxError::kInvalidOperand;
+  }
+  err = parseRegister(lexer, rToken, &expr.rightOpReg);
+  if (err != SyntaxError::kNone) {
+    return err;
+  }
+
+  interpret(expr);
+
+  return SyntaxError::kNone;
+}
+
+auto
+Parser::parseGRUExpr(Lexer& lexer) -> SyntaxError
+{
+  GRUExpr expr;
+
+  auto err = parseNumberOperand(lexer, &expr.inFeatures);
+  if (err != SyntaxError::kNone) {
+    return err;
+  }
+
+  err = parseNumberOperand(lexer, &expr.hiddenSize);
+  if (err != SyntaxError::kNone) {
+    return err;
+  }
+
+  err = parseRegisterOperand(lexer, &expr.inRegister);
+  if (err != SyntaxError::kNone) {
+    return err;
+  }
+
+  interpret(expr);
+
+  return SyntaxError::kNone;
+}
+
+auto
+Parser::parseConv1DExpr(Lexer& lexer) -> SyntaxError
+{
+  Conv1DExpr expr;
+
+  auto err = parseNumberOperand(lexer, &expr.inChannels);
+  if (err != SyntaxError::kNone) {
+    return err;
+  }
+
+  err = parseNumberOperand(lexer, &expr.outChannels);
+  if (err != SyntaxError::kNone) {
+    return err;
+  }
+
+  err = parseNumberOperand(lexer, &expr.kernelSize);
+  if (err != SyntaxError::kNone) {
+    return err;
+  }
+
+  if (expr.kernelSize == 0) {
+    return SyntaxError::kInvalidOperand;
+  }
+
+  err = parseRegisterOperand(lexer, &expr.inRegister);
+  if (err != SyntaxError::kNone) {
+    return err;
+  }
+
+  interpret(expr);
+
+  return SyntaxError::kNone;
+}
+
 void
 Parser::interpret(const Expr& expr)
 {
@@ -16,7 +16,8 @@ enum class SyntaxError : uint8_t
   kRegisterOutOfBounds,
   kNumberOutOfBounds,
   kUnknownFunction,
-  kInvalidOperand
+  kInvalidOperand,
+  kOutOfMemory
 };
 
 class Parser final
@@ -37,6 +38,12 @@ protected:
 
   [[nodiscard]] auto parseLinearExpr(Lexer& lexer) -> SyntaxError;
 
+  [[nodiscard]] auto parseMatMulExpr(Lexer& lexer) -> SyntaxError;
+
+  [[nodiscard]] auto parseGRUExpr(Lexer& lexer) -> SyntaxError;
+
+  [[nodiscard]] auto parseConv1DExpr(Lexer& lexer) -> SyntaxError;
+
   void interpret(const Expr&);
 
 private:
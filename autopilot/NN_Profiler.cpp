@@ -0,0 +1,299 @@
+#include "NN_Profiler.h"
+
+#include "NN_NetRunner.h"
+
+#include <stdlib.h>
+
+namespace NN {
+
+Profiler::Profiler(NetRunner* runner, void* clockData, ClockFunc clock)
+  : runner_(runner)
+  , clockData_(clockData)
+  , clock_(clock)
+{
+}
+
+auto
+Profiler::allocMemory(const InstrIndex maxEntries, const uint32_t maxEvents) -> bool
+{
+  entries_ = static_cast<ProfileEntry*>(malloc((maxEntries > 0 ? maxEntries : 1) * sizeof(ProfileEntry)));
+  events_ = static_cast<ProfileEvent*>(malloc((maxEvents > 0 ? maxEvents : 1) * sizeof(ProfileEvent)));
+  if (!entries_ || !events_) {
+    releaseMemory();
+    return false;
+  }
+  maxEntries_ = maxEntries;
+  maxEvents_ = maxEvents;
+  clear();
+  return true;
+}
+
+void
+Profiler::releaseMemory()
+{
+  free(entries_);
+  free(events_);
+  entries_ = nullptr;
+  events_ = nullptr;
+  maxEntries_ = 0;
+  maxEvents_ = 0;
+  clear();
+}
+
+void
+Profiler::reset()
+{
+  runner_->reset();
+  current_ = 0;
+  numRuns_++;
+}
+
+void
+Profiler::clear()
+{
+  numEntries_ = 0;
+  numEvents_ = 0;
+  numRuns_ = 0;
+  current_ = 0;
+}
+
+auto
+Profiler::getNumRuns() const -> uint32_t
+{
+  return numRuns_;
+}
+
+auto
+Profiler::getNumEntries() const -> InstrIndex
+{
+  return numEntries_;
+}
+
+auto
+Profiler::getEntry(const InstrIndex index) const -> const ProfileEntry&
+{
+  return entries_[index];
+}
+
+auto
+Profiler::getNumEvents() const -> uint32_t
+{
+  return numEvents_;
+}
+
+auto
+Profiler::getEvent(const uint32_t index) const -> const ProfileEvent&
+{
+  return events_[index];
+}
+
+void
+Profiler::sortByTime(InstrIndex* order) const
+{
+  // There are only ever a few dozen statements, so an insertion sort is enough.
+  for (InstrIndex i = 0; i < numEntries_; i++) {
+    InstrIndex j = i;
+    while ((j > 0) && (entries_[order[j - 1]].nanoseconds < entries_[i].nanoseconds)) {
+      order[j] = order[j - 1];
+      j--;
+    }
+    order[j] = i;
+  }
+}
+
+template<typename ExprT>
+void
+Profiler::measure(const Instruction& instr, const ExprT& expr, const uint64_t flops, const uint64_t bytes)
+{
+  const auto index = current_;
+  current_++;
+
+  const auto start = clock_(clockData_);
+  runner_->interpret(expr);
+  const auto duration = clock_(clockData_) - start;
+
+  if (index >= maxEntries_) {
+    return;
+  }
+
+  // Statements past the last one measured so far are new.
+  while (numEntries_ <= index) {
+    entries_[numEntries_] = ProfileEntry();
+    numEntries_++;
+  }
+
+  auto& entry = entries_[index];
+  entry.instruction = instr;
+  entry.instruction.dstReg = dstReg_;
+  entry.numCalls++;
+  entry.nanoseconds += duration;
+  entry.flops += flops;
+  entry.bytes += bytes;
+
+  if (numEvents_ < maxEvents_) {
+    auto& event = events_[numEvents_];
+    event.entry = index;
+    event.run = (numRuns_ > 0) ? (numRuns_ - 1) : 0;
+    event.start = start;
+    event.duration = duration;
+    numEvents_++;
+  }
+}
+
+template<typename ExprT>
+void
+Profiler::interpretBinary(const OpCode op, const ExprT& expr)
+{
+  Instruction instr;
+  instr.op = op;
+  instr.leftReg = expr.leftOpReg;
+  instr.rightReg = expr.rightOpReg;
+  instr.activation = expr.activation;
+
+  const uint64_t batchSize = runner_->getBatchSize();
+  const uint64_t lSize = runner_->getRegisterSize(expr.leftOpReg);
+  const uint64_t rSize = runner_->getRegisterSize(expr.rightOpReg);
+  const auto outSize = (op == OpCode::kConcat) ? (lSize + rSize) : ((lSize < rSize) ? lSize : rSize);
+  const uint64_t arithmetic = (op == OpCode::kConcat) ? 0 : outSize;
+  const uint64_t activations = (expr.activation != Activation::kNone) ? outSize : 0;
+  const auto bytes = (lSize + rSize + outSize) * batchSize * sizeof(float);
+  measure(instr, expr, (arithmetic + activations) * batchSize, bytes);
+}
+
+template<typename ExprT>
+void
+Profiler::interpretUnary(const OpCode op, const ExprT& expr)
+{
+  Instruction instr;
+  instr.op = op;
+  instr.leftReg = expr.inRegister;
+
+  const uint64_t values = static_cast<uint64_t>(runner_->getRegisterSize(expr.inRegister)) * runner_->getBatchSize();
+  measure(instr, expr, values, 2 * values * sizeof(float));
+}
+
+void
+Profiler::beginAssignment(const uint8_t dstReg)
+{
+  dstReg_ = dstReg;
+  runner_->beginAssignment(dstReg);
+}
+
+void
+Profiler::interpret(const LinearExpr& expr)
+{
+  Instruction instr;
+  instr.op = OpCode::kLinear;
+  instr.leftReg = expr.inRegister;
+  instr.inFeatures = expr.inFeatures;
+  instr.outFeatures = expr.outFeatures;
+  instr.activation = expr.activation;
+
+  const auto* net = runner_->getNet();
+  const uint64_t batchSize = runner_->getBatchSize();
+  const uint64_t k = expr.inFeatures;
+  const uint64_t n = expr.outFeatures;
+  const uint64_t activations = (expr.activation != Activation::kNone) ? (n * batchSize) : 0;
+  const uint64_t parameters = linearParameterCount(expr.inFeatures, expr.outFeatures, net->weightLayout);
+  const auto bytes = (parameters + (k + n) * batchSize) * sizeof(float);
+  measure(instr, expr, 2 * k * n * batchSize + activations, bytes);
+}
+
+void
+Profiler::interpret(const MatMulExpr& expr)
+{
+  Instruction instr;
+  instr.op = OpCode::kMatMul;
+  instr.leftReg = expr.leftOpReg;
+  instr.rightReg = expr.rightOpReg;
+  instr.inFeatures = expr.leftRows;
+  instr.activation = expr.activation;
+
+  const uint64_t batchSize = runner_->getBatchSize();
+  const uint64_t m = expr.leftRows;
+  const uint64_t k = (m > 0) ? (runner_->getRegisterSize(expr.leftOpReg) / m) : 0;
+  const uint64_t n = (k > 0) ? (runner_->getRegisterSize(expr.rightOpReg) / k) : 0;
+  const uint64_t activations = (expr.activation != Activation::kNone) ? (m * n * batchSize) : 0;
+  const auto bytes = (m * k + k * n + m * n) * batchSize * sizeof(float);
+  measure(instr, expr, 2 * m * k * n * batchSize + activations, bytes);
+}
+
+void
+Profiler::interpret(const ConcatExpr& expr)
+{
+  interpretBinary(OpCode::kConcat, expr);
+}
+
+void
+Profiler::interpret(const CompAddExpr& expr)
+{
+  interpretBinary(OpCode::kCompAdd, expr);
+}
+
+void
+Profiler::interpret(const CompMulExpr& expr)
+{
+  interpretBinary(OpCode::kCompMul, expr);
+}
+
+void
+Profiler::interpret(const ReLUExpr& expr)
+{
+  interpretUnary(OpCode::kReLU, expr);
+}
+
+void
+Profiler::interpret(const SigmoidExpr& expr)
+{
+  interpretUnary(OpCode::kSigmoid, expr);
+}
+
+void
+Profiler::interpret(const TanhExpr& expr)
+{
+  interpretUnary(OpCode::kTanh, expr);
+}
+
+void
+Profiler::interpret(const GRUExpr& expr)
+{
+  Instruction instr;
+  instr.op = OpCode::kGRU;
+  instr.leftReg = expr.inRegister;
+  instr.inFeatures = expr.inFeatures;
+  instr.outFeatures = expr.hiddenSize;
+
+  const auto* net = runner_->getNet();
+  const uint64_t batchSize = runner_->getBatchSize();
+  const uint64_t k = expr.inFeatures;
+  const uint64_t h = expr.hiddenSize;
+  // The gates take three activations and six other operations per hidden feature.
+  const auto flops = (2 * (k + h) * 3 * h + 9 * h) * batchSize;
+  const uint64_t parameters = gruParameterCount(expr.inFeatures, expr.hiddenSize, net->weightLayout);
+  // The hidden state is read and written, along with the input and the output.
+  const auto bytes = (parameters + (k + 3 * h) * batchSize) * sizeof(float);
+  measure(instr, expr, flops, bytes);
+}
+
+void
+Profiler::interpret(const Conv1DExpr& expr)
+{
+  Instruction instr;
+  instr.op = OpCode::kConv1D;
+  instr.leftReg = expr.inRegister;
+  instr.inFeatures = expr.inChannels;
+  instr.outFeatures = expr.outChannels;
+  instr.kernelSize = expr.kernelSize;
+
+  const auto* net = runner_->getNet();
+  const uint64_t batchSize = runner_->getBatchSize();
+  const uint64_t window = static_cast<uint64_t>(expr.kernelSize) * expr.inChannels;
+  const uint64_t n = expr.outChannels;
+  const uint64_t parameters =
+    conv1DParameterCount(expr.inChannels, expr.outChannels, expr.kernelSize, net->weightLayout);
+  // The window is moved along, and then read by the linear layer.
+  const auto bytes = (parameters + (expr.inChannels + 3 * window + n) * batchSize) * sizeof(float);
+  measure(instr, expr, 2 * window * n * batchSize, bytes);
+}
+
+} // namespace NN
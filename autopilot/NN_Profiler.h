@@ -0,0 +1,170 @@
+#pragma once
+
+#include "NN_Interpreter.h"
+#include "NN_Program.h"
+
+#include <stdint.h>
+
+namespace NN {
+
+class NetRunner;
+
+/**
+ * @brief What was measured for one statement of a program, over every run.
+ * */
+struct ProfileEntry final
+{
+  /**
+   * @brief The statement, as it was last run.
+   * */
+  Instruction instruction;
+
+  uint32_t numCalls{};
+
+  uint64_t nanoseconds{};
+
+  /**
+   * @brief The floating point operations, counting a multiply-add as two. Activations count one per value.
+   * */
+  uint64_t flops{};
+
+  /**
+   * @brief The bytes of parameters and registers that were read and written.
+   * */
+  uint64_t bytes{};
+};
+
+/**
+ * @brief A single run of one statement.
+ * */
+struct ProfileEvent final
+{
+  InstrIndex entry{};
+
+  uint32_t run{};
+
+  uint64_t start{};
+
+  uint64_t duration{};
+};
+
+/**
+ * @brief Runs a network through a @ref NetRunner and measures each statement.
+ *
+ * @details Statements are numbered in the order that they run, from zero at each @ref Profiler::reset. When the
+ *          source text is run, this is the source line of each statement. When a compiled program is run, it is the
+ *          index of each instruction. Time is only spent in the runner between the two clock reads, so the cost of
+ *          profiling is two clock reads per statement.
+ * */
+class Profiler final : public Interpreter
+{
+public:
+  /**
+   * @brief Reads a monotonic clock, in nanoseconds.
+   * */
+  using ClockFunc = auto (*)(void*) -> uint64_t;
+
+  Profiler(NetRunner* runner, void* clockData, ClockFunc clock);
+
+  /**
+   * @param maxEntries The number of statements that can be measured. Statements past this are run, but not measured.
+   *
+   * @param maxEvents The number of single runs of a statement that are kept for a trace. Once these are used up, only
+   *                  the totals are kept.
+   * */
+  [[nodiscard]] auto allocMemory(InstrIndex maxEntries, uint32_t maxEvents) -> bool;
+
+  void releaseMemory();
+
+  /**
+   * @brief Resets the runner, and starts a new run.
+   * */
+  void reset();
+
+  /**
+   * @brief Forgets everything that was measured.
+   * */
+  void clear();
+
+  [[nodiscard]] auto getNumRuns() const -> uint32_t;
+
+  [[nodiscard]] auto getNumEntries() const -> InstrIndex;
+
+  [[nodiscard]] auto getEntry(InstrIndex index) const -> const ProfileEntry&;
+
+  [[nodiscard]] auto getNumEvents() const -> uint32_t;
+
+  [[nodiscard]] auto getEvent(uint32_t index) const -> const ProfileEvent&;
+
+  /**
+   * @brief Orders the entries by their total time, from the slowest to the fastest.
+   *
+   * @param order Filled with @ref Profiler::getNumEntries indices.
+   * */
+  void sortByTime(InstrIndex* order) const;
+
+  void beginAssignment(uint8_t dstReg) override;
+
+  void interpret(const LinearExpr& expr) override;
+
+  void interpret(const MatMulExpr& expr) override;
+
+  void interpret(const ConcatExpr& expr) override;
+
+  void interpret(const CompAddExpr& expr) override;
+
+  void interpret(const CompMulExpr& expr) override;
+
+  void interpret(const ReLUExpr& expr) override;
+
+  void interpret(const SigmoidExpr& expr) override;
+
+  void interpret(const TanhExpr& expr) override;
+
+  void interpret(const GRUExpr& expr) override;
+
+  void interpret(const Conv1DExpr& expr) override;
+
+protected:
+  template<typename ExprT>
+  void interpretBinary(OpCode op, const ExprT& expr);
+
+  template<typename ExprT>
+  void interpretUnary(OpCode op, const ExprT& expr);
+
+  /**
+   * @brief Runs an expression in the runner and adds what was measured to the current statement.
+   * */
+  template<typename ExprT>
+  void measure(const Instruction& instr, const ExprT& expr, uint64_t flops, uint64_t bytes);
+
+private:
+  NetRunner* runner_{};
+
+  void* clockData_{};
+
+  ClockFunc clock_{};
+
+  ProfileEntry* entries_{};
+
+  InstrIndex maxEntries_{};
+
+  InstrIndex numEntries_{};
+
+  ProfileEvent* events_{};
+
+  uint32_t maxEvents_{};
+
+  uint32_t numEvents_{};
+
+  uint32_t numRuns_{};
+
+  /**
+   * @brief The index of the statement being run.
+   * */
+  InstrIndex current_{};
+
+  uint8_t dstReg_{};
+};
+
+} // namespace NN
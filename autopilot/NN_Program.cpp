@@ -0,0 +1,364 @@
+#include "NN_Program.h"
+
+#include "NN_Interpreter.h"
+#include "NN_Parser.h"
+
+#include <stdlib.h>
+
+namespace NN {
+
+namespace {
+
+/**
+ * @brief Records each statement it is given as an instruction.
+ *
+ * @details When no instruction buffer is given, the instructions are only counted. This allows the program to be
+ *          allocated with its exact size.
+ * */
+class Compiler final : public Interpreter
+{
+public:
+  explicit Compiler(Instruction* instructions)
+    : instructions_(instructions)
+  {
+  }
+
+  [[nodiscard]] auto getInstructionCount() const -> InstrIndex { return numInstructions_; }
+
+  void beginAssignment(const uint8_t dstReg) override { dstReg_ = dstReg; }
+
+  void interpret(const LinearExpr& expr) override
+  {
+    Instruction instr;
+    instr.op = OpCode::kLinear;
+    instr.leftReg = expr.inRegister;
+    instr.inFeatures = expr.inFeatures;
+    instr.outFeatures = expr.outFeatures;
+    instr.activation = expr.activation;
+    emit(instr);
+  }
+
+  void interpret(const MatMulExpr& expr) override
+  {
+    Instruction instr;
+    instr.op = OpCode::kMatMul;
+    instr.leftReg = expr.leftOpReg;
+    instr.rightReg = expr.rightOpReg;
+    instr.inFeatures = expr.leftRows;
+    instr.activation = expr.activation;
+    emit(instr);
+  }
+
+  void interpret(const ConcatExpr& expr) override { emitBinary(OpCode::kConcat, expr); }
+
+  void interpret(const CompAddExpr& expr) override { emitBinary(OpCode::kCompAdd, expr); }
+
+  void interpret(const CompMulExpr& expr) override { emitBinary(OpCode::kCompMul, expr); }
+
+  void interpret(const ReLUExpr& expr) override { emitUnary(OpCode::kReLU, expr); }
+
+  void interpret(const SigmoidExpr& expr) override { emitUnary(OpCode::kSigmoid, expr); }
+
+  void interpret(const TanhExpr& expr) override { emitUnary(OpCode::kTanh, expr); }
+
+  void interpret(const GRUExpr& expr) override
+  {
+    Instruction instr;
+    instr.op = OpCode::kGRU;
+    instr.leftReg = expr.inRegister;
+    instr.inFeatures = expr.inFeatures;
+    instr.outFeatures = expr.hiddenSize;
+    emit(instr);
+  }
+
+  void interpret(const Conv1DExpr& expr) override
+  {
+    Instruction instr;
+    instr.op = OpCode::kConv1D;
+    instr.leftReg = expr.inRegister;
+    instr.inFeatures = expr.inChannels;
+    instr.outFeatures = expr.outChannels;
+    instr.kernelSize = expr.kernelSize;
+    emit(instr);
+  }
+
+protected:
+  void emitBinary(const OpCode op, const BinaryExpr& expr)
+  {
+    Instruction instr;
+    instr.op = op;
+    instr.leftReg = expr.leftOpReg;
+    instr.rightReg = expr.rightOpReg;
+    instr.activation = expr.activation;
+    emit(instr);
+  }
+
+  void emitUnary(const OpCode op, const UnaryExpr& expr)
+  {
+    Instruction instr;
+    instr.op = op;
+    instr.leftReg = expr.inRegister;
+    emit(instr);
+  }
+
+  void emit(Instruction& instr)
+  {
+    instr.dstReg = dstReg_;
+    if (instructions_) {
+      instructions_[numInstructions_] = instr;
+    }
+    numInstructions_++;
+  }
+
+private:
+  Instruction* instructions_{};
+
+  InstrIndex numInstructions_{};
+
+  uint8_t dstReg_{};
+};
+
+template<typename ExprT>
+void
+interpretUnary(const Instruction& instr, Interpreter& interp)
+{
+  ExprT expr;
+  expr.inRegister = instr.leftReg;
+  interp.interpret(expr);
+}
+
+template<typename ExprT>
+void
+interpretBinary(const Instruction& instr, Interpreter& interp)
+{
+  ExprT expr;
+  expr.leftOpReg = instr.leftReg;
+  expr.rightOpReg = instr.rightReg;
+  expr.activation = instr.activation;
+  interp.interpret(expr);
+}
+
+auto
+toActivation(const OpCode op, Activation* activation) -> bool
+{
+  switch (op) {
+    case OpCode::kReLU:
+      *activation = Activation::kReLU;
+      return true;
+    case OpCode::kSigmoid:
+      *activation = Activation::kSigmoid;
+      return true;
+    case OpCode::kTanh:
+      *activation = Activation::kTanh;
+      return true;
+    case OpCode::kLinear:
+    case OpCode::kMatMul:
+    case OpCode::kConcat:
+    case OpCode::kCompAdd:
+    case OpCode::kCompMul:
+    case OpCode::kGRU:
+    case OpCode::kConv1D:
+      break;
+  }
+  return false;
+}
+
+auto
+isFusable(const OpCode op) -> bool
+{
+  return (op == OpCode::kLinear) || (op == OpCode::kCompAdd) || (op == OpCode::kCompMul);
+}
+
+auto
+isUnary(const OpCode op) -> bool
+{
+  Activation activation;
+  return (op == OpCode::kLinear) || (op == OpCode::kGRU) || (op == OpCode::kConv1D) || toActivation(op, &activation);
+}
+
+auto
+reads(const Instruction& instr, const uint8_t reg) -> bool
+{
+  return (instr.leftReg == reg) || (!isUnary(instr.op) && (instr.rightReg == reg));
+}
+
+/**
+ * @brief Checks whether a register is read before it is next written, starting at a given instruction.
+ * */
+auto
+isReadFrom(const Program& program, const InstrIndex first, const uint8_t reg, const RegMask liveOut) -> bool
+{
+  for (InstrIndex i = first; i < program.numInstructions; i++) {
+    const auto& instr = program.instructions[i];
+    if (reads(instr, reg)) {
+      return true;
+    }
+    if (instr.dstReg == reg) {
+      return false;
+    }
+  }
+  return (liveOut & regBit(reg)) != 0;
+}
+
+} // namespace
+
+void
+execInstruction(const Instruction& instr, Interpreter& interp)
+{
+  interp.beginAssignment(instr.dstReg);
+
+  switch (instr.op) {
+    case OpCode::kLinear: {
+      LinearExpr expr;
+      expr.inFeatures = instr.inFeatures;
+      expr.outFeatures = instr.outFeatures;
+      expr.inRegister = instr.leftReg;
+      expr.activation = instr.activation;
+      interp.interpret(expr);
+    } break;
+    case OpCode::kMatMul: {
+      MatMulExpr expr;
+      expr.leftOpReg = instr.leftReg;
+      expr.rightOpReg = instr.rightReg;
+      expr.leftRows = instr.inFeatures;
+      expr.activation = instr.activation;
+      interp.interpret(expr);
+    } break;
+    case OpCode::kConcat:
+      interpretBinary<ConcatExpr>(instr, interp);
+      break;
+    case OpCode::kCompAdd:
+      interpretBinary<CompAddExpr>(instr, interp);
+      break;
+    case OpCode::kCompMul:
+      interpretBinary<CompMulExpr>(instr, interp);
+      break;
+    case OpCode::kReLU:
+      interpretUnary<ReLUExpr>(instr, interp);
+      break;
+    case OpCode::kSigmoid:
+      interpretUnary<SigmoidExpr>(instr, interp);
+      break;
+    case OpCode::kTanh:
+      interpretUnary<TanhExpr>(instr, interp);
+      break;
+    case OpCode::kGRU: {
+      GRUExpr expr;
+      expr.inFeatures = instr.inFeatures;
+      expr.hiddenSize = instr.outFeatures;
+      expr.inRegister = instr.leftReg;
+      interp.interpret(expr);
+    } break;
+    case OpCode::kConv1D: {
+      Conv1DExpr expr;
+      expr.inChannels = instr.inFeatures;
+      expr.outChannels = instr.outFeatures;
+      expr.kernelSize = instr.kernelSize;
+      expr.inRegister = instr.leftReg;
+      interp.interpret(expr);
+    } break;
+  }
+}
+
+auto
+Program::allocMemory() -> bool
+{
+  if (numInstructions == 0) {
+    instructions = nullptr;
+    return true;
+  }
+  instructions = static_cast<Instruction*>(malloc(static_cast<size_t>(numInstructions) * sizeof(Instruction)));
+  return instructions != nullptr;
+}
+
+void
+Program::releaseMemory()
+{
+  free(instructions);
+  instructions = nullptr;
+}
+
+auto
+compile(const char* source, const SourceSize length, Program* program) -> SyntaxError
+{
+  Compiler counter(nullptr);
+  auto err = exec(source, length, counter);
+  if (err != SyntaxError::kNone) {
+    return err;
+  }
+
+  program->numInstructions = counter.getInstructionCount();
+  if (!program->allocMemory()) {
+    return SyntaxError::kOutOfMemory;
+  }
+
+  Compiler writer(program->instructions);
+  err = exec(source, length, writer);
+  if (err != SyntaxError::kNone) {
+    program->releaseMemory();
+  }
+  return err;
+}
+
+auto
+fuseActivations(Program* program, const RegMask liveOut) -> InstrIndex
+{
+  InstrIndex numFused = 0;
+  InstrIndex numKept = 0;
+
+  for (InstrIndex i = 0; i < program->numInstructions; i++) {
+    auto& producer = program->instructions[i];
+    program->instructions[numKept] = producer;
+    numKept++;
+
+    if ((i + 1) >= program->numInstructions) {
+      break;
+    }
+
+    const auto& consumer = program->instructions[i + 1];
+    Activation activation;
+    if (!isFusable(producer.op) || (producer.activation != Activation::kNone) ||
+        !toActivation(consumer.op, &activation) || (consumer.leftReg != producer.dstReg)) {
+      continue;
+    }
+
+    const auto intermediate = producer.dstReg;
+    const auto dst = consumer.dstReg;
+    if ((dst != intermediate) && isReadFrom(*program, i + 2, intermediate, liveOut)) {
+      continue;
+    }
+
+    // Writing the result over an operand is only safe for the element-wise instructions.
+    if ((dst != intermediate) && (producer.op == OpCode::kLinear) && reads(producer, dst)) {
+      continue;
+    }
+
+    auto& fused = program->instructions[numKept - 1];
+    fused.dstReg = dst;
+    fused.activation = activation;
+    numFused++;
+    i++;
+  }
+
+  program->numInstructions = numKept;
+
+  return numFused;
+}
+
+void
+exec(const Program& program, Interpreter& interp)
+{
+  for (InstrIndex i = 0; i < program.numInstructions; i++) {
+    execInstruction(program.instructions[i], interp);
+  }
+}
+
+void
+reverseExec(const Program& program, Interpreter& interp)
+{
+  for (InstrIndex i = program.numInstructions; i > 0; i--) {
+    execInstruction(program.instructions[i - 1], interp);
+  }
+}
+
+} // namespace NN
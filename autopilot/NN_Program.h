@@ -0,0 +1,138 @@
+#pragma once
+
+#include "NN_Activation.h"
+#include "NN_Config.h"
+
+#include <stdint.h>
+
+namespace NN {
+
+enum class SyntaxError : uint8_t;
+
+class Interpreter;
+
+enum class OpCode : uint8_t
+{
+  kLinear,
+  kMatMul,
+  kConcat,
+  kCompAdd,
+  kCompMul,
+  kReLU,
+  kSigmoid,
+  kTanh,
+  kGRU,
+  kConv1D
+};
+
+/**
+ * @brief A single statement of the IR, decoded ahead of time.
+ * */
+struct Instruction final
+{
+  OpCode op{ OpCode::kLinear };
+
+  uint8_t dstReg{};
+
+  /**
+   * @brief The input register of unary expressions, Linear, GRU and Conv1D, or the left operand of binary expressions.
+   * */
+  uint8_t leftReg{};
+
+  /**
+   * @brief The right operand of binary expressions.
+   * */
+  uint8_t rightReg{};
+
+  /**
+   * @brief The input features of Linear and GRU, the input channels of Conv1D, or the number of rows of the left
+   *        operand of MatMul.
+   * */
+  FeatureSize inFeatures{};
+
+  /**
+   * @brief The output features of Linear, the hidden size of GRU, or the output channels of Conv1D.
+   * */
+  FeatureSize outFeatures{};
+
+  /**
+   * @brief The kernel size of Conv1D.
+   * */
+  FeatureSize kernelSize{};
+
+  /**
+   * @brief An activation that was fused into this instruction.
+   * */
+  Activation activation{ Activation::kNone };
+};
+
+/**
+ * @brief The compiled form of the IR.
+ *
+ * @details Compiling the source once removes the lexer and parser from the inference loop. Any interpreter that
+ *          accepts the source text can also be driven by a program.
+ * */
+struct Program final
+{
+  InstrIndex numInstructions{};
+
+  Instruction* instructions{};
+
+  /**
+   * @brief Attempts to allocate space for @ref Program::numInstructions instructions.
+   *
+   * @return True on success, false on failure.
+   * */
+  [[nodiscard]] auto allocMemory() -> bool;
+
+  /**
+   * @brief Releases the memory allocated for the instructions.
+   * */
+  void releaseMemory();
+};
+
+/**
+ * @brief Compiles the source code of a network into a program.
+ *
+ * @note On success, the program has to be released with @ref Program::releaseMemory.
+ *
+ * @return @ref SyntaxError::kNone on success. Failing to allocate the program is reported as
+ *         @ref SyntaxError::kOutOfMemory.
+ * */
+[[nodiscard]] auto
+compile(const char* source, SourceSize length, Program* program) -> SyntaxError;
+
+/**
+ * @brief Fuses activations into the instruction that produces their input.
+ *
+ * @details An activation that directly follows a Linear, CompAdd or CompMul instruction, and that is the only reader
+ *          of its result, is folded into that instruction. The activation is then applied as each output is written,
+ *          and the intermediate register is no longer written at all.
+ *
+ * @param liveOut A mask of the registers that are read after the program finishes, one bit per register. These keep
+ *                their values.
+ *
+ * @return The number of activations that were fused.
+ * */
+auto
+fuseActivations(Program* program, RegMask liveOut) -> InstrIndex;
+
+/**
+ * @brief Executes a single instruction of a compiled program.
+ * */
+void
+execInstruction(const Instruction& instr, Interpreter& interp);
+
+/**
+ * @brief Executes a compiled program, from the first instruction to the last.
+ * */
+void
+exec(const Program& program, Interpreter& interp);
+
+/**
+ * @brief Executes a compiled program, from the last instruction to the first.
+ * */
+void
+reverseExec(const Program& program, Interpreter& interp);
+
+} // namespace NN
@@ -0,0 +1,280 @@
+#include "NN_QuantNet.h"
+
+#include "NN_Activation.h"
+#include "NN_Calibrator.h"
+#include "NN_Interpreter.h"
+#include "NN_Kernels.h"
+#include "NN_Program.h"
+
+#include <stdlib.h>
+
+namespace NN {
+
+namespace {
+
+auto
+roundToInt32(const float x) -> int32_t
+{
+  const float limit = 2147483520.0F;
+  const auto clamped = (x < -limit) ? -limit : ((x > limit) ? limit : x);
+  return static_cast<int32_t>((clamped >= 0.0F) ? (clamped + 0.5F) : (clamped - 0.5F));
+}
+
+/**
+ * @brief Writes the quantized parameters of each instruction.
+ *
+ * @details When no network is given, the parameters are only counted. This allows the network to be allocated with
+ *          its exact size.
+ * */
+class Quantizer final : public Interpreter
+{
+public:
+  Quantizer(const Net& net, const Calibrator& calibrator, QuantNet* quantNet)
+    : net_(net)
+    , calibrator_(calibrator)
+    , quantNet_(quantNet)
+    , floatParameters_(net.parameters)
+  {
+    for (uint8_t i = 0; i < NN_MAX_REGS; i++) {
+      regScales_[i] = calibrator.getInputRange(i).getInt8Scale();
+    }
+  }
+
+  [[nodiscard]] auto getNumWeights() const -> uint32_t { return numWeights_; }
+
+  [[nodiscard]] auto getNumBiases() const -> uint32_t { return numBiases_; }
+
+  [[nodiscard]] auto getNumMultipliers() const -> uint32_t { return numMultipliers_; }
+
+  [[nodiscard]] auto getNumTables() const -> uint32_t { return numTables_; }
+
+  [[nodiscard]] auto getInputScale(const uint8_t reg) const -> float
+  {
+    return calibrator_.getInputRange(reg).getInt8Scale();
+  }
+
+  void beginAssignment(const uint8_t dstReg) override { currentReg_ = dstReg; }
+
+  void interpret(const LinearExpr& expr) override
+  {
+    const auto computeScale = beginInstruction(expr.activation);
+    const auto inputScale = regScales_[expr.inRegister];
+    const auto stride = linearRowStride(expr.inFeatures, net_.weightLayout);
+    const auto* bias = floatParameters_ + stride * expr.outFeatures;
+
+    if (quantNet_) {
+      for (uint32_t row = 0; row < expr.outFeatures; row++) {
+        const auto* w = floatParameters_ + row * stride;
+        auto absMax = 0.0F;
+        for (uint32_t j = 0; j < expr.inFeatures; j++) {
+          const auto a = (w[j] < 0.0F) ? -w[j] : w[j];
+          absMax = (a > absMax) ? a : absMax;
+        }
+        const auto weightScale = (absMax > 0.0F) ? (absMax / 127.0F) : 1.0F;
+        auto* qw = quantNet_->weights + numWeights_ + row * expr.inFeatures;
+        for (uint32_t j = 0; j < expr.inFeatures; j++) {
+          qw[j] = roundToInt8(w[j] / weightScale, -127);
+        }
+        const auto accumulatorScale = inputScale * weightScale;
+        quantNet_->biases[numBiases_ + row] = roundToInt32(bias[row] / accumulatorScale);
+        quantNet_->multipliers[numMultipliers_ + row] = accumulatorScale / computeScale;
+      }
+    }
+
+    numWeights_ += static_cast<uint32_t>(expr.inFeatures) * expr.outFeatures;
+    numBiases_ += expr.outFeatures;
+    numMultipliers_ += expr.outFeatures;
+    floatParameters_ += linearParameterCount(expr.inFeatures, expr.outFeatures, net_.weightLayout);
+
+    endInstruction(expr.activation, computeScale);
+  }
+
+  void interpret(const MatMulExpr& expr) override { emitProduct(expr); }
+
+  void interpret(const ConcatExpr& expr) override { emitSum(expr); }
+
+  void interpret(const CompAddExpr& expr) override { emitSum(expr); }
+
+  void interpret(const CompMulExpr& expr) override { emitProduct(expr); }
+
+  void interpret(const ReLUExpr& expr) override
+  {
+    const auto outputScale = beginInstruction(Activation::kNone);
+    emitMultiplier(regScales_[expr.inRegister] / outputScale);
+    endInstruction(Activation::kNone, outputScale);
+  }
+
+  void interpret(const SigmoidExpr& expr) override { emitTableInstruction(expr, Activation::kSigmoid); }
+
+  void interpret(const TanhExpr& expr) override { emitTableInstruction(expr, Activation::kTanh); }
+
+  void interpret(const GRUExpr&) override {}
+
+  void interpret(const Conv1DExpr&) override {}
+
+protected:
+  /**
+   * @return The scale that the instruction computes its result in, before any table activation.
+   * */
+  auto beginInstruction(const Activation activation) -> float
+  {
+    const auto outputScale = calibrator_.getOutputRange(instruction_).getInt8Scale();
+    if ((activation == Activation::kSigmoid) || (activation == Activation::kTanh)) {
+      return calibrator_.getPreActivationRange(instruction_).getInt8Scale();
+    }
+    return outputScale;
+  }
+
+  void endInstruction(const Activation activation, const float computeScale)
+  {
+    const auto outputScale = calibrator_.getOutputRange(instruction_).getInt8Scale();
+    if ((activation == Activation::kSigmoid) || (activation == Activation::kTanh)) {
+      emitTable(activation, computeScale, outputScale);
+    }
+    if (quantNet_) {
+      quantNet_->outputScales[instruction_] = outputScale;
+    }
+    regScales_[currentReg_] = outputScale;
+    instruction_++;
+  }
+
+  void emitProduct(const BinaryExpr& expr)
+  {
+    const auto computeScale = beginInstruction(expr.activation);
+    emitMultiplier(regScales_[expr.leftOpReg] * regScales_[expr.rightOpReg] / computeScale);
+    endInstruction(expr.activation, computeScale);
+  }
+
+  void emitSum(const BinaryExpr& expr)
+  {
+    const auto computeScale = beginInstruction(expr.activation);
+    emitMultiplier(regScales_[expr.leftOpReg] / computeScale);
+    emitMultiplier(regScales_[expr.rightOpReg] / computeScale);
+    endInstruction(expr.activation, computeScale);
+  }
+
+  void emitTableInstruction(const UnaryExpr& expr, const Activation activation)
+  {
+    const auto outputScale = beginInstruction(Activation::kNone);
+    emitTable(activation, regScales_[expr.inRegister], outputScale);
+    endInstruction(Activation::kNone, outputScale);
+  }
+
+  void emitMultiplier(const float multiplier)
+  {
+    if (quantNet_) {
+      quantNet_->multipliers[numMultipliers_] = multiplier;
+    }
+    numMultipliers_++;
+  }
+
+  void emitTable(const Activation activation, const float inputScale, const float outputScale)
+  {
+    if (quantNet_) {
+      auto* table = quantNet_->tables + numTables_ * NN_INT8_TABLE_SIZE;
+      for (int32_t q = -128; q < 128; q++) {
+        const auto y = applyActivation(static_cast<float>(q) * inputScale, activation);
+        table[q + 128] = roundToInt8(y / outputScale, -127);
+      }
+    }
+    numTables_++;
+  }
+
+private:
+  const Net& net_;
+
+  const Calibrator& calibrator_;
+
+  QuantNet* quantNet_{};
+
+  const float* floatParameters_{};
+
+  /**
+   * @brief The scale of the value that each register holds at the current instruction.
+   * */
+  float regScales_[NN_MAX_REGS]{};
+
+  uint32_t numWeights_{};
+
+  uint32_t numBiases_{};
+
+  uint32_t numMultipliers_{};
+
+  uint32_t numTables_{};
+
+  InstrIndex instruction_{};
+
+  uint8_t currentReg_{};
+};
+
+} // namespace
+
+auto
+QuantNet::allocMemory() -> bool
+{
+  const size_t wordCount = static_cast<size_t>(numBiases) + numMultipliers + numInstructions;
+  const size_t tableBytes = static_cast<size_t>(numTables) * NN_INT8_TABLE_SIZE;
+  const size_t byteCount = numWeights + tableBytes + static_cast<size_t>(arenaSize) * batchSize;
+  // The 32 bit values come first, so that they stay aligned.
+  memory = malloc(wordCount * sizeof(float) + byteCount);
+  if (!memory) {
+    return false;
+  }
+  biases = static_cast<int32_t*>(memory);
+  multipliers = reinterpret_cast<float*>(biases + numBiases);
+  outputScales = multipliers + numMultipliers;
+  weights = reinterpret_cast<int8_t*>(outputScales + numInstructions);
+  tables = weights + numWeights;
+  auto* arena = tables + tableBytes;
+  for (uint8_t i = 0; i < NN_MAX_REGS; i++) {
+    regs[i] = arena + static_cast<size_t>(regOffsets[i]) * batchSize;
+  }
+  return true;
+}
+
+void
+QuantNet::releaseMemory()
+{
+  free(memory);
+  memory = nullptr;
+  weights = nullptr;
+  biases = nullptr;
+  multipliers = nullptr;
+  outputScales = nullptr;
+  tables = nullptr;
+}
+
+auto
+quantize(const Program& program, const Net& net, const Calibrator& calibrator, QuantNet* quantNet) -> bool
+{
+  if ((calibrator.getNumInstructions() != program.numInstructions) || (net.stateSize != 0)) {
+    return false;
+  }
+
+  Quantizer counter(net, calibrator, nullptr);
+  exec(program, counter);
+
+  quantNet->numWeights = counter.getNumWeights();
+  quantNet->numBiases = counter.getNumBiases();
+  quantNet->numMultipliers = counter.getNumMultipliers();
+  quantNet->numTables = counter.getNumTables();
+  quantNet->numInstructions = program.numInstructions;
+  quantNet->arenaSize = net.arenaSize;
+  quantNet->batchSize = net.batchSize;
+  for (uint8_t i = 0; i < NN_MAX_REGS; i++) {
+    quantNet->regSizes[i] = net.regSizes[i];
+    quantNet->regOffsets[i] = net.regOffsets[i];
+    quantNet->inputScales[i] = counter.getInputScale(i);
+  }
+
+  if (!quantNet->allocMemory()) {
+    return false;
+  }
+
+  Quantizer writer(net, calibrator, quantNet);
+  exec(program, writer);
+
+  return true;
+}
+
+} // namespace NN
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "NN_Net.h"
+
+#include <stdint.h>
+
+namespace NN {
+
+class Calibrator;
+
+struct Program;
+
+/**
+ * @brief The number of entries in the table of an int8 activation, one for each possible input.
+ * */
+#define NN_INT8_TABLE_SIZE 256
+
+/**
+ * @brief A network whose parameters and registers are stored as int8.
+ *
+ * @details Every value is stored as `round(x / scale)`, clamped to [-127, 127]. The weights have one scale per output
+ *          feature. The registers have one scale per instruction that writes them, which is found by a
+ *          @ref Calibrator.
+ *
+ *          The parameters are split into streams, which are consumed in program order by the
+ *          @ref QuantNetRunner, in the same way that the float parameters are consumed by the @ref NetRunner:
+ *
+ *          - Linear takes `inFeatures * outFeatures` weights, `outFeatures` biases and `outFeatures` multipliers.
+ *          - MatMul and CompMul take one multiplier. Concat and CompAdd take one multiplier for each operand. ReLU takes
+ *            one multiplier.
+ *          - Sigmoid and Tanh, including when they are fused, take one table.
+ *          - Every instruction takes one output scale.
+ *
+ *          A multiplier converts a product of input scales into the output scale.
+ * */
+struct QuantNet final
+{
+  uint32_t numWeights{};
+
+  uint32_t numBiases{};
+
+  uint32_t numMultipliers{};
+
+  uint32_t numTables{};
+
+  InstrIndex numInstructions{};
+
+  FeatureSize regSizes[NN_MAX_REGS]{};
+
+  /**
+   * @brief Where each register starts in the register arena. See @ref Net::regOffsets.
+   * */
+  uint32_t regOffsets[NN_MAX_REGS]{};
+
+  uint32_t arenaSize{};
+
+  uint16_t batchSize{ 1 };
+
+  /**
+   * @brief The scale of each register that is read before it is written.
+   * */
+  float inputScales[NN_MAX_REGS]{};
+
+  int8_t* weights{};
+
+  /**
+   * @brief The biases, in the scale of the accumulator of their output feature.
+   * */
+  int32_t* biases{};
+
+  float* multipliers{};
+
+  /**
+   * @brief The scale of the result of each instruction.
+   * */
+  float* outputScales{};
+
+  /**
+   * @brief The activation tables, each with @ref NN_INT8_TABLE_SIZE entries indexed by `input + 128`.
+   * */
+  int8_t* tables{};
+
+  int8_t* regs[NN_MAX_REGS]{};
+
+  void* memory{};
+
+  /**
+   * @brief Attempts to allocate the parameter streams and the registers.
+   *
+   * @return True on success, false on failure.
+   * */
+  [[nodiscard]] auto allocMemory() -> bool;
+
+  void releaseMemory();
+};
+
+/**
+ * @brief Quantizes a float network to int8.
+ *
+ * @param program The program that the network was built from.
+ *
+ * @param net The float network, with its parameters.
+ *
+ * @param calibrator A calibrator that the program was run through with representative inputs.
+ *
+ * @param quantNet The network to write the quantized parameters to. It has to be released with
+ *                 @ref QuantNet::releaseMemory.
+ *
+ * @return False if the memory could not be allocated, if the calibrator was made for a different program, or if the
+ *         network has a GRU or Conv1D, which are not quantized.
+ * */
+[[nodiscard]] auto
+quantize(const Program& program, const Net& net, const Calibrator& calibrator, QuantNet* quantNet) -> bool;
+
+} // namespace NN
@@ -0,0 +1,298 @@
+#include "NN_QuantNetRunner.h"
+
+#include "NN_Kernels.h"
+
+namespace NN {
+
+namespace {
+
+auto
+minValueOf(const Activation activation) -> int32_t
+{
+  return (activation == Activation::kReLU) ? 0 : -127;
+}
+
+auto
+isTableActivation(const Activation activation) -> bool
+{
+  return (activation == Activation::kSigmoid) || (activation == Activation::kTanh);
+}
+
+} // namespace
+
+QuantNetRunner::QuantNetRunner(const QuantNet* net)
+  : net_(net)
+{
+}
+
+auto
+QuantNetRunner::getRegister(const uint8_t reg, const uint16_t sample) -> int8_t*
+{
+  return net_->regs[reg] + static_cast<uint32_t>(sample) * net_->regSizes[reg];
+}
+
+auto
+QuantNetRunner::getScale(const uint8_t reg) const -> float
+{
+  return regScales_[reg];
+}
+
+void
+QuantNetRunner::setInput(const uint8_t reg, const uint16_t sample, const float* values)
+{
+  auto* output = getRegister(reg, sample);
+  const auto scale = net_->inputScales[reg];
+  for (FeatureSize i = 0; i < net_->regSizes[reg]; i++) {
+    output[i] = roundToInt8(values[i] / scale, -127);
+  }
+}
+
+void
+QuantNetRunner::getOutput(const uint8_t reg, const uint16_t sample, float* values) const
+{
+  const auto* input = net_->regs[reg] + static_cast<uint32_t>(sample) * net_->regSizes[reg];
+  const auto scale = regScales_[reg];
+  for (FeatureSize i = 0; i < regSizes_[reg]; i++) {
+    values[i] = static_cast<float>(input[i]) * scale;
+  }
+}
+
+void
+QuantNetRunner::setBatchSize(const uint16_t batchSize)
+{
+  batchSize_ = (batchSize < net_->batchSize) ? batchSize : net_->batchSize;
+}
+
+void
+QuantNetRunner::reset()
+{
+  currentReg_ = 0;
+  currentWeights_ = net_->weights;
+  currentBiases_ = net_->biases;
+  currentMultipliers_ = net_->multipliers;
+  currentOutputScale_ = net_->outputScales;
+  currentTable_ = net_->tables;
+  for (uint8_t i = 0; i < NN_MAX_REGS; i++) {
+    regSizes_[i] = net_->regSizes[i];
+    regScales_[i] = net_->inputScales[i];
+  }
+}
+
+void
+QuantNetRunner::beginAssignment(const uint8_t dstReg)
+{
+  currentReg_ = dstReg;
+}
+
+template<typename Func>
+void
+QuantNetRunner::applyUnary(const uint8_t inReg, Func func)
+{
+  const auto numFeatures = regSizes_[inReg];
+  for (uint16_t b = 0; b < batchSize_; b++) {
+    const auto* in = getRegister(inReg, b);
+    auto* out = getRegister(currentReg_, b);
+    for (FeatureSize i = 0; i < numFeatures; i++) {
+      out[i] = func(in[i]);
+    }
+  }
+  regSizes_[currentReg_] = numFeatures;
+}
+
+template<typename Func>
+void
+QuantNetRunner::applyBinary(const BinaryExpr& expr, Func func)
+{
+  const auto lSize = regSizes_[expr.leftOpReg];
+  const auto rSize = regSizes_[expr.rightOpReg];
+  const auto minSize = (lSize < rSize) ? lSize : rSize;
+  for (uint16_t b = 0; b < batchSize_; b++) {
+    const auto* leftOp = getRegister(expr.leftOpReg, b);
+    const auto* rightOp = getRegister(expr.rightOpReg, b);
+    auto* output = getRegister(currentReg_, b);
+    for (FeatureSize i = 0; i < minSize; i++) {
+      output[i] = func(leftOp[i], rightOp[i]);
+    }
+  }
+  regSizes_[currentReg_] = minSize;
+}
+
+void
+QuantNetRunner::applyTable(const Activation activation)
+{
+  if (!isTableActivation(activation)) {
+    return;
+  }
+  const auto* table = currentTable_;
+  for (uint16_t b = 0; b < batchSize_; b++) {
+    auto* values = getRegister(currentReg_, b);
+    for (FeatureSize i = 0; i < regSizes_[currentReg_]; i++) {
+      values[i] = table[values[i] + 128];
+    }
+  }
+  currentTable_ += NN_INT8_TABLE_SIZE;
+}
+
+void
+QuantNetRunner::endInstruction()
+{
+  regScales_[currentReg_] = *currentOutputScale_;
+  currentOutputScale_++;
+}
+
+void
+QuantNetRunner::interpret(const LinearExpr& expr)
+{
+  for (uint16_t b = 0; b < batchSize_; b++) {
+    linearInt8(currentWeights_,
+               currentBiases_,
+               currentMultipliers_,
+               getRegister(expr.inRegister, b),
+               getRegister(currentReg_, b),
+               expr.inFeatures,
+               expr.outFeatures,
+               minValueOf(expr.activation));
+  }
+
+  currentWeights_ += static_cast<uint32_t>(expr.inFeatures) * expr.outFeatures;
+  currentBiases_ += expr.outFeatures;
+  currentMultipliers_ += expr.outFeatures;
+
+  regSizes_[currentReg_] = expr.outFeatures;
+
+  applyTable(expr.activation);
+
+  endInstruction();
+}
+
+void
+QuantNetRunner::interpret(const MatMulExpr& expr)
+{
+  const uint32_t m = expr.leftRows;
+  const uint32_t k = (m > 0) ? (regSizes_[expr.leftOpReg] / m) : 0;
+  const uint32_t n = (k > 0) ? (regSizes_[expr.rightOpReg] / k) : 0;
+  const auto multiplier = currentMultipliers_[0];
+  const auto minValue = minValueOf(expr.activation);
+
+  for (uint16_t b = 0; b < batchSize_; b++) {
+    const auto* a = getRegister(expr.leftOpReg, b);
+    const auto* bMatrix = getRegister(expr.rightOpReg, b);
+    auto* c = getRegister(currentReg_, b);
+    for (uint32_t i = 0; i < m; i++) {
+      for (uint32_t j = 0; j < n; j++) {
+        int32_t acc = 0;
+        for (uint32_t p = 0; p < k; p++) {
+          acc += static_cast<int32_t>(a[i * k + p]) * static_cast<int32_t>(bMatrix[p * n + j]);
+        }
+        c[i * n + j] = roundToInt8(static_cast<float>(acc) * multiplier, minValue);
+      }
+    }
+  }
+
+  currentMultipliers_++;
+
+  regSizes_[currentReg_] = static_cast<FeatureSize>(m * n);
+
+  applyTable(expr.activation);
+
+  endInstruction();
+}
+
+void
+QuantNetRunner::interpret(const ConcatExpr& expr)
+{
+  const auto lSize = regSizes_[expr.leftOpReg];
+  const auto rSize = regSizes_[expr.rightOpReg];
+  const auto lMultiplier = currentMultipliers_[0];
+  const auto rMultiplier = currentMultipliers_[1];
+  const auto minValue = minValueOf(expr.activation);
+
+  for (uint16_t b = 0; b < batchSize_; b++) {
+    const auto* leftOp = getRegister(expr.leftOpReg, b);
+    const auto* rightOp = getRegister(expr.rightOpReg, b);
+    auto* output = getRegister(currentReg_, b);
+    for (FeatureSize i = 0; i < lSize; i++) {
+      output[i] = roundToInt8(static_cast<float>(leftOp[i]) * lMultiplier, minValue);
+    }
+    for (FeatureSize i = 0; i < rSize; i++) {
+      output[lSize + i] = roundToInt8(static_cast<float>(rightOp[i]) * rMultiplier, minValue);
+    }
+  }
+
+  currentMultipliers_ += 2;
+
+  regSizes_[currentReg_] = lSize + rSize;
+
+  applyTable(expr.activation);
+
+  endInstruction();
+}
+
+void
+QuantNetRunner::interpret(const CompAddExpr& expr)
+{
+  const auto lMultiplier = currentMultipliers_[0];
+  const auto rMultiplier = currentMultipliers_[1];
+  const auto minValue = minValueOf(expr.activation);
+  applyBinary(expr, [lMultiplier, rMultiplier, minValue](const int8_t l, const int8_t r) -> int8_t {
+    return roundToInt8(static_cast<float>(l) * lMultiplier + static_cast<float>(r) * rMultiplier, minValue);
+  });
+  currentMultipliers_ += 2;
+  applyTable(expr.activation);
+  endInstruction();
+}
+
+void
+QuantNetRunner::interpret(const CompMulExpr& expr)
+{
+  const auto multiplier = currentMultipliers_[0];
+  const auto minValue = minValueOf(expr.activation);
+  applyBinary(expr, [multiplier, minValue](const int8_t l, const int8_t r) -> int8_t {
+    return roundToInt8(static_cast<float>(static_cast<int32_t>(l) * static_cast<int32_t>(r)) * multiplier, minValue);
+  });
+  currentMultipliers_++;
+  applyTable(expr.activation);
+  endInstruction();
+}
+
+void
+QuantNetRunner::interpret(const ReLUExpr& expr)
+{
+  const auto multiplier = currentMultipliers_[0];
+  applyUnary(expr.inRegister,
+             [multiplier](const int8_t in) -> int8_t { return roundToInt8(static_cast<float>(in) * multiplier, 0); });
+  currentMultipliers_++;
+  endInstruction();
+}
+
+void
+QuantNetRunner::interpret(const SigmoidExpr& expr)
+{
+  const auto* table = currentTable_;
+  applyUnary(expr.inRegister, [table](const int8_t in) -> int8_t { return table[in + 128]; });
+  currentTable_ += NN_INT8_TABLE_SIZE;
+  endInstruction();
+}
+
+void
+QuantNetRunner::interpret(const GRUExpr&)
+{
+  // Never reached, since networks with state are not quantized.
+}
+
+void
+QuantNetRunner::interpret(const Conv1DExpr&)
+{
+  // Never reached, since networks with state are not quantized.
+}
+
+void
+QuantNetRunner::interpret(const TanhExpr& expr)
+{
+  const auto* table = currentTable_;
+  applyUnary(expr.inRegister, [table](const int8_t in) -> int8_t { return table[in + 128]; });
+  currentTable_ += NN_INT8_TABLE_SIZE;
+  endInstruction();
+}
+
+} // namespace NN
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "NN_Interpreter.h"
+#include "NN_QuantNet.h"
+
+#include <stdint.h>
+
+namespace NN {
+
+/**
+ * @brief Runs a network that was quantized with @ref quantize.
+ *
+ * @details This has to be driven by the same program that the network was quantized from. The inputs are written
+ *          with @ref QuantNetRunner::setInput, which quantizes them, and the outputs are read back with
+ *          @ref QuantNetRunner::getOutput.
+ * */
+class QuantNetRunner final : public Interpreter
+{
+public:
+  QuantNetRunner(const QuantNet* net);
+
+  [[nodiscard]] auto getRegister(uint8_t reg, uint16_t sample) -> int8_t*;
+
+  /**
+   * @brief Gets the scale of the value that a register currently holds.
+   * */
+  [[nodiscard]] auto getScale(uint8_t reg) const -> float;
+
+  /**
+   * @brief Quantizes an input and writes it to a register.
+   *
+   * @details The number of values is the size of the register.
+   * */
+  void setInput(uint8_t reg, uint16_t sample, const float* values);
+
+  /**
+   * @brief Reads a register back as float values.
+   *
+   * @details The number of values is the size of the register.
+   * */
+  void getOutput(uint8_t reg, uint16_t sample, float* values) const;
+
+  /**
+   * @brief Sets the number of samples that each instruction is applied to. See @ref NetRunner::setBatchSize.
+   * */
+  void setBatchSize(uint16_t batchSize);
+
+  void reset();
+
+  void beginAssignment(uint8_t dstReg) override;
+
+  void interpret(const LinearExpr&) override;
+
+  void interpret(const MatMulExpr&) override;
+
+  void interpret(const ConcatExpr&) override;
+
+  void interpret(const CompAddExpr&) override;
+
+  void interpret(const CompMulExpr&) override;
+
+  void interpret(const ReLUExpr&) override;
+
+  void interpret(const SigmoidExpr&) override;
+
+  void interpret(const TanhExpr&) override;
+
+  void interpret(const GRUExpr&) override;
+
+  void interpret(const Conv1DExpr&) override;
+
+protected:
+  template<typename Func>
+  void applyUnary(uint8_t inReg, Func func);
+
+  template<typename Func>
+  void applyBinary(const BinaryExpr& expr, Func func);
+
+  /**
+   * @brief Applies a fused table activation to the result of the current instruction.
+   * */
+  void applyTable(Activation activation);
+
+  void endInstruction();
+
+private:
+  const QuantNet* net_{};
+
+  uint16_t batchSize_{ 1 };
+
+  uint8_t currentReg_{};
+
+  const int8_t* currentWeights_{};
+
+  const int32_t* currentBiases_{};
+
+  const float* currentMultipliers_{};
+
+  const float* currentOutputScale_{};
+
+  const int8_t* currentTable_{};
+
+  FeatureSize regSizes_[NN_MAX_REGS]{};
+
+  float regScales_[NN_MAX_REGS]{};
+};
+
+} // namespace NN
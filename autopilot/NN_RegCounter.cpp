@@ -62,6 +62,18 @@ RegCounter::interpret(const TanhExpr& expr)
   count(expr);
 }
 
+void
+RegCounter::interpret(const GRUExpr& expr)
+{
+  updateMaxReg(expr.inRegister);
+}
+
+void
+RegCounter::interpret(const Conv1DExpr& expr)
+{
+  updateMaxReg(expr.inRegister);
+}
+
 void
 RegCounter::count(const UnaryExpr& expr)
 {
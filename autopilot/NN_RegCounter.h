@@ -29,6 +29,10 @@ public:
 
   void interpret(const TanhExpr& expr) override;
 
+  void interpret(const GRUExpr& expr) override;
+
+  void interpret(const Conv1DExpr& expr) override;
+
 protected:
   void count(const UnaryExpr& expr);
 
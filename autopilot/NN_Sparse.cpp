@@ -0,0 +1,317 @@
+#include "NN_Sparse.h"
+
+#include "NN_Interpreter.h"
+#include "NN_Program.h"
+
+#include <stdlib.h>
+
+namespace NN {
+
+namespace {
+
+/**
+ * @brief Walks the weights of each linear layer of a network. No other instruction has parameters.
+ * */
+class LinearVisitor : public Interpreter
+{
+public:
+  explicit LinearVisitor(const Net& net)
+    : net_(net)
+    , parameters_(net.parameters)
+  {
+  }
+
+  void beginAssignment(uint8_t) override {}
+
+  void interpret(const LinearExpr& expr) override
+  {
+    visit(expr, parameters_, linearRowStride(expr.inFeatures, net_.weightLayout));
+    parameters_ += linearParameterCount(expr.inFeatures, expr.outFeatures, net_.weightLayout);
+  }
+
+  void interpret(const MatMulExpr&) override {}
+
+  void interpret(const ConcatExpr&) override {}
+
+  void interpret(const CompAddExpr&) override {}
+
+  void interpret(const CompMulExpr&) override {}
+
+  void interpret(const ReLUExpr&) override {}
+
+  void interpret(const SigmoidExpr&) override {}
+
+  void interpret(const TanhExpr&) override {}
+
+  void interpret(const GRUExpr&) override {}
+
+  void interpret(const Conv1DExpr&) override {}
+
+protected:
+  /**
+   * @param weights The row-major weights of the layer, which are followed by the biases.
+   *
+   * @param stride The number of floats between the start of each row of weights.
+   * */
+  virtual void visit(const LinearExpr& expr, float* weights, uint32_t stride) = 0;
+
+  [[nodiscard]] static auto getNumBlockRows(const LinearExpr& expr) -> uint32_t
+  {
+    return (static_cast<uint32_t>(expr.outFeatures) + NN_SPARSE_BLOCK_ROWS - 1) / NN_SPARSE_BLOCK_ROWS;
+  }
+
+  /**
+   * @brief Gets the number of rows of a block row that are output features, which is less than a full block at the
+   *        end of a layer.
+   * */
+  [[nodiscard]] static auto getNumRows(const LinearExpr& expr, const uint32_t blockRow) -> uint32_t
+  {
+    const auto left = static_cast<uint32_t>(expr.outFeatures) - blockRow * NN_SPARSE_BLOCK_ROWS;
+    return (left < NN_SPARSE_BLOCK_ROWS) ? left : NN_SPARSE_BLOCK_ROWS;
+  }
+
+  const Net& net_;
+
+private:
+  float* parameters_{};
+};
+
+struct BlockNorm final
+{
+  float norm;
+
+  uint32_t index;
+};
+
+auto
+compareBlockNorms(const void* a, const void* b) -> int
+{
+  const auto* l = static_cast<const BlockNorm*>(a);
+  const auto* r = static_cast<const BlockNorm*>(b);
+  if (l->norm != r->norm) {
+    return (l->norm < r->norm) ? -1 : 1;
+  }
+  // The sort is not stable, so ties are broken by position to keep pruning deterministic.
+  return (l->index < r->index) ? -1 : ((l->index > r->index) ? 1 : 0);
+}
+
+class Pruner final : public LinearVisitor
+{
+public:
+  Pruner(const Net& net, const float fraction)
+    : LinearVisitor(net)
+    , fraction_((fraction < 0.0F) ? 0.0F : ((fraction > 1.0F) ? 1.0F : fraction))
+  {
+  }
+
+  [[nodiscard]] auto failed() const -> bool { return failed_; }
+
+protected:
+  void visit(const LinearExpr& expr, float* weights, const uint32_t stride) override
+  {
+    const uint32_t inFeatures = expr.inFeatures;
+    const auto numBlocks = getNumBlockRows(expr) * inFeatures;
+    const auto numPruned = static_cast<uint32_t>(fraction_ * static_cast<float>(numBlocks));
+    if ((numPruned == 0) || failed_) {
+      return;
+    }
+
+    auto* blocks = static_cast<BlockNorm*>(malloc(numBlocks * sizeof(BlockNorm)));
+    if (!blocks) {
+      failed_ = true;
+      return;
+    }
+
+    for (uint32_t i = 0; i < numBlocks; i++) {
+      const auto* w = weights + (i / inFeatures) * NN_SPARSE_BLOCK_ROWS * stride + (i % inFeatures);
+      auto norm = 0.0F;
+      for (uint32_t r = 0; r < getNumRows(expr, i / inFeatures); r++) {
+        norm += (w[r * stride] < 0.0F) ? -w[r * stride] : w[r * stride];
+      }
+      blocks[i].norm = norm;
+      blocks[i].index = i;
+    }
+
+    qsort(blocks, numBlocks, sizeof(BlockNorm), compareBlockNorms);
+
+    for (uint32_t i = 0; (i < numPruned) && (i < numBlocks); i++) {
+      const auto blockRow = blocks[i].index / inFeatures;
+      auto* w = weights + blockRow * NN_SPARSE_BLOCK_ROWS * stride + (blocks[i].index % inFeatures);
+      for (uint32_t r = 0; r < getNumRows(expr, blockRow); r++) {
+        w[r * stride] = 0.0F;
+      }
+    }
+
+    free(blocks);
+  }
+
+private:
+  float fraction_{};
+
+  bool failed_{ false };
+};
+
+/**
+ * @brief Writes the blocks of each linear layer that are not zero.
+ *
+ * @details When no network is given, the parameters are only counted. This allows the network to be allocated with
+ *          its exact size.
+ * */
+class Sparsifier final : public LinearVisitor
+{
+public:
+  Sparsifier(const Net& net, SparseNet* sparseNet)
+    : LinearVisitor(net)
+    , sparseNet_(sparseNet)
+  {
+  }
+
+  [[nodiscard]] auto getNumParameters() const -> uint32_t { return numParameters_; }
+
+  [[nodiscard]] auto getNumBlockStarts() const -> uint32_t { return numBlockStarts_; }
+
+  [[nodiscard]] auto getNumBlocks() const -> uint32_t { return numBlocks_; }
+
+protected:
+  void visit(const LinearExpr& expr, float* weights, const uint32_t stride) override
+  {
+    const auto numBlockRows = getNumBlockRows(expr);
+    const auto* bias = weights + stride * expr.outFeatures;
+
+    float* biases{};
+    uint32_t* starts{};
+    FeatureSize* columns{};
+    if (sparseNet_) {
+      biases = sparseNet_->parameters + numParameters_;
+      starts = sparseNet_->blockStarts + numBlockStarts_;
+      columns = sparseNet_->blockColumns + numBlocks_;
+      for (uint32_t i = 0; i < expr.outFeatures; i++) {
+        biases[i] = bias[i];
+      }
+    }
+
+    uint32_t kept{};
+
+    for (uint32_t i = 0; i < numBlockRows; i++) {
+      const auto numRows = getNumRows(expr, i);
+      const auto* row = weights + i * NN_SPARSE_BLOCK_ROWS * stride;
+      if (starts) {
+        starts[i] = kept;
+      }
+      for (uint32_t j = 0; j < expr.inFeatures; j++) {
+        auto nonZero = false;
+        for (uint32_t r = 0; r < numRows; r++) {
+          nonZero = nonZero || (row[r * stride + j] != 0.0F);
+        }
+        if (!nonZero) {
+          continue;
+        }
+        if (sparseNet_) {
+          columns[kept] = static_cast<FeatureSize>(j);
+          auto* values = biases + expr.outFeatures + kept * NN_SPARSE_BLOCK_ROWS;
+          for (uint32_t r = 0; r < NN_SPARSE_BLOCK_ROWS; r++) {
+            values[r] = (r < numRows) ? row[r * stride + j] : 0.0F;
+          }
+        }
+        kept++;
+      }
+    }
+
+    if (starts) {
+      starts[numBlockRows] = kept;
+    }
+
+    numParameters_ += sparseLinearParameterCount(expr.outFeatures, kept);
+    numBlockStarts_ += numBlockRows + 1;
+    numBlocks_ += kept;
+  }
+
+private:
+  SparseNet* sparseNet_{};
+
+  uint32_t numParameters_{};
+
+  uint32_t numBlockStarts_{};
+
+  uint32_t numBlocks_{};
+};
+
+} // namespace
+
+auto
+sparseLinearParameterCount(const FeatureSize outFeatures, const uint32_t numBlocks) -> uint32_t
+{
+  return static_cast<uint32_t>(outFeatures) + numBlocks * NN_SPARSE_BLOCK_ROWS;
+}
+
+auto
+SparseNet::allocMemory() -> bool
+{
+  // The 32 bit values come first, so that they stay aligned.
+  const size_t wordCount = static_cast<size_t>(numParameters) + numBlockStarts;
+  memory = malloc(wordCount * sizeof(float) + static_cast<size_t>(numBlocks) * sizeof(FeatureSize));
+  if (!memory) {
+    return false;
+  }
+  parameters = static_cast<float*>(memory);
+  blockStarts = reinterpret_cast<uint32_t*>(parameters + numParameters);
+  blockColumns = reinterpret_cast<FeatureSize*>(blockStarts + numBlockStarts);
+  return true;
+}
+
+void
+SparseNet::releaseMemory()
+{
+  free(memory);
+  memory = nullptr;
+  parameters = nullptr;
+  blockStarts = nullptr;
+  blockColumns = nullptr;
+}
+
+auto
+SparseNet::getParameterBytes() const -> uint64_t
+{
+  return (static_cast<uint64_t>(numParameters) + numBlockStarts) * sizeof(float) +
+         static_cast<uint64_t>(numBlocks) * sizeof(FeatureSize);
+}
+
+auto
+pruneByMagnitude(const Program& program, Net* net, const float fraction) -> bool
+{
+  if (net->stateSize != 0) {
+    return false;
+  }
+
+  Pruner pruner(*net, fraction);
+  exec(program, pruner);
+  return !pruner.failed();
+}
+
+auto
+sparsify(const Program& program, const Net& net, SparseNet* sparseNet) -> bool
+{
+  if (net.stateSize != 0) {
+    return false;
+  }
+
+  Sparsifier counter(net, nullptr);
+  exec(program, counter);
+
+  sparseNet->numParameters = counter.getNumParameters();
+  sparseNet->numBlockStarts = counter.getNumBlockStarts();
+  sparseNet->numBlocks = counter.getNumBlocks();
+
+  sparseNet->shape = net.getShape();
+
+  if (!sparseNet->allocMemory()) {
+    return false;
+  }
+
+  Sparsifier writer(net, sparseNet);
+  exec(program, writer);
+
+  return true;
+}
+
+} // namespace NN
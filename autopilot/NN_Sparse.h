@@ -0,0 +1,109 @@
+#pragma once
+
+#include "NN_Kernels.h"
+#include "NN_Net.h"
+
+#include <stdint.h>
+
+namespace NN {
+
+struct Program;
+
+/**
+ * @brief Gets the number of parameters (biases and kept weights) taken up by a sparse linear layer.
+ *
+ * @param numBlocks The number of blocks of @ref NN_SPARSE_BLOCK_ROWS weights that were kept.
+ * */
+[[nodiscard]] auto
+sparseLinearParameterCount(FeatureSize outFeatures, uint32_t numBlocks) -> uint32_t;
+
+/**
+ * @brief A network whose linear layers only store the blocks of weights that are not zero.
+ *
+ * @details The weights of each linear layer are split into blocks of @ref NN_SPARSE_BLOCK_ROWS rows by one column,
+ *          and the blocks that are entirely zero are left out. Every other instruction is run the same way as by the
+ *          @ref NetRunner, since none of them have parameters.
+ *
+ *          The parameters are split into streams, which are consumed in program order by the @ref SparseNetRunner,
+ *          in the same way that the float parameters are consumed by the @ref NetRunner. Each Linear takes:
+ *
+ *          - `outFeatures` biases, followed by the weights of each kept block, from the parameters.
+ *          - One start for each block row, followed by the number of kept blocks, from the block starts. The starts
+ *            count from zero for each layer.
+ *          - The input feature of each kept block, from the block columns.
+ * */
+struct SparseNet final
+{
+  /**
+   * @brief The registers, batch size and activation mode of the network that this was made from.
+   *
+   * @details This has no parameters. It is what a @ref NetRunner and @ref Activations::allocMemory need to lay out
+   *          the registers.
+   * */
+  Net shape;
+
+  uint32_t numParameters{};
+
+  uint32_t numBlockStarts{};
+
+  uint32_t numBlocks{};
+
+  float* parameters{};
+
+  uint32_t* blockStarts{};
+
+  FeatureSize* blockColumns{};
+
+  void* memory{};
+
+  /**
+   * @brief Attempts to allocate the parameter streams.
+   *
+   * @return True on success, false on failure.
+   * */
+  [[nodiscard]] auto allocMemory() -> bool;
+
+  void releaseMemory();
+
+  /**
+   * @brief Gets the size of the parameter streams, which is what the network takes up in flash.
+   * */
+  [[nodiscard]] auto getParameterBytes() const -> uint64_t;
+};
+
+/**
+ * @brief Zeroes the blocks of weights with the smallest magnitude in each linear layer.
+ *
+ * @details Blocks are the same as in @ref SparseNet, and their magnitude is the sum of the absolute values of their
+ *          weights. Blocks that are already zero are pruned first. Biases are never pruned. The network can still be
+ *          run and trained as before, so pruning can be followed by more training to recover the accuracy, as long as
+ *          the pruned weights are pruned again before calling @ref sparsify.
+ *
+ * @param program The program that the network was built from.
+ *
+ * @param net The network to prune.
+ *
+ * @param fraction The fraction of the blocks of each linear layer to prune, between zero and one.
+ *
+ * @return False if the memory for sorting the blocks could not be allocated, in which case the network may have
+ *         been partially pruned, or if the network has a GRU or Conv1D, which are not pruned.
+ * */
+[[nodiscard]] auto
+pruneByMagnitude(const Program& program, Net* net, float fraction) -> bool;
+
+/**
+ * @brief Converts a float network into a sparse one, leaving out the blocks of weights that are zero.
+ *
+ * @param program The program that the network was built from.
+ *
+ * @param net The float network, usually pruned with @ref pruneByMagnitude.
+ *
+ * @param sparseNet The network to write the sparse parameters to. It has to be released with
+ *                  @ref SparseNet::releaseMemory.
+ *
+ * @return False if the memory could not be allocated, or if the network has a GRU or Conv1D.
+ * */
+[[nodiscard]] auto
+sparsify(const Program& program, const Net& net, SparseNet* sparseNet) -> bool;
+
+} // namespace NN
@@ -0,0 +1,144 @@
+#include "NN_SparseNetRunner.h"
+
+#include "NN_Kernels.h"
+
+namespace NN {
+
+SparseNetRunner::SparseNetRunner(const SparseNet* net, Activations* activations)
+  : net_(net)
+  , runner_(&net->shape, activations)
+{
+}
+
+auto
+SparseNetRunner::getRegister(const uint8_t reg) -> float*
+{
+  return runner_.getRegister(reg);
+}
+
+auto
+SparseNetRunner::getRegister(const uint8_t reg, const uint16_t sample) -> float*
+{
+  return runner_.getRegister(reg, sample);
+}
+
+auto
+SparseNetRunner::getRegisterSize(const uint8_t reg) const -> FeatureSize
+{
+  return runner_.getRegisterSize(reg);
+}
+
+void
+SparseNetRunner::setBatchSize(const uint16_t batchSize)
+{
+  runner_.setBatchSize(batchSize);
+}
+
+auto
+SparseNetRunner::getBatchSize() const -> uint16_t
+{
+  return runner_.getBatchSize();
+}
+
+void
+SparseNetRunner::reset()
+{
+  runner_.reset();
+  currentReg_ = 0;
+  currentParameters_ = net_->parameters;
+  currentBlockStarts_ = net_->blockStarts;
+  currentBlockColumns_ = net_->blockColumns;
+}
+
+void
+SparseNetRunner::beginAssignment(const uint8_t dstReg)
+{
+  currentReg_ = dstReg;
+  runner_.beginAssignment(dstReg);
+}
+
+void
+SparseNetRunner::interpret(const LinearExpr& expr)
+{
+  const uint32_t numBlockRows = (static_cast<uint32_t>(expr.outFeatures) + NN_SPARSE_BLOCK_ROWS - 1) /
+                                NN_SPARSE_BLOCK_ROWS;
+  const auto numBlocks = currentBlockStarts_[numBlockRows];
+  const auto* bias = currentParameters_;
+  const auto* values = bias + expr.outFeatures;
+
+  // The indices are loaded again for each sample, but they are small enough to stay in cache.
+  const auto batchSize = runner_.getBatchSize();
+  for (uint16_t b = 0; b < batchSize; b++) {
+    sparseLinear(values,
+                 currentBlockStarts_,
+                 currentBlockColumns_,
+                 bias,
+                 runner_.getRegister(expr.inRegister, b),
+                 runner_.getRegister(currentReg_, b),
+                 expr.outFeatures,
+                 expr.activation,
+                 net_->shape.activationMode);
+  }
+
+  runner_.setRegisterSize(currentReg_, expr.outFeatures);
+
+  currentParameters_ += sparseLinearParameterCount(expr.outFeatures, numBlocks);
+  currentBlockStarts_ += numBlockRows + 1;
+  currentBlockColumns_ += numBlocks;
+}
+
+void
+SparseNetRunner::interpret(const MatMulExpr& expr)
+{
+  runner_.interpret(expr);
+}
+
+void
+SparseNetRunner::interpret(const ConcatExpr& expr)
+{
+  runner_.interpret(expr);
+}
+
+void
+SparseNetRunner::interpret(const CompAddExpr& expr)
+{
+  runner_.interpret(expr);
+}
+
+void
+SparseNetRunner::interpret(const CompMulExpr& expr)
+{
+  runner_.interpret(expr);
+}
+
+void
+SparseNetRunner::interpret(const ReLUExpr& expr)
+{
+  runner_.interpret(expr);
+}
+
+void
+SparseNetRunner::interpret(const SigmoidExpr& expr)
+{
+  runner_.interpret(expr);
+}
+
+void
+SparseNetRunner::interpret(const TanhExpr& expr)
+{
+  runner_.interpret(expr);
+}
+
+void
+SparseNetRunner::interpret(const GRUExpr&)
+{
+  // Never reached, since networks with state are not sparsified.
+}
+
+void
+SparseNetRunner::interpret(const Conv1DExpr&)
+{
+  // Never reached, since networks with state are not sparsified.
+}
+
+} // namespace NN
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "NN_Activation.h"
+#include "NN_Net.h"
+
+#include <stdint.h>
+
+namespace NN {
+
+/**
+ * @brief A network that was compiled ahead of time into C++ by the code generator.
+ *
+ * @details The generated translation unit defines one of these. Its registers live in static storage, so running it
+ *          needs no allocation, no parsing and no virtual dispatch.
+ * */
+struct StaticNet final
+{
+  /**
+   * @brief The number of floats in each register.
+   * */
+  const FeatureSize* regSizes;
+
+  /**
+   * @brief Where each register is stored. Registers that are never live at the same time may share memory.
+   * */
+  float* const* regs;
+
+  /**
+   * @brief Runs the network on the values in the input registers.
+   * */
+  void (*run)();
+};
+
+/**
+ * @brief Computes `a[0] * b[0] + a[1] * b[Stride] + ...` over a constant number of terms.
+ *
+ * @details The sum is split in halves recursively, so that the product is fully unrolled without the instantiation
+ *          depth growing faster than the logarithm of the length.
+ * */
+template<uint32_t Begin, uint32_t Count, uint32_t Stride>
+struct StaticDot final
+{
+  static inline auto run(const float* a, const float* b) -> float
+  {
+    return StaticDot<Begin, Count / 2, Stride>::run(a, b) +
+           StaticDot<Begin + Count / 2, Count - Count / 2, Stride>::run(a, b);
+  }
+};
+
+template<uint32_t Begin, uint32_t Stride>
+struct StaticDot<Begin, 1, Stride> final
+{
+  static inline auto run(const float* a, const float* b) -> float { return a[Begin] * b[Begin * Stride]; }
+};
+
+template<uint32_t Begin, uint32_t Stride>
+struct StaticDot<Begin, 0, Stride> final
+{
+  static inline auto run(const float*, const float*) -> float { return 0.0F; }
+};
+
+/**
+ * @brief A linear layer with packed weights, as laid out by @ref NetBuilder.
+ * */
+template<FeatureSize In, FeatureSize Out, Activation A, ActivationMode Mode>
+inline void
+staticLinear(const float* weights, const float* input, float* output)
+{
+  const auto* bias = weights + static_cast<uint32_t>(In) * Out;
+  for (uint32_t i = 0; i < Out; i++) {
+    output[i] = applyActivation(StaticDot<0, In, 1>::run(weights + i * In, input) + bias[i], A, Mode);
+  }
+}
+
+template<FeatureSize M, FeatureSize K, FeatureSize N, Activation A, ActivationMode Mode>
+inline void
+staticMatMul(const float* a, const float* b, float* c)
+{
+  for (uint32_t i = 0; i < M; i++) {
+    for (uint32_t j = 0; j < N; j++) {
+      c[i * N + j] = applyActivation(StaticDot<0, K, N>::run(a + i * K, b + j), A, Mode);
+    }
+  }
+}
+
+template<FeatureSize L, FeatureSize R, Activation A, ActivationMode Mode>
+inline void
+staticConcat(const float* left, const float* right, float* output)
+{
+  for (uint32_t i = 0; i < L; i++) {
+    output[i] = applyActivation(left[i], A, Mode);
+  }
+  for (uint32_t i = 0; i < R; i++) {
+    output[L + i] = applyActivation(right[i], A, Mode);
+  }
+}
+
+template<FeatureSize N, Activation A, ActivationMode Mode>
+inline void
+staticCompAdd(const float* left, const float* right, float* output)
+{
+  for (uint32_t i = 0; i < N; i++) {
+    output[i] = applyActivation(left[i] + right[i], A, Mode);
+  }
+}
+
+template<FeatureSize N, Activation A, ActivationMode Mode>
+inline void
+staticCompMul(const float* left, const float* right, float* output)
+{
+  for (uint32_t i = 0; i < N; i++) {
+    output[i] = applyActivation(left[i] * right[i], A, Mode);
+  }
+}
+
+/**
+ * @brief Computes the ReLU, Sigmoid and Tanh instructions.
+ * */
+template<FeatureSize N, Activation A, ActivationMode Mode>
+inline void
+staticActivation(const float* input, float* output)
+{
+  for (uint32_t i = 0; i < N; i++) {
+    output[i] = applyActivation(input[i], A, Mode);
+  }
+}
+
+} // namespace NN
@@ -0,0 +1,215 @@
+#include "NN_WeightFile.h"
+
+#include <string.h>
+
+namespace NN {
+
+namespace {
+
+constexpr uint32_t headerSize = 64;
+
+constexpr uint8_t magic[4]{ 'A', 'R', 'C', 'W' };
+
+auto
+alignUp(const size_t size, const size_t alignment) -> size_t
+{
+  return ((size + alignment - 1) / alignment) * alignment;
+}
+
+auto
+getSourceOffset(const uint32_t numRegs) -> uint32_t
+{
+  return headerSize + numRegs * 4;
+}
+
+auto
+getParameterOffset(const uint32_t numRegs, const uint32_t sourceSize) -> uint32_t
+{
+  return static_cast<uint32_t>(alignUp(getSourceOffset(numRegs) + sourceSize + 1, NN_WEIGHT_FILE_ALIGNMENT));
+}
+
+/**
+ * @brief Gets the number of registers up to and including the last one that is used.
+ * */
+auto
+getNumRegs(const Net& net) -> uint32_t
+{
+  uint32_t numRegs = 0;
+  for (uint32_t i = 0; i < NN_MAX_REGS; i++) {
+    numRegs = (net.regSizes[i] > 0) ? (i + 1) : numRegs;
+  }
+  return numRegs;
+}
+
+auto
+isLittleEndian() -> bool
+{
+  const uint32_t value{ 1 };
+  uint8_t bytes[4]{};
+  memcpy(bytes, &value, sizeof(value));
+  return bytes[0] == 1;
+}
+
+auto
+readU32(const uint8_t* bytes) -> uint32_t
+{
+  return static_cast<uint32_t>(bytes[0]) | (static_cast<uint32_t>(bytes[1]) << 8) |
+         (static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+}
+
+void
+writeU32(uint8_t* bytes, const uint32_t value)
+{
+  bytes[0] = static_cast<uint8_t>(value);
+  bytes[1] = static_cast<uint8_t>(value >> 8);
+  bytes[2] = static_cast<uint8_t>(value >> 16);
+  bytes[3] = static_cast<uint8_t>(value >> 24);
+}
+
+} // namespace
+
+auto
+getWeightFileSize(const Net& net, const uint32_t sourceSize) -> size_t
+{
+  return getParameterOffset(getNumRegs(net), sourceSize) + static_cast<size_t>(net.numParameters) * sizeof(float);
+}
+
+auto
+writeWeightFile(const Net& net, const char* source, const uint32_t sourceSize, void* buffer, const size_t bufferSize)
+  -> WeightFileError
+{
+  if (bufferSize < getWeightFileSize(net, sourceSize)) {
+    return WeightFileError::kBufferTooSmall;
+  }
+
+  const auto numRegs = getNumRegs(net);
+  const auto sourceOffset = getSourceOffset(numRegs);
+  const auto parameterOffset = getParameterOffset(numRegs, sourceSize);
+
+  auto* bytes = static_cast<uint8_t*>(buffer);
+  memset(bytes, 0, parameterOffset);
+  memcpy(bytes, magic, sizeof(magic));
+  writeU32(bytes + 4, NN_WEIGHT_FILE_VERSION);
+  writeU32(bytes + 8, headerSize);
+  writeU32(bytes + 12, net.numParameters);
+  writeU32(bytes + 16, sourceOffset);
+  writeU32(bytes + 20, sourceSize);
+  writeU32(bytes + 24, parameterOffset);
+  bytes[28] = static_cast<uint8_t>(net.weightLayout);
+  bytes[29] = static_cast<uint8_t>(net.activationMode);
+  bytes[30] = static_cast<uint8_t>(numRegs);
+  bytes[31] = static_cast<uint8_t>(numRegs >> 8);
+  writeU32(bytes + 32, net.stateSize);
+  for (uint32_t i = 0; i < numRegs; i++) {
+    writeU32(bytes + headerSize + i * 4, net.regSizes[i]);
+  }
+
+  memcpy(bytes + sourceOffset, source, sourceSize);
+
+  auto* parameters = bytes + parameterOffset;
+  for (uint32_t i = 0; i < net.numParameters; i++) {
+    uint32_t value{};
+    memcpy(&value, &net.parameters[i], sizeof(value));
+    writeU32(parameters + i * sizeof(float), value);
+  }
+
+  return WeightFileError::kNone;
+}
+
+auto
+openWeightFile(const void* data, const size_t size, WeightFile* file) -> WeightFileError
+{
+  const auto* bytes = static_cast<const uint8_t*>(data);
+
+  if (size < headerSize) {
+    return WeightFileError::kTruncated;
+  }
+
+  if (memcmp(bytes, magic, sizeof(magic)) != 0) {
+    return WeightFileError::kBadMagic;
+  }
+
+  if (readU32(bytes + 4) != NN_WEIGHT_FILE_VERSION) {
+    return WeightFileError::kUnsupportedVersion;
+  }
+
+  const auto numParameters = readU32(bytes + 12);
+  const auto sourceOffset = readU32(bytes + 16);
+  const auto sourceSize = readU32(bytes + 20);
+  const auto parameterOffset = readU32(bytes + 24);
+  const auto layout = bytes[28];
+  const auto mode = bytes[29];
+  const auto numRegs = static_cast<uint32_t>(bytes[30]) | (static_cast<uint32_t>(bytes[31]) << 8);
+
+  if ((readU32(bytes + 8) != headerSize) || (sourceOffset != getSourceOffset(numRegs)) ||
+      (layout > static_cast<uint8_t>(WeightLayout::kPadded)) || (mode > static_cast<uint8_t>(ActivationMode::kFast))) {
+    return WeightFileError::kInvalidHeader;
+  }
+
+  if ((sourceOffset >= size) || (sourceSize >= size - sourceOffset)) {
+    return WeightFileError::kTruncated;
+  }
+
+  if ((parameterOffset != getParameterOffset(numRegs, sourceSize)) || (bytes[sourceOffset + sourceSize] != 0)) {
+    return WeightFileError::kInvalidHeader;
+  }
+
+  if ((parameterOffset > size) || ((size - parameterOffset) / sizeof(float) < numParameters)) {
+    return WeightFileError::kTruncated;
+  }
+
+  if ((numRegs > NN_MAX_REGS) || (sourceSize > maxSourceSize)) {
+    return WeightFileError::kTooLarge;
+  }
+
+  for (uint32_t i = 0; i < numRegs; i++) {
+    if (readU32(bytes + headerSize + i * 4) > maxFeatures) {
+      return WeightFileError::kTooLarge;
+    }
+  }
+
+  if (!isLittleEndian()) {
+    return WeightFileError::kWrongByteOrder;
+  }
+
+  const auto* parameters = bytes + parameterOffset;
+  const auto alignment = (static_cast<WeightLayout>(layout) == WeightLayout::kPadded)
+                           ? static_cast<uintptr_t>(NN_ROW_ALIGNMENT * sizeof(float))
+                           : static_cast<uintptr_t>(sizeof(float));
+  if ((reinterpret_cast<uintptr_t>(parameters) % alignment) != 0) {
+    return WeightFileError::kMisaligned;
+  }
+
+  file->source = reinterpret_cast<const char*>(bytes + sourceOffset);
+  file->sourceSize = sourceSize;
+  file->parameters = reinterpret_cast<const float*>(parameters);
+  file->numParameters = numParameters;
+  file->stateSize = readU32(bytes + 32);
+  file->weightLayout = static_cast<WeightLayout>(layout);
+  file->activationMode = static_cast<ActivationMode>(mode);
+  for (uint32_t i = 0; i < NN_MAX_REGS; i++) {
+    file->regSizes[i] = (i < numRegs) ? static_cast<FeatureSize>(readU32(bytes + headerSize + i * 4)) : 0;
+  }
+
+  return WeightFileError::kNone;
+}
+
+void
+bindWeightFile(const WeightFile& file, Net* net)
+{
+  net->numParameters = file.numParameters;
+  net->stateSize = file.stateSize;
+  net->weightLayout = file.weightLayout;
+  net->activationMode = file.activationMode;
+  net->parameters = const_cast<float*>(file.parameters);
+  net->state = nullptr;
+  net->memory = nullptr;
+  net->arenaSize = 0;
+  for (uint8_t i = 0; i < NN_MAX_REGS; i++) {
+    net->regSizes[i] = file.regSizes[i];
+    net->regs[i] = nullptr;
+  }
+  net->assignRegisters();
+}
+
+} // namespace NN
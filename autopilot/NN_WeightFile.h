@@ -0,0 +1,128 @@
+#pragma once
+
+#include "NN_Net.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief The version of the weight file format that is written, and the only one that can be read.
+ * */
+#define NN_WEIGHT_FILE_VERSION 3
+
+/**
+ * @brief The alignment of the parameters in a weight file, in bytes, relative to the start of the file.
+ * */
+#define NN_WEIGHT_FILE_ALIGNMENT 64
+
+namespace NN {
+
+/**
+ * @brief A weight file holds everything needed to run a trained network: the program text, the register sizes and the
+ *        parameters.
+ *
+ * @details The layout is:
+ *
+ *          | Offset            | Size                 | Contents                                            |
+ *          |-------------------|----------------------|-----------------------------------------------------|
+ *          | 0                 | 4                    | The magic bytes "ARCW"                              |
+ *          | 4                 | 4                    | The version                                         |
+ *          | 8                 | 4                    | The size of the header (64)                         |
+ *          | 12                | 4                    | The number of parameters                            |
+ *          | 16                | 4                    | Where the program text starts                       |
+ *          | 20                | 4                    | The size of the program text, without the null      |
+ *          | 24                | 4                    | Where the parameters start                          |
+ *          | 28                | 1                    | The @ref WeightLayout                               |
+ *          | 29                | 1                    | The @ref ActivationMode                             |
+ *          | 30                | 2                    | The number of registers in the register table       |
+ *          | 32                | 4                    | The number of floats of state in each sample        |
+ *          | 36                | 28                   | Reserved, zero                                      |
+ *          | 64                | 4 * registers        | The size of each register                           |
+ *          | text offset       | text size + 1        | The program text, followed by a null                |
+ *          | parameter offset  | 4 * parameters       | The parameters, as 32-bit floats                    |
+ *
+ *          Every number is little-endian. The parameters start on a multiple of @ref NN_WEIGHT_FILE_ALIGNMENT, so a
+ *          file that is mapped into memory, or stored as an aligned constant array, can be used without copying it.
+ *
+ *          The register table only goes up to the last register that is used. A file written by a build in the wide
+ *          index mode can be read by a compact build, as long as the network fits in it. See @ref NN_WIDE_INDEX.
+ * */
+struct WeightFile final
+{
+  const char* source{};
+
+  uint32_t sourceSize{};
+
+  const float* parameters{};
+
+  uint32_t numParameters{};
+
+  /**
+   * @brief The floats kept by the GRU and Conv1D instructions of each sample. See @ref Net::stateSize.
+   * */
+  uint32_t stateSize{};
+
+  WeightLayout weightLayout{ WeightLayout::kPacked };
+
+  ActivationMode activationMode{ ActivationMode::kPrecise };
+
+  FeatureSize regSizes[NN_MAX_REGS]{};
+};
+
+enum class WeightFileError : uint8_t
+{
+  kNone,
+  kTruncated,
+  kBadMagic,
+  kUnsupportedVersion,
+  kInvalidHeader,
+  /**
+   * @brief The parameters do not start on a float boundary, or on a row boundary for the padded layout.
+   * */
+  kMisaligned,
+  /**
+   * @brief The parameters can only be used in place on a little-endian machine.
+   * */
+  kWrongByteOrder,
+  kBufferTooSmall,
+  /**
+   * @brief The program text, a register or the number of registers is larger than this build can hold.
+   * */
+  kTooLarge
+};
+
+/**
+ * @brief Gets the number of bytes that a network and its program take up in a weight file.
+ * */
+[[nodiscard]] auto
+getWeightFileSize(const Net& net, uint32_t sourceSize) -> size_t;
+
+/**
+ * @brief Writes a network and the program that it was built from into a buffer.
+ *
+ * @param buffer Where to write the file. It must have room for @ref getWeightFileSize bytes.
+ * */
+[[nodiscard]] auto
+writeWeightFile(const Net& net, const char* source, uint32_t sourceSize, void* buffer, size_t bufferSize)
+  -> WeightFileError;
+
+/**
+ * @brief Checks the header of a weight file and points into its contents. Nothing is copied.
+ *
+ * @param data The start of the file. The parameters are used in place, so the data has to stay valid while they are
+ *             in use, and it has to be aligned to @ref NN_WEIGHT_FILE_ALIGNMENT for the padded layout.
+ * */
+[[nodiscard]] auto
+openWeightFile(const void* data, size_t size, WeightFile* file) -> WeightFileError;
+
+/**
+ * @brief Sets up a network to run on the parameters of a weight file, without copying them.
+ *
+ * @details The network does not own any memory afterwards, and has no registers. Run it with a @ref NetRunner that is
+ *          given its own @ref Activations. The batch size of the network has to be set before this is called. If the
+ *          file is read-only, as it is when mapped read-only or stored in flash, the parameters must not be written.
+ * */
+void
+bindWeightFile(const WeightFile& file, Net* net);
+
+} // namespace NN
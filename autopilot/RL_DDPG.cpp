@@ -1,21 +1,19 @@
 #include "RL_DDPG.h"
 
-#include "NN_Parser.h"
-
 #include <string.h>
 
 namespace RL {
 
-DDPGPolicy::DDPGPolicy(const NN::Net* net, const char* source, const uint16_t sourceLength)
+DDPGPolicy::DDPGPolicy(const NN::Net* net, const NN::Program* program)
   : runner_(net)
-  , source_(source)
-  , sourceLength_(sourceLength)
+  , program_(program)
 {
 }
 
 void
 DDPGPolicy::reset()
 {
+  runner_.clearState();
 }
 
 void
@@ -27,13 +25,32 @@ DDPGPolicy::computeAction(const State& state, Action& action)
 
   runner_.reset();
 
-  const auto err = NN::exec(source_, sourceLength_, runner_);
-  if (err != NN::SyntaxError::kNone) {
-    return;
-  }
+  NN::exec(*program_, runner_);
 
   auto* output = runner_.getRegister(3);
   memcpy(action.actuators, output, sizeof(action.actuators));
 }
 
+StaticDDPGPolicy::StaticDDPGPolicy(const NN::StaticNet* net)
+  : net_(net)
+{
+}
+
+void
+StaticDDPGPolicy::reset()
+{
+}
+
+void
+StaticDDPGPolicy::computeAction(const State& state, Action& action)
+{
+  memcpy(net_->regs[0], state.rotation, sizeof(state.rotation));
+  net_->regs[1][0] = state.altitudeError;
+  memcpy(net_->regs[2], state.speedError, sizeof(state.speedError));
+
+  net_->run();
+
+  memcpy(action.actuators, net_->regs[3], sizeof(action.actuators));
+}
+
 } // namespace RL
@@ -4,6 +4,8 @@
 
 #include "NN_Net.h"
 #include "NN_NetRunner.h"
+#include "NN_Program.h"
+#include "NN_Static.h"
 
 namespace RL {
 
@@ -25,11 +27,9 @@ public:
    *
    * @param net The network to compute the action with.
    *
-   * @param source The source code of the network.
-   *
-   * @param sourceLength The length of the network source code.
+   * @param program The compiled source code of the network.
    * */
-  DDPGPolicy(const NN::Net* net, const char* source, uint16_t sourceLength);
+  DDPGPolicy(const NN::Net* net, const NN::Program* program);
 
   void reset() override;
 
@@ -38,9 +38,31 @@ public:
 private:
   NN::NetRunner runner_;
 
-  const char* source_{};
+  const NN::Program* program_{};
+};
 
-  const uint16_t sourceLength_{};
+/**
+ * @brief The same policy as @ref DDPGPolicy, with a network that was compiled ahead of time by the code generator.
+ *
+ * @details The network reads the state from the same registers, and writes the action to the same register. Generate
+ *          it with `nn-codegen --input 0:9 --input 1:1 --input 2:2 --output 3`.
+ * */
+class StaticDDPGPolicy final : public Policy
+{
+public:
+  /**
+   * @brief Constructs a new policy instance.
+   *
+   * @param net The generated network, which is declared with `extern const NN::StaticNet name;`.
+   * */
+  explicit StaticDDPGPolicy(const NN::StaticNet* net);
+
+  void reset() override;
+
+  void computeAction(const State& state, Action& action) override;
+
+private:
+  const NN::StaticNet* net_{};
 };
 
 } // namespace RL
@@ -0,0 +1,72 @@
+#include <benchmark/benchmark.h>
+
+#include <NN_Kernels.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+auto
+randomInputs(const size_t size) -> std::vector<float>
+{
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(-8, 8);
+  std::vector<float> v(size);
+  for (auto& x : v) {
+    x = dist(rng);
+  }
+  return v;
+}
+
+/**
+ * @brief Applies an activation to a vector in place. The arguments are the size, the activation and the mode.
+ * */
+void
+BM_Activation(benchmark::State& state)
+{
+  const auto n = static_cast<uint32_t>(state.range(0));
+  const auto activation = static_cast<NN::Activation>(state.range(1));
+  const auto mode = static_cast<NN::ActivationMode>(state.range(2));
+  const auto input = randomInputs(n);
+  std::vector<float> output(n);
+  for (auto _ : state) {
+    NN::activate(input.data(), output.data(), n, activation, mode);
+    benchmark::DoNotOptimize(output.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(n) * state.iterations());
+}
+
+/**
+ * @brief The same work as BM_Activation with the C library's expf, for comparison.
+ * */
+void
+BM_ActivationLibm(benchmark::State& state)
+{
+  const auto n = static_cast<uint32_t>(state.range(0));
+  const auto activation = static_cast<NN::Activation>(state.range(1));
+  const auto input = randomInputs(n);
+  std::vector<float> output(n);
+  for (auto _ : state) {
+    if (activation == NN::Activation::kSigmoid) {
+      for (uint32_t i = 0; i < n; i++) {
+        output[i] = 1.0F / (1.0F + std::exp(-input[i]));
+      }
+    } else {
+      for (uint32_t i = 0; i < n; i++) {
+        output[i] = std::tanh(input[i]);
+      }
+    }
+    benchmark::DoNotOptimize(output.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(n) * state.iterations());
+}
+
+} // namespace
+
+BENCHMARK(BM_Activation)->ArgsProduct({ { 4096 }, { 2, 3 }, { 0, 1 } });
+
+BENCHMARK(BM_ActivationLibm)->ArgsProduct({ { 4096 }, { 2, 3 } });
@@ -0,0 +1,83 @@
+#include <benchmark/benchmark.h>
+
+#include <NN_Lexer.h>
+#include <NN_Parser.h>
+#include <NN_Program.h>
+#include <NN_RegCounter.h>
+
+#include <string>
+
+namespace {
+
+/**
+ * @brief A program of alternating Linear and Tanh layers, which is what most of the networks look like.
+ * */
+auto
+makeSource(const int numLayers) -> std::string
+{
+  std::string source;
+  for (int i = 0; i < numLayers; i++) {
+    const auto in = std::to_string((2 * i) % 15);
+    const auto hidden = std::to_string((2 * i) % 15 + 1);
+    const auto out = std::to_string((2 * i + 2) % 15);
+    source += "%" + hidden + " = Linear 64 64 %" + in + "\n";
+    source += "%" + out + " = Tanh %" + hidden + "\n";
+  }
+  return source;
+}
+
+void
+setCounters(benchmark::State& state, const std::string& source)
+{
+  state.SetBytesProcessed(static_cast<int64_t>(source.size()) * state.iterations());
+  state.counters["lines/s"] = benchmark::Counter(2.0 * state.range(0), benchmark::Counter::kIsIterationInvariantRate);
+}
+
+void
+BM_Lex(benchmark::State& state)
+{
+  const auto source = makeSource(static_cast<int>(state.range(0)));
+  for (auto _ : state) {
+    NN::Lexer lexer(source.c_str(), static_cast<uint16_t>(source.size()));
+    uint32_t numTokens{};
+    while (lexer.lex().kind != NN::TokenKind::kNone) {
+      numTokens++;
+    }
+    benchmark::DoNotOptimize(numTokens);
+  }
+  setCounters(state, source);
+}
+
+/**
+ * @brief Parses into the register counter, which does almost no work of its own.
+ * */
+void
+BM_Parse(benchmark::State& state)
+{
+  const auto source = makeSource(static_cast<int>(state.range(0)));
+  for (auto _ : state) {
+    NN::Lexer lexer(source.c_str(), static_cast<uint16_t>(source.size()));
+    NN::RegCounter counter;
+    NN::Parser parser(&counter);
+    benchmark::DoNotOptimize(parser.parse(lexer));
+  }
+  setCounters(state, source);
+}
+
+void
+BM_Compile(benchmark::State& state)
+{
+  const auto source = makeSource(static_cast<int>(state.range(0)));
+  for (auto _ : state) {
+    NN::Program program;
+    benchmark::DoNotOptimize(NN::compile(source.c_str(), static_cast<uint16_t>(source.size()), &program));
+    program.releaseMemory();
+  }
+  setCounters(state, source);
+}
+
+} // namespace
+
+BENCHMARK(BM_Lex)->Arg(8)->Arg(128);
+BENCHMARK(BM_Parse)->Arg(8)->Arg(128);
+BENCHMARK(BM_Compile)->Arg(8)->Arg(128);
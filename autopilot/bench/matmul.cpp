@@ -0,0 +1,127 @@
+#include <benchmark/benchmark.h>
+
+#include <NN_Kernels.h>
+
+#include <random>
+#include <vector>
+
+namespace {
+
+auto
+randomVector(const size_t size) -> std::vector<float>
+{
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(-1, 1);
+  std::vector<float> v(size);
+  for (auto& x : v) {
+    x = dist(rng);
+  }
+  return v;
+}
+
+void
+setCounters(benchmark::State& state, const double flops, const double bytes)
+{
+  state.counters["FLOP/s"] = benchmark::Counter(flops, benchmark::Counter::kIsIterationInvariantRate);
+  state.SetBytesProcessed(static_cast<int64_t>(bytes * static_cast<double>(state.iterations())));
+}
+
+/**
+ * @brief A vector-matrix product through MatMul, which is the same work as a Linear layer without the bias.
+ * */
+void
+BM_MatMulVector(benchmark::State& state)
+{
+  const auto k = static_cast<uint32_t>(state.range(0));
+  const auto n = static_cast<uint32_t>(state.range(1));
+  const auto a = randomVector(k);
+  const auto b = randomVector(static_cast<size_t>(k) * n);
+  std::vector<float> c(n);
+  for (auto _ : state) {
+    NN::matMul(a.data(), b.data(), c.data(), 1, k, n);
+    benchmark::DoNotOptimize(c.data());
+    benchmark::ClobberMemory();
+  }
+  setCounters(state, 2.0 * k * n, (static_cast<double>(k) * n + k + n) * sizeof(float));
+}
+
+void
+BM_LinearVector(benchmark::State& state)
+{
+  const auto k = static_cast<uint32_t>(state.range(0));
+  const auto n = static_cast<uint32_t>(state.range(1));
+  const auto input = randomVector(k);
+  const auto weights = randomVector(static_cast<size_t>(k) * n);
+  const auto bias = randomVector(n);
+  std::vector<float> output(n);
+  for (auto _ : state) {
+    NN::linear(weights.data(),
+               bias.data(),
+               input.data(),
+               output.data(),
+               k,
+               n,
+               k,
+               NN::Activation::kNone,
+               NN::ActivationMode::kPrecise);
+    benchmark::DoNotOptimize(output.data());
+    benchmark::ClobberMemory();
+  }
+  setCounters(state, 2.0 * k * n, (static_cast<double>(k) * n + k + 2 * n) * sizeof(float));
+}
+
+/**
+ * @brief A matrix product of M rows, against a Linear layer applied to a batch of M samples.
+ * */
+void
+BM_MatMulMatrix(benchmark::State& state)
+{
+  const auto m = static_cast<uint32_t>(state.range(0));
+  const auto k = static_cast<uint32_t>(state.range(1));
+  const auto n = static_cast<uint32_t>(state.range(2));
+  const auto a = randomVector(static_cast<size_t>(m) * k);
+  const auto b = randomVector(static_cast<size_t>(k) * n);
+  std::vector<float> c(static_cast<size_t>(m) * n);
+  for (auto _ : state) {
+    NN::matMul(a.data(), b.data(), c.data(), m, k, n);
+    benchmark::DoNotOptimize(c.data());
+    benchmark::ClobberMemory();
+  }
+  setCounters(state, 2.0 * m * k * n, (static_cast<double>(m) * k + static_cast<double>(k) * n + m * n) * sizeof(float));
+}
+
+void
+BM_LinearBatch(benchmark::State& state)
+{
+  const auto m = static_cast<uint32_t>(state.range(0));
+  const auto k = static_cast<uint32_t>(state.range(1));
+  const auto n = static_cast<uint32_t>(state.range(2));
+  const auto input = randomVector(static_cast<size_t>(m) * k);
+  const auto weights = randomVector(static_cast<size_t>(k) * n);
+  const auto bias = randomVector(n);
+  std::vector<float> output(static_cast<size_t>(m) * n);
+  for (auto _ : state) {
+    NN::linearBatch(weights.data(),
+                    bias.data(),
+                    input.data(),
+                    k,
+                    output.data(),
+                    n,
+                    k,
+                    n,
+                    k,
+                    m,
+                    NN::Activation::kNone,
+                    NN::ActivationMode::kPrecise);
+    benchmark::DoNotOptimize(output.data());
+    benchmark::ClobberMemory();
+  }
+  setCounters(state, 2.0 * m * k * n, (static_cast<double>(m) * k + static_cast<double>(k) * n + m * n) * sizeof(float));
+}
+
+} // namespace
+
+BENCHMARK(BM_MatMulVector)->Args({ 64, 64 })->Args({ 256, 256 })->Args({ 1024, 1024 });
+BENCHMARK(BM_LinearVector)->Args({ 64, 64 })->Args({ 256, 256 })->Args({ 1024, 1024 });
+BENCHMARK(BM_MatMulMatrix)->Args({ 16, 64, 64 })->Args({ 64, 256, 256 })->Args({ 128, 512, 512 });
+BENCHMARK(BM_LinearBatch)->Args({ 16, 64, 64 })->Args({ 64, 256, 256 })->Args({ 128, 512, 512 });
@@ -0,0 +1,202 @@
+#include <benchmark/benchmark.h>
+
+#include <NN_IncrementalEvaluator.h>
+#include <NN_Loss.h>
+#include <NN_NetBuilder.h>
+#include <NN_NetRunner.h>
+#include <NN_Optim.h>
+#include <NN_Parser.h>
+#include <NN_Program.h>
+
+#include <ThreadPool.h>
+
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr uint16_t numSamples = 64;
+
+struct Dataset final
+{
+  NN::Program program;
+
+  std::vector<float> inputs;
+
+  std::vector<float> targets;
+};
+
+auto
+datasetLoss(void* dataPtr, const NN::Net& net) -> float
+{
+  const auto* data = static_cast<const Dataset*>(dataPtr);
+  NN::NetRunner runner(&net);
+  runner.setBatchSize(numSamples);
+  runner.reset();
+  for (uint16_t b = 0; b < numSamples; b++) {
+    for (uint16_t i = 0; i < 32; i++) {
+      runner.getRegister(0, b)[i] = data->inputs[b * 32 + i];
+    }
+  }
+  NN::exec(data->program, runner);
+  float loss{};
+  for (uint16_t b = 0; b < numSamples; b++) {
+    loss += NN::mseLoss(runner.getRegister(3, b), &data->targets[b], 1);
+  }
+  return loss / numSamples;
+}
+
+auto
+outputLoss(void* dataPtr, const NN::Net& net) -> float
+{
+  const auto* data = static_cast<const Dataset*>(dataPtr);
+  float loss{};
+  for (uint16_t b = 0; b < numSamples; b++) {
+    loss += NN::mseLoss(net.regs[3] + b * net.regSizes[3], &data->targets[b], 1);
+  }
+  return loss / numSamples;
+}
+
+auto
+randomInt(void* rngPtr, const int32_t minValue, const int32_t maxValue) -> int32_t
+{
+  std::uniform_int_distribution<int32_t> dist(minValue, maxValue - 1);
+  return dist(*static_cast<std::mt19937*>(rngPtr));
+}
+
+auto
+randomFloat(void* rngPtr, const float minValue, const float maxValue) -> float
+{
+  std::uniform_real_distribution<float> dist(minValue, maxValue);
+  return dist(*static_cast<std::mt19937*>(rngPtr));
+}
+
+/**
+ * @brief Steps of a population of candidates, on a given number of threads. The candidates per second is the number
+ *        to compare against a population of one.
+ * */
+void
+setup(Dataset* data, NN::Net* net)
+{
+  const char src[] = "%1 = Linear 32 64 %0\n"
+                     "%2 = Tanh %1\n"
+                     "%3 = Linear 64 1 %2\n";
+  (void)NN::compile(src, sizeof(src) - 1, &data->program);
+
+  net->batchSize = numSamples;
+  NN::NetBuilder builder(net, 32);
+  NN::exec(data->program, builder);
+  (void)builder.finish();
+
+  std::mt19937 rng(0);
+  std::normal_distribution<float> dist(0.0F, 0.5F);
+  for (uint32_t i = 0; i < net->numParameters; i++) {
+    net->parameters[i] = dist(rng);
+  }
+  for (uint32_t i = 0; i < numSamples * 32; i++) {
+    data->inputs.push_back(dist(rng));
+  }
+  for (uint32_t i = 0; i < numSamples; i++) {
+    data->targets.push_back(dist(rng));
+  }
+}
+
+void
+BM_LSOptimizerStep(benchmark::State& state)
+{
+  const auto populationSize = static_cast<uint32_t>(state.range(0));
+  const auto numThreads = static_cast<uint32_t>(state.range(1));
+
+  Dataset data;
+  NN::Net net;
+  setup(&data, &net);
+  std::mt19937 rng(0);
+
+  NN::ThreadPool pool(numThreads);
+  NN::LSOptimizer optimizer(&net, 16);
+  optimizer.setPopulation(populationSize, &pool, NN::ThreadPool::parallelFor);
+  (void)optimizer.allocMemory();
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(optimizer.step(&rng, randomInt, randomFloat, &data, datasetLoss));
+  }
+
+  state.counters["candidates/s"] = benchmark::Counter(populationSize, benchmark::Counter::kIsIterationInvariantRate);
+
+  optimizer.releaseMemory();
+  net.releaseMemory();
+  data.program.releaseMemory();
+}
+
+/**
+ * @brief Single steps that only re-run the layers downstream of the perturbed weights. Most weights of this network
+ *        are in the first layer, so the saving is largest when the last layer is perturbed.
+ * */
+void
+BM_LSOptimizerStepIncremental(benchmark::State& state)
+{
+  Dataset data;
+  NN::Net net;
+  setup(&data, &net);
+  std::mt19937 rng(0);
+
+  NN::IncrementalEvaluator evaluator(&net, &data.program);
+  evaluator.markOutput(3);
+  (void)evaluator.allocMemory();
+  evaluator.setBatchSize(numSamples);
+  for (uint16_t b = 0; b < numSamples; b++) {
+    for (uint16_t i = 0; i < 32; i++) {
+      evaluator.getRegister(0, b)[i] = data.inputs[b * 32 + i];
+    }
+  }
+  (void)evaluator.evaluate(&data, outputLoss);
+
+  NN::LSOptimizer optimizer(&net, 16);
+  (void)optimizer.allocMemory();
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(optimizer.step(&rng, randomInt, randomFloat, &evaluator, &data, outputLoss));
+  }
+
+  optimizer.releaseMemory();
+  evaluator.releaseMemory();
+  net.releaseMemory();
+  data.program.releaseMemory();
+}
+
+/**
+ * @brief Steps of evolution strategies with a given number of mirrored pairs and threads. Each step evaluates two
+ *        members per pair.
+ * */
+void
+BM_ESOptimizerStep(benchmark::State& state)
+{
+  const auto numPairs = static_cast<uint32_t>(state.range(0));
+  const auto numThreads = static_cast<uint32_t>(state.range(1));
+
+  Dataset data;
+  NN::Net net;
+  setup(&data, &net);
+  std::mt19937 rng(0);
+
+  NN::ThreadPool pool(numThreads);
+  NN::ESOptimizer optimizer(&net, numPairs);
+  optimizer.setParallel(&pool, NN::ThreadPool::parallelFor);
+  (void)optimizer.allocMemory();
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(optimizer.step(&rng, randomInt, &data, datasetLoss));
+  }
+
+  state.counters["members/s"] = benchmark::Counter(2 * numPairs, benchmark::Counter::kIsIterationInvariantRate);
+
+  optimizer.releaseMemory();
+  net.releaseMemory();
+  data.program.releaseMemory();
+}
+
+} // namespace
+
+BENCHMARK(BM_LSOptimizerStepIncremental);
+BENCHMARK(BM_ESOptimizerStep)->Args({ 8, 1 })->Args({ 8, 4 })->UseRealTime();
+BENCHMARK(BM_LSOptimizerStep)->Args({ 1, 1 })->Args({ 8, 1 })->Args({ 8, 4 })->Args({ 32, 8 })->UseRealTime();
@@ -0,0 +1,92 @@
+#include <benchmark/benchmark.h>
+
+#include <NN_Kernels.h>
+
+#include <random>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief The same layer as BM_LinearVector, on int8 weights and inputs.
+ * */
+void
+BM_LinearInt8(benchmark::State& state)
+{
+  const auto k = static_cast<uint32_t>(state.range(0));
+  const auto n = static_cast<uint32_t>(state.range(1));
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<int> dist(-127, 127);
+  std::vector<int8_t> weights(static_cast<size_t>(k) * n);
+  std::vector<int8_t> input(k);
+  for (auto& w : weights) {
+    w = static_cast<int8_t>(dist(rng));
+  }
+  for (auto& x : input) {
+    x = static_cast<int8_t>(dist(rng));
+  }
+  const std::vector<int32_t> bias(n, 0);
+  const std::vector<float> multipliers(n, 0.0001F);
+  std::vector<int8_t> output(n);
+  for (auto _ : state) {
+    NN::linearInt8(weights.data(), bias.data(), multipliers.data(), input.data(), output.data(), k, n, -127);
+    benchmark::DoNotOptimize(output.data());
+    benchmark::ClobberMemory();
+  }
+  state.counters["OP/s"] = benchmark::Counter(2.0 * k * n, benchmark::Counter::kIsIterationInvariantRate);
+  state.SetBytesProcessed(static_cast<int64_t>((static_cast<double>(k) * n + k + n) * state.iterations()));
+}
+
+/**
+ * @brief The same layer as BM_LinearVector, with 16 bit float weights. The third argument is zero for binary16 and one
+ *        for bfloat16.
+ * */
+void
+BM_LinearHalf(benchmark::State& state)
+{
+  const auto k = static_cast<uint32_t>(state.range(0));
+  const auto n = static_cast<uint32_t>(state.range(1));
+  const auto format = state.range(2) ? NN::HalfFormat::kBFloat16 : NN::HalfFormat::kFloat16;
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(-1, 1);
+  std::vector<uint16_t> weights(static_cast<size_t>(k) * n);
+  std::vector<uint16_t> bias(n);
+  std::vector<float> input(k);
+  for (auto& w : weights) {
+    w = NN::floatToHalf(dist(rng), format);
+  }
+  for (auto& b : bias) {
+    b = NN::floatToHalf(dist(rng), format);
+  }
+  for (auto& x : input) {
+    x = dist(rng);
+  }
+  std::vector<float> output(n);
+  for (auto _ : state) {
+    NN::linearHalf(weights.data(),
+                   bias.data(),
+                   input.data(),
+                   output.data(),
+                   k,
+                   n,
+                   k,
+                   format,
+                   NN::Activation::kNone,
+                   NN::ActivationMode::kPrecise);
+    benchmark::DoNotOptimize(output.data());
+    benchmark::ClobberMemory();
+  }
+  state.counters["FLOP/s"] = benchmark::Counter(2.0 * k * n, benchmark::Counter::kIsIterationInvariantRate);
+  const auto bytes = (static_cast<double>(k) * n + n) * sizeof(uint16_t) + (static_cast<double>(k) + n) * sizeof(float);
+  state.SetBytesProcessed(static_cast<int64_t>(bytes * static_cast<double>(state.iterations())));
+}
+
+} // namespace
+
+BENCHMARK(BM_LinearHalf)
+  ->Args({ 256, 256, 0 })
+  ->Args({ 1024, 1024, 0 })
+  ->Args({ 2048, 2048, 0 })
+  ->Args({ 1024, 1024, 1 })
+  ->Args({ 2048, 2048, 1 });
+BENCHMARK(BM_LinearInt8)->Args({ 64, 64 })->Args({ 256, 256 })->Args({ 1024, 1024 });
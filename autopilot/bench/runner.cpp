@@ -0,0 +1,349 @@
+#include <benchmark/benchmark.h>
+
+#include <NN_NetBuilder.h>
+#include <NN_NetRunner.h>
+#include <NN_Parser.h>
+#include <NN_Program.h>
+#include <NN_Sparse.h>
+#include <NN_SparseNetRunner.h>
+#include <RL_DDPG.h>
+
+#include <ThreadPool.h>
+
+#include <random>
+#include <string>
+
+namespace {
+
+/**
+ * @brief A network of a single instruction, run through the interpreter the same way a whole program is.
+ * */
+class Layer final
+{
+public:
+  /**
+   * @param sizes The sizes of the input registers %0, %1 and %2. Registers of size zero are not inputs.
+   * */
+  Layer(const std::string& source, const uint16_t (&sizes)[3], const uint16_t batchSize)
+    : runner_(&net_)
+  {
+    (void)NN::compile(source.c_str(), static_cast<uint16_t>(source.size()), &program_);
+    net_.batchSize = batchSize;
+    NN::NetBuilder builder(&net_, sizes[0]);
+    net_.regSizes[1] = sizes[1];
+    net_.regSizes[2] = sizes[2];
+    NN::exec(program_, builder);
+    (void)builder.finish();
+
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<float> dist(-1, 1);
+    for (uint32_t i = 0; i < net_.numParameters; i++) {
+      net_.parameters[i] = dist(rng);
+    }
+    for (uint8_t r = 0; r < 3; r++) {
+      for (uint32_t i = 0; i < static_cast<uint32_t>(sizes[r]) * batchSize; i++) {
+        net_.regs[r][i] = dist(rng);
+      }
+    }
+    runner_.setBatchSize(batchSize);
+  }
+
+  ~Layer()
+  {
+    net_.releaseMemory();
+    program_.releaseMemory();
+  }
+
+  Layer(const Layer&) = delete;
+
+  auto operator=(const Layer&) -> Layer& = delete;
+
+  /**
+   * @brief Splits large Linear layers over a pool, with no size threshold.
+   * */
+  void setParallel(NN::ThreadPool* pool) { runner_.setParallel(pool, NN::ThreadPool::parallelFor, 0); }
+
+  void run()
+  {
+    runner_.reset();
+    NN::exec(program_, runner_);
+    benchmark::DoNotOptimize(net_.regs[3]);
+    benchmark::ClobberMemory();
+  }
+
+private:
+  NN::Program program_;
+
+  NN::Net net_;
+
+  NN::NetRunner runner_;
+};
+
+void
+setCounters(benchmark::State& state, const double flops, const double bytes)
+{
+  if (flops > 0) {
+    state.counters["FLOP/s"] = benchmark::Counter(flops, benchmark::Counter::kIsIterationInvariantRate);
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(bytes * static_cast<double>(state.iterations())));
+}
+
+/**
+ * @brief A Linear layer. The arguments are the input features, the output features and the batch size.
+ * */
+void
+BM_RunLinear(benchmark::State& state)
+{
+  const auto k = static_cast<uint16_t>(state.range(0));
+  const auto n = static_cast<uint16_t>(state.range(1));
+  const auto batchSize = static_cast<uint16_t>(state.range(2));
+  Layer layer("%3 = Linear " + std::to_string(k) + " " + std::to_string(n) + " %0\n", { k, 0, 0 }, batchSize);
+  for (auto _ : state) {
+    layer.run();
+  }
+  const auto weights = static_cast<double>(k) * n + n;
+  setCounters(state, 2.0 * k * n * batchSize, (weights + (static_cast<double>(k) + n) * batchSize) * sizeof(float));
+}
+
+/**
+ * @brief A Linear layer for one sample, split over a thread pool. The arguments are the input features, the output
+ *        features and the number of threads. Compare with BM_RunLinear.
+ * */
+void
+BM_RunLinearParallel(benchmark::State& state)
+{
+  const auto k = static_cast<uint16_t>(state.range(0));
+  const auto n = static_cast<uint16_t>(state.range(1));
+  NN::ThreadPool pool(static_cast<uint32_t>(state.range(2)));
+  Layer layer("%3 = Linear " + std::to_string(k) + " " + std::to_string(n) + " %0\n", { k, 0, 0 }, 1);
+  layer.setParallel(&pool);
+  for (auto _ : state) {
+    layer.run();
+  }
+  const auto weights = static_cast<double>(k) * n + n;
+  setCounters(state, 2.0 * k * n, (weights + static_cast<double>(k) + n) * sizeof(float));
+}
+
+/**
+ * @brief A pruned Linear layer run from its sparse form, for one sample. The arguments are the input features, the
+ *        output features and the percentage of weights that are pruned. Compare with BM_RunLinear.
+ * */
+void
+BM_RunSparseLinear(benchmark::State& state)
+{
+  const auto k = static_cast<uint16_t>(state.range(0));
+  const auto n = static_cast<uint16_t>(state.range(1));
+  const auto source = "%1 = Linear " + std::to_string(k) + " " + std::to_string(n) + " %0\n";
+
+  NN::Program program;
+  (void)NN::compile(source.c_str(), static_cast<uint16_t>(source.size()), &program);
+  NN::Net net;
+  NN::NetBuilder builder(&net, k);
+  NN::exec(program, builder);
+  (void)builder.finish();
+
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(-1, 1);
+  for (uint32_t i = 0; i < net.numParameters; i++) {
+    net.parameters[i] = dist(rng);
+  }
+
+  NN::SparseNet sparseNet;
+  (void)NN::pruneByMagnitude(program, &net, static_cast<float>(state.range(2)) / 100.0F);
+  (void)NN::sparsify(program, net, &sparseNet);
+
+  NN::Activations activations;
+  (void)activations.allocMemory(sparseNet.shape);
+  NN::SparseNetRunner runner(&sparseNet, &activations);
+  for (uint16_t i = 0; i < k; i++) {
+    runner.getRegister(0)[i] = dist(rng);
+  }
+
+  for (auto _ : state) {
+    runner.reset();
+    NN::exec(program, runner);
+    benchmark::DoNotOptimize(runner.getRegister(1));
+    benchmark::ClobberMemory();
+  }
+
+  const auto weights = static_cast<double>(sparseNet.numBlocks) * NN_SPARSE_BLOCK_ROWS;
+  setCounters(state, 2.0 * weights, static_cast<double>(sparseNet.getParameterBytes() + (k + n) * sizeof(float)));
+
+  activations.releaseMemory();
+  sparseNet.releaseMemory();
+  net.releaseMemory();
+  program.releaseMemory();
+}
+
+/**
+ * @brief An MxK times KxN product of two registers, for one sample.
+ * */
+void
+BM_RunMatMul(benchmark::State& state)
+{
+  const auto m = static_cast<uint16_t>(state.range(0));
+  const auto k = static_cast<uint16_t>(state.range(1));
+  const auto n = static_cast<uint16_t>(state.range(2));
+  Layer layer("%3 = MatMul " + std::to_string(m) + " %1 %2\n",
+              { 0, static_cast<uint16_t>(m * k), static_cast<uint16_t>(k * n) },
+              1);
+  for (auto _ : state) {
+    layer.run();
+  }
+  setCounters(state, 2.0 * m * k * n, (static_cast<double>(m) * k + k * n + m * n) * sizeof(float));
+}
+
+/**
+ * @brief An instruction with two operands of the same size. The arguments are the size and the batch size.
+ * */
+void
+runBinary(benchmark::State& state, const char* function, const double flopsPerElement)
+{
+  const auto size = static_cast<uint16_t>(state.range(0));
+  const auto batchSize = static_cast<uint16_t>(state.range(1));
+  Layer layer(std::string("%3 = ") + function + " %1 %2\n", { 0, size, size }, batchSize);
+  for (auto _ : state) {
+    layer.run();
+  }
+  const auto elements = static_cast<double>(size) * batchSize;
+  const auto outputs = (flopsPerElement > 0) ? elements : (2 * elements);
+  setCounters(state, flopsPerElement * elements, (2 * elements + outputs) * sizeof(float));
+}
+
+void
+BM_RunConcat(benchmark::State& state)
+{
+  runBinary(state, "Concat", 0);
+}
+
+void
+BM_RunCompAdd(benchmark::State& state)
+{
+  runBinary(state, "CompAdd", 1);
+}
+
+void
+BM_RunCompMul(benchmark::State& state)
+{
+  runBinary(state, "CompMul", 1);
+}
+
+/**
+ * @brief An activation instruction. The activations are not counted as FLOPs, since their cost depends on the mode.
+ * */
+void
+runUnary(benchmark::State& state, const char* function)
+{
+  const auto size = static_cast<uint16_t>(state.range(0));
+  const auto batchSize = static_cast<uint16_t>(state.range(1));
+  Layer layer(std::string("%3 = ") + function + " %0\n", { size, 0, 0 }, batchSize);
+  for (auto _ : state) {
+    layer.run();
+  }
+  const auto elements = static_cast<double>(size) * batchSize;
+  state.SetItemsProcessed(static_cast<int64_t>(elements) * state.iterations());
+  setCounters(state, 0, 2 * elements * sizeof(float));
+}
+
+void
+BM_RunReLU(benchmark::State& state)
+{
+  runUnary(state, "ReLU");
+}
+
+void
+BM_RunSigmoid(benchmark::State& state)
+{
+  runUnary(state, "Sigmoid");
+}
+
+void
+BM_RunTanh(benchmark::State& state)
+{
+  runUnary(state, "Tanh");
+}
+
+/**
+ * @brief One step of the flight policy, from the state to the actuators. This is the same network as
+ *        tests/data/static_policy.nn.
+ * */
+void
+BM_DDPGComputeAction(benchmark::State& state)
+{
+  const char source[] = "%4 = Concat %0 %1\n"
+                        "%5 = Concat %4 %2\n"
+                        "%6 = Linear 12 16 %5\n"
+                        "%7 = Tanh %6\n"
+                        "%8 = Linear 12 16 %5\n"
+                        "%9 = Sigmoid %8\n"
+                        "%10 = CompMul %7 %9\n"
+                        "%11 = MatMul 4 %10 %10\n"
+                        "%12 = CompAdd %11 %10\n"
+                        "%13 = ReLU %12\n"
+                        "%3 = Linear 16 16 %13\n";
+
+  NN::Program program;
+  (void)NN::compile(source, sizeof(source) - 1, &program);
+  (void)NN::fuseActivations(&program, 1U << 3);
+
+  NN::Net net;
+  NN::NetBuilder builder(&net, 9);
+  net.regSizes[1] = 1;
+  net.regSizes[2] = 2;
+  NN::exec(program, builder);
+  (void)builder.finish();
+
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(-1, 1);
+  for (uint32_t i = 0; i < net.numParameters; i++) {
+    net.parameters[i] = dist(rng) * 0.25F;
+  }
+
+  RL::State policyState;
+  for (auto& x : policyState.rotation) {
+    x = dist(rng);
+  }
+  policyState.altitudeError = dist(rng);
+  policyState.speedError[0] = dist(rng);
+  policyState.speedError[1] = dist(rng);
+
+  RL::DDPGPolicy policy(&net, &program);
+  RL::Action action;
+  for (auto _ : state) {
+    policy.computeAction(policyState, action);
+    benchmark::DoNotOptimize(action.actuators);
+    benchmark::ClobberMemory();
+  }
+
+  // Two 12x16 layers, a 16x16 layer, a 4x4 by 4x4 product, and the element-wise product and sum.
+  const double flops = 2.0 * (12 * 16 * 2 + 16 * 16) + 2.0 * 4 * 4 * 4 + 2 * 16;
+  setCounters(state, flops, static_cast<double>(net.numParameters) * sizeof(float));
+
+  net.releaseMemory();
+  program.releaseMemory();
+}
+
+} // namespace
+
+BENCHMARK(BM_RunLinear)->Args({ 16, 16, 1 })->Args({ 64, 64, 1 })->Args({ 256, 256, 1 })->Args({ 64, 64, 32 });
+BENCHMARK(BM_RunLinearParallel)
+  ->Args({ 256, 256, 1 })
+  ->Args({ 256, 256, 4 })
+  ->Args({ 1024, 1024, 1 })
+  ->Args({ 1024, 1024, 4 })
+  ->Args({ 4096, 4096, 1 })
+  ->Args({ 4096, 4096, 4 })
+  ->UseRealTime();
+BENCHMARK(BM_RunSparseLinear)
+  ->Args({ 64, 64, 0 })
+  ->Args({ 64, 64, 75 })
+  ->Args({ 256, 256, 50 })
+  ->Args({ 256, 256, 90 });
+BENCHMARK(BM_RunMatMul)->Args({ 4, 4, 4 })->Args({ 16, 16, 16 })->Args({ 32, 64, 32 });
+BENCHMARK(BM_RunConcat)->Args({ 64, 1 })->Args({ 1024, 1 })->Args({ 64, 32 });
+BENCHMARK(BM_RunCompAdd)->Args({ 64, 1 })->Args({ 1024, 1 })->Args({ 64, 32 });
+BENCHMARK(BM_RunCompMul)->Args({ 64, 1 })->Args({ 1024, 1 })->Args({ 64, 32 });
+BENCHMARK(BM_RunReLU)->Args({ 64, 1 })->Args({ 1024, 1 })->Args({ 64, 32 });
+BENCHMARK(BM_RunSigmoid)->Args({ 64, 1 })->Args({ 1024, 1 })->Args({ 64, 32 });
+BENCHMARK(BM_RunTanh)->Args({ 64, 1 })->Args({ 1024, 1 })->Args({ 64, 32 });
+BENCHMARK(BM_DDPGComputeAction);
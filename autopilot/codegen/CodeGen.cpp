@@ -0,0 +1,230 @@
+#include "CodeGen.h"
+
+#include <NN_Interpreter.h>
+#include <NN_Net.h>
+#include <NN_Program.h>
+
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+
+namespace NN {
+
+namespace {
+
+auto
+activationName(const Activation activation) -> const char*
+{
+  switch (activation) {
+    case Activation::kNone:
+      break;
+    case Activation::kReLU:
+      return "NN::Activation::kReLU";
+    case Activation::kSigmoid:
+      return "NN::Activation::kSigmoid";
+    case Activation::kTanh:
+      return "NN::Activation::kTanh";
+  }
+  return "NN::Activation::kNone";
+}
+
+auto
+modeName(const ActivationMode mode) -> const char*
+{
+  return (mode == ActivationMode::kFast) ? "NN::ActivationMode::kFast" : "NN::ActivationMode::kPrecise";
+}
+
+/**
+ * @brief Formats a float so that it is read back as the same value.
+ * */
+auto
+floatLiteral(const float value) -> std::string
+{
+  char buffer[32]{};
+  std::snprintf(buffer, sizeof(buffer), "%.9g", static_cast<double>(value));
+  std::string literal(buffer);
+  if (literal.find_first_of(".e") == std::string::npos) {
+    literal += ".0";
+  }
+  return literal + "F";
+}
+
+/**
+ * @brief Writes one kernel call for each instruction, keeping track of the register sizes the same way that
+ *        @ref NetRunner does.
+ * */
+class CodeGen final : public Interpreter
+{
+public:
+  CodeGen(const Net& net, std::ostream& out)
+    : net_(net)
+    , out_(out)
+  {
+    for (uint8_t i = 0; i < NN_MAX_REGS; i++) {
+      sizes_[i] = net.regSizes[i];
+    }
+  }
+
+  void beginAssignment(const uint8_t dstReg) override { dstReg_ = dstReg; }
+
+  void interpret(const LinearExpr& expr) override
+  {
+    out_ << "  NN::staticLinear<" << expr.inFeatures << ", " << expr.outFeatures << ", "
+         << activationName(expr.activation) << ", " << mode() << ">(parameters + " << parameterOffset_ << ", "
+         << reg(expr.inRegister) << ", " << reg(dstReg_) << ");\n";
+    parameterOffset_ += linearParameterCount(expr.inFeatures, expr.outFeatures, WeightLayout::kPacked);
+    sizes_[dstReg_] = expr.outFeatures;
+  }
+
+  void interpret(const MatMulExpr& expr) override
+  {
+    const uint32_t m = expr.leftRows;
+    const uint32_t k = (m > 0) ? (sizes_[expr.leftOpReg] / m) : 0;
+    const uint32_t n = (k > 0) ? (sizes_[expr.rightOpReg] / k) : 0;
+    out_ << "  NN::staticMatMul<" << m << ", " << k << ", " << n << ", " << activationName(expr.activation) << ", "
+         << mode() << ">(" << reg(expr.leftOpReg) << ", " << reg(expr.rightOpReg) << ", " << reg(dstReg_) << ");\n";
+    sizes_[dstReg_] = static_cast<FeatureSize>(m * n);
+  }
+
+  void interpret(const ConcatExpr& expr) override
+  {
+    const auto lSize = sizes_[expr.leftOpReg];
+    const auto rSize = sizes_[expr.rightOpReg];
+    out_ << "  NN::staticConcat<" << lSize << ", " << rSize << ", " << activationName(expr.activation) << ", "
+         << mode() << ">(" << reg(expr.leftOpReg) << ", " << reg(expr.rightOpReg) << ", " << reg(dstReg_) << ");\n";
+    sizes_[dstReg_] = static_cast<FeatureSize>(lSize + rSize);
+  }
+
+  void interpret(const CompAddExpr& expr) override { binary("staticCompAdd", expr); }
+
+  void interpret(const CompMulExpr& expr) override { binary("staticCompMul", expr); }
+
+  void interpret(const ReLUExpr& expr) override { unary(expr, Activation::kReLU); }
+
+  void interpret(const SigmoidExpr& expr) override { unary(expr, Activation::kSigmoid); }
+
+  void interpret(const TanhExpr& expr) override { unary(expr, Activation::kTanh); }
+
+  void interpret(const GRUExpr&) override {}
+
+  void interpret(const Conv1DExpr&) override {}
+
+  [[nodiscard]] auto getNumParameters() const -> uint32_t { return parameterOffset_; }
+
+protected:
+  [[nodiscard]] auto mode() const -> const char* { return modeName(net_.activationMode); }
+
+  [[nodiscard]] auto reg(const uint8_t r) const -> std::string
+  {
+    return "arena + " + std::to_string(net_.regOffsets[r]);
+  }
+
+  void binary(const char* kernel, const BinaryExpr& expr)
+  {
+    const auto lSize = sizes_[expr.leftOpReg];
+    const auto rSize = sizes_[expr.rightOpReg];
+    const auto size = (lSize < rSize) ? lSize : rSize;
+    out_ << "  NN::" << kernel << "<" << size << ", " << activationName(expr.activation) << ", " << mode() << ">("
+         << reg(expr.leftOpReg) << ", " << reg(expr.rightOpReg) << ", " << reg(dstReg_) << ");\n";
+    sizes_[dstReg_] = size;
+  }
+
+  void unary(const UnaryExpr& expr, const Activation activation)
+  {
+    const auto size = sizes_[expr.inRegister];
+    out_ << "  NN::staticActivation<" << size << ", " << activationName(activation) << ", " << mode() << ">("
+         << reg(expr.inRegister) << ", " << reg(dstReg_) << ");\n";
+    sizes_[dstReg_] = size;
+  }
+
+private:
+  const Net& net_;
+
+  std::ostream& out_;
+
+  uint8_t dstReg_{};
+
+  FeatureSize sizes_[NN_MAX_REGS]{};
+
+  uint32_t parameterOffset_{};
+};
+
+} // namespace
+
+auto
+generateCode(const Program& program, const Net& net, const std::string& name, std::string* source) -> CodeGenError
+{
+  if (net.stateSize != 0) {
+    return CodeGenError::kStateful;
+  }
+
+  if (net.weightLayout != WeightLayout::kPacked) {
+    return CodeGenError::kPaddedLayout;
+  }
+
+  std::ostringstream body;
+  CodeGen codeGen(net, body);
+  exec(program, codeGen);
+
+  const auto numParameters = codeGen.getNumParameters();
+
+  uint32_t arenaSize = 0;
+  uint32_t numRegs = 0;
+  for (uint8_t i = 0; i < NN_MAX_REGS; i++) {
+    const auto end = net.regOffsets[i] + net.regSizes[i];
+    arenaSize = (end > arenaSize) ? end : arenaSize;
+    numRegs = (net.regSizes[i] > 0) ? (i + 1U) : numRegs;
+  }
+
+  std::ostringstream out;
+  out << "// Generated by nn-codegen. Do not edit.\n"
+      << "\n"
+      << "#include <NN_Static.h>\n"
+      << "\n"
+      << "namespace {\n"
+      << "\n"
+      << "constexpr uint32_t kArenaSize = " << ((arenaSize > 0) ? arenaSize : 1) << ";\n"
+      << "\n"
+      << "constexpr uint32_t kNumParameters = " << ((numParameters > 0) ? numParameters : 1) << ";\n"
+      << "\n"
+      << "float arena[kArenaSize]{};\n"
+      << "\n"
+      << "const float parameters[kNumParameters]{";
+
+  for (uint32_t i = 0; i < numParameters; i++) {
+    if (!std::isfinite(net.parameters[i])) {
+      return CodeGenError::kNotFinite;
+    }
+    out << (((i % 6) == 0) ? "\n  " : " ") << floatLiteral(net.parameters[i]) << ",";
+  }
+
+  out << "\n};\n"
+      << "\n"
+      << "void\n"
+      << "run()\n"
+      << "{\n"
+      << body.str() << "}\n"
+      << "\n"
+      << "const NN::FeatureSize regSizes[NN_MAX_REGS]{";
+  // Only the registers up to the last one used are written, so that the file builds with any register count that is
+  // large enough. The rest are zero.
+  for (uint32_t i = 0; i < numRegs; i++) {
+    out << ((i > 0) ? ", " : " ") << net.regSizes[i];
+  }
+  out << " };\n"
+      << "\n"
+      << "float* const regs[NN_MAX_REGS]{";
+  for (uint32_t i = 0; i < numRegs; i++) {
+    out << ((i % 4) == 0 ? "\n  " : " ") << "arena + " << net.regOffsets[i] << ",";
+  }
+  out << "\n};\n"
+      << "\n"
+      << "} // namespace\n"
+      << "\n"
+      << "extern const NN::StaticNet " << name << "{ regSizes, regs, run };\n";
+
+  *source = out.str();
+  return CodeGenError::kNone;
+}
+
+} // namespace NN
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+
+#include <stdint.h>
+
+namespace NN {
+
+struct Net;
+struct Program;
+
+/**
+ * @brief The reasons that code cannot be generated for a network.
+ * */
+enum class CodeGenError : uint8_t
+{
+  kNone,
+  /**
+   * @brief The network has a GRU or Conv1D, and the static kernels have nowhere to keep their state.
+   * */
+  kStateful,
+  /**
+   * @brief The network uses the padded weight layout, while the static kernels read packed weights.
+   * */
+  kPaddedLayout,
+  kNotFinite
+};
+
+/**
+ * @brief Generates a C++ translation unit that runs a network without interpreting it.
+ *
+ * @details The translation unit defines a @ref StaticNet with the given name. Every instruction becomes a call to one
+ *          of the kernels in @ref NN_Static.h, with the sizes and activations as template arguments, and the
+ *          registers are placed in a static arena at the offsets of the network. The network has to have been built
+ *          and its parameters filled in.
+ *
+ * @param program The compiled program. Activations that were fused into instructions are kept fused.
+ *
+ * @param net The network that the program was built for.
+ *
+ * @param name The name of the @ref StaticNet object.
+ *
+ * @param source Where to write the generated code.
+ *
+ * @return Why the code could not be generated, if it could not be.
+ * */
+[[nodiscard]] auto
+generateCode(const Program& program, const Net& net, const std::string& name, std::string* source) -> CodeGenError;
+
+} // namespace NN
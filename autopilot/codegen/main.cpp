@@ -0,0 +1,167 @@
+#include "CodeGen.h"
+
+#include <NN_Liveness.h>
+#include <NN_Net.h>
+#include <NN_NetBuilder.h>
+#include <NN_Parser.h>
+#include <NN_Program.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char usage[] = "usage: nn-codegen [options] <program> <weights> <output>\n"
+                     "\n"
+                     "Compiles a network into a C++ translation unit that defines an NN::StaticNet.\n"
+                     "The weights are the parameters of the network as raw 32-bit floats.\n"
+                     "\n"
+                     "options:\n"
+                     "  --input REG:SIZE  Sets the size of an input register. Register 0 defaults to 1.\n"
+                     "  --output REG      Marks a register as being read after the network runs.\n"
+                     "  --name NAME       The name of the StaticNet object (default: net).\n"
+                     "  --fast            Uses the fast activation approximations.\n";
+
+auto
+readFile(const std::string& path, std::string* data) -> bool
+{
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return false;
+  }
+  std::ostringstream stream;
+  stream << file.rdbuf();
+  *data = stream.str();
+  return true;
+}
+
+auto
+parseRegister(const char* text, uint8_t* reg) -> bool
+{
+  char* end{};
+  const auto value = std::strtol(text, &end, 10);
+  if ((end == text) || (value < 0) || (value >= NN_MAX_REGS)) {
+    return false;
+  }
+  *reg = static_cast<uint8_t>(value);
+  return true;
+}
+
+} // namespace
+
+auto
+main(int argc, char** argv) -> int
+{
+  std::vector<std::string> paths;
+  std::vector<std::pair<uint8_t, NN::FeatureSize>> inputs;
+  NN::RegMask liveOut = 0;
+  std::string name = "net";
+  auto mode = NN::ActivationMode::kPrecise;
+
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if ((arg == "--input") && ((i + 1) < argc)) {
+      uint8_t reg{};
+      const char* sizeText = std::strchr(argv[++i], ':');
+      if (!sizeText || !parseRegister(argv[i], &reg)) {
+        std::cerr << "invalid input: " << argv[i] << '\n';
+        return EXIT_FAILURE;
+      }
+      inputs.emplace_back(reg, static_cast<NN::FeatureSize>(std::strtoul(sizeText + 1, nullptr, 10)));
+    } else if ((arg == "--output") && ((i + 1) < argc)) {
+      uint8_t reg{};
+      if (!parseRegister(argv[++i], &reg)) {
+        std::cerr << "invalid output: " << argv[i] << '\n';
+        return EXIT_FAILURE;
+      }
+      liveOut |= NN::regBit(reg);
+    } else if ((arg == "--name") && ((i + 1) < argc)) {
+      name = argv[++i];
+    } else if (arg == "--fast") {
+      mode = NN::ActivationMode::kFast;
+    } else if ((arg == "--help") || (arg[0] == '-')) {
+      std::cerr << usage;
+      return (arg == "--help") ? EXIT_SUCCESS : EXIT_FAILURE;
+    } else {
+      paths.emplace_back(arg);
+    }
+  }
+
+  if (paths.size() != 3) {
+    std::cerr << usage;
+    return EXIT_FAILURE;
+  }
+
+  std::string source;
+  std::string weights;
+  if (!readFile(paths[0], &source) || !readFile(paths[1], &weights)) {
+    std::cerr << "failed to read the program or the weights\n";
+    return EXIT_FAILURE;
+  }
+
+  if (source.size() > NN::maxSourceSize) {
+    std::cerr << paths[0] << ": program is too long for this build\n";
+    return EXIT_FAILURE;
+  }
+
+  NN::Program program;
+  if (NN::compile(source.c_str(), static_cast<NN::SourceSize>(source.size()), &program) != NN::SyntaxError::kNone) {
+    std::cerr << paths[0] << ": syntax error\n";
+    return EXIT_FAILURE;
+  }
+
+  (void)NN::fuseActivations(&program, liveOut);
+
+  NN::Net net;
+  net.activationMode = mode;
+  NN::NetBuilder builder(&net, 1);
+  for (const auto& input : inputs) {
+    net.regSizes[input.first] = input.second;
+  }
+  NN::exec(program, builder);
+
+  NN::Liveness liveness;
+  for (uint8_t i = 0; i < NN_MAX_REGS; i++) {
+    if (liveOut & NN::regBit(i)) {
+      liveness.markLiveOut(i);
+    }
+  }
+  NN::exec(program, liveness);
+  liveness.assignOffsets(&net);
+
+  auto exitCode = EXIT_FAILURE;
+
+  std::string output;
+  if (!builder.finish()) {
+    std::cerr << paths[0] << ": the register shapes do not match\n";
+  } else if (weights.size() != (net.numParameters * sizeof(float))) {
+    std::cerr << paths[1] << ": expected " << net.numParameters << " parameters\n";
+  } else {
+    std::memcpy(net.parameters, weights.data(), weights.size());
+    switch (NN::generateCode(program, net, name, &output)) {
+      case NN::CodeGenError::kNone: {
+        std::ofstream file(paths[2], std::ios::binary);
+        file << output;
+        exitCode = file ? EXIT_SUCCESS : EXIT_FAILURE;
+      } break;
+      case NN::CodeGenError::kStateful:
+        std::cerr << paths[0] << ": GRU and Conv1D are not supported by the generated code\n";
+        break;
+      case NN::CodeGenError::kPaddedLayout:
+        std::cerr << paths[0] << ": the padded weight layout is not supported by the generated code\n";
+        break;
+      case NN::CodeGenError::kNotFinite:
+        std::cerr << paths[1] << ": the weights are not finite\n";
+        break;
+    }
+  }
+
+  net.releaseMemory();
+  program.releaseMemory();
+  return exitCode;
+}
@@ -0,0 +1,121 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace NN {
+
+MappedFile::~MappedFile()
+{
+  close();
+}
+
+#ifdef _WIN32
+
+auto
+MappedFile::open(const std::string& path) -> bool
+{
+  close();
+
+  auto file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 0, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+
+  LARGE_INTEGER size{};
+  if (!GetFileSizeEx(file, &size) || (size.QuadPart == 0)) {
+    CloseHandle(file);
+    return false;
+  }
+
+  mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file);
+  if (!mapping_) {
+    return false;
+  }
+
+  data_ = MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+  if (!data_) {
+    CloseHandle(mapping_);
+    mapping_ = nullptr;
+    return false;
+  }
+
+  size_ = static_cast<std::size_t>(size.QuadPart);
+  return true;
+}
+
+void
+MappedFile::close()
+{
+  if (data_) {
+    UnmapViewOfFile(data_);
+    CloseHandle(mapping_);
+  }
+  data_ = nullptr;
+  mapping_ = nullptr;
+  size_ = 0;
+}
+
+#else
+
+auto
+MappedFile::open(const std::string& path) -> bool
+{
+  close();
+
+  const auto fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat info{};
+  if ((fstat(fd, &info) != 0) || (info.st_size == 0)) {
+    ::close(fd);
+    return false;
+  }
+
+  const auto size = static_cast<std::size_t>(info.st_size);
+  auto* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  // The mapping keeps its own reference to the file.
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    return false;
+  }
+
+  data_ = data;
+  size_ = size;
+  return true;
+}
+
+void
+MappedFile::close()
+{
+  if (data_) {
+    munmap(data_, size_);
+  }
+  data_ = nullptr;
+  size_ = 0;
+}
+
+#endif
+
+auto
+MappedFile::getData() const -> const void*
+{
+  return data_;
+}
+
+auto
+MappedFile::getSize() const -> std::size_t
+{
+  return size_;
+}
+
+} // namespace NN
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace NN {
+
+/**
+ * @brief A read-only view of a whole file, mapped into memory.
+ *
+ * @details The mapping starts on a page boundary, which satisfies @ref NN_WEIGHT_FILE_ALIGNMENT, so a weight file can
+ *          be opened directly on @ref MappedFile::getData. Pages are only read from disk when they are first touched,
+ *          and processes that map the same file share them.
+ * */
+class MappedFile final
+{
+public:
+  MappedFile() = default;
+
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+
+  auto operator=(const MappedFile&) -> MappedFile& = delete;
+
+  /**
+   * @brief Maps a file, replacing the file that was mapped before.
+   *
+   * @return True on success, false if the file could not be opened or mapped.
+   * */
+  [[nodiscard]] auto open(const std::string& path) -> bool;
+
+  void close();
+
+  [[nodiscard]] auto getData() const -> const void*;
+
+  [[nodiscard]] auto getSize() const -> std::size_t;
+
+private:
+  void* data_{};
+
+  std::size_t size_{};
+
+#ifdef _WIN32
+  void* mapping_{};
+#endif
+};
+
+} // namespace NN
@@ -0,0 +1,191 @@
+#include "ProfileReport.h"
+
+#include <NN_Profiler.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace NN {
+
+namespace {
+
+auto
+getName(const OpCode op) -> const char*
+{
+  switch (op) {
+    case OpCode::kLinear:
+      return "Linear";
+    case OpCode::kMatMul:
+      return "MatMul";
+    case OpCode::kConcat:
+      return "Concat";
+    case OpCode::kCompAdd:
+      return "CompAdd";
+    case OpCode::kCompMul:
+      return "CompMul";
+    case OpCode::kReLU:
+      return "ReLU";
+    case OpCode::kSigmoid:
+      return "Sigmoid";
+    case OpCode::kTanh:
+      return "Tanh";
+    case OpCode::kGRU:
+      return "GRU";
+    case OpCode::kConv1D:
+      return "Conv1D";
+  }
+  return "";
+}
+
+auto
+getName(const Activation activation) -> const char*
+{
+  switch (activation) {
+    case Activation::kNone:
+      break;
+    case Activation::kReLU:
+      return "ReLU";
+    case Activation::kSigmoid:
+      return "Sigmoid";
+    case Activation::kTanh:
+      return "Tanh";
+  }
+  return "";
+}
+
+auto
+reg(const uint8_t index) -> std::string
+{
+  return "%" + std::to_string(index);
+}
+
+} // namespace
+
+auto
+steadyClock(void*) -> uint64_t
+{
+  const auto now = std::chrono::steady_clock::now().time_since_epoch();
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+}
+
+auto
+formatInstruction(const Instruction& instr) -> std::string
+{
+  auto text = reg(instr.dstReg) + " = " + getName(instr.op);
+  switch (instr.op) {
+    case OpCode::kLinear:
+    case OpCode::kGRU:
+      text += " " + std::to_string(instr.inFeatures) + " " + std::to_string(instr.outFeatures) + " " +
+              reg(instr.leftReg);
+      break;
+    case OpCode::kConv1D:
+      text += " " + std::to_string(instr.inFeatures) + " " + std::to_string(instr.outFeatures) + " " +
+              std::to_string(instr.kernelSize) + " " + reg(instr.leftReg);
+      break;
+    case OpCode::kMatMul:
+      text += " " + std::to_string(instr.inFeatures) + " " + reg(instr.leftReg) + " " + reg(instr.rightReg);
+      break;
+    case OpCode::kConcat:
+    case OpCode::kCompAdd:
+    case OpCode::kCompMul:
+      text += " " + reg(instr.leftReg) + " " + reg(instr.rightReg);
+      break;
+    case OpCode::kReLU:
+    case OpCode::kSigmoid:
+    case OpCode::kTanh:
+      text += " " + reg(instr.leftReg);
+      break;
+  }
+  if (instr.activation != Activation::kNone) {
+    text += std::string(" (") + getName(instr.activation) + ")";
+  }
+  return text;
+}
+
+auto
+formatReport(const Profiler& profiler) -> std::string
+{
+  const auto numEntries = profiler.getNumEntries();
+  std::vector<InstrIndex> order(numEntries);
+  profiler.sortByTime(order.data());
+
+  uint64_t totalTime{};
+  for (InstrIndex i = 0; i < numEntries; i++) {
+    totalTime += profiler.getEntry(i).nanoseconds;
+  }
+
+  char line[256];
+  std::snprintf(line,
+                sizeof(line),
+                "%4s  %-36s %8s %12s %10s %7s %10s %10s\n",
+                "line",
+                "statement",
+                "calls",
+                "total (us)",
+                "avg (ns)",
+                "time",
+                "GFLOP/s",
+                "GB/s");
+  std::string report = line;
+
+  for (const auto index : order) {
+    const auto& entry = profiler.getEntry(index);
+    const auto nanoseconds = static_cast<double>(entry.nanoseconds);
+    const auto average = (entry.numCalls > 0) ? (nanoseconds / entry.numCalls) : 0.0;
+    const auto share = (totalTime > 0) ? (100.0 * nanoseconds / static_cast<double>(totalTime)) : 0.0;
+    // Operations per nanosecond are the same as billions per second.
+    const auto flopRate = (nanoseconds > 0) ? (static_cast<double>(entry.flops) / nanoseconds) : 0.0;
+    const auto byteRate = (nanoseconds > 0) ? (static_cast<double>(entry.bytes) / nanoseconds) : 0.0;
+    std::snprintf(line,
+                  sizeof(line),
+                  "%4u  %-36s %8u %12.3f %10.1f %6.1f%% %10.3f %10.3f\n",
+                  static_cast<unsigned>(index),
+                  formatInstruction(entry.instruction).c_str(),
+                  static_cast<unsigned>(entry.numCalls),
+                  nanoseconds / 1000.0,
+                  average,
+                  share,
+                  flopRate,
+                  byteRate);
+    report += line;
+  }
+
+  std::snprintf(line,
+                sizeof(line),
+                "total: %.3f us over %u runs\n",
+                static_cast<double>(totalTime) / 1000.0,
+                static_cast<unsigned>(profiler.getNumRuns()));
+  report += line;
+
+  return report;
+}
+
+auto
+formatChromeTrace(const Profiler& profiler) -> std::string
+{
+  const auto numEvents = profiler.getNumEvents();
+  const auto origin = (numEvents > 0) ? profiler.getEvent(0).start : 0;
+
+  std::string trace = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  char buffer[128];
+  for (uint32_t i = 0; i < numEvents; i++) {
+    const auto& event = profiler.getEvent(i);
+    const auto& entry = profiler.getEntry(event.entry);
+    trace += (i > 0) ? ",\n" : "\n";
+    // The names only contain letters, digits, spaces and the characters %=(), so they need no escaping.
+    trace += "{\"name\":\"" + formatInstruction(entry.instruction) + "\",\"cat\":\"nn\",\"ph\":\"X\"";
+    std::snprintf(buffer,
+                  sizeof(buffer),
+                  ",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":0,\"args\":{\"line\":%u,\"run\":%u}}",
+                  static_cast<double>(event.start - origin) / 1000.0,
+                  static_cast<double>(event.duration) / 1000.0,
+                  static_cast<unsigned>(event.entry),
+                  static_cast<unsigned>(event.run));
+    trace += buffer;
+  }
+  trace += "\n]}\n";
+  return trace;
+}
+
+} // namespace NN
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace NN {
+
+class Profiler;
+struct Instruction;
+
+/**
+ * @brief Reads std::chrono::steady_clock, for use as a @ref Profiler::ClockFunc.
+ * */
+[[nodiscard]] auto
+steadyClock(void*) -> uint64_t;
+
+/**
+ * @brief Formats an instruction the way it is written in the source, with a fused activation in parentheses.
+ * */
+[[nodiscard]] auto
+formatInstruction(const Instruction& instr) -> std::string;
+
+/**
+ * @brief Formats a table of the measured statements, from the slowest to the fastest.
+ *
+ * @details Each row has the total and average time, the share of the total time, and the rate of floating point
+ *          operations and bytes. The slowest statement is the one to look at first.
+ * */
+[[nodiscard]] auto
+formatReport(const Profiler& profiler) -> std::string;
+
+/**
+ * @brief Formats the runs that the profiler kept as a Chrome trace.
+ *
+ * @details The trace can be opened with chrome://tracing or https://ui.perfetto.dev. Each run of a statement is a
+ *          complete event, named after the statement, with times relative to the first event.
+ * */
+[[nodiscard]] auto
+formatChromeTrace(const Profiler& profiler) -> std::string;
+
+} // namespace NN
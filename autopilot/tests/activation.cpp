@@ -0,0 +1,244 @@
+#include <gtest/gtest.h>
+
+#include <NN_Activation.h>
+#include <NN_Kernels.h>
+#include <NN_Net.h>
+#include <NN_NetBuilder.h>
+#include <NN_NetRunner.h>
+#include <NN_Parser.h>
+#include <NN_Program.h>
+
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief Every float whose bit pattern is a multiple of this is tested. The bounds in @ref NN::ActivationMode were
+ *        found by testing every float, which the disabled tests at the end of this file do. They take about 20
+ *        minutes, and are run with `--gtest_also_run_disabled_tests`.
+ * */
+constexpr uint32_t sweepStride = 4093;
+
+const NN::ActivationMode modes[]{ NN::ActivationMode::kPrecise, NN::ActivationMode::kFast };
+
+/**
+ * @brief Measures the error of a result in units of the last place of the correctly rounded result.
+ * */
+auto
+ulpError(const float result, const double reference) -> double
+{
+  int exponent{};
+  (void)std::frexp(reference, &exponent);
+  return std::fabs(static_cast<double>(result) - reference) / std::ldexp(1.0, exponent - 24);
+}
+
+/**
+ * @brief The largest errors of one function in one mode.
+ * */
+struct ErrorStats final
+{
+  double maxUlp{};
+
+  /**
+   * @brief The largest absolute error, for results that are too small to be normal floats.
+   * */
+  double maxDenormalError{};
+
+  void include(const float result, const double reference)
+  {
+    if (std::fabs(reference) >= FLT_MIN) {
+      maxUlp = std::fmax(maxUlp, ulpError(result, reference));
+    } else {
+      maxDenormalError = std::fmax(maxDenormalError, std::fabs(static_cast<double>(result) - reference));
+    }
+  }
+};
+
+template<typename Func>
+void
+sweep(const uint32_t stride, Func func)
+{
+  for (uint64_t bits = 0; bits <= 0xffffffffULL; bits += stride) {
+    const auto x = NN::bitsToFloat(static_cast<uint32_t>(bits));
+    if (!std::isnan(x)) {
+      func(x);
+    }
+  }
+}
+
+auto
+sameResult(const float a, const float b) -> bool
+{
+  return (std::isnan(a) && std::isnan(b)) || (NN::floatToBits(a) == NN::floatToBits(b));
+}
+
+void
+checkPreciseAccuracy(const uint32_t stride)
+{
+  ErrorStats expStats;
+  ErrorStats sigmoidStats;
+  ErrorStats tanhStats;
+  sweep(stride, [&](const float x) {
+    const auto e = std::exp(static_cast<double>(x));
+    if (e <= FLT_MAX) {
+      expStats.include(NN::preciseExp(x), e);
+    } else {
+      EXPECT_TRUE(std::isinf(NN::preciseExp(x))) << x;
+    }
+    sigmoidStats.include(NN::applySigmoid(x), 1.0 / (1.0 + std::exp(-static_cast<double>(x))));
+    tanhStats.include(NN::applyTanh(x), std::tanh(static_cast<double>(x)));
+  });
+  EXPECT_LE(expStats.maxUlp, 1.0);
+  EXPECT_LE(sigmoidStats.maxUlp, 2.5);
+  EXPECT_LE(tanhStats.maxUlp, 1.5);
+  // Denormal results are flushed to zero.
+  EXPECT_LE(expStats.maxDenormalError, FLT_MIN);
+  EXPECT_LE(sigmoidStats.maxDenormalError, FLT_MIN);
+}
+
+void
+checkFastAccuracy(const uint32_t stride)
+{
+  ErrorStats expStats;
+  ErrorStats sigmoidStats;
+  ErrorStats tanhStats;
+  sweep(stride, [&](const float x) {
+    // The input is clamped to the range in which exp is a normal float.
+    if ((x >= -86.0F) && (x <= 88.0F)) {
+      expStats.include(NN::fastExp(x), std::exp(static_cast<double>(x)));
+    }
+    const auto sigmoid = 1.0 / (1.0 + std::exp(-static_cast<double>(x)));
+    if (x >= -86.0F) {
+      sigmoidStats.include(NN::applySigmoid(x, NN::ActivationMode::kFast), sigmoid);
+    } else {
+      EXPECT_LE(NN::applySigmoid(x, NN::ActivationMode::kFast), 1.0e-37F) << x;
+    }
+    tanhStats.include(NN::applyTanh(x, NN::ActivationMode::kFast), std::tanh(static_cast<double>(x)));
+  });
+  EXPECT_LE(expStats.maxUlp, 122.0);
+  EXPECT_LE(sigmoidStats.maxUlp, 122.0);
+  EXPECT_LE(tanhStats.maxUlp, 26.0);
+}
+
+} // namespace
+
+TEST(Activation, PreciseAccuracy)
+{
+  checkPreciseAccuracy(sweepStride);
+}
+
+TEST(Activation, FastAccuracy)
+{
+  checkFastAccuracy(sweepStride);
+}
+
+TEST(Activation, SpecialValues)
+{
+  const auto inf = std::numeric_limits<float>::infinity();
+  const auto nan = std::numeric_limits<float>::quiet_NaN();
+  EXPECT_EQ(NN::preciseExp(inf), inf);
+  EXPECT_EQ(NN::preciseExp(-inf), 0.0F);
+  EXPECT_EQ(NN::preciseExp(0.0F), 1.0F);
+  EXPECT_TRUE(std::isnan(NN::preciseExp(nan)));
+  for (const auto mode : modes) {
+    EXPECT_EQ(NN::applySigmoid(inf, mode), 1.0F);
+    EXPECT_EQ(NN::applySigmoid(0.0F, mode), 0.5F);
+    EXPECT_EQ(NN::applyTanh(inf, mode), 1.0F);
+    EXPECT_EQ(NN::applyTanh(-inf, mode), -1.0F);
+    EXPECT_TRUE(std::signbit(NN::applyTanh(-0.0F, mode)));
+  }
+  EXPECT_EQ(NN::applySigmoid(-inf), 0.0F);
+  EXPECT_TRUE(std::isnan(NN::applySigmoid(nan)));
+  EXPECT_TRUE(std::isnan(NN::applyTanh(nan)));
+}
+
+TEST(Activation, KernelsMatchScalar)
+{
+  const NN::KernelISA isas[]{ NN::KernelISA::kPortable, NN::KernelISA::kSSE2, NN::KernelISA::kAVX2, NN::KernelISA::kAVX512 };
+
+  const NN::Activation activations[]{
+    NN::Activation::kNone, NN::Activation::kReLU, NN::Activation::kSigmoid, NN::Activation::kTanh
+  };
+
+  // An odd count, so that the scalar tail of the kernels is tested too.
+  std::vector<float> input;
+  for (uint64_t bits = 0; bits <= 0xffffffffULL; bits += sweepStride * 7ULL) {
+    input.push_back(NN::bitsToFloat(static_cast<uint32_t>(bits)));
+  }
+  if ((input.size() % 2) == 0) {
+    input.pop_back();
+  }
+  std::vector<float> output(input.size());
+
+  for (const auto isa : isas) {
+    const auto kernel = NN::getActivationKernel(isa);
+    if (!kernel) {
+      continue;
+    }
+    for (const auto activation : activations) {
+      for (const auto mode : modes) {
+        kernel(input.data(), output.data(), static_cast<uint32_t>(input.size()), activation, mode);
+        for (size_t i = 0; i < input.size(); i++) {
+          ASSERT_TRUE(sameResult(output[i], NN::applyActivation(input[i], activation, mode)))
+            << "x = " << input[i] << ", ISA " << static_cast<int>(isa) << ", activation "
+            << static_cast<int>(activation) << ", mode " << static_cast<int>(mode);
+        }
+        // In place.
+        auto values = input;
+        kernel(values.data(), values.data(), static_cast<uint32_t>(values.size()), activation, mode);
+        for (size_t i = 0; i < values.size(); i++) {
+          ASSERT_TRUE(sameResult(values[i], output[i]));
+        }
+      }
+    }
+  }
+}
+
+TEST(Activation, NetMode)
+{
+  const char src[] = "%1 = Linear 8 8 %0\n"
+                     "%2 = Sigmoid %1\n"
+                     "%3 = Tanh %2\n";
+  NN::Program program;
+  ASSERT_EQ(NN::compile(src, sizeof(src) - 1, &program), NN::SyntaxError::kNone);
+
+  float outputs[2][8]{};
+  for (int m = 0; m < 2; m++) {
+    NN::Net net;
+    net.activationMode = modes[m];
+    NN::NetBuilder builder(&net, 8);
+    NN::exec(program, builder);
+    ASSERT_TRUE(builder.finish());
+    for (uint32_t i = 0; i < net.numParameters; i++) {
+      net.parameters[i] = static_cast<float>(static_cast<int>(i % 13) - 6) * 0.2F;
+    }
+    NN::NetRunner runner(&net);
+    for (int i = 0; i < 8; i++) {
+      runner.getRegister(0)[i] = static_cast<float>(i) - 3.5F;
+    }
+    runner.reset();
+    NN::exec(program, runner);
+    std::memcpy(outputs[m], runner.getRegister(3), sizeof(outputs[m]));
+    net.releaseMemory();
+  }
+
+  for (int i = 0; i < 8; i++) {
+    EXPECT_NEAR(outputs[0][i], outputs[1][i], 1.0e-5F);
+  }
+
+  program.releaseMemory();
+}
+
+TEST(Activation, DISABLED_PreciseAccuracyAllFloats)
+{
+  checkPreciseAccuracy(1);
+}
+
+TEST(Activation, DISABLED_FastAccuracyAllFloats)
+{
+  checkFastAccuracy(1);
+}
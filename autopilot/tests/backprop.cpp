@@ -0,0 +1,311 @@
+#include <gtest/gtest.h>
+
+#include <NN_Backprop.h>
+#include <NN_Liveness.h>
+#include <NN_Loss.h>
+#include <NN_NetBuilder.h>
+#include <NN_NetRunner.h>
+#include <NN_Optim.h>
+#include <NN_Parser.h>
+#include <NN_Program.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr uint16_t inputSize = 6;
+
+constexpr uint16_t batchSize = 3;
+
+constexpr uint8_t outputReg = 10;
+
+// Covers every instruction, a register that is overwritten in place and a register that is read twice.
+const char gradSource[] = "%1 = Linear 6 8 %0\n"
+                          "%2 = Tanh %1\n"
+                          "%3 = Linear 6 8 %0\n"
+                          "%4 = Sigmoid %3\n"
+                          "%5 = CompMul %2 %4\n"
+                          "%6 = Concat %5 %0\n"
+                          "%7 = Linear 14 8 %6\n"
+                          "%7 = ReLU %7\n"
+                          "%8 = MatMul 2 %7 %5\n"
+                          "%9 = CompAdd %8 %2\n"
+                          "%10 = Linear 4 3 %9\n";
+
+struct GradCase final
+{
+  bool fuse{ false };
+
+  NN::WeightLayout layout{ NN::WeightLayout::kPacked };
+
+  bool shareMemory{ false };
+};
+
+class BackpropTest final
+{
+public:
+  explicit BackpropTest(const GradCase& gradCase)
+  {
+    EXPECT_EQ(NN::compile(gradSource, sizeof(gradSource) - 1, &program_), NN::SyntaxError::kNone);
+    if (gradCase.fuse) {
+      EXPECT_GT(NN::fuseActivations(&program_, 1U << outputReg), 0);
+    }
+
+    net_.batchSize = batchSize;
+    net_.weightLayout = gradCase.layout;
+    NN::NetBuilder builder(&net_, inputSize);
+    NN::exec(program_, builder);
+    if (gradCase.shareMemory) {
+      NN::Liveness liveness;
+      liveness.markLiveOut(outputReg);
+      NN::exec(program_, liveness);
+      liveness.assignOffsets(&net_);
+    }
+    EXPECT_TRUE(builder.finish());
+
+    std::mt19937 rng(7);
+    std::normal_distribution<float> dist(0.0F, 0.5F);
+    for (uint32_t i = 0; i < net_.numParameters; i++) {
+      net_.parameters[i] = dist(rng);
+    }
+    inputs_.resize(static_cast<size_t>(inputSize) * batchSize);
+    for (auto& x : inputs_) {
+      x = dist(rng);
+    }
+    lossWeights_.resize(static_cast<size_t>(net_.regSizes[outputReg]) * batchSize);
+    for (auto& x : lossWeights_) {
+      x = dist(rng);
+    }
+  }
+
+  ~BackpropTest()
+  {
+    net_.releaseMemory();
+    program_.releaseMemory();
+  }
+
+  /**
+   * @brief A loss that is linear in the outputs, so that its gradient is just the weights.
+   * */
+  auto loss(const std::vector<float>& inputs) -> float
+  {
+    NN::NetRunner runner(&net_);
+    runner.setBatchSize(batchSize);
+    runner.reset();
+    for (uint16_t b = 0; b < batchSize; b++) {
+      for (uint16_t i = 0; i < inputSize; i++) {
+        runner.getRegister(0, b)[i] = inputs[b * inputSize + i];
+      }
+    }
+    NN::exec(program_, runner);
+    const auto outSize = net_.regSizes[outputReg];
+    float sum{};
+    for (uint16_t b = 0; b < batchSize; b++) {
+      for (uint16_t i = 0; i < outSize; i++) {
+        sum += runner.getRegister(outputReg, b)[i] * lossWeights_[b * outSize + i];
+      }
+    }
+    return sum;
+  }
+
+  void check()
+  {
+    NN::GradientTape tape(&net_);
+    tape.reset();
+    NN::exec(program_, tape);
+    ASSERT_TRUE(tape.allocMemory());
+
+    NN::Backprop backprop(&net_, &tape);
+    ASSERT_TRUE(backprop.allocMemory());
+
+    tape.setBatchSize(batchSize);
+    tape.reset();
+    for (uint16_t b = 0; b < batchSize; b++) {
+      for (uint16_t i = 0; i < inputSize; i++) {
+        tape.getRegister(0, b)[i] = inputs_[b * inputSize + i];
+      }
+    }
+    NN::exec(program_, tape);
+
+    backprop.reset();
+    const auto outSize = net_.regSizes[outputReg];
+    for (uint16_t b = 0; b < batchSize; b++) {
+      for (uint16_t i = 0; i < outSize; i++) {
+        backprop.getGradient(outputReg, b)[i] = lossWeights_[b * outSize + i];
+      }
+    }
+    NN::reverseExec(program_, backprop);
+
+    constexpr float eps = 1.0e-2F;
+
+    const auto* grads = backprop.getParameterGradients();
+    for (uint32_t i = 0; i < net_.numParameters; i++) {
+      const auto saved = net_.parameters[i];
+      net_.parameters[i] = saved + eps;
+      const auto lossPlus = loss(inputs_);
+      net_.parameters[i] = saved - eps;
+      const auto lossMinus = loss(inputs_);
+      net_.parameters[i] = saved;
+      const auto expected = (lossPlus - lossMinus) / (2.0F * eps);
+      EXPECT_NEAR(grads[i], expected, 2.0e-3F + 2.0e-2F * std::fabs(expected)) << "parameter " << i;
+    }
+
+    for (uint16_t b = 0; b < batchSize; b++) {
+      for (uint16_t i = 0; i < inputSize; i++) {
+        auto inputs = inputs_;
+        inputs[b * inputSize + i] += eps;
+        const auto lossPlus = loss(inputs);
+        inputs[b * inputSize + i] -= 2.0F * eps;
+        const auto lossMinus = loss(inputs);
+        const auto expected = (lossPlus - lossMinus) / (2.0F * eps);
+        EXPECT_NEAR(backprop.getGradient(0, b)[i], expected, 2.0e-3F + 2.0e-2F * std::fabs(expected))
+          << "sample " << b << " input " << i;
+      }
+    }
+
+    backprop.releaseMemory();
+    tape.releaseMemory();
+  }
+
+private:
+  NN::Program program_;
+
+  NN::Net net_;
+
+  std::vector<float> inputs_;
+
+  std::vector<float> lossWeights_;
+};
+
+} // namespace
+
+TEST(Backprop, MatchesFiniteDifferences)
+{
+  BackpropTest test(GradCase{});
+  test.check();
+}
+
+TEST(Backprop, MatchesFiniteDifferencesFused)
+{
+  GradCase gradCase;
+  gradCase.fuse = true;
+  BackpropTest test(gradCase);
+  test.check();
+}
+
+TEST(Backprop, MatchesFiniteDifferencesPadded)
+{
+  GradCase gradCase;
+  gradCase.layout = NN::WeightLayout::kPadded;
+  BackpropTest test(gradCase);
+  test.check();
+}
+
+TEST(Backprop, MatchesFiniteDifferencesSharedMemory)
+{
+  GradCase gradCase;
+  gradCase.fuse = true;
+  gradCase.shareMemory = true;
+  BackpropTest test(gradCase);
+  test.check();
+}
+
+TEST(Backprop, LossGradients)
+{
+  const float predicted[] = { 1.0F, -2.0F, 0.5F };
+  const float target[] = { 0.0F, 1.0F, 0.5F };
+  float gradient[3]{};
+
+  NN::mseLossGradient(predicted, target, 3, gradient);
+  EXPECT_FLOAT_EQ(gradient[0], 2.0F / 3.0F);
+  EXPECT_FLOAT_EQ(gradient[1], -2.0F);
+  EXPECT_FLOAT_EQ(gradient[2], 0.0F);
+
+  NN::l1LossGradient(predicted, target, 3, gradient);
+  EXPECT_EQ(gradient[0], 1.0F);
+  EXPECT_EQ(gradient[1], -1.0F);
+  EXPECT_EQ(gradient[2], 0.0F);
+}
+
+TEST(Backprop, SGDTrains)
+{
+  constexpr uint16_t numSamples = 32;
+
+  const char src[] = "%1 = Linear 2 16 %0\n"
+                     "%2 = Tanh %1\n"
+                     "%3 = Linear 16 1 %2\n";
+  NN::Program program;
+  ASSERT_EQ(NN::compile(src, sizeof(src) - 1, &program), NN::SyntaxError::kNone);
+
+  NN::Net net;
+  net.batchSize = numSamples;
+  NN::NetBuilder builder(&net, 2);
+  NN::exec(program, builder);
+  ASSERT_TRUE(builder.finish());
+
+  std::mt19937 rng(1);
+  std::normal_distribution<float> weightDist(0.0F, 0.5F);
+  for (uint32_t i = 0; i < net.numParameters; i++) {
+    net.parameters[i] = weightDist(rng);
+  }
+
+  // Fit a smooth function of two inputs.
+  std::uniform_real_distribution<float> inputDist(-1.0F, 1.0F);
+  std::vector<float> inputs(numSamples * 2);
+  std::vector<float> targets(numSamples);
+  for (uint16_t b = 0; b < numSamples; b++) {
+    inputs[b * 2] = inputDist(rng);
+    inputs[b * 2 + 1] = inputDist(rng);
+    targets[b] = std::sin(2.0F * inputs[b * 2]) * inputs[b * 2 + 1];
+  }
+
+  NN::GradientTape tape(&net);
+  tape.reset();
+  NN::exec(program, tape);
+  ASSERT_TRUE(tape.allocMemory());
+  tape.setBatchSize(numSamples);
+
+  NN::Backprop backprop(&net, &tape);
+  ASSERT_TRUE(backprop.allocMemory());
+
+  NN::SGDOptimizer optimizer(&net, 0.05F, 0.9F);
+  ASSERT_TRUE(optimizer.allocMemory());
+
+  auto runStep = [&]() -> float {
+    tape.reset();
+    for (uint16_t b = 0; b < numSamples; b++) {
+      tape.getRegister(0, b)[0] = inputs[b * 2];
+      tape.getRegister(0, b)[1] = inputs[b * 2 + 1];
+    }
+    NN::exec(program, tape);
+    backprop.reset();
+    backprop.zeroParameterGradients();
+    float loss{};
+    for (uint16_t b = 0; b < numSamples; b++) {
+      const auto* predicted = tape.getRegister(3, b);
+      loss += NN::mseLoss(predicted, &targets[b], 1) / numSamples;
+      NN::mseLossGradient(predicted, &targets[b], 1, backprop.getGradient(3, b));
+      backprop.getGradient(3, b)[0] /= numSamples;
+    }
+    NN::reverseExec(program, backprop);
+    optimizer.step(backprop.getParameterGradients());
+    return loss;
+  };
+
+  const auto initialLoss = runStep();
+  float finalLoss{};
+  for (int i = 0; i < 500; i++) {
+    finalLoss = runStep();
+  }
+
+  EXPECT_LT(finalLoss, initialLoss * 0.05F);
+  EXPECT_LT(finalLoss, 0.01F);
+
+  optimizer.releaseMemory();
+  backprop.releaseMemory();
+  tape.releaseMemory();
+  net.releaseMemory();
+  program.releaseMemory();
+}
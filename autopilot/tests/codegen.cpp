@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+
+#include <CodeGen.h>
+
+#include <NN_Liveness.h>
+#include <NN_NetBuilder.h>
+#include <NN_Parser.h>
+#include <NN_Program.h>
+#include <NN_Static.h>
+#include <RL_DDPG.h>
+
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+
+/**
+ * @brief Defined by data/static_policy.cpp, which was generated from data/static_policy.nn.
+ * */
+extern const NN::StaticNet staticPolicy;
+
+namespace {
+
+auto
+readTestFile(const std::string& name) -> std::string
+{
+  std::ifstream file(std::string(ARC_AUTOPILOT_TEST_DATA) + "/" + name, std::ios::binary);
+  std::ostringstream stream;
+  stream << file.rdbuf();
+  return stream.str();
+}
+
+/**
+ * @brief Builds the network in the same way as nn-codegen does, with the weights that the golden file was generated
+ *        from.
+ * */
+void
+buildPolicyNet(NN::Program* program, NN::Net* net)
+{
+  const auto source = readTestFile("static_policy.nn");
+  ASSERT_EQ(NN::compile(source.c_str(), static_cast<uint16_t>(source.size()), program), NN::SyntaxError::kNone);
+  (void)NN::fuseActivations(program, 1U << 3);
+
+  NN::NetBuilder builder(net, 9);
+  net->regSizes[1] = 1;
+  net->regSizes[2] = 2;
+  NN::exec(*program, builder);
+
+  NN::Liveness liveness;
+  liveness.markLiveOut(3);
+  NN::exec(*program, liveness);
+  liveness.assignOffsets(net);
+
+  ASSERT_TRUE(builder.finish());
+  ASSERT_EQ(net->numParameters, 688);
+  for (uint32_t i = 0; i < net->numParameters; i++) {
+    net->parameters[i] = static_cast<float>(static_cast<int>((i * 7) % 19) - 9) * 0.03125F;
+  }
+}
+
+} // namespace
+
+TEST(CodeGen, Golden)
+{
+  NN::Program program;
+  NN::Net net;
+  buildPolicyNet(&program, &net);
+
+  std::string source;
+  ASSERT_EQ(NN::generateCode(program, net, "staticPolicy", &source), NN::CodeGenError::kNone);
+  EXPECT_EQ(source, readTestFile("static_policy.cpp"));
+
+  net.releaseMemory();
+  program.releaseMemory();
+}
+
+TEST(CodeGen, RejectsNonFinite)
+{
+  NN::Program program;
+  NN::Net net;
+  buildPolicyNet(&program, &net);
+  net.parameters[5] = std::numeric_limits<float>::quiet_NaN();
+
+  std::string source;
+  EXPECT_EQ(NN::generateCode(program, net, "staticPolicy", &source), NN::CodeGenError::kNotFinite);
+
+  net.releaseMemory();
+  program.releaseMemory();
+}
+
+TEST(CodeGen, RejectsUnsupportedNets)
+{
+  const char* sources[]{ "%1 = GRU 3 4 %0\n", "%1 = Linear 3 4 %0\n" };
+  const NN::WeightLayout layouts[]{ NN::WeightLayout::kPacked, NN::WeightLayout::kPadded };
+  const NN::CodeGenError errors[]{ NN::CodeGenError::kStateful, NN::CodeGenError::kPaddedLayout };
+
+  for (int i = 0; i < 2; i++) {
+    NN::Program program;
+    ASSERT_EQ(NN::compile(sources[i], static_cast<uint16_t>(strlen(sources[i])), &program), NN::SyntaxError::kNone);
+    NN::Net net;
+    net.weightLayout = layouts[i];
+    NN::NetBuilder builder(&net, 3);
+    NN::exec(program, builder);
+    ASSERT_TRUE(builder.finish());
+
+    std::string source;
+    EXPECT_EQ(NN::generateCode(program, net, "staticPolicy", &source), errors[i]);
+
+    net.releaseMemory();
+    program.releaseMemory();
+  }
+}
+
+TEST(CodeGen, MatchesInterpreter)
+{
+  NN::Program program;
+  NN::Net net;
+  buildPolicyNet(&program, &net);
+
+  RL::DDPGPolicy policy(&net, &program);
+  RL::StaticDDPGPolicy staticPolicyRunner(&staticPolicy);
+
+  for (int i = 0; i < NN_MAX_REGS; i++) {
+    EXPECT_EQ(staticPolicy.regSizes[i], net.regSizes[i]);
+  }
+
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(-1, 1);
+  for (int trial = 0; trial < 10; trial++) {
+    RL::State state;
+    for (auto& x : state.rotation) {
+      x = dist(rng);
+    }
+    state.altitudeError = dist(rng);
+    state.speedError[0] = dist(rng);
+    state.speedError[1] = dist(rng);
+
+    RL::Action expected;
+    RL::Action actual;
+    policy.computeAction(state, expected);
+    staticPolicyRunner.computeAction(state, actual);
+    for (int i = 0; i < 16; i++) {
+      EXPECT_NEAR(actual.actuators[i], expected.actuators[i], 1.0e-5F);
+    }
+  }
+
+  net.releaseMemory();
+  program.releaseMemory();
+}
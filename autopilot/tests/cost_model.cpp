@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+
+#include <NN_CostModel.h>
+#include <NN_Liveness.h>
+#include <NN_NetBuilder.h>
+#include <NN_Parser.h>
+#include <NN_Program.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+
+auto
+readPolicy() -> std::string
+{
+  std::ifstream file(std::string(ARC_AUTOPILOT_TEST_DATA) + "/static_policy.nn", std::ios::binary);
+  std::ostringstream stream;
+  stream << file.rdbuf();
+  return stream.str();
+}
+
+void
+setPolicyInputs(NN::CostModel* model)
+{
+  model->setInputSize(0, 9);
+  model->setInputSize(1, 1);
+  model->setInputSize(2, 2);
+}
+
+} // namespace
+
+TEST(CostModel, CountsPolicy)
+{
+  const auto source = readPolicy();
+  NN::CostModel model(NN::getCostTable(NN::CostTarget::kCortexM4F));
+  setPolicyInputs(&model);
+  ASSERT_EQ(NN::exec(source.c_str(), static_cast<uint16_t>(source.size()), model), NN::SyntaxError::kNone);
+
+  EXPECT_FALSE(model.hasShapeError());
+  // Two 12x16 layers, a 16x16 layer and a 4x4 by 4x4 product.
+  EXPECT_EQ(model.getMacs(), 12 * 16 * 2 + 16 * 16 + 4 * 4 * 4);
+  EXPECT_EQ(model.getTranscendentals(), 32);
+  // Two concatenations of 10 and 12 values, the product, the sum and the ReLU.
+  EXPECT_EQ(model.getElementOps(), 10 + 12 + 16 + 16 + 16);
+  EXPECT_EQ(model.getParameterBytes(), 688 * sizeof(float));
+}
+
+TEST(CostModel, ActivationBytesMatchNet)
+{
+  const auto source = readPolicy();
+  NN::Program program;
+  ASSERT_EQ(NN::compile(source.c_str(), static_cast<uint16_t>(source.size()), &program), NN::SyntaxError::kNone);
+
+  NN::CostModel model(NN::getCostTable(NN::CostTarget::kDesktop));
+  setPolicyInputs(&model);
+  NN::exec(program, model);
+
+  // Without register sharing, every register is allocated.
+  NN::Net net;
+  NN::NetBuilder builder(&net, 9);
+  net.regSizes[1] = 1;
+  net.regSizes[2] = 2;
+  NN::exec(program, builder);
+  ASSERT_TRUE(builder.finish());
+  EXPECT_EQ(model.getActivationBytes(), net.arenaSize * sizeof(float));
+  const auto unshared = model.getActivationBytes();
+  net.releaseMemory();
+
+  // With sharing, the peak is a lower bound of the arena.
+  NN::Liveness liveness;
+  liveness.markLiveOut(3);
+  NN::exec(program, liveness);
+  model.setLiveness(&liveness);
+
+  NN::Net sharedNet;
+  NN::NetBuilder sharedBuilder(&sharedNet, 9);
+  sharedNet.regSizes[1] = 1;
+  sharedNet.regSizes[2] = 2;
+  NN::exec(program, sharedBuilder);
+  liveness.assignOffsets(&sharedNet);
+  ASSERT_TRUE(sharedBuilder.finish());
+  EXPECT_LT(model.getActivationBytes(), unshared);
+  EXPECT_GT(model.getActivationBytes(), 0);
+  EXPECT_LE(model.getActivationBytes(), sharedNet.arenaSize * sizeof(float));
+  sharedNet.releaseMemory();
+
+  program.releaseMemory();
+}
+
+TEST(CostModel, StateBytesMatchNet)
+{
+  const char source[] = "%1 = GRU 4 8 %0\n"
+                        "%2 = Conv1D 8 4 3 %1\n";
+  NN::Program program;
+  ASSERT_EQ(NN::compile(source, sizeof(source) - 1, &program), NN::SyntaxError::kNone);
+
+  NN::CostModel model(NN::getCostTable(NN::CostTarget::kCortexM4F));
+  model.setInputSize(0, 4);
+  NN::exec(program, model);
+
+  NN::Net net;
+  NN::NetBuilder builder(&net, 4);
+  NN::exec(program, builder);
+  ASSERT_TRUE(builder.finish());
+  EXPECT_EQ(model.getStateBytes(), net.stateSize * sizeof(float));
+  EXPECT_EQ(model.getStateBytes(), (8 + 3 * 8) * sizeof(float));
+  EXPECT_EQ(model.getWorkingBytes(), model.getActivationBytes() + model.getStateBytes());
+  net.releaseMemory();
+
+  program.releaseMemory();
+}
+
+TEST(CostModel, Cycles)
+{
+  NN::CostTable table;
+  table.clockHz = 2000000;
+  table.instructionCycles = 10;
+  table.macCycles = 1;
+  table.elementCycles = 2;
+  table.reluCycles = 3;
+  table.sigmoidCycles = 4;
+  table.tanhCycles = 5;
+
+  const char source[] = "%1 = Linear 4 8 %0\n"
+                        "%2 = Tanh %1\n"
+                        "%3 = CompAdd %2 %2\n";
+  NN::Program program;
+  ASSERT_EQ(NN::compile(source, sizeof(source) - 1, &program), NN::SyntaxError::kNone);
+
+  NN::CostModel model(table);
+  model.setInputSize(0, 4);
+  NN::exec(program, model);
+  EXPECT_FLOAT_EQ(model.getCycles(), 3 * 10 + 32 * 1 + 8 * 5 + 8 * 2);
+  EXPECT_FLOAT_EQ(model.getMicroseconds(), model.getCycles() / 2);
+
+  // Fusing the activation only saves the dispatch.
+  EXPECT_EQ(NN::fuseActivations(&program, 1U << 3), 1);
+  NN::CostModel fusedModel(table);
+  fusedModel.setInputSize(0, 4);
+  NN::exec(program, fusedModel);
+  EXPECT_FLOAT_EQ(fusedModel.getCycles(), model.getCycles() - 10);
+
+  program.releaseMemory();
+}
+
+TEST(CostModel, Targets)
+{
+  const auto source = readPolicy();
+  float microseconds[3]{};
+  const NN::CostTarget targets[3]{ NN::CostTarget::kDesktop,
+                                   NN::CostTarget::kCortexM4F,
+                                   NN::CostTarget::kCortexM0Plus };
+  for (int i = 0; i < 3; i++) {
+    NN::CostModel model(NN::getCostTable(targets[i]));
+    setPolicyInputs(&model);
+    ASSERT_EQ(NN::exec(source.c_str(), static_cast<uint16_t>(source.size()), model), NN::SyntaxError::kNone);
+    microseconds[i] = model.getMicroseconds();
+  }
+  EXPECT_LT(microseconds[0], microseconds[1]);
+  EXPECT_LT(microseconds[1], microseconds[2]);
+}
+
+TEST(CostModel, ShapeError)
+{
+  const char source[] = "%3 = MatMul 3 %1 %2\n";
+  NN::CostModel model(NN::getCostTable(NN::CostTarget::kDesktop));
+  model.setInputSize(1, 4);
+  model.setInputSize(2, 4);
+  ASSERT_EQ(NN::exec(source, sizeof(source) - 1, model), NN::SyntaxError::kNone);
+  EXPECT_TRUE(model.hasShapeError());
+}
@@ -0,0 +1,155 @@
+// Generated by nn-codegen. Do not edit.
+
+#include <NN_Static.h>
+
+namespace {
+
+constexpr uint32_t kArenaSize = 48;
+
+constexpr uint32_t kNumParameters = 688;
+
+float arena[kArenaSize]{};
+
+const float parameters[kNumParameters]{
+  -0.28125F, -0.0625F, 0.15625F, -0.21875F, 0.0F, 0.21875F,
+  -0.15625F, 0.0625F, 0.28125F, -0.09375F, 0.125F, -0.25F,
+  -0.03125F, 0.1875F, -0.1875F, 0.03125F, 0.25F, -0.125F,
+  0.09375F, -0.28125F, -0.0625F, 0.15625F, -0.21875F, 0.0F,
+  0.21875F, -0.15625F, 0.0625F, 0.28125F, -0.09375F, 0.125F,
+  -0.25F, -0.03125F, 0.1875F, -0.1875F, 0.03125F, 0.25F,
+  -0.125F, 0.09375F, -0.28125F, -0.0625F, 0.15625F, -0.21875F,
+  0.0F, 0.21875F, -0.15625F, 0.0625F, 0.28125F, -0.09375F,
+  0.125F, -0.25F, -0.03125F, 0.1875F, -0.1875F, 0.03125F,
+  0.25F, -0.125F, 0.09375F, -0.28125F, -0.0625F, 0.15625F,
+  -0.21875F, 0.0F, 0.21875F, -0.15625F, 0.0625F, 0.28125F,
+  -0.09375F, 0.125F, -0.25F, -0.03125F, 0.1875F, -0.1875F,
+  0.03125F, 0.25F, -0.125F, 0.09375F, -0.28125F, -0.0625F,
+  0.15625F, -0.21875F, 0.0F, 0.21875F, -0.15625F, 0.0625F,
+  0.28125F, -0.09375F, 0.125F, -0.25F, -0.03125F, 0.1875F,
+  -0.1875F, 0.03125F, 0.25F, -0.125F, 0.09375F, -0.28125F,
+  -0.0625F, 0.15625F, -0.21875F, 0.0F, 0.21875F, -0.15625F,
+  0.0625F, 0.28125F, -0.09375F, 0.125F, -0.25F, -0.03125F,
+  0.1875F, -0.1875F, 0.03125F, 0.25F, -0.125F, 0.09375F,
+  -0.28125F, -0.0625F, 0.15625F, -0.21875F, 0.0F, 0.21875F,
+  -0.15625F, 0.0625F, 0.28125F, -0.09375F, 0.125F, -0.25F,
+  -0.03125F, 0.1875F, -0.1875F, 0.03125F, 0.25F, -0.125F,
+  0.09375F, -0.28125F, -0.0625F, 0.15625F, -0.21875F, 0.0F,
+  0.21875F, -0.15625F, 0.0625F, 0.28125F, -0.09375F, 0.125F,
+  -0.25F, -0.03125F, 0.1875F, -0.1875F, 0.03125F, 0.25F,
+  -0.125F, 0.09375F, -0.28125F, -0.0625F, 0.15625F, -0.21875F,
+  0.0F, 0.21875F, -0.15625F, 0.0625F, 0.28125F, -0.09375F,
+  0.125F, -0.25F, -0.03125F, 0.1875F, -0.1875F, 0.03125F,
+  0.25F, -0.125F, 0.09375F, -0.28125F, -0.0625F, 0.15625F,
+  -0.21875F, 0.0F, 0.21875F, -0.15625F, 0.0625F, 0.28125F,
+  -0.09375F, 0.125F, -0.25F, -0.03125F, 0.1875F, -0.1875F,
+  0.03125F, 0.25F, -0.125F, 0.09375F, -0.28125F, -0.0625F,
+  0.15625F, -0.21875F, 0.0F, 0.21875F, -0.15625F, 0.0625F,
+  0.28125F, -0.09375F, 0.125F, -0.25F, -0.03125F, 0.1875F,
+  -0.1875F, 0.03125F, 0.25F, -0.125F, 0.09375F, -0.28125F,
+  -0.0625F, 0.15625F, -0.21875F, 0.0F, 0.21875F, -0.15625F,
+  0.0625F, 0.28125F, -0.09375F, 0.125F, -0.25F, -0.03125F,
+  0.1875F, -0.1875F, 0.03125F, 0.25F, -0.125F, 0.09375F,
+  -0.28125F, -0.0625F, 0.15625F, -0.21875F, 0.0F, 0.21875F,
+  -0.15625F, 0.0625F, 0.28125F, -0.09375F, 0.125F, -0.25F,
+  -0.03125F, 0.1875F, -0.1875F, 0.03125F, 0.25F, -0.125F,
+  0.09375F, -0.28125F, -0.0625F, 0.15625F, -0.21875F, 0.0F,
+  0.21875F, -0.15625F, 0.0625F, 0.28125F, -0.09375F, 0.125F,
+  -0.25F, -0.03125F, 0.1875F, -0.1875F, 0.03125F, 0.25F,
+  -0.125F, 0.09375F, -0.28125F, -0.0625F, 0.15625F, -0.21875F,
+  0.0F, 0.21875F, -0.15625F, 0.0625F, 0.28125F, -0.09375F,
+  0.125F, -0.25F, -0.03125F, 0.1875F, -0.1875F, 0.03125F,
+  0.25F, -0.125F, 0.09375F, -0.28125F, -0.0625F, 0.15625F,
+  -0.21875F, 0.0F, 0.21875F, -0.15625F, 0.0625F, 0.28125F,
+  -0.09375F, 0.125F, -0.25F, -0.03125F, 0.1875F, -0.1875F,
+  0.03125F, 0.25F, -0.125F, 0.09375F, -0.28125F, -0.0625F,
+  0.15625F, -0.21875F, 0.0F, 0.21875F, -0.15625F, 0.0625F,
+  0.28125F, -0.09375F, 0.125F, -0.25F, -0.03125F, 0.1875F,
+  -0.1875F, 0.03125F, 0.25F, -0.125F, 0.09375F, -0.28125F,
+  -0.0625F, 0.15625F, -0.21875F, 0.0F, 0.21875F, -0.15625F,
+  0.0625F, 0.28125F, -0.09375F, 0.125F, -0.25F, -0.03125F,
+  0.1875F, -0.1875F, 0.03125F, 0.25F, -0.125F, 0.09375F,
+  -0.28125F, -0.0625F, 0.15625F, -0.21875F, 0.0F, 0.21875F,
+  -0.15625F, 0.0625F, 0.28125F, -0.09375F, 0.125F, -0.25F,
+  -0.03125F, 0.1875F, -0.1875F, 0.03125F, 0.25F, -0.125F,
+  0.09375F, -0.28125F, -0.0625F, 0.15625F, -0.21875F, 0.0F,
+  0.21875F, -0.15625F, 0.0625F, 0.28125F, -0.09375F, 0.125F,
+  -0.25F, -0.03125F, 0.1875F, -0.1875F, 0.03125F, 0.25F,
+  -0.125F, 0.09375F, -0.28125F, -0.0625F, 0.15625F, -0.21875F,
+  0.0F, 0.21875F, -0.15625F, 0.0625F, 0.28125F, -0.09375F,
+  0.125F, -0.25F, -0.03125F, 0.1875F, -0.1875F, 0.03125F,
+  0.25F, -0.125F, 0.09375F, -0.28125F, -0.0625F, 0.15625F,
+  -0.21875F, 0.0F, 0.21875F, -0.15625F, 0.0625F, 0.28125F,
+  -0.09375F, 0.125F, -0.25F, -0.03125F, 0.1875F, -0.1875F,
+  0.03125F, 0.25F, -0.125F, 0.09375F, -0.28125F, -0.0625F,
+  0.15625F, -0.21875F, 0.0F, 0.21875F, -0.15625F, 0.0625F,
+  0.28125F, -0.09375F, 0.125F, -0.25F, -0.03125F, 0.1875F,
+  -0.1875F, 0.03125F, 0.25F, -0.125F, 0.09375F, -0.28125F,
+  -0.0625F, 0.15625F, -0.21875F, 0.0F, 0.21875F, -0.15625F,
+  0.0625F, 0.28125F, -0.09375F, 0.125F, -0.25F, -0.03125F,
+  0.1875F, -0.1875F, 0.03125F, 0.25F, -0.125F, 0.09375F,
+  -0.28125F, -0.0625F, 0.15625F, -0.21875F, 0.0F, 0.21875F,
+  -0.15625F, 0.0625F, 0.28125F, -0.09375F, 0.125F, -0.25F,
+  -0.03125F, 0.1875F, -0.1875F, 0.03125F, 0.25F, -0.125F,
+  0.09375F, -0.28125F, -0.0625F, 0.15625F, -0.21875F, 0.0F,
+  0.21875F, -0.15625F, 0.0625F, 0.28125F, -0.09375F, 0.125F,
+  -0.25F, -0.03125F, 0.1875F, -0.1875F, 0.03125F, 0.25F,
+  -0.125F, 0.09375F, -0.28125F, -0.0625F, 0.15625F, -0.21875F,
+  0.0F, 0.21875F, -0.15625F, 0.0625F, 0.28125F, -0.09375F,
+  0.125F, -0.25F, -0.03125F, 0.1875F, -0.1875F, 0.03125F,
+  0.25F, -0.125F, 0.09375F, -0.28125F, -0.0625F, 0.15625F,
+  -0.21875F, 0.0F, 0.21875F, -0.15625F, 0.0625F, 0.28125F,
+  -0.09375F, 0.125F, -0.25F, -0.03125F, 0.1875F, -0.1875F,
+  0.03125F, 0.25F, -0.125F, 0.09375F, -0.28125F, -0.0625F,
+  0.15625F, -0.21875F, 0.0F, 0.21875F, -0.15625F, 0.0625F,
+  0.28125F, -0.09375F, 0.125F, -0.25F, -0.03125F, 0.1875F,
+  -0.1875F, 0.03125F, 0.25F, -0.125F, 0.09375F, -0.28125F,
+  -0.0625F, 0.15625F, -0.21875F, 0.0F, 0.21875F, -0.15625F,
+  0.0625F, 0.28125F, -0.09375F, 0.125F, -0.25F, -0.03125F,
+  0.1875F, -0.1875F, 0.03125F, 0.25F, -0.125F, 0.09375F,
+  -0.28125F, -0.0625F, 0.15625F, -0.21875F, 0.0F, 0.21875F,
+  -0.15625F, 0.0625F, 0.28125F, -0.09375F, 0.125F, -0.25F,
+  -0.03125F, 0.1875F, -0.1875F, 0.03125F, 0.25F, -0.125F,
+  0.09375F, -0.28125F, -0.0625F, 0.15625F, -0.21875F, 0.0F,
+  0.21875F, -0.15625F, 0.0625F, 0.28125F, -0.09375F, 0.125F,
+  -0.25F, -0.03125F, 0.1875F, -0.1875F, 0.03125F, 0.25F,
+  -0.125F, 0.09375F, -0.28125F, -0.0625F, 0.15625F, -0.21875F,
+  0.0F, 0.21875F, -0.15625F, 0.0625F, 0.28125F, -0.09375F,
+  0.125F, -0.25F, -0.03125F, 0.1875F, -0.1875F, 0.03125F,
+  0.25F, -0.125F, 0.09375F, -0.28125F, -0.0625F, 0.15625F,
+  -0.21875F, 0.0F, 0.21875F, -0.15625F, 0.0625F, 0.28125F,
+  -0.09375F, 0.125F, -0.25F, -0.03125F, 0.1875F, -0.1875F,
+  0.03125F, 0.25F, -0.125F, 0.09375F, -0.28125F, -0.0625F,
+  0.15625F, -0.21875F, 0.0F, 0.21875F, -0.15625F, 0.0625F,
+  0.28125F, -0.09375F, 0.125F, -0.25F, -0.03125F, 0.1875F,
+  -0.1875F, 0.03125F, 0.25F, -0.125F, 0.09375F, -0.28125F,
+  -0.0625F, 0.15625F, -0.21875F, 0.0F, 0.21875F, -0.15625F,
+  0.0625F, 0.28125F, -0.09375F, 0.125F, -0.25F, -0.03125F,
+  0.1875F, -0.1875F, 0.03125F, 0.25F, -0.125F, 0.09375F,
+  -0.28125F, -0.0625F, 0.15625F, -0.21875F,
+};
+
+void
+run()
+{
+  NN::staticConcat<9, 1, NN::Activation::kNone, NN::ActivationMode::kPrecise>(arena + 10, arena + 21, arena + 0);
+  NN::staticConcat<10, 2, NN::Activation::kNone, NN::ActivationMode::kPrecise>(arena + 0, arena + 19, arena + 32);
+  NN::staticLinear<12, 16, NN::Activation::kTanh, NN::ActivationMode::kPrecise>(parameters + 0, arena + 32, arena + 0);
+  NN::staticLinear<12, 16, NN::Activation::kSigmoid, NN::ActivationMode::kPrecise>(parameters + 208, arena + 32, arena + 16);
+  NN::staticCompMul<16, NN::Activation::kNone, NN::ActivationMode::kPrecise>(arena + 0, arena + 16, arena + 32);
+  NN::staticMatMul<4, 4, 4, NN::Activation::kNone, NN::ActivationMode::kPrecise>(arena + 32, arena + 32, arena + 0);
+  NN::staticCompAdd<16, NN::Activation::kReLU, NN::ActivationMode::kPrecise>(arena + 0, arena + 32, arena + 16);
+  NN::staticLinear<16, 16, NN::Activation::kNone, NN::ActivationMode::kPrecise>(parameters + 416, arena + 16, arena + 0);
+}
+
+const NN::FeatureSize regSizes[NN_MAX_REGS]{ 9, 1, 2, 16, 10, 12, 0, 16, 0, 16, 16, 16, 0, 16 };
+
+float* const regs[NN_MAX_REGS]{
+  arena + 10, arena + 21, arena + 19, arena + 0,
+  arena + 0, arena + 32, arena + 0, arena + 0,
+  arena + 0, arena + 16, arena + 32, arena + 0,
+  arena + 0, arena + 16,
+};
+
+} // namespace
+
+extern const NN::StaticNet staticPolicy{ regSizes, regs, run };
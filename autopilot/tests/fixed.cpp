@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+
+#include <NN_FixedNet.h>
+#include <NN_FixedNetRunner.h>
+#include <NN_NetBuilder.h>
+#include <NN_NetRunner.h>
+#include <NN_Parser.h>
+#include <NN_Program.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr uint8_t fracBits = 12;
+
+/**
+ * @brief Converts a float network to fixed-point and checks that both networks agree.
+ * */
+void
+checkFixedOutput(const char* source,
+                 const uint16_t length,
+                 const uint8_t outputReg,
+                 const float tolerance,
+                 const uint16_t expectedFusions = 0)
+{
+  constexpr uint16_t inputSize = 8;
+  constexpr uint16_t batchSize = 16;
+
+  NN::Program program;
+  ASSERT_EQ(NN::compile(source, length, &program), NN::SyntaxError::kNone);
+  if (expectedFusions > 0) {
+    ASSERT_EQ(NN::fuseActivations(&program, 0), expectedFusions);
+  }
+
+  NN::Net net;
+  net.batchSize = batchSize;
+  NN::NetBuilder builder(&net, inputSize);
+  NN::exec(program, builder);
+  ASSERT_TRUE(builder.finish());
+
+  std::mt19937 rng(42);
+  std::normal_distribution<float> weightDist(0.0F, 0.3F);
+  for (uint32_t i = 0; i < net.numParameters; i++) {
+    net.parameters[i] = weightDist(rng);
+  }
+
+  NN::FixedNet fixedNet;
+  ASSERT_TRUE(NN::convertToFixed(program, net, fracBits, &fixedNet));
+
+  NN::NetRunner runner(&net);
+  runner.setBatchSize(batchSize);
+  NN::FixedNetRunner fixedRunner(&fixedNet);
+  fixedRunner.setBatchSize(batchSize);
+
+  std::uniform_real_distribution<float> inputDist(-1.0F, 1.0F);
+  std::vector<float> input(inputSize);
+  for (uint16_t b = 0; b < batchSize; b++) {
+    for (auto& x : input) {
+      x = inputDist(rng);
+    }
+    std::copy(input.begin(), input.end(), runner.getRegister(0, b));
+    fixedRunner.setInput(0, b, input.data());
+  }
+
+  runner.reset();
+  NN::exec(program, runner);
+  fixedRunner.reset();
+  NN::exec(program, fixedRunner);
+
+  // The registers are laid out the same way.
+  for (uint8_t i = 0; i < NN_MAX_REGS; i++) {
+    EXPECT_EQ(fixedNet.regSizes[i], net.regSizes[i]);
+    EXPECT_EQ(fixedNet.regOffsets[i], net.regOffsets[i]);
+  }
+
+  const auto outputSize = net.regSizes[outputReg];
+  std::vector<float> output(outputSize);
+  auto maxError = 0.0F;
+  for (uint16_t b = 0; b < batchSize; b++) {
+    fixedRunner.getOutput(outputReg, b, output.data());
+    const auto* expected = runner.getRegister(outputReg, b);
+    for (uint16_t i = 0; i < outputSize; i++) {
+      maxError = std::fmax(maxError, std::fabs(output[i] - expected[i]));
+    }
+  }
+  EXPECT_LT(maxError, tolerance);
+
+  fixedNet.releaseMemory();
+  net.releaseMemory();
+  program.releaseMemory();
+}
+
+} // namespace
+
+TEST(Fixed, Conversion)
+{
+  EXPECT_EQ(NN::toFixed(1.0F, fracBits), 4096);
+  EXPECT_EQ(NN::toFixed(-0.5F, fracBits), -2048);
+  EXPECT_EQ(NN::toFixed(100.0F, fracBits), 32767);
+  EXPECT_EQ(NN::toFixed(-100.0F, fracBits), -32768);
+  EXPECT_EQ(NN::fromFixed(6144, fracBits), 1.5F);
+}
+
+TEST(Fixed, Activations)
+{
+  const auto lsb = NN::fromFixed(1, fracBits);
+  auto maxSigmoidError = 0.0F;
+  auto maxTanhError = 0.0F;
+  for (int32_t q = -32768; q <= 32767; q++) {
+    const auto x = NN::fromFixed(static_cast<int16_t>(q), fracBits);
+    const auto sigmoid = NN::fromFixed(NN::fixedSigmoid(static_cast<int16_t>(q), fracBits), fracBits);
+    const auto tanh = NN::fromFixed(NN::fixedTanh(static_cast<int16_t>(q), fracBits), fracBits);
+    maxSigmoidError = std::fmax(maxSigmoidError, std::fabs(sigmoid - 1.0F / (1.0F + std::exp(-x))));
+    maxTanhError = std::fmax(maxTanhError, std::fabs(tanh - std::tanh(x)));
+  }
+  EXPECT_LT(maxSigmoidError, 4.0e-4F + lsb);
+  EXPECT_LT(maxTanhError, 7.0e-4F + lsb);
+}
+
+TEST(Fixed, Saturates)
+{
+  const char src[] = "%2 = CompAdd %0 %1\n"
+                     "%3 = CompMul %0 %1\n";
+  NN::Program program;
+  ASSERT_EQ(NN::compile(src, sizeof(src) - 1, &program), NN::SyntaxError::kNone);
+  NN::Net net;
+  NN::NetBuilder builder(&net, 2);
+  net.regSizes[1] = 2;
+  NN::exec(program, builder);
+  ASSERT_TRUE(builder.finish());
+
+  NN::FixedNet fixedNet;
+  ASSERT_TRUE(NN::convertToFixed(program, net, fracBits, &fixedNet));
+  NN::FixedNetRunner runner(&fixedNet);
+  const float a[2]{ 7.5F, -7.5F };
+  const float b[2]{ 7.5F, 0.5F };
+  runner.setInput(0, 0, a);
+  runner.setInput(1, 0, b);
+  runner.reset();
+  NN::exec(program, runner);
+
+  EXPECT_EQ(runner.getRegister(2, 0)[0], 32767);
+  EXPECT_EQ(runner.getRegister(2, 0)[1], NN::toFixed(-7.0F, fracBits));
+  EXPECT_EQ(runner.getRegister(3, 0)[0], 32767);
+  EXPECT_EQ(runner.getRegister(3, 0)[1], NN::toFixed(-3.75F, fracBits));
+
+  fixedNet.releaseMemory();
+  net.releaseMemory();
+  program.releaseMemory();
+}
+
+TEST(Fixed, BadFracBits)
+{
+  NN::Program program;
+  NN::Net net;
+  NN::FixedNet fixedNet;
+  EXPECT_FALSE(NN::convertToFixed(program, net, NN_MAX_FRAC_BITS + 1, &fixedNet));
+}
+
+TEST(Fixed, MatchesFloatMLP)
+{
+  const char src[] = "%1 = Linear 8 32 %0\n"
+                     "%2 = ReLU %1\n"
+                     "%3 = Linear 32 32 %2\n"
+                     "%4 = Tanh %3\n"
+                     "%5 = Linear 32 4 %4\n"
+                     "%6 = Sigmoid %5\n";
+  checkFixedOutput(src, sizeof(src) - 1, 6, 0.005F);
+}
+
+TEST(Fixed, MatchesFloatFused)
+{
+  const char src[] = "%1 = Linear 8 32 %0\n"
+                     "%2 = ReLU %1\n"
+                     "%3 = Linear 32 32 %2\n"
+                     "%4 = Tanh %3\n"
+                     "%5 = CompAdd %4 %2\n"
+                     "%6 = Sigmoid %5\n"
+                     "%7 = Linear 32 4 %6\n";
+  checkFixedOutput(src, sizeof(src) - 1, 7, 0.01F, 3);
+}
+
+TEST(Fixed, MatchesFloatBinaryOps)
+{
+  const char src[] = "%1 = Linear 8 16 %0\n"
+                     "%2 = Linear 8 16 %0\n"
+                     "%3 = CompMul %1 %2\n"
+                     "%4 = Concat %3 %0\n"
+                     "%5 = Linear 24 8 %4\n"
+                     "%6 = MatMul 2 %5 %1\n"
+                     "%7 = ReLU %6\n";
+  checkFixedOutput(src, sizeof(src) - 1, 7, 0.01F);
+}
@@ -0,0 +1,222 @@
+#include <gtest/gtest.h>
+
+#include <NN_GraphOpt.h>
+#include <NN_NetBuilder.h>
+#include <NN_Parser.h>
+#include <NN_Program.h>
+
+#include <cmath>
+#include <cstring>
+#include <random>
+
+namespace {
+
+/**
+ * @brief A program and a float network with random weights, along with their optimized versions.
+ * */
+class GraphOptTest : public testing::Test
+{
+protected:
+  void build(const char* source, const uint16_t inputSize, const NN::WeightLayout layout)
+  {
+    ASSERT_EQ(NN::compile(source, static_cast<uint16_t>(strlen(source)), &program_), NN::SyntaxError::kNone);
+    net_.weightLayout = layout;
+    NN::NetBuilder builder(&net_, inputSize);
+    NN::exec(program_, builder);
+    ASSERT_TRUE(builder.finish());
+
+    std::normal_distribution<float> dist(0.0F, 0.5F);
+    for (uint32_t i = 0; i < net_.numParameters; i++) {
+      net_.parameters[i] = dist(rng_);
+    }
+  }
+
+  void optimize(const NN::RegMask liveOut)
+  {
+    liveOut_ = liveOut;
+    ASSERT_TRUE(NN::optimizeGraph(program_, net_, liveOut, &optimized_, &optimizedNet_, &stats_));
+  }
+
+  auto verify(const uint16_t numRuns = 4) -> float
+  {
+    auto rng = [](void* rngData) -> float {
+      std::uniform_real_distribution<float> dist(-1.0F, 1.0F);
+      return dist(*static_cast<std::mt19937*>(rngData));
+    };
+    return NN::verifyGraph(program_, net_, optimized_, optimizedNet_, liveOut_, numRuns, &rng_, rng);
+  }
+
+  void TearDown() override
+  {
+    optimizedNet_.releaseMemory();
+    optimized_.releaseMemory();
+    net_.releaseMemory();
+    program_.releaseMemory();
+  }
+
+  std::mt19937 rng_{ 1234 };
+
+  NN::Program program_;
+
+  NN::Net net_;
+
+  NN::Program optimized_;
+
+  NN::Net optimizedNet_;
+
+  NN::GraphOptStats stats_;
+
+  NN::RegMask liveOut_{};
+};
+
+} // namespace
+
+TEST_F(GraphOptTest, RemovesDeadAssignments)
+{
+  // %2 is never read, %3 is overwritten before it is read, and %5 only feeds %2.
+  const char source[] = "%1 = Linear 4 8 %0\n"
+                        "%5 = Tanh %1\n"
+                        "%2 = Linear 8 3 %5\n"
+                        "%3 = Linear 4 6 %0\n"
+                        "%3 = ReLU %1\n"
+                        "%4 = Linear 8 2 %3\n";
+  build(source, 4, NN::WeightLayout::kPacked);
+  optimize(NN::regBit(4));
+
+  EXPECT_EQ(stats_.numRemoved, 3);
+  EXPECT_EQ(stats_.numForwarded, 0);
+  EXPECT_EQ(stats_.numFolded, 0);
+  ASSERT_EQ(optimized_.numInstructions, 3);
+  EXPECT_EQ(optimized_.instructions[0].op, NN::OpCode::kLinear);
+  EXPECT_EQ(optimized_.instructions[1].op, NN::OpCode::kReLU);
+  EXPECT_EQ(optimized_.instructions[2].op, NN::OpCode::kLinear);
+  EXPECT_EQ(optimizedNet_.numParameters, (4U * 8U + 8U) + (8U * 2U + 2U));
+  EXPECT_EQ(optimizedNet_.regSizes[2], 0);
+
+  // The kept instructions run with the same parameters, so the outputs are exactly the same.
+  EXPECT_EQ(verify(), 0.0F);
+}
+
+TEST_F(GraphOptTest, ForwardsCopies)
+{
+  const char source[] = "%1 = Linear 4 6 %0\n"
+                        "%2 = ReLU %1\n"
+                        "%3 = ReLU %2\n"
+                        "%4 = Concat %3 %3\n"
+                        "%5 = Linear 12 2 %4\n";
+  build(source, 4, NN::WeightLayout::kPacked);
+  ASSERT_EQ(NN::fuseActivations(&program_, NN::regBit(5)), 1);
+  optimize(NN::regBit(5));
+
+  EXPECT_EQ(stats_.numForwarded, 1);
+  EXPECT_EQ(stats_.numRemoved, 1);
+  ASSERT_EQ(optimized_.numInstructions, 3);
+  EXPECT_EQ(optimized_.instructions[1].op, NN::OpCode::kConcat);
+  EXPECT_EQ(optimized_.instructions[1].leftReg, 2);
+  EXPECT_EQ(optimized_.instructions[1].rightReg, 2);
+  EXPECT_EQ(verify(), 0.0F);
+}
+
+TEST_F(GraphOptTest, ForwardingStopsAtOverwrite)
+{
+  // After %2 is overwritten, %3 is the only copy of its old value.
+  const char source[] = "%1 = Linear 4 6 %0\n"
+                        "%2 = ReLU %1\n"
+                        "%3 = ReLU %2\n"
+                        "%2 = Linear 4 6 %0\n"
+                        "%4 = CompAdd %3 %2\n";
+  build(source, 4, NN::WeightLayout::kPacked);
+  optimize(NN::regBit(4));
+
+  EXPECT_EQ(stats_.numForwarded, 0);
+  EXPECT_EQ(stats_.numRemoved, 0);
+  EXPECT_EQ(optimized_.numInstructions, 5);
+  EXPECT_EQ(verify(), 0.0F);
+}
+
+TEST_F(GraphOptTest, FoldsLinearChains)
+{
+  for (const auto layout : { NN::WeightLayout::kPacked, NN::WeightLayout::kPadded }) {
+    const char source[] = "%1 = Linear 5 32 %0\n"
+                          "%2 = Linear 32 24 %1\n"
+                          "%3 = Linear 24 3 %2\n"
+                          "%3 = Tanh %3\n";
+    build(source, 5, layout);
+    ASSERT_EQ(NN::fuseActivations(&program_, NN::regBit(3)), 1);
+    optimize(NN::regBit(3));
+
+    EXPECT_EQ(stats_.numFolded, 2);
+    EXPECT_EQ(stats_.numRemoved, 2);
+    ASSERT_EQ(optimized_.numInstructions, 1);
+    EXPECT_EQ(optimized_.instructions[0].leftReg, 0);
+    EXPECT_EQ(optimized_.instructions[0].inFeatures, 5);
+    EXPECT_EQ(optimized_.instructions[0].outFeatures, 3);
+    EXPECT_EQ(optimized_.instructions[0].activation, NN::Activation::kTanh);
+    EXPECT_EQ(optimizedNet_.numParameters, NN::linearParameterCount(5, 3, layout));
+    EXPECT_LT(verify(), 1.0e-4F);
+
+    TearDown();
+  }
+}
+
+TEST_F(GraphOptTest, KeepsLinearThatOverwritesItsInput)
+{
+  // The input of the first layer is gone by the time the second one runs.
+  const char source[] = "%0 = Linear 4 4 %0\n"
+                        "%1 = Linear 4 2 %0\n";
+  build(source, 4, NN::WeightLayout::kPacked);
+  optimize(NN::regBit(1));
+
+  EXPECT_EQ(stats_.numFolded, 0);
+  EXPECT_EQ(optimized_.numInstructions, 2);
+  EXPECT_EQ(verify(), 0.0F);
+}
+
+TEST_F(GraphOptTest, KeepsBottleneck)
+{
+  // Folding would take 64 * 64 multiply-adds instead of 2 * 64 * 4.
+  const char source[] = "%1 = Linear 64 4 %0\n"
+                        "%2 = Linear 4 64 %1\n";
+  build(source, 64, NN::WeightLayout::kPacked);
+  optimize(NN::regBit(2));
+
+  EXPECT_EQ(stats_.numFolded, 0);
+  EXPECT_EQ(optimized_.numInstructions, 2);
+  EXPECT_EQ(verify(), 0.0F);
+}
+
+TEST_F(GraphOptTest, KeepsStatefulInstructions)
+{
+  // The output of the GRU is never read, but it still has to update its state on every run.
+  const char source[] = "%1 = GRU 3 4 %0\n"
+                        "%2 = Conv1D 3 2 3 %0\n"
+                        "%3 = Linear 3 5 %0\n"
+                        "%4 = ReLU %2\n";
+  build(source, 3, NN::WeightLayout::kPacked);
+  optimize(NN::regBit(4));
+
+  EXPECT_EQ(stats_.numRemoved, 1);
+  ASSERT_EQ(optimized_.numInstructions, 3);
+  EXPECT_EQ(optimized_.instructions[0].op, NN::OpCode::kGRU);
+  EXPECT_EQ(optimized_.instructions[1].op, NN::OpCode::kConv1D);
+  EXPECT_EQ(optimizedNet_.stateSize, net_.stateSize);
+  EXPECT_EQ(verify(6), 0.0F);
+}
+
+TEST_F(GraphOptTest, VerifierFindsDifferences)
+{
+  const char source[] = "%1 = Linear 4 6 %0\n"
+                        "%2 = Linear 6 2 %1\n";
+  build(source, 4, NN::WeightLayout::kPacked);
+  optimize(NN::regBit(1) | NN::regBit(2));
+
+  EXPECT_EQ(stats_.numFolded, 0);
+  EXPECT_EQ(verify(), 0.0F);
+
+  // The first bias of the last layer.
+  optimizedNet_.parameters[optimizedNet_.numParameters - 2] += 0.5F;
+  EXPECT_NEAR(verify(), 0.5F, 1.0e-6F);
+
+  optimizedNet_.parameters[optimizedNet_.numParameters - 2] = std::nanf("");
+  EXPECT_TRUE(std::isinf(verify()));
+}
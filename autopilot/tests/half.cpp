@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+
+#include <NN_HalfNet.h>
+#include <NN_HalfNetRunner.h>
+#include <NN_NetBuilder.h>
+#include <NN_NetRunner.h>
+#include <NN_Parser.h>
+#include <NN_Program.h>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+TEST(Half, Float16Conversion)
+{
+  const auto f16 = NN::HalfFormat::kFloat16;
+
+  EXPECT_EQ(NN::floatToHalf(0.0F, f16), 0x0000);
+  EXPECT_EQ(NN::floatToHalf(-0.0F, f16), 0x8000);
+  EXPECT_EQ(NN::floatToHalf(1.0F, f16), 0x3c00);
+  EXPECT_EQ(NN::floatToHalf(-2.5F, f16), 0xc100);
+  EXPECT_EQ(NN::floatToHalf(65504.0F, f16), 0x7bff);
+  // The smallest subnormal.
+  EXPECT_EQ(NN::floatToHalf(std::ldexp(1.0F, -24), f16), 0x0001);
+  EXPECT_EQ(NN::floatToHalf(std::ldexp(1.0F, -26), f16), 0x0000);
+
+  // Ties go to the even mantissa.
+  EXPECT_EQ(NN::floatToHalf(1.0F + std::ldexp(1.0F, -11), f16), 0x3c00);
+  EXPECT_EQ(NN::floatToHalf(1.0F + 3.0F * std::ldexp(1.0F, -11), f16), 0x3c02);
+
+  EXPECT_EQ(NN::floatToHalf(65520.0F, f16), 0x7c00);
+  EXPECT_EQ(NN::floatToHalf(-1.0e9F, f16), 0xfc00);
+  EXPECT_EQ(NN::floatToHalf(std::numeric_limits<float>::infinity(), f16), 0x7c00);
+  EXPECT_TRUE(std::isnan(NN::halfToFloat(NN::floatToHalf(std::nanf(""), f16), f16)));
+
+  EXPECT_EQ(NN::halfToFloat(0x3c00, f16), 1.0F);
+  EXPECT_EQ(NN::halfToFloat(0x0001, f16), std::ldexp(1.0F, -24));
+  EXPECT_EQ(NN::halfToFloat(0x83ff, f16), -std::ldexp(1023.0F, -24));
+  EXPECT_EQ(NN::halfToFloat(0xfc00, f16), -std::numeric_limits<float>::infinity());
+
+  // Every finite value survives a round trip.
+  for (uint32_t h = 0; h < 0x10000; h++) {
+    const auto x = NN::halfToFloat(static_cast<uint16_t>(h), f16);
+    if (std::isfinite(x)) {
+      EXPECT_EQ(NN::floatToHalf(x, f16), h);
+    }
+  }
+}
+
+TEST(Half, BFloat16Conversion)
+{
+  const auto bf16 = NN::HalfFormat::kBFloat16;
+
+  EXPECT_EQ(NN::floatToHalf(1.0F, bf16), 0x3f80);
+  EXPECT_EQ(NN::floatToHalf(-2.5F, bf16), 0xc020);
+  EXPECT_EQ(NN::floatToHalf(1.0F + std::ldexp(1.0F, -8), bf16), 0x3f80);
+  EXPECT_EQ(NN::floatToHalf(1.0F + 3.0F * std::ldexp(1.0F, -8), bf16), 0x3f82);
+  // The range is the same as a float.
+  EXPECT_NEAR(NN::halfToFloat(NN::floatToHalf(1.0e30F, bf16), bf16), 1.0e30F, 1.0e30F * std::ldexp(1.0F, -8));
+  EXPECT_TRUE(std::isnan(NN::halfToFloat(NN::floatToHalf(std::nanf(""), bf16), bf16)));
+  EXPECT_EQ(NN::halfToFloat(0x3f80, bf16), 1.0F);
+}
+
+namespace {
+
+/**
+ * @brief Runs a network and its 16 bit copy on the same inputs, and checks that each output is within the documented
+ *        error bound of the format.
+ * */
+void
+checkHalfOutput(const NN::HalfFormat format, const NN::WeightLayout layout, const uint16_t batchSize)
+{
+  const char source[] = "%1 = Linear 24 16 %0\n"
+                        "%2 = ReLU %1\n"
+                        "%3 = Linear 16 5 %2\n";
+
+  NN::Program program;
+  ASSERT_EQ(NN::compile(source, static_cast<uint16_t>(strlen(source)), &program), NN::SyntaxError::kNone);
+
+  NN::Net net;
+  net.batchSize = batchSize;
+  net.weightLayout = layout;
+  NN::NetBuilder builder(&net, 24);
+  NN::exec(program, builder);
+  ASSERT_TRUE(builder.finish());
+
+  std::mt19937 rng(99);
+  std::normal_distribution<float> weightDist(0.0F, 0.3F);
+  for (uint32_t i = 0; i < net.numParameters; i++) {
+    net.parameters[i] = weightDist(rng);
+  }
+
+  NN::HalfNet halfNet;
+  ASSERT_TRUE(NN::convertToHalf(net, format, &halfNet));
+  EXPECT_EQ(halfNet.numParameters, net.numParameters);
+
+  NN::Activations activations;
+  ASSERT_TRUE(activations.allocMemory(halfNet.shape));
+
+  NN::NetRunner runner(&net);
+  runner.setBatchSize(batchSize);
+  NN::HalfNetRunner halfRunner(&halfNet, &activations);
+  halfRunner.setBatchSize(batchSize);
+
+  std::uniform_real_distribution<float> inputDist(-1.0F, 1.0F);
+  for (uint16_t b = 0; b < batchSize; b++) {
+    for (uint16_t i = 0; i < 24; i++) {
+      const auto x = inputDist(rng);
+      runner.getRegister(0, b)[i] = x;
+      halfRunner.getRegister(0, b)[i] = x;
+    }
+  }
+
+  runner.reset();
+  NN::exec(program, runner);
+  halfRunner.reset();
+  NN::exec(program, halfRunner);
+
+  // The error of the hidden layer carries through the weights of the output layer, so the bound is the relative error
+  // times the sum of |w * x| through both layers, which is loosely bounded by the number of terms.
+  const auto relativeError = (format == NN::HalfFormat::kFloat16) ? std::ldexp(1.0F, -11) : std::ldexp(1.0F, -8);
+  const auto tolerance = relativeError * 2.0F * (24 + 16);
+
+  EXPECT_EQ(halfRunner.getRegisterSize(3), 5);
+  for (uint16_t b = 0; b < batchSize; b++) {
+    for (uint16_t i = 0; i < 5; i++) {
+      const auto expected = runner.getRegister(3, b)[i];
+      const auto actual = halfRunner.getRegister(3, b)[i];
+      EXPECT_NEAR(actual, expected, tolerance);
+    }
+  }
+
+  activations.releaseMemory();
+  halfNet.releaseMemory();
+  net.releaseMemory();
+  program.releaseMemory();
+}
+
+} // namespace
+
+TEST(Half, Float16MatchesFloatRunner)
+{
+  checkHalfOutput(NN::HalfFormat::kFloat16, NN::WeightLayout::kPacked, 1);
+}
+
+TEST(Half, BFloat16MatchesFloatRunner)
+{
+  checkHalfOutput(NN::HalfFormat::kBFloat16, NN::WeightLayout::kPadded, 4);
+}
@@ -8,6 +8,9 @@
 #include <NN_NetRunner.h>
 #include <NN_Optim.h>
 #include <NN_Parser.h>
+#include <NN_Program.h>
+
+#include <ThreadPool.h>
 
 #include <cstring>
 
@@ -44,6 +47,383 @@ TEST(NetBuilder, Minimal)
   net.releaseMemory();
 }
 
+TEST(NetBuilder, MatMulShape)
+{
+  // A 2x3 matrix from the first layer, times a 3x4 matrix from the second.
+  auto net = buildNet("%1 = Linear 2 6 %0\n"
+                      "%2 = Linear 2 12 %0\n"
+                      "%3 = MatMul 2 %1 %2\n",
+                      2);
+
+  EXPECT_EQ(net.regSizes[3], 8);
+
+  net.releaseMemory();
+}
+
+TEST(NetBuilder, MatMulShapeError)
+{
+  const std::string source = "%1 = Linear 2 6 %0\n"
+                             "%2 = Linear 2 5 %0\n"
+                             "%3 = MatMul 2 %1 %2\n";
+  NN::Net net;
+  NN::Lexer lexer(source.c_str(), static_cast<uint16_t>(source.size()));
+  NN::NetBuilder builder(&net, 2);
+  NN::Parser parser(&builder);
+  ASSERT_EQ(parser.parse(lexer), NN::SyntaxError::kNone);
+  EXPECT_FALSE(builder.finish());
+}
+
+TEST(NetBuilder, RegisterSizeOverflow)
+{
+  const std::string source = "%1 = Concat %0 %0\n";
+  NN::Net net;
+  NN::Lexer lexer(source.c_str(), static_cast<uint16_t>(source.size()));
+  NN::NetBuilder builder(&net, NN::maxFeatures);
+  NN::Parser parser(&builder);
+  ASSERT_EQ(parser.parse(lexer), NN::SyntaxError::kNone);
+  EXPECT_FALSE(builder.finish());
+}
+
+TEST(NetBuilder, ParameterCountOverflow)
+{
+  // Each layer fits in the 32-bit parameter count, but the two together do not.
+  const std::string source = "%1 = Linear 65535 65535 %0\n"
+                             "%2 = Linear 65535 65535 %0\n";
+  NN::Net net;
+  NN::Lexer lexer(source.c_str(), static_cast<uint16_t>(source.size()));
+  NN::NetBuilder builder(&net, 65535);
+  NN::Parser parser(&builder);
+  ASSERT_EQ(parser.parse(lexer), NN::SyntaxError::kNone);
+  EXPECT_FALSE(builder.finish());
+}
+
+#if NN_WIDE_INDEX
+
+TEST(NetBuilder, WideParameterCountOverflow)
+{
+  // A single layer with more parameters than fit in 32 bits.
+  const std::string source = "%1 = Linear 100000 100000 %0\n";
+  NN::Net net;
+  NN::Lexer lexer(source.c_str(), static_cast<uint16_t>(source.size()));
+  NN::NetBuilder builder(&net, 100000);
+  NN::Parser parser(&builder);
+  ASSERT_EQ(parser.parse(lexer), NN::SyntaxError::kNone);
+  EXPECT_FALSE(builder.finish());
+}
+
+TEST(NetBuilder, WideArenaOverflow)
+{
+  // Each register fits, but the arena that holds both of them does not.
+  const std::string source = "%1 = ReLU %0\n";
+  NN::Net net;
+  NN::Lexer lexer(source.c_str(), static_cast<uint16_t>(source.size()));
+  NN::NetBuilder builder(&net, 3000000000U);
+  NN::Parser parser(&builder);
+  ASSERT_EQ(parser.parse(lexer), NN::SyntaxError::kNone);
+  EXPECT_FALSE(builder.finish());
+}
+
+TEST(NetBuilder, WideIndex)
+{
+  // A register past 65535 floats, and a register past the sixteen of the compact mode.
+  auto net = buildNet("%40 = Linear 2 70000 %0\n"
+                      "%41 = ReLU %40\n",
+                      2);
+
+  EXPECT_EQ(net.regSizes[40], 70000);
+  EXPECT_EQ(net.regSizes[41], 70000);
+  EXPECT_EQ(net.numParameters, 3 * 70000);
+
+  for (uint32_t i = 0; i < net.numParameters; i++) {
+    net.parameters[i] = 1.0F;
+  }
+
+  NN::NetRunner runner(&net);
+  runner.getRegister(0)[0] = -2.0F;
+  runner.getRegister(0)[1] = 0.5F;
+  runner.reset();
+  const std::string source = "%40 = Linear 2 70000 %0\n"
+                             "%41 = ReLU %40\n";
+  ASSERT_EQ(NN::exec(source.c_str(), static_cast<NN::SourceSize>(source.size()), runner), NN::SyntaxError::kNone);
+  EXPECT_EQ(runner.getRegisterSize(41), 70000);
+  EXPECT_EQ(runner.getRegister(40)[69999], -0.5F);
+  EXPECT_EQ(runner.getRegister(41)[69999], 0.0F);
+
+  net.releaseMemory();
+}
+
+TEST(Program, WideInstructionCount)
+{
+  // More instructions than a 16-bit count can hold.
+  std::string source;
+  for (uint32_t i = 0; i < 65540; i++) {
+    source += "%1 = ReLU %0\n";
+  }
+
+  NN::Program program;
+  ASSERT_EQ(NN::compile(source.c_str(), static_cast<NN::SourceSize>(source.size()), &program), NN::SyntaxError::kNone);
+  EXPECT_EQ(program.numInstructions, 65540U);
+  EXPECT_EQ(program.instructions[65539].op, NN::OpCode::kReLU);
+  program.releaseMemory();
+}
+
+#endif
+
+TEST(NetRunner, MatMul)
+{
+  const std::string source = "%3 = MatMul 2 %1 %2\n";
+
+  NN::Net net;
+  NN::NetBuilder builder(&net, 0);
+  net.regSizes[1] = 6;
+  net.regSizes[2] = 12;
+  NN::Lexer lexer(source.c_str(), static_cast<uint16_t>(source.size()));
+  NN::Parser parser(&builder);
+  ASSERT_EQ(parser.parse(lexer), NN::SyntaxError::kNone);
+  ASSERT_TRUE(builder.finish());
+  ASSERT_EQ(net.regSizes[3], 8);
+
+  const float a[6]{ 1, 2, 3, 4, 5, 6 };
+  const float b[12]{ 1, 0, 0, 1, 0, 1, 0, 1, 0, 0, 1, 1 };
+  NN::NetRunner runner(&net);
+  std::memcpy(runner.getRegister(1), a, sizeof(a));
+  std::memcpy(runner.getRegister(2), b, sizeof(b));
+
+  runner.reset();
+  ASSERT_EQ(NN::exec(source.c_str(), source.size(), runner), NN::SyntaxError::kNone);
+
+  const float expected[8]{ 1, 2, 3, 6, 4, 5, 6, 15 };
+  for (int i = 0; i < 8; i++) {
+    EXPECT_FLOAT_EQ(runner.getRegister(3)[i], expected[i]);
+  }
+
+  net.releaseMemory();
+}
+
+TEST(NetRunner, SharedWeights)
+{
+  constexpr uint32_t numJobs = 8;
+
+  const std::string source = "%1 = Linear 4 16 %0\n"
+                             "%2 = Tanh %1\n"
+                             "%3 = Linear 16 2 %2\n";
+
+  const auto net = buildNet(source, 4);
+  for (uint32_t i = 0; i < net.numParameters; i++) {
+    net.parameters[i] = static_cast<float>(static_cast<int>(i % 7) - 3) * 0.1F;
+  }
+
+  struct Job final
+  {
+    const NN::Net* net{};
+
+    const std::string* source{};
+
+    NN::Activations activations[numJobs];
+
+    float outputs[numJobs][2]{};
+
+    static void run(void* jobPtr, const uint32_t index)
+    {
+      auto* job = static_cast<Job*>(jobPtr);
+      NN::NetRunner runner(job->net, &job->activations[index]);
+      for (uint16_t i = 0; i < 4; i++) {
+        runner.getRegister(0)[i] = static_cast<float>(index + i) * 0.25F;
+      }
+      runner.reset();
+      (void)NN::exec(job->source->c_str(), job->source->size(), runner);
+      job->outputs[index][0] = runner.getRegister(3)[0];
+      job->outputs[index][1] = runner.getRegister(3)[1];
+    }
+  };
+
+  Job job;
+  job.net = &net;
+  job.source = &source;
+  for (auto& activations : job.activations) {
+    ASSERT_TRUE(activations.allocMemory(net));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(activations.regs[0]) % 64, 0);
+  }
+
+  NN::ThreadPool pool(4);
+  pool.run(numJobs, Job::run, &job);
+
+  // The same inputs, run one at a time in the registers of the network.
+  for (uint32_t index = 0; index < numJobs; index++) {
+    NN::NetRunner runner(&net);
+    for (uint16_t i = 0; i < 4; i++) {
+      runner.getRegister(0)[i] = static_cast<float>(index + i) * 0.25F;
+    }
+    runner.reset();
+    ASSERT_EQ(NN::exec(source.c_str(), source.size(), runner), NN::SyntaxError::kNone);
+    EXPECT_EQ(job.outputs[index][0], runner.getRegister(3)[0]);
+    EXPECT_EQ(job.outputs[index][1], runner.getRegister(3)[1]);
+  }
+
+  for (auto& activations : job.activations) {
+    activations.releaseMemory();
+  }
+  auto copy = net;
+  copy.releaseMemory();
+}
+
+TEST(NetRunner, ParallelLinearMatchesSerial)
+{
+  // The second layer does not fill its last job.
+  const std::string source = "%1 = Linear 300 200 %0\n"
+                             "%2 = ReLU %1\n"
+                             "%3 = Linear 200 70 %2\n";
+
+  NN::Net net;
+  net.batchSize = 3;
+  net.weightLayout = NN::WeightLayout::kPadded;
+  NN::Lexer lexer(source.c_str(), static_cast<uint16_t>(source.size()));
+  NN::NetBuilder builder(&net, 300);
+  NN::Parser parser(&builder);
+  ASSERT_EQ(parser.parse(lexer), NN::SyntaxError::kNone);
+  ASSERT_TRUE(builder.finish());
+
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> dist(-0.1F, 0.1F);
+  for (uint32_t i = 0; i < net.numParameters; i++) {
+    net.parameters[i] = dist(rng);
+  }
+
+  NN::Activations activations;
+  ASSERT_TRUE(activations.allocMemory(net));
+
+  NN::ThreadPool pool(4);
+
+  for (uint16_t batchSize = 1; batchSize <= 3; batchSize += 2) {
+    NN::NetRunner serial(&net);
+    serial.setBatchSize(batchSize);
+    NN::NetRunner parallel(&net, &activations);
+    parallel.setBatchSize(batchSize);
+    parallel.setParallel(&pool, NN::ThreadPool::parallelFor, 0);
+
+    for (uint16_t b = 0; b < batchSize; b++) {
+      for (uint16_t i = 0; i < 300; i++) {
+        const auto x = dist(rng) * 10.0F;
+        serial.getRegister(0, b)[i] = x;
+        parallel.getRegister(0, b)[i] = x;
+      }
+    }
+
+    serial.reset();
+    ASSERT_EQ(NN::exec(source.c_str(), source.size(), serial), NN::SyntaxError::kNone);
+    parallel.reset();
+    ASSERT_EQ(NN::exec(source.c_str(), source.size(), parallel), NN::SyntaxError::kNone);
+
+    EXPECT_EQ(parallel.getRegisterSize(3), 70);
+    for (uint16_t b = 0; b < batchSize; b++) {
+      for (uint16_t i = 0; i < 70; i++) {
+        EXPECT_EQ(parallel.getRegister(3, b)[i], serial.getRegister(3, b)[i]);
+      }
+    }
+  }
+
+  activations.releaseMemory();
+  net.releaseMemory();
+}
+
+TEST(NetRunner, ParallelThreshold)
+{
+  const std::string source = "%1 = Linear 64 16 %0\n"
+                             "%2 = Linear 16 100 %1\n";
+
+  auto net = buildNet(source, 64);
+
+  struct Counter final
+  {
+    uint32_t calls{};
+
+    uint32_t jobs{};
+
+    static void parallelFor(void* counterPtr, const uint32_t count, NN::ParallelJob job, void* jobData)
+    {
+      auto* counter = static_cast<Counter*>(counterPtr);
+      counter->calls++;
+      counter->jobs += count;
+      NN::serialFor(nullptr, count, job, jobData);
+    }
+  };
+
+  // Only the second layer is large enough, and it has more outputs than one job computes.
+  Counter counter;
+  NN::NetRunner runner(&net);
+  runner.setParallel(&counter, Counter::parallelFor, 1600);
+  runner.reset();
+  ASSERT_EQ(NN::exec(source.c_str(), source.size(), runner), NN::SyntaxError::kNone);
+  EXPECT_EQ(counter.calls, 1U);
+  EXPECT_EQ(counter.jobs, (100U + NN::parallelChunkRows - 1) / NN::parallelChunkRows);
+
+  counter = Counter{};
+  runner.setParallel(&counter, Counter::parallelFor);
+  runner.reset();
+  ASSERT_EQ(NN::exec(source.c_str(), source.size(), runner), NN::SyntaxError::kNone);
+  EXPECT_EQ(counter.calls, 0U);
+
+  net.releaseMemory();
+}
+
+TEST(NetBuilder, PaddedLayout)
+{
+  const std::string source = "%1 = Linear 5 3 %0\n"
+                             "%2 = Linear 3 20 %1\n";
+
+  NN::Net packed = buildNet(source, 5);
+
+  NN::Net padded;
+  padded.weightLayout = NN::WeightLayout::kPadded;
+  NN::Lexer lexer(source.c_str(), static_cast<uint16_t>(source.size()));
+  NN::NetBuilder builder(&padded, 5);
+  NN::Parser parser(&builder);
+  ASSERT_EQ(parser.parse(lexer), NN::SyntaxError::kNone);
+  ASSERT_TRUE(builder.finish());
+
+  EXPECT_EQ(padded.numParameters, (16 * 3 + 16) + (16 * 20 + 32));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(padded.parameters) % 64, 0);
+
+  for (uint32_t i = 0; i < packed.numParameters; i++) {
+    packed.parameters[i] = static_cast<float>(static_cast<int>(i % 11) - 5) * 0.1F;
+  }
+
+  // Copy the packed weights into the padded layout, so that both networks compute the same function.
+  const float* src = packed.parameters;
+  float* dst = padded.parameters;
+  const uint16_t layers[2][2]{ { 5, 3 }, { 3, 20 } };
+  for (const auto& layer : layers) {
+    const auto stride = NN::linearRowStride(layer[0], NN::WeightLayout::kPadded);
+    for (uint32_t i = 0; i < layer[1]; i++) {
+      for (uint32_t j = 0; j < layer[0]; j++) {
+        dst[i * stride + j] = *src++;
+      }
+    }
+    for (uint32_t i = 0; i < layer[1]; i++) {
+      dst[stride * layer[1] + i] = *src++;
+    }
+    dst += NN::linearParameterCount(layer[0], layer[1], NN::WeightLayout::kPadded);
+  }
+
+  NN::NetRunner packedRunner(&packed);
+  NN::NetRunner paddedRunner(&padded);
+  for (int i = 0; i < 5; i++) {
+    packedRunner.getRegister(0)[i] = static_cast<float>(i) - 2.0F;
+    paddedRunner.getRegister(0)[i] = static_cast<float>(i) - 2.0F;
+  }
+  packedRunner.reset();
+  paddedRunner.reset();
+  ASSERT_EQ(NN::exec(source.c_str(), source.size(), packedRunner), NN::SyntaxError::kNone);
+  ASSERT_EQ(NN::exec(source.c_str(), source.size(), paddedRunner), NN::SyntaxError::kNone);
+
+  for (int i = 0; i < 20; i++) {
+    EXPECT_FLOAT_EQ(paddedRunner.getRegister(2)[i], packedRunner.getRegister(2)[i]);
+  }
+
+  packed.releaseMemory();
+  padded.releaseMemory();
+}
+
 namespace {
 
 class XorTest final
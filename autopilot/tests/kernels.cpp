@@ -0,0 +1,331 @@
+#include <gtest/gtest.h>
+
+#include <NN_Kernels.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+const NN::Activation activations[]{
+  NN::Activation::kNone, NN::Activation::kReLU, NN::Activation::kSigmoid, NN::Activation::kTanh
+};
+
+auto
+referenceActivation(const double x, const NN::Activation activation) -> double
+{
+  switch (activation) {
+    case NN::Activation::kNone:
+      break;
+    case NN::Activation::kReLU:
+      return (x >= 0.0) ? x : 0.0;
+    case NN::Activation::kSigmoid:
+      return 1.0 / (1.0 + std::exp(-x));
+    case NN::Activation::kTanh:
+      return std::tanh(x);
+  }
+  return x;
+}
+
+void
+referenceLinear(const std::vector<float>& weights,
+                const std::vector<float>& bias,
+                const std::vector<float>& input,
+                std::vector<double>& output,
+                const uint32_t inFeatures,
+                const uint32_t outFeatures,
+                const uint32_t stride,
+                const NN::Activation activation)
+{
+  output.resize(outFeatures);
+  for (uint32_t i = 0; i < outFeatures; i++) {
+    double acc = bias[i];
+    for (uint32_t j = 0; j < inFeatures; j++) {
+      acc += static_cast<double>(weights[i * stride + j]) * input[j];
+    }
+    output[i] = referenceActivation(acc, activation);
+  }
+}
+
+void
+checkKernel(const NN::LinearKernel kernel,
+            const uint32_t inFeatures,
+            const uint32_t outFeatures,
+            const uint32_t stride,
+            const NN::Activation activation,
+            const NN::ActivationMode mode)
+{
+  std::mt19937 rng(inFeatures * 31 + outFeatures);
+  std::uniform_real_distribution<float> dist(-1, 1);
+
+  std::vector<float> weights(stride * outFeatures);
+  std::vector<float> bias(outFeatures);
+  std::vector<float> input(inFeatures);
+  for (auto& w : weights) {
+    w = dist(rng);
+  }
+  for (auto& b : bias) {
+    b = dist(rng);
+  }
+  for (auto& x : input) {
+    x = dist(rng);
+  }
+
+  std::vector<double> expected;
+  referenceLinear(weights, bias, input, expected, inFeatures, outFeatures, stride, activation);
+
+  std::vector<float> output(outFeatures);
+  kernel(weights.data(), bias.data(), input.data(), output.data(), inFeatures, outFeatures, stride, activation, mode);
+
+  for (uint32_t i = 0; i < outFeatures; i++) {
+    EXPECT_NEAR(output[i], expected[i], 1.0e-4 * (inFeatures + 1)) << "row " << i;
+  }
+}
+
+} // namespace
+
+TEST(Kernels, DetectedKernelExists)
+{
+  EXPECT_NE(NN::getLinearKernel(NN::detectKernelISA()), nullptr);
+}
+
+TEST(Kernels, Linear)
+{
+  const NN::KernelISA isas[]{ NN::KernelISA::kPortable, NN::KernelISA::kSSE2, NN::KernelISA::kAVX2, NN::KernelISA::kAVX512 };
+
+  const uint32_t sizes[]{ 1, 3, 4, 7, 8, 15, 16, 17, 33, 64, 100 };
+
+  for (const auto isa : isas) {
+    const auto kernel = NN::getLinearKernel(isa);
+    if (!kernel) {
+      continue;
+    }
+    for (const auto in : sizes) {
+      for (const auto out : sizes) {
+        for (const auto activation : activations) {
+          const auto mode = ((in + out) % 2) ? NN::ActivationMode::kFast : NN::ActivationMode::kPrecise;
+          checkKernel(kernel, in, out, in, activation, mode);
+          checkKernel(kernel, in, out, ((in + 15) / 16) * 16, activation, mode);
+        }
+      }
+    }
+  }
+}
+
+TEST(Kernels, LinearBatch)
+{
+  const NN::KernelISA isas[]{ NN::KernelISA::kPortable, NN::KernelISA::kSSE2, NN::KernelISA::kAVX2, NN::KernelISA::kAVX512 };
+
+  const uint32_t sizes[]{ 1, 5, 8, 17, 64, 300 };
+
+  const uint32_t batchSizes[]{ 1, 2, 3, 8 };
+
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(-1, 1);
+
+  for (const auto isa : isas) {
+    const auto kernel = NN::getLinearBatchKernel(isa);
+    if (!kernel) {
+      continue;
+    }
+    for (const auto in : sizes) {
+      for (const auto out : sizes) {
+        for (const auto batch : batchSizes) {
+          const auto stride = in + 3;
+          const auto inputStride = in + 1;
+          const auto outputStride = out + 2;
+          std::vector<float> weights(stride * out);
+          std::vector<float> bias(out);
+          std::vector<float> input(inputStride * batch);
+          for (auto& w : weights) {
+            w = dist(rng);
+          }
+          for (auto& b : bias) {
+            b = dist(rng);
+          }
+          for (auto& x : input) {
+            x = dist(rng);
+          }
+          std::vector<float> output(outputStride * batch);
+          const auto activation = activations[(in + out + batch) % 4];
+          const auto mode = (batch % 2) ? NN::ActivationMode::kFast : NN::ActivationMode::kPrecise;
+          kernel(weights.data(),
+                 bias.data(),
+                 input.data(),
+                 inputStride,
+                 output.data(),
+                 outputStride,
+                 in,
+                 out,
+                 stride,
+                 batch,
+                 activation,
+                 mode);
+          for (uint32_t b = 0; b < batch; b++) {
+            const std::vector<float> sample(input.begin() + b * inputStride, input.begin() + b * inputStride + in);
+            std::vector<double> expected;
+            referenceLinear(weights, bias, sample, expected, in, out, stride, activation);
+            for (uint32_t i = 0; i < out; i++) {
+              EXPECT_NEAR(output[b * outputStride + i], expected[i], 1.0e-4 * (in + 1));
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(Kernels, MatMul)
+{
+  const NN::KernelISA isas[]{ NN::KernelISA::kPortable, NN::KernelISA::kSSE2, NN::KernelISA::kAVX2, NN::KernelISA::kAVX512 };
+
+  const uint32_t sizes[]{ 1, 3, 4, 9, 16, 33, 40 };
+
+  // The larger depth checks that the blocks along the shared dimension are accumulated.
+  const uint32_t depths[]{ 1, 3, 16, 33, 300 };
+
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(-1, 1);
+
+  for (const auto isa : isas) {
+    const auto kernel = NN::getMatMulKernel(isa);
+    if (!kernel) {
+      continue;
+    }
+    for (const auto m : sizes) {
+      for (const auto k : depths) {
+        for (const auto n : sizes) {
+          std::vector<float> a(m * k);
+          std::vector<float> b(k * n);
+          for (auto& x : a) {
+            x = dist(rng);
+          }
+          for (auto& x : b) {
+            x = dist(rng);
+          }
+          std::vector<float> c(m * n);
+          kernel(a.data(), b.data(), c.data(), m, k, n);
+          for (uint32_t i = 0; i < m; i++) {
+            for (uint32_t j = 0; j < n; j++) {
+              double expected{};
+              for (uint32_t p = 0; p < k; p++) {
+                expected += static_cast<double>(a[i * k + p]) * b[p * n + j];
+              }
+              ASSERT_NEAR(c[i * n + j], expected, 1.0e-4 * (k + 1));
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(Kernels, LinearInt8)
+{
+  const NN::KernelISA isas[]{ NN::KernelISA::kPortable, NN::KernelISA::kSSE2, NN::KernelISA::kAVX2, NN::KernelISA::kAVX512 };
+
+  const uint32_t sizes[]{ 1, 7, 16, 17, 33, 100 };
+
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<int> dist(-127, 127);
+  std::uniform_real_distribution<float> multiplierDist(0.0001F, 0.01F);
+
+  for (const auto isa : isas) {
+    const auto kernel = NN::getLinearInt8Kernel(isa);
+    if (!kernel) {
+      continue;
+    }
+    for (const auto in : sizes) {
+      for (const auto out : sizes) {
+        std::vector<int8_t> weights(in * out);
+        std::vector<int32_t> bias(out);
+        std::vector<float> multipliers(out);
+        std::vector<int8_t> input(in);
+        for (auto& w : weights) {
+          w = static_cast<int8_t>(dist(rng));
+        }
+        for (auto& b : bias) {
+          b = dist(rng) * 100;
+        }
+        for (auto& m : multipliers) {
+          m = multiplierDist(rng);
+        }
+        for (auto& x : input) {
+          x = static_cast<int8_t>(dist(rng));
+        }
+        for (const int32_t minValue : { -127, 0 }) {
+          std::vector<int8_t> output(out);
+          kernel(weights.data(), bias.data(), multipliers.data(), input.data(), output.data(), in, out, minValue);
+          for (uint32_t i = 0; i < out; i++) {
+            int32_t acc = bias[i];
+            for (uint32_t j = 0; j < in; j++) {
+              acc += weights[i * in + j] * input[j];
+            }
+            EXPECT_EQ(output[i], NN::roundToInt8(static_cast<float>(acc) * multipliers[i], minValue));
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(Kernels, LinearHalf)
+{
+  const NN::KernelISA isas[]{ NN::KernelISA::kPortable, NN::KernelISA::kSSE2, NN::KernelISA::kAVX2, NN::KernelISA::kAVX512 };
+
+  const uint32_t sizes[]{ 1, 3, 8, 17, 64, 100 };
+
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(-1, 1);
+
+  for (const auto isa : isas) {
+    const auto kernel = NN::getLinearHalfKernel(isa);
+    if (!kernel) {
+      continue;
+    }
+    for (const auto format : { NN::HalfFormat::kFloat16, NN::HalfFormat::kBFloat16 }) {
+      for (const auto in : sizes) {
+        for (const auto out : sizes) {
+          const auto stride = ((in + 15) / 16) * 16;
+          std::vector<uint16_t> weights(stride * out);
+          std::vector<uint16_t> bias(out);
+          std::vector<float> wideWeights(weights.size());
+          std::vector<float> wideBias(out);
+          std::vector<float> input(in);
+          for (size_t i = 0; i < weights.size(); i++) {
+            weights[i] = NN::floatToHalf(dist(rng), format);
+            wideWeights[i] = NN::halfToFloat(weights[i], format);
+          }
+          for (uint32_t i = 0; i < out; i++) {
+            bias[i] = NN::floatToHalf(dist(rng), format);
+            wideBias[i] = NN::halfToFloat(bias[i], format);
+          }
+          for (auto& x : input) {
+            x = dist(rng);
+          }
+
+          // Once widened, the weights are exact, so this only differs from a float layer by the order of the sums.
+          std::vector<double> expected;
+          referenceLinear(wideWeights, wideBias, input, expected, in, out, stride, NN::Activation::kTanh);
+
+          std::vector<float> output(out);
+          kernel(weights.data(),
+                 bias.data(),
+                 input.data(),
+                 output.data(),
+                 in,
+                 out,
+                 stride,
+                 format,
+                 NN::Activation::kTanh,
+                 NN::ActivationMode::kPrecise);
+
+          for (uint32_t i = 0; i < out; i++) {
+            EXPECT_NEAR(output[i], expected[i], 1.0e-4 * (in + 1)) << "row " << i;
+          }
+        }
+      }
+    }
+  }
+}
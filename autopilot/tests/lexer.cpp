@@ -2,6 +2,8 @@
 
 #include <NN_Lexer.h>
 
+#include <string>
+
 #define DECL_LEXER(name, input)                                                                                        \
   const char src[] = input;                                                                                            \
   NN::Lexer lexer(src, sizeof(src) - 1)
@@ -73,3 +75,13 @@ TEST(Lexer, Number)
   EXPECT_EQ(token.kind, NN::TokenKind::kNumber);
   EXPECT_EQ(token.length, 4);
 }
+
+TEST(Lexer, LongIdentifier)
+{
+  const std::string src(300, 'a');
+  NN::Lexer lexer(src.c_str(), static_cast<NN::SourceSize>(src.size()));
+  const auto token = lexer.lex();
+  EXPECT_EQ(token.kind, NN::TokenKind::kIdentifier);
+  EXPECT_EQ(token.length, 300);
+  EXPECT_EQ(lexer.remaining(), 0);
+}
@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+
+#include <NN_Liveness.h>
+#include <NN_NetBuilder.h>
+#include <NN_NetRunner.h>
+#include <NN_Parser.h>
+#include <NN_Program.h>
+
+#include <vector>
+
+namespace {
+
+const char mlpSource[] = "%1 = Linear 8 64 %0\n"
+                         "%2 = ReLU %1\n"
+                         "%3 = Linear 64 64 %2\n"
+                         "%4 = ReLU %3\n"
+                         "%5 = Linear 64 64 %4\n"
+                         "%6 = Tanh %5\n"
+                         "%7 = Linear 64 2 %6\n";
+
+auto
+runNet(NN::Net& net, const NN::Program& program) -> std::vector<float>
+{
+  for (uint32_t i = 0; i < net.numParameters; i++) {
+    net.parameters[i] = static_cast<float>(static_cast<int>(i % 11) - 5) * 0.05F;
+  }
+  NN::NetRunner runner(&net);
+  for (int i = 0; i < 8; i++) {
+    runner.getRegister(0)[i] = static_cast<float>(i) * 0.25F - 1.0F;
+  }
+  runner.reset();
+  NN::exec(program, runner);
+  return std::vector<float>(runner.getRegister(7), runner.getRegister(7) + net.regSizes[7]);
+}
+
+} // namespace
+
+TEST(Liveness, Intervals)
+{
+  const char src[] = "%1 = ReLU %0\n"
+                     "%2 = CompAdd %0 %1\n"
+                     "%3 = Tanh %2\n";
+  NN::Liveness liveness;
+  ASSERT_EQ(NN::exec(src, sizeof(src) - 1, liveness), NN::SyntaxError::kNone);
+
+  const auto input = liveness.getInterval(0);
+  EXPECT_TRUE(input.used);
+  EXPECT_EQ(input.begin, 0);
+  EXPECT_EQ(input.end, 2);
+
+  const auto hidden = liveness.getInterval(1);
+  EXPECT_EQ(hidden.begin, 1);
+  EXPECT_EQ(hidden.end, 2);
+
+  const auto output = liveness.getInterval(3);
+  EXPECT_EQ(output.begin, 3);
+  EXPECT_EQ(output.end, NN::LiveInterval::kEnd);
+
+  EXPECT_FALSE(liveness.getInterval(4).used);
+}
+
+TEST(Liveness, OverwrittenInput)
+{
+  const char src[] = "%0 = ReLU %0\n"
+                     "%1 = Tanh %0\n";
+  NN::Liveness liveness;
+  ASSERT_EQ(NN::exec(src, sizeof(src) - 1, liveness), NN::SyntaxError::kNone);
+  EXPECT_EQ(liveness.getInterval(0).begin, 0);
+  EXPECT_EQ(liveness.getInterval(0).end, 2);
+}
+
+TEST(Liveness, LiveOut)
+{
+  const char src[] = "%1 = ReLU %0\n"
+                     "%2 = Tanh %1\n";
+  NN::Liveness liveness;
+  liveness.markLiveOut(1);
+  ASSERT_EQ(NN::exec(src, sizeof(src) - 1, liveness), NN::SyntaxError::kNone);
+  EXPECT_EQ(liveness.getInterval(1).end, NN::LiveInterval::kEnd);
+}
+
+TEST(Liveness, SharesMemory)
+{
+  NN::Program program;
+  ASSERT_EQ(NN::compile(mlpSource, sizeof(mlpSource) - 1, &program), NN::SyntaxError::kNone);
+
+  NN::Net net;
+  NN::NetBuilder builder(&net, 8);
+  NN::exec(program, builder);
+  NN::Liveness liveness;
+  NN::exec(program, liveness);
+  liveness.assignOffsets(&net);
+  ASSERT_TRUE(builder.finish());
+
+  // At most two of the hidden layers are live at a time, and the input and output fit in the space they free up.
+  EXPECT_EQ(net.arenaSize, 64 + 64);
+
+  for (uint8_t i = 0; i < NN_MAX_REGS; i++) {
+    for (uint8_t j = i + 1; j < NN_MAX_REGS; j++) {
+      if (!liveness.getInterval(i).overlaps(liveness.getInterval(j))) {
+        continue;
+      }
+      const auto iEnd = net.regOffsets[i] + net.regSizes[i];
+      const auto jEnd = net.regOffsets[j] + net.regSizes[j];
+      EXPECT_TRUE((iEnd <= net.regOffsets[j]) || (jEnd <= net.regOffsets[i]))
+        << "registers " << int(i) << " and " << int(j) << " overlap";
+    }
+  }
+
+  NN::Net separateNet;
+  NN::NetBuilder separateBuilder(&separateNet, 8);
+  NN::exec(program, separateBuilder);
+  ASSERT_TRUE(separateBuilder.finish());
+  EXPECT_EQ(separateNet.arenaSize, 8 + 64 * 6 + 2);
+
+  const auto expected = runNet(separateNet, program);
+  const auto actual = runNet(net, program);
+  ASSERT_EQ(actual.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); i++) {
+    EXPECT_EQ(actual[i], expected[i]);
+  }
+
+  separateNet.releaseMemory();
+  net.releaseMemory();
+  program.releaseMemory();
+}
@@ -0,0 +1,519 @@
+#include <gtest/gtest.h>
+
+#include <NN_IncrementalEvaluator.h>
+#include <NN_Liveness.h>
+#include <NN_Loss.h>
+#include <NN_NetBuilder.h>
+#include <NN_NetRunner.h>
+#include <NN_Optim.h>
+#include <NN_Parser.h>
+#include <NN_Program.h>
+
+#include <ThreadPool.h>
+
+#include <atomic>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr uint16_t numSamples = 16;
+
+const char regressionSource[] = "%1 = Linear 4 8 %0\n"
+                                "%2 = Tanh %1\n"
+                                "%3 = Linear 8 1 %2\n";
+
+/**
+ * @brief Only read by the loss function, so that it can be called from several threads at once.
+ * */
+struct Dataset final
+{
+  NN::Program program;
+
+  std::vector<float> inputs;
+
+  std::vector<float> targets;
+};
+
+auto
+datasetLoss(void* dataPtr, const NN::Net& net) -> float
+{
+  const auto* data = static_cast<const Dataset*>(dataPtr);
+  NN::NetRunner runner(&net);
+  runner.setBatchSize(numSamples);
+  runner.reset();
+  for (uint16_t b = 0; b < numSamples; b++) {
+    for (uint16_t i = 0; i < 4; i++) {
+      runner.getRegister(0, b)[i] = data->inputs[b * 4 + i];
+    }
+  }
+  NN::exec(data->program, runner);
+  float loss{};
+  for (uint16_t b = 0; b < numSamples; b++) {
+    loss += NN::mseLoss(runner.getRegister(3, b), &data->targets[b], 1);
+  }
+  return loss / numSamples;
+}
+
+auto
+randomInt(void* rngPtr, const int32_t minValue, const int32_t maxValue) -> int32_t
+{
+  std::uniform_int_distribution<int32_t> dist(minValue, maxValue - 1);
+  return dist(*static_cast<std::mt19937*>(rngPtr));
+}
+
+auto
+randomFloat(void* rngPtr, const float minValue, const float maxValue) -> float
+{
+  std::uniform_real_distribution<float> dist(minValue, maxValue);
+  return dist(*static_cast<std::mt19937*>(rngPtr));
+}
+
+class PopulationTest final
+{
+public:
+  PopulationTest()
+  {
+    EXPECT_EQ(NN::compile(regressionSource, sizeof(regressionSource) - 1, &data_.program), NN::SyntaxError::kNone);
+    net_.batchSize = numSamples;
+    NN::NetBuilder builder(&net_, 4);
+    NN::exec(data_.program, builder);
+    EXPECT_TRUE(builder.finish());
+
+    std::mt19937 rng(3);
+    std::normal_distribution<float> dist(0.0F, 0.5F);
+    for (uint32_t i = 0; i < net_.numParameters; i++) {
+      net_.parameters[i] = dist(rng);
+    }
+    for (uint16_t b = 0; b < numSamples; b++) {
+      float sum{};
+      for (uint16_t i = 0; i < 4; i++) {
+        const auto x = dist(rng);
+        data_.inputs.push_back(x);
+        sum += x * static_cast<float>(i + 1) * 0.25F;
+      }
+      data_.targets.push_back(sum);
+    }
+  }
+
+  ~PopulationTest()
+  {
+    net_.releaseMemory();
+    data_.program.releaseMemory();
+  }
+
+  /**
+   * @brief Trains the network and returns its parameters.
+   * */
+  auto train(const uint32_t populationSize, void* executorData, NN::ParallelForFunc parallelFor, const int numSteps)
+    -> std::vector<float>
+  {
+    NN::LSOptimizer optimizer(&net_, 4, -0.05F, 0.05F, 0.0F);
+    optimizer.setPopulation(populationSize, executorData, parallelFor);
+    EXPECT_TRUE(optimizer.allocMemory());
+    std::mt19937 rng(11);
+    firstLoss_ = optimizer.step(&rng, randomInt, randomFloat, &data_, datasetLoss);
+    for (int i = 1; i < numSteps; i++) {
+      (void)optimizer.step(&rng, randomInt, randomFloat, &data_, datasetLoss);
+    }
+    bestLoss_ = optimizer.getBestLoss();
+    optimizer.releaseMemory();
+    return std::vector<float>(net_.parameters, net_.parameters + net_.numParameters);
+  }
+
+  auto getFirstLoss() const -> float { return firstLoss_; }
+
+  auto getNet() -> NN::Net& { return net_; }
+
+  auto getData() -> Dataset* { return &data_; }
+
+  auto getBestLoss() const -> float { return bestLoss_; }
+
+private:
+  Dataset data_;
+
+  NN::Net net_;
+
+  float firstLoss_{};
+
+  float bestLoss_{};
+};
+
+constexpr uint8_t evalOutputReg = 9;
+
+// Has two branches, a register that is overwritten in place, and every kind of instruction.
+const char evalSource[] = "%1 = Linear 4 8 %0\n"
+                          "%1 = Tanh %1\n"
+                          "%2 = Linear 4 8 %0\n"
+                          "%3 = Sigmoid %2\n"
+                          "%4 = CompMul %1 %3\n"
+                          "%5 = Concat %4 %0\n"
+                          "%6 = Linear 12 8 %5\n"
+                          "%7 = MatMul 2 %6 %1\n"
+                          "%8 = CompAdd %7 %4\n"
+                          "%9 = Linear 4 2 %8\n";
+
+auto
+outputLoss(void* dataPtr, const NN::Net& net) -> float
+{
+  const auto* data = static_cast<const Dataset*>(dataPtr);
+  float loss{};
+  for (uint16_t b = 0; b < numSamples; b++) {
+    loss += NN::mseLoss(net.regs[evalOutputReg] + b * net.regSizes[evalOutputReg], &data->targets[b * 2], 2);
+  }
+  return loss / numSamples;
+}
+
+/**
+ * @brief Runs the whole network, as the reference for the incremental evaluation.
+ * */
+auto
+fullLoss(void* dataPtr, const NN::Net& net) -> float
+{
+  const auto* data = static_cast<const Dataset*>(dataPtr);
+  NN::NetRunner runner(&net);
+  runner.setBatchSize(numSamples);
+  runner.reset();
+  for (uint16_t b = 0; b < numSamples; b++) {
+    for (uint16_t i = 0; i < 4; i++) {
+      runner.getRegister(0, b)[i] = data->inputs[b * 4 + i];
+    }
+  }
+  NN::exec(data->program, runner);
+  return outputLoss(dataPtr, net);
+}
+
+class EvaluatorTest final
+{
+public:
+  explicit EvaluatorTest(const bool shareMemory)
+  {
+    EXPECT_EQ(NN::compile(evalSource, sizeof(evalSource) - 1, &data_.program), NN::SyntaxError::kNone);
+    if (shareMemory) {
+      EXPECT_GT(NN::fuseActivations(&data_.program, 1U << evalOutputReg), 0);
+    }
+    net_.batchSize = numSamples;
+    NN::NetBuilder builder(&net_, 4);
+    NN::exec(data_.program, builder);
+    if (shareMemory) {
+      NN::Liveness liveness;
+      liveness.markLiveOut(evalOutputReg);
+      NN::exec(data_.program, liveness);
+      liveness.assignOffsets(&net_);
+    }
+    EXPECT_TRUE(builder.finish());
+
+    std::mt19937 rng(5);
+    std::normal_distribution<float> dist(0.0F, 0.5F);
+    for (uint32_t i = 0; i < net_.numParameters; i++) {
+      net_.parameters[i] = dist(rng);
+    }
+    for (uint32_t i = 0; i < numSamples * 4; i++) {
+      data_.inputs.push_back(dist(rng));
+    }
+    for (uint32_t i = 0; i < numSamples * 2; i++) {
+      data_.targets.push_back(dist(rng));
+    }
+  }
+
+  ~EvaluatorTest()
+  {
+    net_.releaseMemory();
+    data_.program.releaseMemory();
+  }
+
+  auto makeEvaluator() -> NN::IncrementalEvaluator
+  {
+    NN::IncrementalEvaluator evaluator(&net_, &data_.program);
+    evaluator.markOutput(evalOutputReg);
+    EXPECT_TRUE(evaluator.allocMemory());
+    evaluator.setBatchSize(numSamples);
+    for (uint16_t b = 0; b < numSamples; b++) {
+      for (uint16_t i = 0; i < 4; i++) {
+        evaluator.getRegister(0, b)[i] = data_.inputs[b * 4 + i];
+      }
+    }
+    return evaluator;
+  }
+
+  auto getNet() -> NN::Net& { return net_; }
+
+  auto getData() -> Dataset* { return &data_; }
+
+private:
+  Dataset data_;
+
+  NN::Net net_;
+};
+
+void
+checkIncremental(const bool shareMemory)
+{
+  EvaluatorTest test(shareMemory);
+  auto& net = test.getNet();
+  auto evaluator = test.makeEvaluator();
+
+  // The full run may overwrite the inputs when registers share memory, so the evaluator has to read them first.
+  const auto initial = evaluator.evaluate(test.getData(), outputLoss);
+  EXPECT_EQ(initial, fullLoss(test.getData(), net));
+
+  std::mt19937 rng(9);
+  std::uniform_int_distribution<uint32_t> indexDist(0, net.numParameters - 1);
+  std::uniform_int_distribution<uint32_t> countDist(1, 4);
+  std::uniform_real_distribution<float> noiseDist(-0.2F, 0.2F);
+  for (int trial = 0; trial < 200; trial++) {
+    uint32_t indices[4]{};
+    float saved[4]{};
+    const auto count = countDist(rng);
+    for (uint32_t k = 0; k < count; k++) {
+      indices[k] = indexDist(rng);
+      saved[k] = net.parameters[indices[k]];
+    }
+    for (uint32_t k = 0; k < count; k++) {
+      net.parameters[indices[k]] += noiseDist(rng);
+    }
+
+    const auto incremental = evaluator.evaluateChanged(indices, count, test.getData(), outputLoss);
+    ASSERT_EQ(incremental, fullLoss(test.getData(), net)) << "trial " << trial;
+
+    if (trial % 2 == 0) {
+      evaluator.commit();
+    } else {
+      for (uint32_t k = count; k > 0; k--) {
+        net.parameters[indices[k - 1]] = saved[k - 1];
+      }
+    }
+  }
+
+  evaluator.releaseMemory();
+}
+
+} // namespace
+
+TEST(ThreadPool, RunsEveryIndexOnce)
+{
+  NN::ThreadPool pool(4);
+  EXPECT_EQ(pool.getNumThreads(), 4);
+
+  for (uint32_t count : { 0U, 1U, 3U, 64U, 1000U }) {
+    std::vector<std::atomic<uint32_t>> hits(count);
+    for (auto& h : hits) {
+      h.store(0);
+    }
+    NN::ThreadPool::parallelFor(
+      &pool,
+      count,
+      [](void* hitsPtr, const uint32_t index) {
+        (*static_cast<std::vector<std::atomic<uint32_t>>*>(hitsPtr))[index].fetch_add(1);
+      },
+      &hits);
+    for (uint32_t i = 0; i < count; i++) {
+      EXPECT_EQ(hits[i].load(), 1U) << "count " << count << " index " << i;
+    }
+  }
+}
+
+TEST(LSOptimizer, PopulationIsDeterministic)
+{
+  NN::ThreadPool pool(4);
+
+  PopulationTest serialTest;
+  const auto serial = serialTest.train(8, nullptr, NN::serialFor, 50);
+
+  PopulationTest parallelTest;
+  const auto parallel = parallelTest.train(8, &pool, NN::ThreadPool::parallelFor, 50);
+
+  ASSERT_EQ(serial.size(), parallel.size());
+  for (size_t i = 0; i < serial.size(); i++) {
+    EXPECT_EQ(serial[i], parallel[i]) << "parameter " << i;
+  }
+}
+
+TEST(LSOptimizer, PopulationLowersLoss)
+{
+  NN::ThreadPool pool(4);
+
+  PopulationTest test;
+  (void)test.train(8, &pool, NN::ThreadPool::parallelFor, 200);
+  EXPECT_LT(test.getBestLoss(), test.getFirstLoss() * 0.5F);
+}
+
+TEST(IncrementalEvaluator, MatchesFullEvaluation)
+{
+  checkIncremental(false);
+}
+
+TEST(IncrementalEvaluator, MatchesFullEvaluationSharedMemory)
+{
+  checkIncremental(true);
+}
+
+TEST(IncrementalEvaluator, RecomputesOnlyDownstream)
+{
+  EvaluatorTest test(false);
+  auto& net = test.getNet();
+  auto evaluator = test.makeEvaluator();
+  (void)evaluator.evaluate(test.getData(), outputLoss);
+  EXPECT_EQ(evaluator.getNumRecomputed(), 10);
+
+  // The last weight belongs to the last layer.
+  const uint32_t last = net.numParameters - 1;
+  net.parameters[last] += 0.5F;
+  (void)evaluator.evaluateChanged(&last, 1, test.getData(), outputLoss);
+  EXPECT_EQ(evaluator.getNumRecomputed(), 1);
+
+  // The second branch skips the first Linear and Tanh.
+  const uint32_t secondBranch = 4 * 8 + 8;
+  net.parameters[secondBranch] += 0.5F;
+  (void)evaluator.evaluateChanged(&secondBranch, 1, test.getData(), outputLoss);
+  EXPECT_EQ(evaluator.getNumRecomputed(), 8);
+
+  evaluator.releaseMemory();
+}
+
+TEST(LSOptimizer, EvaluatorMatchesLossFunction)
+{
+  EvaluatorTest fullTest(false);
+  EvaluatorTest incrementalTest(false);
+
+  NN::LSOptimizer fullOptimizer(&fullTest.getNet(), 4, -0.05F, 0.05F, 0.0F);
+  ASSERT_TRUE(fullOptimizer.allocMemory());
+  NN::LSOptimizer incrementalOptimizer(&incrementalTest.getNet(), 4, -0.05F, 0.05F, 0.0F);
+  ASSERT_TRUE(incrementalOptimizer.allocMemory());
+  auto evaluator = incrementalTest.makeEvaluator();
+
+  std::mt19937 fullRng(13);
+  std::mt19937 incrementalRng(13);
+  for (int i = 0; i < 100; i++) {
+    const auto fullLossValue = fullOptimizer.step(&fullRng, randomInt, randomFloat, fullTest.getData(), fullLoss);
+    const auto incrementalLossValue = incrementalOptimizer.step(
+      &incrementalRng, randomInt, randomFloat, &evaluator, incrementalTest.getData(), outputLoss);
+    ASSERT_EQ(fullLossValue, incrementalLossValue) << "step " << i;
+  }
+  EXPECT_LT(incrementalOptimizer.getBestLoss(), fullLoss(incrementalTest.getData(), incrementalTest.getNet()) + 1e-6F);
+
+  const auto& fullNet = fullTest.getNet();
+  const auto& incrementalNet = incrementalTest.getNet();
+  for (uint32_t i = 0; i < fullNet.numParameters; i++) {
+    EXPECT_EQ(fullNet.parameters[i], incrementalNet.parameters[i]) << "parameter " << i;
+  }
+
+  evaluator.releaseMemory();
+  incrementalOptimizer.releaseMemory();
+  fullOptimizer.releaseMemory();
+}
+
+TEST(ESOptimizer, NoiseTable)
+{
+  constexpr uint32_t tableSize = 1 << 16;
+
+  NN::Net net;
+  net.numParameters = 4;
+  NN::ESOptimizer optimizer(&net, 4, 0.1F, 0.1F, tableSize, 7);
+  ASSERT_TRUE(optimizer.allocMemory());
+
+  double sum{};
+  double sumSquares{};
+  const auto* noise = optimizer.getNoise(0);
+  for (uint32_t i = 0; i < tableSize; i++) {
+    sum += noise[i];
+    sumSquares += static_cast<double>(noise[i]) * noise[i];
+  }
+  const auto mean = sum / tableSize;
+  EXPECT_NEAR(mean, 0.0, 0.02);
+  EXPECT_NEAR(sumSquares / tableSize - mean * mean, 1.0, 0.02);
+
+  // Workers with the same seed have the same table.
+  NN::ESOptimizer other(&net, 4, 0.1F, 0.1F, tableSize, 7);
+  ASSERT_TRUE(other.allocMemory());
+  for (uint32_t i = 0; i < tableSize; i++) {
+    ASSERT_EQ(noise[i], other.getNoise(0)[i]);
+  }
+
+  other.releaseMemory();
+  optimizer.releaseMemory();
+}
+
+TEST(ESOptimizer, RejectsSmallNoiseTable)
+{
+  NN::Net net;
+  net.numParameters = 64;
+  NN::ESOptimizer optimizer(&net, 4, 0.1F, 0.1F, 64);
+  EXPECT_FALSE(optimizer.allocMemory());
+}
+
+TEST(ESOptimizer, TiesDoNotMove)
+{
+  PopulationTest test;
+  auto& net = test.getNet();
+  const std::vector<float> before(net.parameters, net.parameters + net.numParameters);
+
+  NN::ESOptimizer optimizer(&net, 4, 0.1F, 0.1F, 1 << 12);
+  ASSERT_TRUE(optimizer.allocMemory());
+  std::mt19937 rng(1);
+  EXPECT_EQ(optimizer.step(&rng, randomInt, nullptr, [](void*, const NN::Net&) -> float { return 1.0F; }), 1.0F);
+  for (uint32_t i = 0; i < 8; i++) {
+    EXPECT_EQ(optimizer.getUtility(i), 0.0F);
+  }
+  for (uint32_t i = 0; i < net.numParameters; i++) {
+    EXPECT_EQ(net.parameters[i], before[i]);
+  }
+  optimizer.releaseMemory();
+}
+
+TEST(ESOptimizer, ShapesFitnessByRank)
+{
+  PopulationTest test;
+  auto& net = test.getNet();
+
+  // The loss grows with the first parameter, so the member that lowered it the most ranks first.
+  NN::ESOptimizer optimizer(&net, 4, 0.1F, 0.1F, 1 << 12);
+  ASSERT_TRUE(optimizer.allocMemory());
+  std::mt19937 rng(1);
+  (void)optimizer.step(&rng, randomInt, nullptr, [](void*, const NN::Net& n) -> float { return n.parameters[0]; });
+  float sum{};
+  float best{ -1.0F };
+  for (uint32_t i = 0; i < 8; i++) {
+    sum += optimizer.getUtility(i);
+    best = (optimizer.getUtility(i) > best) ? optimizer.getUtility(i) : best;
+    // Mirrored members have mirrored losses, and so opposite utilities.
+    if ((i % 2) == 0) {
+      EXPECT_NEAR(optimizer.getUtility(i), -optimizer.getUtility(i + 1), 1e-6F);
+    }
+  }
+  EXPECT_NEAR(sum, 0.0F, 1e-6F);
+  EXPECT_FLOAT_EQ(best, 0.5F);
+  optimizer.releaseMemory();
+}
+
+TEST(ESOptimizer, ParallelIsDeterministic)
+{
+  NN::ThreadPool pool(4);
+
+  auto train = [](PopulationTest& test, void* executorData, NN::ParallelForFunc parallelFor) {
+    auto& net = test.getNet();
+    NN::ESOptimizer optimizer(&net, 8, 0.05F, 0.05F, 1 << 12);
+    optimizer.setParallel(executorData, parallelFor);
+    EXPECT_TRUE(optimizer.allocMemory());
+    std::mt19937 rng(17);
+    float firstLoss{};
+    float lastLoss{};
+    for (int i = 0; i < 150; i++) {
+      lastLoss = optimizer.step(&rng, randomInt, test.getData(), datasetLoss);
+      firstLoss = (i == 0) ? lastLoss : firstLoss;
+    }
+    optimizer.releaseMemory();
+    EXPECT_LT(lastLoss, firstLoss * 0.5F);
+    return std::vector<float>(net.parameters, net.parameters + net.numParameters);
+  };
+
+  PopulationTest serialTest;
+  const auto serial = train(serialTest, nullptr, NN::serialFor);
+  PopulationTest parallelTest;
+  const auto parallel = train(parallelTest, &pool, NN::ThreadPool::parallelFor);
+
+  ASSERT_EQ(serial.size(), parallel.size());
+  for (size_t i = 0; i < serial.size(); i++) {
+    EXPECT_EQ(serial[i], parallel[i]) << "parameter " << i;
+  }
+}
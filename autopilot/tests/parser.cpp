@@ -5,6 +5,7 @@
 #include <NN_Parser.h>
 
 #include <sstream>
+#include <string>
 
 namespace {
 
@@ -28,6 +29,10 @@ public:
   void interpret(const NN::SigmoidExpr&) override {}
 
   void interpret(const NN::TanhExpr&) override {}
+
+  void interpret(const NN::GRUExpr&) override {}
+
+  void interpret(const NN::Conv1DExpr&) override {}
 };
 
 auto
@@ -77,9 +82,35 @@ TEST(Parser, LinearExpr)
   EXPECT_EQ(runErrorTest("%1 = Linear 16 32 %0"), NN::SyntaxError::kNone);
 }
 
+TEST(Parser, MatMulExpr)
+{
+  EXPECT_EQ(runErrorTest("%2 = MatMul %0 %1"), NN::SyntaxError::kNone);
+  EXPECT_EQ(runErrorTest("%2 = MatMul 4 %0 %1"), NN::SyntaxError::kNone);
+  EXPECT_EQ(runErrorTest("%2 = MatMul 0 %0 %1"), NN::SyntaxError::kInvalidOperand);
+  EXPECT_EQ(runErrorTest("%2 = MatMul 4 %0"), NN::SyntaxError::kInvalidOperand);
+}
+
+TEST(Parser, GRUExpr)
+{
+  EXPECT_EQ(runErrorTest("%2 = GRU 8 16 %1"), NN::SyntaxError::kNone);
+  EXPECT_EQ(runErrorTest("%2 = GRU 8 %1"), NN::SyntaxError::kInvalidOperand);
+}
+
+TEST(Parser, Conv1DExpr)
+{
+  EXPECT_EQ(runErrorTest("%2 = Conv1D 4 8 3 %1"), NN::SyntaxError::kNone);
+  EXPECT_EQ(runErrorTest("%2 = Conv1D 4 8 0 %1"), NN::SyntaxError::kInvalidOperand);
+  EXPECT_EQ(runErrorTest("%2 = Conv1D 4 8 %1"), NN::SyntaxError::kInvalidOperand);
+}
+
 TEST(Parser, NumberOutOfBounds)
 {
+#if NN_WIDE_INDEX
+  EXPECT_EQ(runErrorTest("%1 = Linear 1000000 256 %0"), NN::SyntaxError::kNone);
+#else
   EXPECT_EQ(runErrorTest("%1 = Linear 1000000 256 %0"), NN::SyntaxError::kNumberOutOfBounds);
+#endif
+  EXPECT_EQ(runErrorTest("%1 = Linear 10000000000 256 %0"), NN::SyntaxError::kNumberOutOfBounds);
 }
 
 TEST(Parser, EmptyLine)
@@ -131,6 +162,18 @@ public:
 
   void interpret(const NN::TanhExpr&) override {}
 
+  void interpret(const NN::GRUExpr& expr) override
+  {
+    stream_ << "GRU " << static_cast<int>(expr.inFeatures) << ' ' << static_cast<int>(expr.hiddenSize) << " %"
+            << static_cast<int>(expr.inRegister) << '\n';
+  }
+
+  void interpret(const NN::Conv1DExpr& expr) override
+  {
+    stream_ << "Conv1D " << static_cast<int>(expr.inChannels) << ' ' << static_cast<int>(expr.outChannels) << ' '
+            << static_cast<int>(expr.kernelSize) << " %" << static_cast<int>(expr.inRegister) << '\n';
+  }
+
 private:
   std::ostringstream stream_;
 };
@@ -161,3 +204,29 @@ TEST(Parser, Reverse)
             "%4 = CompAdd %2 %3\n"
             "%3 = MatMul %0 %1\n");
 }
+
+TEST(Parser, Recurrent)
+{
+  const char src[] = "%2 = GRU 8 16 %1\n"
+                     "%3 = Conv1D 16 4 3 %2\n";
+  Printer printer;
+  EXPECT_EQ(NN::exec(src, sizeof(src) - 1, printer), NN::SyntaxError::kNone);
+  EXPECT_EQ(printer.getString(), std::string(src));
+}
+
+TEST(Parser, ReverseLongSource)
+{
+  // Longer than 255 bytes, so that the lines are found past the range of a byte index.
+  std::string src;
+  std::string reversed;
+  for (int i = 1; i <= 40; i++) {
+    const auto line = "%" + std::to_string(i % 16) + " = ReLU %" + std::to_string((i - 1) % 16) + "\n";
+    src += line;
+    reversed = line + reversed;
+  }
+  ASSERT_GT(src.size(), 255);
+
+  Printer printer;
+  EXPECT_EQ(NN::reverseExec(src.c_str(), static_cast<NN::SourceSize>(src.size()), printer), NN::SyntaxError::kNone);
+  EXPECT_EQ(printer.getString(), reversed);
+}
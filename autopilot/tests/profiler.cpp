@@ -0,0 +1,203 @@
+#include <gtest/gtest.h>
+
+#include <NN_NetBuilder.h>
+#include <NN_NetRunner.h>
+#include <NN_Parser.h>
+#include <NN_Profiler.h>
+#include <NN_Program.h>
+
+#include <ProfileReport.h>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+const char source[] = "%1 = Linear 4 8 %0\n"
+                      "%2 = Tanh %1\n"
+                      "%3 = Linear 8 2 %2\n"
+                      "%4 = CompAdd %3 %3\n";
+
+/**
+ * @brief A clock that advances by one more nanosecond on every read, so later statements take longer.
+ * */
+struct FakeClock final
+{
+  uint64_t time{};
+
+  uint64_t step{};
+
+  static auto read(void* clockPtr) -> uint64_t
+  {
+    auto* clock = static_cast<FakeClock*>(clockPtr);
+    clock->step++;
+    clock->time += clock->step;
+    return clock->time;
+  }
+};
+
+void
+buildNet(NN::Program* program, NN::Net* net, const uint16_t batchSize)
+{
+  ASSERT_EQ(NN::compile(source, sizeof(source) - 1, program), NN::SyntaxError::kNone);
+  net->batchSize = batchSize;
+  NN::NetBuilder builder(net, 4);
+  NN::exec(*program, builder);
+  ASSERT_TRUE(builder.finish());
+  for (uint32_t i = 0; i < net->numParameters; i++) {
+    net->parameters[i] = static_cast<float>(static_cast<int>(i % 5) - 2) * 0.25F;
+  }
+}
+
+void
+setInputs(NN::NetRunner& runner, const uint16_t batchSize)
+{
+  for (uint16_t b = 0; b < batchSize; b++) {
+    for (uint16_t i = 0; i < 4; i++) {
+      runner.getRegister(0, b)[i] = static_cast<float>(b + i) * 0.5F;
+    }
+  }
+}
+
+} // namespace
+
+TEST(Profiler, CountsWork)
+{
+  constexpr uint16_t batchSize = 3;
+
+  NN::Program program;
+  NN::Net net;
+  buildNet(&program, &net, batchSize);
+
+  NN::NetRunner runner(&net);
+  runner.setBatchSize(batchSize);
+  FakeClock clock;
+  NN::Profiler profiler(&runner, &clock, FakeClock::read);
+  ASSERT_TRUE(profiler.allocMemory(16, 6));
+
+  for (int run = 0; run < 2; run++) {
+    setInputs(runner, batchSize);
+    profiler.reset();
+    NN::exec(program, profiler);
+  }
+
+  ASSERT_EQ(profiler.getNumRuns(), 2);
+  ASSERT_EQ(profiler.getNumEntries(), 4);
+
+  const auto& linear = profiler.getEntry(0);
+  EXPECT_EQ(linear.instruction.op, NN::OpCode::kLinear);
+  EXPECT_EQ(linear.instruction.dstReg, 1);
+  EXPECT_EQ(linear.numCalls, 2);
+  EXPECT_EQ(linear.flops, 2 * (2 * 4 * 8 * batchSize));
+  EXPECT_EQ(linear.bytes, 2 * ((4 * 8 + 8) + (4 + 8) * batchSize) * sizeof(float));
+
+  const auto& tanh = profiler.getEntry(1);
+  EXPECT_EQ(tanh.instruction.op, NN::OpCode::kTanh);
+  EXPECT_EQ(tanh.flops, 2 * 8 * batchSize);
+
+  const auto& add = profiler.getEntry(3);
+  EXPECT_EQ(add.instruction.op, NN::OpCode::kCompAdd);
+  EXPECT_EQ(add.flops, 2 * 2 * batchSize);
+  EXPECT_EQ(add.bytes, 2 * 3 * 2 * batchSize * sizeof(float));
+
+  // Only the first six runs of a statement are kept.
+  ASSERT_EQ(profiler.getNumEvents(), 6);
+  EXPECT_EQ(profiler.getEvent(4).entry, 0);
+  EXPECT_EQ(profiler.getEvent(4).run, 1);
+
+  // Each statement took longer than the one before, so the last one is the slowest.
+  std::vector<NN::InstrIndex> order(profiler.getNumEntries());
+  profiler.sortByTime(order.data());
+  EXPECT_EQ(order, (std::vector<NN::InstrIndex>{ 3, 2, 1, 0 }));
+
+  profiler.releaseMemory();
+  net.releaseMemory();
+  program.releaseMemory();
+}
+
+TEST(Profiler, MatchesRunner)
+{
+  NN::Program program;
+  NN::Net net;
+  buildNet(&program, &net, 1);
+
+  NN::NetRunner runner(&net);
+  setInputs(runner, 1);
+  runner.reset();
+  NN::exec(program, runner);
+  const std::vector<float> expected(runner.getRegister(4), runner.getRegister(4) + 2);
+
+  NN::Profiler profiler(&runner, nullptr, NN::steadyClock);
+  ASSERT_TRUE(profiler.allocMemory(16, 16));
+  setInputs(runner, 1);
+  profiler.reset();
+  // The source text goes through the same interpreter, so statements are numbered by line.
+  ASSERT_EQ(NN::exec(source, sizeof(source) - 1, profiler), NN::SyntaxError::kNone);
+  EXPECT_EQ(std::vector<float>(runner.getRegister(4), runner.getRegister(4) + 2), expected);
+  EXPECT_EQ(profiler.getNumEntries(), 4);
+
+  profiler.releaseMemory();
+  net.releaseMemory();
+  program.releaseMemory();
+}
+
+TEST(Profiler, DropsStatementsPastCapacity)
+{
+  NN::Program program;
+  NN::Net net;
+  buildNet(&program, &net, 1);
+
+  NN::NetRunner runner(&net);
+  FakeClock clock;
+  NN::Profiler profiler(&runner, &clock, FakeClock::read);
+  ASSERT_TRUE(profiler.allocMemory(2, 0));
+  profiler.reset();
+  NN::exec(program, profiler);
+  EXPECT_EQ(profiler.getNumEntries(), 2);
+  EXPECT_EQ(profiler.getNumEvents(), 0);
+
+  profiler.clear();
+  EXPECT_EQ(profiler.getNumEntries(), 0);
+  EXPECT_EQ(profiler.getNumRuns(), 0);
+
+  profiler.releaseMemory();
+  net.releaseMemory();
+  program.releaseMemory();
+}
+
+TEST(Profiler, Formats)
+{
+  NN::Program program;
+  NN::Net net;
+  buildNet(&program, &net, 1);
+  // The Tanh is fused into the first layer, which then writes %2 directly.
+  EXPECT_EQ(NN::fuseActivations(&program, 1U << 4), 1);
+
+  NN::NetRunner runner(&net);
+  FakeClock clock;
+  NN::Profiler profiler(&runner, &clock, FakeClock::read);
+  ASSERT_TRUE(profiler.allocMemory(16, 16));
+  setInputs(runner, 1);
+  profiler.reset();
+  NN::exec(program, profiler);
+
+  const auto report = NN::formatReport(profiler);
+  EXPECT_NE(report.find("%2 = Linear 4 8 %0 (Tanh)"), std::string::npos) << report;
+  EXPECT_NE(report.find("%4 = CompAdd %3 %3"), std::string::npos) << report;
+  // The slowest statement comes first.
+  EXPECT_LT(report.find("CompAdd"), report.find("Linear 4 8")) << report;
+
+  const auto trace = NN::formatChromeTrace(profiler);
+  EXPECT_EQ(trace.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["), 0);
+  EXPECT_NE(trace.find("{\"name\":\"%3 = Linear 8 2 %2\",\"cat\":\"nn\",\"ph\":\"X\",\"ts\":"), std::string::npos)
+    << trace;
+  size_t numEvents{};
+  for (auto pos = trace.find("\"ph\":\"X\""); pos != std::string::npos; pos = trace.find("\"ph\":\"X\"", pos + 1)) {
+    numEvents++;
+  }
+  EXPECT_EQ(numEvents, 3);
+
+  profiler.releaseMemory();
+  net.releaseMemory();
+  program.releaseMemory();
+}
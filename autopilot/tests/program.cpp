@@ -0,0 +1,321 @@
+#include <gtest/gtest.h>
+
+#include <NN_Interpreter.h>
+#include <NN_NetBuilder.h>
+#include <NN_NetRunner.h>
+#include <NN_Parser.h>
+#include <NN_Program.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+class Printer final : public NN::Interpreter
+{
+public:
+  auto getString() const -> std::string { return stream_.str(); }
+
+  void beginAssignment(uint8_t dstReg) override { stream_ << '%' << static_cast<int>(dstReg) << " = "; }
+
+  void interpret(const NN::LinearExpr& expr) override
+  {
+    stream_ << "Linear " << static_cast<int>(expr.inFeatures) << ' ' << static_cast<int>(expr.outFeatures) << " %"
+            << static_cast<int>(expr.inRegister) << '\n';
+  }
+
+  void interpret(const NN::MatMulExpr& expr) override { printBinary("MatMul", expr); }
+
+  void interpret(const NN::ConcatExpr& expr) override { printBinary("Concat", expr); }
+
+  void interpret(const NN::CompAddExpr& expr) override { printBinary("CompAdd", expr); }
+
+  void interpret(const NN::CompMulExpr& expr) override { printBinary("CompMul", expr); }
+
+  void interpret(const NN::ReLUExpr& expr) override { printUnary("ReLU", expr); }
+
+  void interpret(const NN::SigmoidExpr& expr) override { printUnary("Sigmoid", expr); }
+
+  void interpret(const NN::TanhExpr& expr) override { printUnary("Tanh", expr); }
+
+  void interpret(const NN::GRUExpr& expr) override
+  {
+    stream_ << "GRU " << static_cast<int>(expr.inFeatures) << ' ' << static_cast<int>(expr.hiddenSize) << " %"
+            << static_cast<int>(expr.inRegister) << '\n';
+  }
+
+  void interpret(const NN::Conv1DExpr& expr) override
+  {
+    stream_ << "Conv1D " << static_cast<int>(expr.inChannels) << ' ' << static_cast<int>(expr.outChannels) << ' '
+            << static_cast<int>(expr.kernelSize) << " %" << static_cast<int>(expr.inRegister) << '\n';
+  }
+
+protected:
+  void printBinary(const char* name, const NN::BinaryExpr& expr)
+  {
+    stream_ << name << " %" << static_cast<int>(expr.leftOpReg) << " %" << static_cast<int>(expr.rightOpReg) << '\n';
+  }
+
+  void printUnary(const char* name, const NN::UnaryExpr& expr)
+  {
+    stream_ << name << " %" << static_cast<int>(expr.inRegister) << '\n';
+  }
+
+private:
+  std::ostringstream stream_;
+};
+
+const char testSource[] = "%1 = Linear 4 8 %0\n"
+                          "\n"
+                          "%2 = ReLU %1\n"
+                          "%3 = Linear 8 8 %2\n"
+                          "%4 = CompAdd %2 %3\n"
+                          "%5 = Concat %4 %0\n"
+                          "%6 = CompMul %5 %5\n"
+                          "%7 = Tanh %6\n"
+                          "%8 = Sigmoid %7\n";
+
+} // namespace
+
+TEST(Program, Compile)
+{
+  NN::Program program;
+  ASSERT_EQ(NN::compile(testSource, sizeof(testSource) - 1, &program), NN::SyntaxError::kNone);
+  ASSERT_EQ(program.numInstructions, 8);
+  EXPECT_EQ(program.instructions[0].op, NN::OpCode::kLinear);
+  EXPECT_EQ(program.instructions[0].dstReg, 1);
+  EXPECT_EQ(program.instructions[0].leftReg, 0);
+  EXPECT_EQ(program.instructions[0].inFeatures, 4);
+  EXPECT_EQ(program.instructions[0].outFeatures, 8);
+  EXPECT_EQ(program.instructions[3].op, NN::OpCode::kCompAdd);
+  EXPECT_EQ(program.instructions[3].leftReg, 2);
+  EXPECT_EQ(program.instructions[3].rightReg, 3);
+  program.releaseMemory();
+}
+
+TEST(Program, CompileError)
+{
+  const char src[] = "%1 = ReLU %0\n"
+                     "%2 = Foo %1\n";
+  NN::Program program;
+  EXPECT_EQ(NN::compile(src, sizeof(src) - 1, &program), NN::SyntaxError::kUnknownFunction);
+  EXPECT_EQ(program.instructions, nullptr);
+}
+
+TEST(Program, Forward)
+{
+  NN::Program program;
+  ASSERT_EQ(NN::compile(testSource, sizeof(testSource) - 1, &program), NN::SyntaxError::kNone);
+
+  Printer textPrinter;
+  ASSERT_EQ(NN::exec(testSource, sizeof(testSource) - 1, textPrinter), NN::SyntaxError::kNone);
+
+  Printer programPrinter;
+  NN::exec(program, programPrinter);
+
+  EXPECT_EQ(programPrinter.getString(), textPrinter.getString());
+
+  program.releaseMemory();
+}
+
+TEST(Program, Reverse)
+{
+  const char src[] = "%3 = MatMul %0 %1\n"
+                     "%4 = CompAdd %2 %3\n"
+                     "%5 = ReLU %4\n";
+  NN::Program program;
+  ASSERT_EQ(NN::compile(src, sizeof(src) - 1, &program), NN::SyntaxError::kNone);
+  Printer printer;
+  NN::reverseExec(program, printer);
+  EXPECT_EQ(printer.getString(),
+            "%5 = ReLU %4\n"
+            "%4 = CompAdd %2 %3\n"
+            "%3 = MatMul %0 %1\n");
+  program.releaseMemory();
+}
+
+TEST(Program, SameOutputAsSource)
+{
+  NN::Program program;
+  ASSERT_EQ(NN::compile(testSource, sizeof(testSource) - 1, &program), NN::SyntaxError::kNone);
+
+  NN::Net net;
+  NN::NetBuilder builder(&net, 4);
+  NN::exec(program, builder);
+  ASSERT_TRUE(builder.finish());
+
+  for (uint32_t i = 0; i < net.numParameters; i++) {
+    net.parameters[i] = static_cast<float>(static_cast<int>(i % 7) - 3) * 0.1F;
+  }
+
+  NN::NetRunner runner(&net);
+
+  const float input[4]{ 0.5F, -1.0F, 0.25F, 2.0F };
+
+  for (int i = 0; i < 4; i++) {
+    runner.getRegister(0)[i] = input[i];
+  }
+  runner.reset();
+  ASSERT_EQ(NN::exec(testSource, sizeof(testSource) - 1, runner), NN::SyntaxError::kNone);
+  std::vector<float> expected(runner.getRegister(8), runner.getRegister(8) + net.regSizes[8]);
+
+  for (int i = 0; i < 4; i++) {
+    runner.getRegister(0)[i] = input[i];
+  }
+  runner.reset();
+  NN::exec(program, runner);
+
+  for (size_t i = 0; i < expected.size(); i++) {
+    EXPECT_EQ(runner.getRegister(8)[i], expected[i]);
+  }
+
+  net.releaseMemory();
+  program.releaseMemory();
+}
+
+TEST(Program, BatchMatchesSingleSamples)
+{
+  NN::Program program;
+  ASSERT_EQ(NN::compile(testSource, sizeof(testSource) - 1, &program), NN::SyntaxError::kNone);
+
+  constexpr uint16_t batchSize = 5;
+
+  NN::Net net;
+  net.batchSize = batchSize;
+  NN::NetBuilder builder(&net, 4);
+  NN::exec(program, builder);
+  ASSERT_TRUE(builder.finish());
+
+  for (uint32_t i = 0; i < net.numParameters; i++) {
+    net.parameters[i] = static_cast<float>(static_cast<int>(i % 13) - 6) * 0.05F;
+  }
+
+  NN::NetRunner runner(&net);
+
+  auto inputValue = [](int sample, int i) -> float { return static_cast<float>(sample - i) * 0.3F; };
+
+  std::vector<std::vector<float>> expected;
+  for (int b = 0; b < batchSize; b++) {
+    for (int i = 0; i < 4; i++) {
+      runner.getRegister(0)[i] = inputValue(b, i);
+    }
+    runner.reset();
+    NN::exec(program, runner);
+    expected.emplace_back(runner.getRegister(8), runner.getRegister(8) + net.regSizes[8]);
+  }
+
+  runner.setBatchSize(batchSize);
+  for (int b = 0; b < batchSize; b++) {
+    for (int i = 0; i < 4; i++) {
+      runner.getRegister(0, b)[i] = inputValue(b, i);
+    }
+  }
+  runner.reset();
+  NN::exec(program, runner);
+
+  for (int b = 0; b < batchSize; b++) {
+    const auto* output = runner.getRegister(8, b);
+    for (size_t i = 0; i < expected[b].size(); i++) {
+      EXPECT_NEAR(output[i], expected[b][i], 1.0e-5F);
+    }
+  }
+
+  net.releaseMemory();
+  program.releaseMemory();
+}
+
+namespace {
+
+auto
+runProgram(const NN::Program& program, const uint8_t outputReg) -> std::vector<float>
+{
+  NN::Net net;
+  NN::NetBuilder builder(&net, 4);
+  NN::exec(program, builder);
+  EXPECT_TRUE(builder.finish());
+
+  for (uint32_t i = 0; i < net.numParameters; i++) {
+    net.parameters[i] = static_cast<float>(static_cast<int>(i % 7) - 3) * 0.1F;
+  }
+
+  NN::NetRunner runner(&net);
+  const float input[4]{ 0.5F, -1.0F, 0.25F, 2.0F };
+  for (int i = 0; i < 4; i++) {
+    runner.getRegister(0)[i] = input[i];
+  }
+  runner.reset();
+  NN::exec(program, runner);
+
+  std::vector<float> output(runner.getRegister(outputReg), runner.getRegister(outputReg) + net.regSizes[outputReg]);
+  net.releaseMemory();
+  return output;
+}
+
+} // namespace
+
+TEST(Program, FuseActivations)
+{
+  NN::Program program;
+  ASSERT_EQ(NN::compile(testSource, sizeof(testSource) - 1, &program), NN::SyntaxError::kNone);
+  const auto expected = runProgram(program, 8);
+
+  EXPECT_EQ(NN::fuseActivations(&program, 0), 2);
+  ASSERT_EQ(program.numInstructions, 6);
+  EXPECT_EQ(program.instructions[0].op, NN::OpCode::kLinear);
+  EXPECT_EQ(program.instructions[0].dstReg, 2);
+  EXPECT_EQ(program.instructions[0].activation, NN::Activation::kReLU);
+  EXPECT_EQ(program.instructions[4].op, NN::OpCode::kCompMul);
+  EXPECT_EQ(program.instructions[4].dstReg, 7);
+  EXPECT_EQ(program.instructions[4].activation, NN::Activation::kTanh);
+  // An instruction only takes one activation.
+  EXPECT_EQ(program.instructions[5].op, NN::OpCode::kSigmoid);
+
+  const auto actual = runProgram(program, 8);
+  ASSERT_EQ(actual.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); i++) {
+    EXPECT_EQ(actual[i], expected[i]);
+  }
+
+  program.releaseMemory();
+}
+
+TEST(Program, FuseActivationsKeepsReadRegisters)
+{
+  const char src[] = "%1 = Linear 4 4 %0\n"
+                     "%2 = ReLU %1\n"
+                     "%3 = CompAdd %1 %2\n"
+                     "%4 = Linear 4 4 %3\n"
+                     "%5 = Sigmoid %4\n";
+  NN::Program program;
+  ASSERT_EQ(NN::compile(src, sizeof(src) - 1, &program), NN::SyntaxError::kNone);
+
+  // The first activation can not be fused, because %1 is read again. The second one can not be fused, because %4 is
+  // read after the program.
+  EXPECT_EQ(NN::fuseActivations(&program, 1U << 4), 0);
+  EXPECT_EQ(program.numInstructions, 5);
+
+  EXPECT_EQ(NN::fuseActivations(&program, 0), 1);
+  EXPECT_EQ(program.numInstructions, 4);
+
+  program.releaseMemory();
+}
+
+TEST(Program, FuseActivationsInPlace)
+{
+  const char src[] = "%1 = Linear 4 4 %0\n"
+                     "%1 = Tanh %1\n"
+                     "%2 = CompAdd %1 %0\n";
+  NN::Program program;
+  ASSERT_EQ(NN::compile(src, sizeof(src) - 1, &program), NN::SyntaxError::kNone);
+  const auto expected = runProgram(program, 2);
+
+  EXPECT_EQ(NN::fuseActivations(&program, 0), 1);
+  const auto actual = runProgram(program, 2);
+  ASSERT_EQ(actual.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); i++) {
+    EXPECT_EQ(actual[i], expected[i]);
+  }
+
+  program.releaseMemory();
+}
@@ -0,0 +1,180 @@
+#include <gtest/gtest.h>
+
+#include <NN_Calibrator.h>
+#include <NN_NetBuilder.h>
+#include <NN_NetRunner.h>
+#include <NN_Parser.h>
+#include <NN_Program.h>
+#include <NN_QuantNet.h>
+#include <NN_QuantNetRunner.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief Builds a float network, calibrates it and quantizes it, then checks that both networks agree on new inputs.
+ * */
+void
+checkQuantizedOutput(const char* source,
+                     const uint16_t length,
+                     const uint8_t outputReg,
+                     const float tolerance,
+                     const uint16_t expectedFusions = 0)
+{
+  constexpr uint16_t inputSize = 8;
+  constexpr uint16_t batchSize = 32;
+
+  NN::Program program;
+  ASSERT_EQ(NN::compile(source, length, &program), NN::SyntaxError::kNone);
+  if (expectedFusions > 0) {
+    ASSERT_EQ(NN::fuseActivations(&program, 0), expectedFusions);
+  }
+
+  NN::Net net;
+  net.batchSize = batchSize;
+  NN::NetBuilder builder(&net, inputSize);
+  NN::exec(program, builder);
+  ASSERT_TRUE(builder.finish());
+
+  std::mt19937 rng(1234);
+  std::normal_distribution<float> weightDist(0.0F, 0.3F);
+  for (uint32_t i = 0; i < net.numParameters; i++) {
+    net.parameters[i] = weightDist(rng);
+  }
+
+  std::uniform_real_distribution<float> inputDist(-1.0F, 1.0F);
+
+  NN::Calibrator calibrator(&net, program.numInstructions);
+  ASSERT_TRUE(calibrator.allocMemory());
+  calibrator.setBatchSize(batchSize);
+  for (int run = 0; run < 4; run++) {
+    calibrator.reset();
+    for (uint16_t b = 0; b < batchSize; b++) {
+      for (uint16_t i = 0; i < inputSize; i++) {
+        calibrator.getRegister(0, b)[i] = inputDist(rng);
+      }
+    }
+    NN::exec(program, calibrator);
+  }
+
+  NN::QuantNet quantNet;
+  ASSERT_TRUE(NN::quantize(program, net, calibrator, &quantNet));
+  calibrator.releaseMemory();
+
+  // Int8 weights take a quarter of the space of the float weights.
+  EXPECT_LT(quantNet.numWeights, net.numParameters);
+
+  NN::NetRunner runner(&net);
+  runner.setBatchSize(batchSize);
+  NN::QuantNetRunner quantRunner(&quantNet);
+  quantRunner.setBatchSize(batchSize);
+
+  std::vector<float> input(inputSize);
+  for (uint16_t b = 0; b < batchSize; b++) {
+    for (auto& x : input) {
+      x = inputDist(rng);
+    }
+    std::copy(input.begin(), input.end(), runner.getRegister(0, b));
+    quantRunner.setInput(0, b, input.data());
+  }
+
+  runner.reset();
+  NN::exec(program, runner);
+  quantRunner.reset();
+  NN::exec(program, quantRunner);
+
+  const auto outputSize = net.regSizes[outputReg];
+  std::vector<float> output(outputSize);
+  auto maxError = 0.0F;
+  for (uint16_t b = 0; b < batchSize; b++) {
+    quantRunner.getOutput(outputReg, b, output.data());
+    const auto* expected = runner.getRegister(outputReg, b);
+    for (uint16_t i = 0; i < outputSize; i++) {
+      maxError = std::fmax(maxError, std::fabs(output[i] - expected[i]));
+    }
+  }
+  EXPECT_LT(maxError, tolerance);
+
+  quantNet.releaseMemory();
+  net.releaseMemory();
+  program.releaseMemory();
+}
+
+} // namespace
+
+TEST(Quant, ValueRangeScale)
+{
+  NN::ValueRange range;
+  EXPECT_EQ(range.getInt8Scale(), 1.0F);
+  range.include(-2.54F);
+  range.include(1.0F);
+  EXPECT_FLOAT_EQ(range.getInt8Scale(), 0.02F);
+}
+
+TEST(Quant, Calibrate)
+{
+  const char src[] = "%1 = ReLU %0\n"
+                     "%2 = Tanh %1\n";
+  NN::Program program;
+  ASSERT_EQ(NN::compile(src, sizeof(src) - 1, &program), NN::SyntaxError::kNone);
+  NN::Net net;
+  NN::NetBuilder builder(&net, 2);
+  NN::exec(program, builder);
+  ASSERT_TRUE(builder.finish());
+
+  NN::Calibrator calibrator(&net, program.numInstructions);
+  ASSERT_TRUE(calibrator.allocMemory());
+  calibrator.reset();
+  calibrator.getRegister(0, 0)[0] = -3.0F;
+  calibrator.getRegister(0, 0)[1] = 2.0F;
+  NN::exec(program, calibrator);
+
+  EXPECT_EQ(calibrator.getInputRange(0).minValue, -3.0F);
+  EXPECT_EQ(calibrator.getInputRange(0).maxValue, 2.0F);
+  EXPECT_FALSE(calibrator.getInputRange(1).observed);
+  EXPECT_EQ(calibrator.getOutputRange(0).minValue, 0.0F);
+  EXPECT_EQ(calibrator.getOutputRange(0).maxValue, 2.0F);
+  EXPECT_FLOAT_EQ(calibrator.getOutputRange(1).maxValue, std::tanh(2.0F));
+
+  calibrator.releaseMemory();
+  net.releaseMemory();
+  program.releaseMemory();
+}
+
+TEST(Quant, MatchesFloatMLP)
+{
+  const char src[] = "%1 = Linear 8 32 %0\n"
+                     "%2 = ReLU %1\n"
+                     "%3 = Linear 32 32 %2\n"
+                     "%4 = Tanh %3\n"
+                     "%5 = Linear 32 4 %4\n"
+                     "%6 = Sigmoid %5\n";
+  checkQuantizedOutput(src, sizeof(src) - 1, 6, 0.03F);
+}
+
+TEST(Quant, MatchesFloatFused)
+{
+  const char src[] = "%1 = Linear 8 32 %0\n"
+                     "%2 = ReLU %1\n"
+                     "%3 = Linear 32 32 %2\n"
+                     "%4 = Tanh %3\n"
+                     "%5 = CompAdd %4 %2\n"
+                     "%6 = Sigmoid %5\n"
+                     "%7 = Linear 32 4 %6\n";
+  checkQuantizedOutput(src, sizeof(src) - 1, 7, 0.06F, 3);
+}
+
+TEST(Quant, MatchesFloatBinaryOps)
+{
+  const char src[] = "%1 = Linear 8 16 %0\n"
+                     "%2 = Linear 8 16 %0\n"
+                     "%3 = CompMul %1 %2\n"
+                     "%4 = Concat %3 %0\n"
+                     "%5 = Linear 24 8 %4\n"
+                     "%6 = MatMul 2 %5 %1\n"
+                     "%7 = ReLU %6\n";
+  checkQuantizedOutput(src, sizeof(src) - 1, 7, 0.1F);
+}
@@ -0,0 +1,315 @@
+#include <gtest/gtest.h>
+
+#include <NN_FixedNet.h>
+#include <NN_HalfNet.h>
+#include <NN_HalfNetRunner.h>
+#include <NN_NetBuilder.h>
+#include <NN_NetRunner.h>
+#include <NN_Parser.h>
+#include <NN_Program.h>
+#include <NN_Sparse.h>
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief A program and a float network with random weights.
+ * */
+class RecurrentTest : public testing::Test
+{
+protected:
+  void build(const char* source, const uint16_t inputSize, const uint16_t batchSize, const NN::WeightLayout layout)
+  {
+    ASSERT_EQ(NN::compile(source, static_cast<uint16_t>(strlen(source)), &program_), NN::SyntaxError::kNone);
+    net_.batchSize = batchSize;
+    net_.weightLayout = layout;
+    NN::NetBuilder builder(&net_, inputSize);
+    NN::exec(program_, builder);
+    ASSERT_TRUE(builder.finish());
+
+    std::normal_distribution<float> dist(0.0F, 0.5F);
+    for (uint32_t i = 0; i < net_.numParameters; i++) {
+      net_.parameters[i] = dist(rng_);
+    }
+  }
+
+  /**
+   * @brief Computes one step of a GRU the slow way, from the parameters of the network.
+   * */
+  auto referenceGRU(const std::vector<float>& x, const std::vector<float>& h) const -> std::vector<float>
+  {
+    const auto in = static_cast<uint32_t>(x.size());
+    const auto hidden = static_cast<uint32_t>(h.size());
+    const auto layout = net_.weightLayout;
+    const auto inStride = NN::linearRowStride(static_cast<NN::FeatureSize>(in), layout);
+    const auto hiddenStride = NN::linearRowStride(static_cast<NN::FeatureSize>(hidden), layout);
+    const auto* wi = net_.parameters;
+    const auto* bi = wi + inStride * 3 * hidden;
+    const auto* wh =
+      wi + NN::linearParameterCount(static_cast<NN::FeatureSize>(in), static_cast<NN::FeatureSize>(3 * hidden), layout);
+    const auto* bh = wh + hiddenStride * 3 * hidden;
+
+    std::vector<float> gi(3 * hidden);
+    std::vector<float> gh(3 * hidden);
+    for (uint32_t row = 0; row < 3 * hidden; row++) {
+      gi[row] = bi[row];
+      for (uint32_t j = 0; j < in; j++) {
+        gi[row] += wi[row * inStride + j] * x[j];
+      }
+      gh[row] = bh[row];
+      for (uint32_t j = 0; j < hidden; j++) {
+        gh[row] += wh[row * hiddenStride + j] * h[j];
+      }
+    }
+
+    auto sigmoid = [](const float v) -> float { return 1.0F / (1.0F + std::exp(-v)); };
+
+    std::vector<float> next(hidden);
+    for (uint32_t i = 0; i < hidden; i++) {
+      const auto r = sigmoid(gi[i] + gh[i]);
+      const auto z = sigmoid(gi[hidden + i] + gh[hidden + i]);
+      const auto n = std::tanh(gi[2 * hidden + i] + r * gh[2 * hidden + i]);
+      next[i] = (1.0F - z) * n + z * h[i];
+    }
+    return next;
+  }
+
+  /**
+   * @brief Computes one output of a Conv1D the slow way, from the inputs of the last ticks, oldest first.
+   * */
+  auto referenceConv1D(const std::vector<std::vector<float>>& ticks, const uint32_t outChannels) const
+    -> std::vector<float>
+  {
+    const auto kernelSize = static_cast<uint32_t>(ticks.size());
+    const auto inChannels = static_cast<uint32_t>(ticks[0].size());
+    const auto stride = NN::linearRowStride(static_cast<NN::FeatureSize>(kernelSize * inChannels), net_.weightLayout);
+    const auto* bias = net_.parameters + stride * outChannels;
+
+    std::vector<float> y(outChannels);
+    for (uint32_t o = 0; o < outChannels; o++) {
+      y[o] = bias[o];
+      for (uint32_t k = 0; k < kernelSize; k++) {
+        for (uint32_t c = 0; c < inChannels; c++) {
+          y[o] += net_.parameters[o * stride + k * inChannels + c] * ticks[k][c];
+        }
+      }
+    }
+    return y;
+  }
+
+  void checkGRU(const NN::WeightLayout layout, const uint16_t batchSize)
+  {
+    // More hidden features than the kernel computes at once, so that the blocks are covered.
+    const char source[] = "%1 = GRU 3 21 %0\n";
+    build(source, 3, batchSize, layout);
+    EXPECT_EQ(net_.stateSize, 21U);
+    EXPECT_EQ(net_.numParameters, NN::gruParameterCount(3, 21, layout));
+
+    NN::NetRunner runner(&net_);
+    runner.setBatchSize(batchSize);
+
+    std::vector<std::vector<float>> hidden(batchSize, std::vector<float>(21, 0.0F));
+
+    std::uniform_real_distribution<float> dist(-1.0F, 1.0F);
+    for (int tick = 0; tick < 4; tick++) {
+      std::vector<std::vector<float>> inputs(batchSize, std::vector<float>(3));
+      for (uint16_t b = 0; b < batchSize; b++) {
+        for (uint32_t i = 0; i < 3; i++) {
+          inputs[b][i] = dist(rng_);
+          runner.getRegister(0, b)[i] = inputs[b][i];
+        }
+      }
+
+      runner.reset();
+      NN::exec(program_, runner);
+
+      EXPECT_EQ(runner.getRegisterSize(1), 21);
+      for (uint16_t b = 0; b < batchSize; b++) {
+        hidden[b] = referenceGRU(inputs[b], hidden[b]);
+        for (uint32_t i = 0; i < 21; i++) {
+          EXPECT_NEAR(runner.getRegister(1, b)[i], hidden[b][i], 1.0e-5F);
+        }
+      }
+    }
+  }
+
+  void checkConv1D(const NN::WeightLayout layout, const uint16_t batchSize)
+  {
+    const char source[] = "%1 = Conv1D 2 5 3 %0\n";
+    build(source, 2, batchSize, layout);
+    EXPECT_EQ(net_.stateSize, 6U);
+    EXPECT_EQ(net_.numParameters, NN::linearParameterCount(6, 5, layout));
+
+    NN::NetRunner runner(&net_);
+    runner.setBatchSize(batchSize);
+
+    // The window starts out as zero.
+    using Window = std::vector<std::vector<float>>;
+    std::vector<Window> windows(batchSize, Window(3, std::vector<float>(2, 0.0F)));
+
+    std::uniform_real_distribution<float> dist(-1.0F, 1.0F);
+    for (int tick = 0; tick < 5; tick++) {
+      for (uint16_t b = 0; b < batchSize; b++) {
+        std::vector<float> x(2);
+        for (uint32_t i = 0; i < 2; i++) {
+          x[i] = dist(rng_);
+          runner.getRegister(0, b)[i] = x[i];
+        }
+        windows[b].erase(windows[b].begin());
+        windows[b].push_back(x);
+      }
+
+      runner.reset();
+      NN::exec(program_, runner);
+
+      EXPECT_EQ(runner.getRegisterSize(1), 5);
+      for (uint16_t b = 0; b < batchSize; b++) {
+        const auto expected = referenceConv1D(windows[b], 5);
+        for (uint32_t i = 0; i < 5; i++) {
+          EXPECT_NEAR(runner.getRegister(1, b)[i], expected[i], 1.0e-5F);
+        }
+      }
+    }
+  }
+
+  void TearDown() override
+  {
+    net_.releaseMemory();
+    program_.releaseMemory();
+  }
+
+  std::mt19937 rng_{ 2024 };
+
+  NN::Program program_;
+
+  NN::Net net_;
+};
+
+} // namespace
+
+TEST_F(RecurrentTest, GRUMatchesReference)
+{
+  checkGRU(NN::WeightLayout::kPacked, 1);
+}
+
+TEST_F(RecurrentTest, GRUMatchesReferencePaddedBatch)
+{
+  checkGRU(NN::WeightLayout::kPadded, 3);
+}
+
+TEST_F(RecurrentTest, Conv1DIsCausal)
+{
+  checkConv1D(NN::WeightLayout::kPacked, 1);
+}
+
+TEST_F(RecurrentTest, Conv1DPaddedBatch)
+{
+  checkConv1D(NN::WeightLayout::kPadded, 2);
+}
+
+TEST_F(RecurrentTest, ClearState)
+{
+  const char source[] = "%1 = GRU 2 4 %0\n"
+                        "%2 = Conv1D 4 3 2 %1\n";
+  build(source, 2, 2, NN::WeightLayout::kPacked);
+  EXPECT_EQ(net_.stateSize, 4U + 8U);
+
+  NN::NetRunner runner(&net_);
+  runner.setBatchSize(2);
+
+  const float x[2]{ 0.5F, -0.25F };
+  for (uint16_t b = 0; b < 2; b++) {
+    memcpy(runner.getRegister(0, b), x, sizeof(x));
+  }
+
+  runner.reset();
+  NN::exec(program_, runner);
+  const std::vector<float> first(runner.getRegister(2, 0), runner.getRegister(2, 0) + 3);
+
+  // Only the second sample starts over.
+  runner.clearState(1);
+  runner.reset();
+  NN::exec(program_, runner);
+  for (uint32_t i = 0; i < 3; i++) {
+    EXPECT_EQ(runner.getRegister(2, 1)[i], first[i]);
+  }
+  const std::vector<float> second(runner.getRegister(2, 0), runner.getRegister(2, 0) + 3);
+
+  runner.clearState();
+  runner.reset();
+  NN::exec(program_, runner);
+  for (uint32_t i = 0; i < 3; i++) {
+    EXPECT_EQ(runner.getRegister(2, 0)[i], first[i]);
+    EXPECT_EQ(runner.getRegister(2, 1)[i], first[i]);
+  }
+
+  // Separate activations have their own state.
+  NN::Activations activations;
+  ASSERT_TRUE(activations.allocMemory(net_));
+  NN::NetRunner other(&net_, &activations);
+  memcpy(other.getRegister(0, 0), x, sizeof(x));
+  other.reset();
+  NN::exec(program_, other);
+  other.reset();
+  NN::exec(program_, other);
+  for (uint32_t i = 0; i < 3; i++) {
+    EXPECT_EQ(other.getRegister(2, 0)[i], second[i]);
+  }
+  activations.releaseMemory();
+}
+
+TEST_F(RecurrentTest, HalfMatchesFloatRunner)
+{
+  const char source[] = "%1 = Conv1D 4 6 3 %0\n"
+                        "%2 = GRU 6 8 %1\n"
+                        "%3 = Linear 8 2 %2\n";
+  build(source, 4, 1, NN::WeightLayout::kPacked);
+
+  NN::HalfNet halfNet;
+  ASSERT_TRUE(NN::convertToHalf(net_, NN::HalfFormat::kFloat16, &halfNet));
+
+  NN::Activations activations;
+  ASSERT_TRUE(activations.allocMemory(halfNet.shape));
+
+  NN::NetRunner runner(&net_);
+  NN::HalfNetRunner halfRunner(&halfNet, &activations);
+
+  std::uniform_real_distribution<float> dist(-1.0F, 1.0F);
+  for (int tick = 0; tick < 6; tick++) {
+    for (uint32_t i = 0; i < 4; i++) {
+      const auto x = dist(rng_);
+      runner.getRegister(0)[i] = x;
+      halfRunner.getRegister(0)[i] = x;
+    }
+
+    runner.reset();
+    NN::exec(program_, runner);
+    halfRunner.reset();
+    NN::exec(program_, halfRunner);
+
+    EXPECT_EQ(halfRunner.getRegisterSize(3), 2);
+    for (uint32_t i = 0; i < 2; i++) {
+      EXPECT_NEAR(halfRunner.getRegister(3)[i], runner.getRegister(3)[i], 0.02F);
+    }
+  }
+
+  activations.releaseMemory();
+  halfNet.releaseMemory();
+}
+
+TEST_F(RecurrentTest, ConvertersRejectState)
+{
+  const char source[] = "%1 = GRU 2 4 %0\n";
+  build(source, 2, 1, NN::WeightLayout::kPacked);
+
+  NN::FixedNet fixedNet;
+  EXPECT_FALSE(NN::convertToFixed(program_, net_, 8, &fixedNet));
+
+  NN::SparseNet sparseNet;
+  EXPECT_FALSE(NN::pruneByMagnitude(program_, &net_, 0.5F));
+  EXPECT_FALSE(NN::sparsify(program_, net_, &sparseNet));
+}
@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+
+#include <NN_NetBuilder.h>
+#include <NN_NetRunner.h>
+#include <NN_Parser.h>
+#include <NN_Program.h>
+#include <NN_Sparse.h>
+#include <NN_SparseNetRunner.h>
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief A program and a float network with random weights.
+ * */
+class SparseTest : public testing::Test
+{
+protected:
+  void build(const char* source, const uint16_t inputSize, const uint16_t batchSize, const NN::WeightLayout layout)
+  {
+    ASSERT_EQ(NN::compile(source, static_cast<uint16_t>(strlen(source)), &program_), NN::SyntaxError::kNone);
+    net_.batchSize = batchSize;
+    net_.weightLayout = layout;
+    NN::NetBuilder builder(&net_, inputSize);
+    NN::exec(program_, builder);
+    ASSERT_TRUE(builder.finish());
+
+    std::normal_distribution<float> dist(0.0F, 0.5F);
+    for (uint32_t i = 0; i < net_.numParameters; i++) {
+      net_.parameters[i] = dist(rng_);
+    }
+  }
+
+  /**
+   * @brief Prunes a network and checks that the sparse network gives the same outputs as the pruned float network.
+   * */
+  void checkAgainstDense(const NN::WeightLayout layout, const uint16_t batchSize)
+  {
+    const char source[] = "%1 = Linear 10 7 %0\n"
+                          "%2 = Tanh %1\n"
+                          "%3 = Linear 7 5 %2\n"
+                          "%4 = Concat %3 %2\n"
+                          "%5 = Linear 12 3 %4\n";
+    build(source, 10, batchSize, layout);
+    ASSERT_EQ(NN::fuseActivations(&program_, NN::regBit(5)), 1);
+
+    ASSERT_TRUE(NN::pruneByMagnitude(program_, &net_, 0.6F));
+    ASSERT_TRUE(NN::sparsify(program_, net_, &sparseNet_));
+
+    NN::Activations activations;
+    ASSERT_TRUE(activations.allocMemory(sparseNet_.shape));
+
+    NN::NetRunner runner(&net_);
+    runner.setBatchSize(batchSize);
+    NN::SparseNetRunner sparseRunner(&sparseNet_, &activations);
+    sparseRunner.setBatchSize(batchSize);
+
+    std::uniform_real_distribution<float> dist(-1.0F, 1.0F);
+    for (uint16_t b = 0; b < batchSize; b++) {
+      for (uint16_t i = 0; i < 10; i++) {
+        const auto x = dist(rng_);
+        runner.getRegister(0, b)[i] = x;
+        sparseRunner.getRegister(0, b)[i] = x;
+      }
+    }
+
+    runner.reset();
+    NN::exec(program_, runner);
+    sparseRunner.reset();
+    NN::exec(program_, sparseRunner);
+
+    EXPECT_EQ(sparseRunner.getRegisterSize(5), 3);
+    for (uint16_t b = 0; b < batchSize; b++) {
+      for (uint16_t i = 0; i < 3; i++) {
+        EXPECT_NEAR(sparseRunner.getRegister(5, b)[i], runner.getRegister(5, b)[i], 1.0e-5F);
+      }
+    }
+
+    activations.releaseMemory();
+  }
+
+  void TearDown() override
+  {
+    sparseNet_.releaseMemory();
+    net_.releaseMemory();
+    program_.releaseMemory();
+  }
+
+  std::mt19937 rng_{ 4321 };
+
+  NN::Program program_;
+
+  NN::Net net_;
+
+  NN::SparseNet sparseNet_;
+};
+
+} // namespace
+
+TEST_F(SparseTest, PruneByMagnitude)
+{
+  const char source[] = "%1 = Linear 10 7 %0\n";
+  build(source, 10, 1, NN::WeightLayout::kPacked);
+
+  std::vector<float> bias(net_.parameters + 70, net_.parameters + 77);
+
+  ASSERT_TRUE(NN::pruneByMagnitude(program_, &net_, 0.5F));
+
+  // Blocks are four rows of one column, so the 7 rows make 2 block rows of 10 blocks each.
+  std::vector<float> norms;
+  std::vector<bool> pruned;
+  for (uint32_t i = 0; i < 2; i++) {
+    for (uint32_t j = 0; j < 10; j++) {
+      auto norm = 0.0F;
+      for (uint32_t r = i * 4; (r < (i + 1) * 4) && (r < 7); r++) {
+        norm += std::fabs(net_.parameters[r * 10 + j]);
+      }
+      norms.push_back(norm);
+      pruned.push_back(norm == 0.0F);
+    }
+  }
+
+  uint32_t numPruned{};
+  for (size_t i = 0; i < norms.size(); i++) {
+    numPruned += pruned[i] ? 1 : 0;
+    for (size_t j = 0; j < norms.size(); j++) {
+      if (pruned[i] && !pruned[j]) {
+        EXPECT_GT(norms[j], 0.0F);
+      }
+    }
+  }
+  EXPECT_EQ(numPruned, 10U);
+
+  for (uint32_t i = 0; i < 7; i++) {
+    EXPECT_EQ(net_.parameters[70 + i], bias[i]);
+  }
+}
+
+TEST_F(SparseTest, PruneKeepsLargestBlocks)
+{
+  const char source[] = "%1 = Linear 8 4 %0\n";
+  build(source, 8, 1, NN::WeightLayout::kPacked);
+
+  // Each column is one block, with a magnitude that grows with the column.
+  for (uint32_t r = 0; r < 4; r++) {
+    for (uint32_t j = 0; j < 8; j++) {
+      net_.parameters[r * 8 + j] = ((r % 2) ? -1.0F : 1.0F) * static_cast<float>(j + 1);
+    }
+  }
+
+  ASSERT_TRUE(NN::pruneByMagnitude(program_, &net_, 0.75F));
+
+  for (uint32_t r = 0; r < 4; r++) {
+    for (uint32_t j = 0; j < 8; j++) {
+      EXPECT_EQ(net_.parameters[r * 8 + j] != 0.0F, j >= 6);
+    }
+  }
+}
+
+TEST_F(SparseTest, CompressedSize)
+{
+  const char source[] = "%1 = Linear 64 32 %0\n"
+                        "%2 = ReLU %1\n"
+                        "%3 = Linear 32 8 %2\n";
+  build(source, 64, 1, NN::WeightLayout::kPacked);
+
+  ASSERT_TRUE(NN::sparsify(program_, net_, &sparseNet_));
+  EXPECT_EQ(sparseNet_.numBlocks, 64U * 8U + 32U * 2U);
+  EXPECT_EQ(sparseNet_.numParameters, net_.numParameters);
+  EXPECT_EQ(sparseNet_.numBlockStarts, 9U + 3U);
+  sparseNet_.releaseMemory();
+
+  ASSERT_TRUE(NN::pruneByMagnitude(program_, &net_, 0.75F));
+  ASSERT_TRUE(NN::sparsify(program_, net_, &sparseNet_));
+  EXPECT_EQ(sparseNet_.numBlocks, 64U * 2U + 32U * 2U / 4U);
+  EXPECT_EQ(sparseNet_.numParameters, NN::sparseLinearParameterCount(32, 128) + NN::sparseLinearParameterCount(8, 16));
+
+  // A quarter of the weights, with an index for every four of them.
+  EXPECT_LT(sparseNet_.getParameterBytes(), net_.numParameters * sizeof(float) / 3);
+}
+
+TEST_F(SparseTest, MatchesDenseRunner)
+{
+  checkAgainstDense(NN::WeightLayout::kPacked, 1);
+}
+
+TEST_F(SparseTest, MatchesDenseRunnerPaddedBatch)
+{
+  checkAgainstDense(NN::WeightLayout::kPadded, 3);
+}
@@ -0,0 +1,292 @@
+#include <gtest/gtest.h>
+
+#include <NN_NetBuilder.h>
+#include <NN_NetRunner.h>
+#include <NN_Parser.h>
+#include <NN_Program.h>
+#include <NN_WeightFile.h>
+
+#include <MappedFile.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char source[] = "%1 = Linear 3 8 %0\n"
+                      "%2 = Tanh %1\n"
+                      "%3 = Linear 8 2 %2\n";
+
+/**
+ * @brief A buffer that starts on a 64 byte boundary, the way a mapped file or an aligned array in flash does.
+ * */
+struct AlignedBuffer final
+{
+  std::vector<uint8_t> storage;
+
+  uint8_t* data{};
+
+  explicit AlignedBuffer(const size_t size)
+    : storage(size + NN_WEIGHT_FILE_ALIGNMENT)
+  {
+    const auto address = reinterpret_cast<uintptr_t>(storage.data());
+    data = storage.data() + (NN_WEIGHT_FILE_ALIGNMENT - address % NN_WEIGHT_FILE_ALIGNMENT) % NN_WEIGHT_FILE_ALIGNMENT;
+  }
+};
+
+void
+buildNet(NN::Net* net, NN::Program* program, const NN::WeightLayout layout)
+{
+  ASSERT_EQ(NN::compile(source, sizeof(source) - 1, program), NN::SyntaxError::kNone);
+  net->weightLayout = layout;
+  net->activationMode = NN::ActivationMode::kFast;
+  NN::NetBuilder builder(net, 3);
+  NN::exec(*program, builder);
+  ASSERT_TRUE(builder.finish());
+  for (uint32_t i = 0; i < net->numParameters; i++) {
+    net->parameters[i] = static_cast<float>(static_cast<int>(i % 13) - 6) * 0.05F;
+  }
+}
+
+auto
+run(const NN::Net& net, NN::NetRunner& runner, const NN::Program& program) -> std::vector<float>
+{
+  runner.getRegister(0)[0] = 0.5F;
+  runner.getRegister(0)[1] = -1.0F;
+  runner.getRegister(0)[2] = 2.0F;
+  runner.reset();
+  NN::exec(program, runner);
+  return std::vector<float>(runner.getRegister(3), runner.getRegister(3) + net.regSizes[3]);
+}
+
+auto
+writeFile(const NN::Net& net) -> AlignedBuffer
+{
+  const auto size = NN::getWeightFileSize(net, sizeof(source) - 1);
+  AlignedBuffer buffer(size);
+  EXPECT_EQ(NN::writeWeightFile(net, source, sizeof(source) - 1, buffer.data, size), NN::WeightFileError::kNone);
+  return buffer;
+}
+
+void
+roundTrip(const NN::WeightLayout layout)
+{
+  NN::Net net;
+  NN::Program program;
+  buildNet(&net, &program, layout);
+
+  const auto size = NN::getWeightFileSize(net, sizeof(source) - 1);
+  const auto buffer = writeFile(net);
+
+  NN::WeightFile file;
+  ASSERT_EQ(NN::openWeightFile(buffer.data, size, &file), NN::WeightFileError::kNone);
+  EXPECT_EQ(std::string(file.source, file.sourceSize), source);
+  EXPECT_EQ(file.numParameters, net.numParameters);
+  EXPECT_EQ(file.weightLayout, net.weightLayout);
+  EXPECT_EQ(file.activationMode, net.activationMode);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(file.parameters) % NN_WEIGHT_FILE_ALIGNMENT, 0);
+  for (uint8_t i = 0; i < NN_MAX_REGS; i++) {
+    EXPECT_EQ(file.regSizes[i], net.regSizes[i]);
+  }
+
+  // The loaded network runs in place on the file, with its own registers.
+  NN::Net loaded;
+  NN::bindWeightFile(file, &loaded);
+  EXPECT_EQ(loaded.parameters, file.parameters);
+  NN::Program loadedProgram;
+  ASSERT_EQ(NN::compile(file.source, static_cast<uint16_t>(file.sourceSize), &loadedProgram), NN::SyntaxError::kNone);
+  NN::Activations activations;
+  ASSERT_TRUE(activations.allocMemory(loaded));
+
+  NN::NetRunner runner(&net);
+  NN::NetRunner loadedRunner(&loaded, &activations);
+  EXPECT_EQ(run(net, runner, program), run(loaded, loadedRunner, loadedProgram));
+
+  activations.releaseMemory();
+  loaded.releaseMemory();
+  loadedProgram.releaseMemory();
+  net.releaseMemory();
+  program.releaseMemory();
+}
+
+} // namespace
+
+TEST(WeightFile, RoundTripPacked)
+{
+  roundTrip(NN::WeightLayout::kPacked);
+}
+
+TEST(WeightFile, RoundTripPadded)
+{
+  roundTrip(NN::WeightLayout::kPadded);
+}
+
+TEST(WeightFile, RoundTripState)
+{
+  const char statefulSource[] = "%1 = GRU 4 8 %0\n"
+                                "%2 = Conv1D 8 4 3 %1\n";
+  NN::Program program;
+  ASSERT_EQ(NN::compile(statefulSource, sizeof(statefulSource) - 1, &program), NN::SyntaxError::kNone);
+  NN::Net net;
+  NN::NetBuilder builder(&net, 4);
+  NN::exec(program, builder);
+  ASSERT_TRUE(builder.finish());
+  ASSERT_EQ(net.stateSize, 8 + 3 * 8);
+  for (uint32_t i = 0; i < net.numParameters; i++) {
+    net.parameters[i] = static_cast<float>(static_cast<int>(i % 11) - 5) * 0.1F;
+  }
+
+  const auto size = NN::getWeightFileSize(net, sizeof(statefulSource) - 1);
+  AlignedBuffer buffer(size);
+  ASSERT_EQ(NN::writeWeightFile(net, statefulSource, sizeof(statefulSource) - 1, buffer.data, size),
+            NN::WeightFileError::kNone);
+
+  NN::WeightFile file;
+  ASSERT_EQ(NN::openWeightFile(buffer.data, size, &file), NN::WeightFileError::kNone);
+  EXPECT_EQ(file.stateSize, net.stateSize);
+  NN::Net loaded;
+  NN::bindWeightFile(file, &loaded);
+  NN::Activations activations;
+  ASSERT_TRUE(activations.allocMemory(loaded));
+
+  // The outputs depend on the earlier inputs, so they only match if the state is kept the same way.
+  NN::NetRunner runner(&net);
+  NN::NetRunner loadedRunner(&loaded, &activations);
+  for (int tick = 0; tick < 6; tick++) {
+    for (int i = 0; i < 4; i++) {
+      const auto x = static_cast<float>((tick * 4 + i) % 7) * 0.25F - 0.75F;
+      runner.getRegister(0)[i] = x;
+      loadedRunner.getRegister(0)[i] = x;
+    }
+    runner.reset();
+    NN::exec(program, runner);
+    loadedRunner.reset();
+    NN::exec(program, loadedRunner);
+    for (int i = 0; i < 4; i++) {
+      ASSERT_EQ(runner.getRegister(2)[i], loadedRunner.getRegister(2)[i]) << "tick " << tick;
+    }
+  }
+
+  activations.releaseMemory();
+  loaded.releaseMemory();
+  net.releaseMemory();
+  program.releaseMemory();
+}
+
+TEST(WeightFile, IsLittleEndian)
+{
+  NN::Net net;
+  NN::Program program;
+  buildNet(&net, &program, NN::WeightLayout::kPacked);
+  net.parameters[0] = 1.0F;
+
+  const auto buffer = writeFile(net);
+  EXPECT_EQ(buffer.data[0], 'A');
+  EXPECT_EQ(buffer.data[4], NN_WEIGHT_FILE_VERSION);
+  EXPECT_EQ(buffer.data[30], 4);
+  EXPECT_EQ(buffer.data[64], 3);
+  EXPECT_EQ(buffer.data[68], 8);
+
+  // 1.0 is 0x3f800000.
+  const auto* parameter = buffer.data + NN_WEIGHT_FILE_ALIGNMENT * 3;
+  EXPECT_EQ(parameter[0], 0x00);
+  EXPECT_EQ(parameter[2], 0x80);
+  EXPECT_EQ(parameter[3], 0x3f);
+
+  net.releaseMemory();
+  program.releaseMemory();
+}
+
+TEST(WeightFile, RejectsBadFiles)
+{
+  NN::Net net;
+  NN::Program program;
+  buildNet(&net, &program, NN::WeightLayout::kPadded);
+
+  const auto size = NN::getWeightFileSize(net, sizeof(source) - 1);
+  auto buffer = writeFile(net);
+  NN::WeightFile file;
+
+  EXPECT_EQ(NN::writeWeightFile(net, source, sizeof(source) - 1, buffer.data, size - 1),
+            NN::WeightFileError::kBufferTooSmall);
+
+  EXPECT_EQ(NN::openWeightFile(buffer.data, 63, &file), NN::WeightFileError::kTruncated);
+  EXPECT_EQ(NN::openWeightFile(buffer.data, size - 1, &file), NN::WeightFileError::kTruncated);
+  EXPECT_EQ(NN::openWeightFile(buffer.data, NN_WEIGHT_FILE_ALIGNMENT + 8, &file), NN::WeightFileError::kTruncated);
+
+  // The padded layout needs the parameters on a row boundary.
+  AlignedBuffer shifted(size + 4);
+  std::copy(buffer.data, buffer.data + size, shifted.data + 4);
+  EXPECT_EQ(NN::openWeightFile(shifted.data + 4, size, &file), NN::WeightFileError::kMisaligned);
+
+  buffer.data[4] = NN_WEIGHT_FILE_VERSION + 1;
+  EXPECT_EQ(NN::openWeightFile(buffer.data, size, &file), NN::WeightFileError::kUnsupportedVersion);
+  buffer.data[4] = NN_WEIGHT_FILE_VERSION;
+
+  buffer.data[28] = 7;
+  EXPECT_EQ(NN::openWeightFile(buffer.data, size, &file), NN::WeightFileError::kInvalidHeader);
+  buffer.data[28] = static_cast<uint8_t>(NN::WeightLayout::kPadded);
+
+  buffer.data[20] = 0xff;
+  EXPECT_EQ(NN::openWeightFile(buffer.data, size, &file), NN::WeightFileError::kInvalidHeader);
+  buffer.data[23] = 0xff;
+  EXPECT_EQ(NN::openWeightFile(buffer.data, size, &file), NN::WeightFileError::kTruncated);
+  buffer.data[20] = sizeof(source) - 1;
+  buffer.data[23] = 0;
+
+  // The register table has to end where the program text starts.
+  buffer.data[30] = NN_MAX_REGS + 1;
+  EXPECT_EQ(NN::openWeightFile(buffer.data, size, &file), NN::WeightFileError::kInvalidHeader);
+  buffer.data[30] = 4;
+
+#if !NN_WIDE_INDEX
+  // A register that only fits in the wide index mode.
+  buffer.data[64 + 2] = 1;
+  EXPECT_EQ(NN::openWeightFile(buffer.data, size, &file), NN::WeightFileError::kTooLarge);
+  buffer.data[64 + 2] = 0;
+#endif
+
+  EXPECT_EQ(NN::openWeightFile(buffer.data, size, &file), NN::WeightFileError::kNone);
+
+  buffer.data[0] = 'X';
+  EXPECT_EQ(NN::openWeightFile(buffer.data, size, &file), NN::WeightFileError::kBadMagic);
+
+  net.releaseMemory();
+  program.releaseMemory();
+}
+
+TEST(WeightFile, MapsFile)
+{
+  NN::Net net;
+  NN::Program program;
+  buildNet(&net, &program, NN::WeightLayout::kPadded);
+
+  const auto size = NN::getWeightFileSize(net, sizeof(source) - 1);
+  const auto buffer = writeFile(net);
+  const std::string path = testing::TempDir() + "weights.arcw";
+  {
+    std::ofstream stream(path, std::ios::binary);
+    stream.write(reinterpret_cast<const char*>(buffer.data), static_cast<std::streamsize>(size));
+  }
+
+  NN::MappedFile mapped;
+  ASSERT_TRUE(mapped.open(path));
+  ASSERT_EQ(mapped.getSize(), size);
+
+  NN::WeightFile file;
+  ASSERT_EQ(NN::openWeightFile(mapped.getData(), mapped.getSize(), &file), NN::WeightFileError::kNone);
+  EXPECT_GE(reinterpret_cast<const uint8_t*>(file.parameters), static_cast<const uint8_t*>(mapped.getData()));
+  for (uint32_t i = 0; i < net.numParameters; i++) {
+    ASSERT_EQ(file.parameters[i], net.parameters[i]);
+  }
+
+  mapped.close();
+  EXPECT_EQ(mapped.getData(), nullptr);
+  EXPECT_FALSE(mapped.open(path + ".missing"));
+  std::remove(path.c_str());
+
+  net.releaseMemory();
+  program.releaseMemory();
+}
@@ -0,0 +1,101 @@
+#include "ThreadPool.h"
+
+namespace NN {
+
+ThreadPool::ThreadPool(uint32_t numThreads)
+{
+  if (numThreads == 0) {
+    numThreads = std::thread::hardware_concurrency();
+  }
+  for (uint32_t i = 1; i < numThreads; i++) {
+    workers_.emplace_back([this]() { workerLoop(); });
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+auto
+ThreadPool::getNumThreads() const -> uint32_t
+{
+  return static_cast<uint32_t>(workers_.size()) + 1;
+}
+
+void
+ThreadPool::run(const uint32_t count, ParallelJob job, void* jobData)
+{
+  if (workers_.empty() || (count <= 1)) {
+    serialFor(nullptr, count, job, jobData);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    job_ = job;
+    jobData_ = jobData;
+    count_ = count;
+    next_.store(0);
+    busy_ = static_cast<uint32_t>(workers_.size());
+    generation_++;
+  }
+  wake_.notify_all();
+
+  drain();
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_.wait(lock, [this]() { return busy_ == 0; });
+}
+
+void
+ThreadPool::parallelFor(void* pool, const uint32_t count, ParallelJob job, void* jobData)
+{
+  static_cast<ThreadPool*>(pool)->run(count, job, jobData);
+}
+
+void
+ThreadPool::workerLoop()
+{
+  uint64_t seen{};
+
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [this, seen]() { return stopping_ || (generation_ != seen); });
+      if (stopping_) {
+        return;
+      }
+      seen = generation_;
+    }
+
+    drain();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    busy_--;
+    if (busy_ == 0) {
+      done_.notify_one();
+    }
+  }
+}
+
+void
+ThreadPool::drain()
+{
+  for (;;) {
+    const auto index = next_.fetch_add(1);
+    if (index >= count_) {
+      break;
+    }
+    job_(jobData_, index);
+  }
+}
+
+} // namespace NN
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <NN_Parallel.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace NN {
+
+/**
+ * @brief A fixed set of worker threads that run the jobs of @ref ParallelForFunc.
+ *
+ * @details The thread that calls @ref ThreadPool::run works on the jobs too, so a pool of N threads starts N - 1
+ *          workers. Indices are handed out one at a time, which balances jobs of uneven length. A job must not call
+ *          back into the same pool, and only one thread may run jobs on a pool at a time.
+ * */
+class ThreadPool final
+{
+public:
+  /**
+   * @param numThreads The number of threads to run jobs on, including the caller. Zero uses one per core.
+   * */
+  explicit ThreadPool(uint32_t numThreads = 0);
+
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+
+  auto operator=(const ThreadPool&) -> ThreadPool& = delete;
+
+  [[nodiscard]] auto getNumThreads() const -> uint32_t;
+
+  void run(uint32_t count, ParallelJob job, void* jobData);
+
+  /**
+   * @brief Matches @ref ParallelForFunc, with the pool as the executor data.
+   * */
+  static void parallelFor(void* pool, uint32_t count, ParallelJob job, void* jobData);
+
+protected:
+  void workerLoop();
+
+  void drain();
+
+private:
+  std::vector<std::thread> workers_;
+
+  std::mutex mutex_;
+
+  std::condition_variable wake_;
+
+  std::condition_variable done_;
+
+  /**
+   * @brief Incremented for each call to @ref ThreadPool::run, so that the workers can tell new work from old.
+   * */
+  uint64_t generation_{};
+
+  /**
+   * @brief The number of workers that have not finished the current call yet.
+   * */
+  uint32_t busy_{};
+
+  bool stopping_{ false };
+
+  ParallelJob job_{};
+
+  void* jobData_{};
+
+  uint32_t count_{};
+
+  std::atomic<uint32_t> next_{ 0 };
+};
+
+} // namespace NN
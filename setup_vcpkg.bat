@@ -6,4 +6,4 @@ pushd vcpkg
 set "VCPKG_ROOT=%cd%"
 git checkout "2024.11.16"
 call .\bootstrap-vcpkg.bat -disableMetrics
-.\vcpkg.exe install cxxopts spdlog libuv gtest glfw3 glm protobuf
+.\vcpkg.exe install cxxopts spdlog libuv gtest benchmark glfw3 glm protobuf
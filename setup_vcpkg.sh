@@ -10,5 +10,5 @@ if [ ! -e vcpkg ]; then
 fi
 
 pushd vcpkg
-./vcpkg install cxxopts spdlog libuv gtest glfw3 glm protobuf
+./vcpkg install cxxopts spdlog libuv gtest benchmark glfw3 glm protobuf
 popd
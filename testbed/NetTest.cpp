@@ -9,12 +9,15 @@
 #include <string>
 #include <vector>
 
+#include <NN_CostModel.h>
 #include <NN_Lexer.h>
+#include <NN_Liveness.h>
 #include <NN_Loss.h>
 #include <NN_NetBuilder.h>
 #include <NN_NetRunner.h>
 #include <NN_Optim.h>
 #include <NN_Parser.h>
+#include <NN_Program.h>
 
 namespace {
 
@@ -25,6 +28,11 @@ const char initSource[] = "%2 = Linear 8 8 %0\n"
 class NetTestImpl final : public NetTest
 {
 public:
+  /**
+   * @brief The number of samples that the loss is computed over.
+   * */
+  static constexpr int maxSamples{ 128 };
+
   NetTestImpl() { buildNet(); }
 
   void render() override
@@ -58,9 +66,27 @@ protected:
   {
     net_.releaseMemory();
 
+    program_.releaseMemory();
+
+    if (NN::compile(netSource_.c_str(), netSource_.size(), &program_) != NN::SyntaxError::kNone) {
+      program_ = NN::Program{};
+    }
+
+    NN::fuseActivations(&program_, 1U << 2);
+
+    net_.batchSize = maxSamples;
+
     NN::NetBuilder builder(&net_, 8);
 
-    (void)NN::exec(netSource_.c_str(), netSource_.size(), builder);
+    NN::exec(program_, builder);
+
+    NN::Liveness liveness;
+
+    liveness.markLiveOut(2);
+
+    NN::exec(program_, liveness);
+
+    liveness.assignOffsets(&net_);
 
     (void)builder.finish();
 
@@ -112,17 +138,18 @@ protected:
 
     NN::NetRunner runner(&net);
 
-    constexpr auto maxIterations{ 128 };
+    runner.setBatchSize(maxSamples);
 
-    auto loss{ 0.0F };
+    int results[maxSamples]{};
+
+    std::uniform_int_distribution<int> operandDist(0, 15);
 
-    for (auto i = 0; i < maxIterations; i++) {
+    for (auto i = 0; i < maxSamples; i++) {
 
-      std::uniform_int_distribution<int> operandDist(0, 15);
       const auto a = operandDist(self->rng_);
       const auto b = operandDist(self->rng_);
 
-      auto* input = runner.getRegister(0);
+      auto* input = runner.getRegister(0, i);
       input[0] = (a & 1) ? 1.0F : 0.0F;
       input[1] = (a & 2) ? 1.0F : 0.0F;
       input[2] = (a & 4) ? 1.0F : 0.0F;
@@ -133,21 +160,26 @@ protected:
       input[6] = (b & 4) ? 1.0F : 0.0F;
       input[7] = (b & 8) ? 1.0F : 0.0F;
 
-      runner.reset();
+      results[i] = a ^ b;
+    }
 
-      if (NN::exec(self->netSource_.c_str(), self->netSource_.size(), runner) != NN::SyntaxError::kNone) {
-        return 0.0F;
-      }
+    // All of the samples go through the network at once.
+    runner.reset();
+
+    NN::exec(self->program_, runner);
 
-      const auto* output = runner.getRegister(2);
-      const auto result = a ^ b;
+    auto loss{ 0.0F };
+
+    for (auto i = 0; i < maxSamples; i++) {
+      const auto* output = runner.getRegister(2, i);
+      const auto result = results[i];
       const float target[4]{
         (result & 1) ? 1.0F : 0.0F, (result & 2) ? 1.0F : 0.0F, (result & 4) ? 1.0F : 0.0F, (result & 8) ? 1.0F : 0.0F
       };
       loss += NN::l1Loss(output, target, 4);
     }
 
-    return loss / maxIterations;
+    return loss / maxSamples;
   }
 
   void stepOptim()
@@ -177,7 +209,10 @@ protected:
   {
     NN::Lexer lexer(netSource_.c_str(), netSource_.size());
 
-    NN::NetBuilder builder(&net_, 8);
+    // Check the source against a scratch network, so that the one being optimized keeps its shape.
+    NN::Net scratchNet;
+
+    NN::NetBuilder builder(&scratchNet, 8);
 
     NN::Parser parser(&builder);
 
@@ -201,15 +236,87 @@ protected:
       case NN::SyntaxError::kNumberOutOfBounds:
         ImGui::TextUnformatted("number out of bounds");
         break;
+      case NN::SyntaxError::kOutOfMemory:
+        ImGui::TextUnformatted("out of memory");
+        break;
     }
     ImGui::PopStyleColor();
 
-    ImGui::InputTextMultiline("##Source", &netSource_, ImVec2(-1, -1));
+    if (err == NN::SyntaxError::kNone) {
+      renderCost();
+    }
+
+    if (ImGui::InputTextMultiline("##Source", &netSource_, ImVec2(-1, -1))) {
+      // The program is compiled when the optimizer is recreated.
+      optimizer_.reset();
+    }
+  }
+
+  /**
+   * @brief Shows what the source would cost to run on each target, so that it can be checked against the budget of
+   *        the control loop while it is being edited.
+   * */
+  void renderCost()
+  {
+    NN::Liveness liveness;
+
+    liveness.markLiveOut(2);
+
+    (void)NN::exec(netSource_.c_str(), netSource_.size(), liveness);
+
+    const NN::CostTarget targets[]{ NN::CostTarget::kDesktop,
+                                    NN::CostTarget::kCortexM4F,
+                                    NN::CostTarget::kCortexM0Plus };
+
+    const char* names[]{ "Desktop", "Cortex-M4F", "Cortex-M0+" };
+
+    if (!ImGui::BeginTable("Cost", 7, ImGuiTableFlags_Borders)) {
+      return;
+    }
+
+    ImGui::TableSetupColumn("Target");
+    ImGui::TableSetupColumn("MACs");
+    ImGui::TableSetupColumn("Sigmoid/Tanh");
+    ImGui::TableSetupColumn("Parameters (B)");
+    ImGui::TableSetupColumn("Activations (B)");
+    ImGui::TableSetupColumn("Cycles");
+    ImGui::TableSetupColumn("Time (us)");
+    ImGui::TableHeadersRow();
+
+    for (int i = 0; i < 3; i++) {
+      NN::CostModel model(NN::getCostTable(targets[i]));
+
+      model.setInputSize(0, 8);
+
+      model.setLiveness(&liveness);
+
+      (void)NN::exec(netSource_.c_str(), netSource_.size(), model);
+
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(names[i]);
+      ImGui::TableNextColumn();
+      ImGui::Text("%llu", static_cast<unsigned long long>(model.getMacs()));
+      ImGui::TableNextColumn();
+      ImGui::Text("%llu", static_cast<unsigned long long>(model.getTranscendentals()));
+      ImGui::TableNextColumn();
+      ImGui::Text("%llu", static_cast<unsigned long long>(model.getParameterBytes()));
+      ImGui::TableNextColumn();
+      ImGui::Text("%llu", static_cast<unsigned long long>(model.getActivationBytes()));
+      ImGui::TableNextColumn();
+      ImGui::Text("%.0f", model.getCycles());
+      ImGui::TableNextColumn();
+      ImGui::Text("%.1f", model.getMicroseconds());
+    }
+
+    ImGui::EndTable();
   }
 
 private:
   NN::Net net_;
 
+  NN::Program program_;
+
   bool optimize_{ false };
 
   int batchSize_{ 8 };